@@ -79,4 +79,40 @@ unsigned int ClusterPipe::gather(unsigned int value,GatherOperation::OpCode op)
 	return multiplexer->gather(pipeId,value,op);
 	}
 
+void ClusterPipe::allReduce(int* values,size_t numValues,GatherOperation::OpCode op)
+	{
+	/* Send any unsent data: */
+	flushPipe();
+	
+	/* Pass call through to multicast pipe multiplexer: */
+	multiplexer->allReduce(pipeId,values,numValues,op);
+	}
+
+void ClusterPipe::allReduce(float* values,size_t numValues,GatherOperation::OpCode op)
+	{
+	/* Send any unsent data: */
+	flushPipe();
+	
+	/* Pass call through to multicast pipe multiplexer: */
+	multiplexer->allReduce(pipeId,values,numValues,op);
+	}
+
+void ClusterPipe::allReduce(double* values,size_t numValues,GatherOperation::OpCode op)
+	{
+	/* Send any unsent data: */
+	flushPipe();
+	
+	/* Pass call through to multicast pipe multiplexer: */
+	multiplexer->allReduce(pipeId,values,numValues,op);
+	}
+
+void ClusterPipe::allGather(const void* data,size_t dataSize,std::vector<std::vector<unsigned char> >& nodeData)
+	{
+	/* Send any unsent data: */
+	flushPipe();
+	
+	/* Pass call through to multicast pipe multiplexer: */
+	multiplexer->allGather(pipeId,data,dataSize,nodeData);
+	}
+
 }
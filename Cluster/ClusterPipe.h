@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef CLUSTER_CLUSTERPIPE_INCLUDED
 #define CLUSTER_CLUSTERPIPE_INCLUDED
 
+#include <vector>
 #include <Cluster/GatherOperation.h>
 #include <Cluster/Multiplexer.h>
 
@@ -81,9 +82,17 @@ class ClusterPipe
 		{
 		return writeCoupled;
 		}
+	Multiplexer::PipeStatistics getStatistics(void) const // Returns the pipe's current communication counters
+		{
+		return multiplexer->getPipeStatistics(pipeId);
+		}
 	virtual void couple(bool newReadCoupled,bool newWriteCoupled); // Couples or decouples the reading and writing side of the pipe
 	virtual void barrier(void); // Blocks the calling thread until all nodes in a cluster pipe have reached the same point in the program
 	virtual unsigned int gather(unsigned int value,GatherOperation::OpCode op); // Blocks the calling thread until all nodes in a cluster pipe have exchanged a value; returns final accumulated value
+	virtual void allReduce(int* values,size_t numValues,GatherOperation::OpCode op); // Blocks the calling thread until all nodes in a cluster pipe have accumulated the given arrays element-wise; replaces the arrays with the accumulated result
+	virtual void allReduce(float* values,size_t numValues,GatherOperation::OpCode op); // Ditto, for float arrays
+	virtual void allReduce(double* values,size_t numValues,GatherOperation::OpCode op); // Ditto, for double arrays
+	virtual void allGather(const void* data,size_t dataSize,std::vector<std::vector<unsigned char> >& nodeData); // Blocks the calling thread until all nodes in a cluster pipe have exchanged variable-sized blocks of data; nodeData[i] receives the data contributed by node i
 	};
 
 }
@@ -26,6 +26,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #define CLUSTER_CONFIG_IP_HEADER_SIZE 20
 #define CLUSTER_CONFIG_UDP_HEADER_SIZE 8
 
+#define CLUSTER_CONFIG_HAVE_MMSG 1
+
 #define CLUSTER_CONFIG_DEBUG_MULTIPLEXER 0
 #define CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE 0
 
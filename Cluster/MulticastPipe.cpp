@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Misc/ThrowStdErr.h>
 #include <Cluster/Packet.h>
 #include <Cluster/Multiplexer.h>
+#include <Cluster/PacketCompressor.h>
 
 namespace Cluster {
 
@@ -35,6 +36,12 @@ Methods of class MulticastPipe:
 
 size_t MulticastPipe::readData(IO::File::Byte* buffer,size_t bufferSize)
 	{
+	if(compressor!=0)
+		{
+		/* Receive the next frame and decompress it into the file's own read buffer: */
+		return compressor->receiveFrame(multiplexer,pipeId,multiplexer->receivePacket(pipeId),buffer,bufferSize);
+		}
+	
 	/* Delete the current (completely read) packet: */
 	if(packet!=0)
 		{
@@ -54,6 +61,13 @@ size_t MulticastPipe::readData(IO::File::Byte* buffer,size_t bufferSize)
 
 void MulticastPipe::writeData(const IO::File::Byte* buffer,size_t bufferSize)
 	{
+	if(compressor!=0)
+		{
+		/* Compress the write buffer's contents into a frame of packets: */
+		compressor->sendFrame(multiplexer,pipeId,buffer,bufferSize);
+		return;
+		}
+	
 	/* Pass the current packet to the multiplexer: */
 	{
 	Packet* sendPacket=packet;
@@ -73,12 +87,27 @@ void MulticastPipe::flushPipe(void)
 	flush();
 	}
 
-MulticastPipe::MulticastPipe(Multiplexer* sMultiplexer)
+MulticastPipe::MulticastPipe(Multiplexer* sMultiplexer,bool sCompressed)
 	:IO::File(),ClusterPipe(sMultiplexer),
-	 packet(0)
+	 packet(0),
+	 compressor(sCompressed?new PacketCompressor(multiplexer->isMaster()):0)
 	{
 	/* Set up the master or slave buffers: */
-	if(isMaster())
+	if(compressor!=0)
+		{
+		/* Use frame-sized buffers owned by the file; packets are assembled by the compressor: */
+		if(isMaster())
+			{
+			IO::File::resizeWriteBuffer(PacketCompressor::maxFrameSize);
+			canWriteThrough=false;
+			}
+		else
+			{
+			IO::File::resizeReadBuffer(PacketCompressor::maxFrameSize);
+			canReadThrough=false;
+			}
+		}
+	else if(isMaster())
 		{
 		/* Install a fresh cluster packet as the write buffer: */
 		packet=multiplexer->newPacket();
@@ -96,7 +125,14 @@ MulticastPipe::MulticastPipe(Multiplexer* sMultiplexer)
 
 MulticastPipe::~MulticastPipe(void)
 	{
-	if(isMaster())
+	if(compressor!=0)
+		{
+		/* Send any unsent data, and delete the compressor: */
+		if(isMaster())
+			flush();
+		delete compressor;
+		}
+	else if(isMaster())
 		{
 		/* Check if there is unsent data in the write buffer: */
 		size_t unwrittenSize=getWritePtr();
@@ -127,20 +163,20 @@ MulticastPipe::~MulticastPipe(void)
 
 size_t MulticastPipe::getReadBufferSize(void) const
 	{
-	/* Return the maximum cluster packet size: */
-	return Packet::maxPacketSize;
+	/* Return the maximum frame size or the maximum cluster packet size: */
+	return compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize;
 	}
 
 size_t MulticastPipe::getWriteBufferSize(void) const
 	{
-	/* Return the maximum cluster packet size: */
-	return Packet::maxPacketSize;
+	/* Return the maximum frame size or the maximum cluster packet size: */
+	return compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize;
 	}
 
 size_t MulticastPipe::resizeReadBuffer(size_t newReadBufferSize)
 	{
-	/* Ignore the request and return the maximum cluster packet size: */
-	return Packet::maxPacketSize;
+	/* Ignore the request and return the maximum frame size or the maximum cluster packet size: */
+	return compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize;
 	}
 
 void MulticastPipe::resizeWriteBuffer(size_t newWriteBufferSize)
@@ -31,6 +31,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 /* Forward declarations: */
 namespace Cluster {
 struct Packet;
+class PacketCompressor;
 }
 
 namespace Cluster {
@@ -41,6 +42,7 @@ class MulticastPipe:public IO::File,public ClusterPipe
 	private:
 	Packet* packet; // Pointer to current packet
 	size_t packetPos; // Data position in current packet
+	PacketCompressor* compressor; // Compressor or decompressor for data sent over the pipe, or null if data is sent uncompressed
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -52,7 +54,7 @@ class MulticastPipe:public IO::File,public ClusterPipe
 	
 	/* Constructors and destructors: */
 	public:
-	MulticastPipe(Multiplexer* sMultiplexer); // Creates new pipe for the given multiplexer
+	MulticastPipe(Multiplexer* sMultiplexer,bool sCompressed =false); // Creates new pipe for the given multiplexer; compresses data sent over the pipe if flag is true; flag must be the same on all nodes
 	private:
 	MulticastPipe(const MulticastPipe& source); // Prohibit copy constructor
 	MulticastPipe& operator=(const MulticastPipe& source); // Prohibit assignment operato
@@ -66,6 +68,10 @@ class MulticastPipe:public IO::File,public ClusterPipe
 	virtual void resizeWriteBuffer(size_t newWriteBufferSize);
 	
 	/* New methods: */
+	bool isCompressed(void) const // Returns true if data sent over the pipe is compressed
+		{
+		return compressor!=0;
+		}
 	template <class DataParam>
 	void broadcast(DataParam& data) // Sends single value of arbitrary type from master to all slaves; does not change value on master
 		{
@@ -29,10 +29,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <Misc/ThrowStdErr.h>
+#include <Threads/Profiler.h>
 #include <Cluster/Config.h>
 
 #if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
@@ -113,21 +115,46 @@ Packet* Multiplexer::PipeState::PacketList::pop_front(void)
 	return result;
 	}
 
+bool Multiplexer::PipeState::PacketList::insertSorted(Packet* packet,unsigned int baseStreamPos)
+	{
+	/* Find the insertion position; compare stream positions relative to the base position to handle wrap-around: */
+	unsigned int offset=packet->streamPos-baseStreamPos;
+	Packet* pred=0;
+	Packet* pPtr;
+	for(pPtr=head;pPtr!=0&&pPtr->streamPos-baseStreamPos<offset;pred=pPtr,pPtr=pPtr->succ)
+		;
+	
+	/* Reject duplicate packets: */
+	if(pPtr!=0&&pPtr->streamPos==packet->streamPos)
+		return false;
+	
+	/* Link the packet into the list: */
+	packet->succ=pPtr;
+	if(pred!=0)
+		pred->succ=packet;
+	else
+		head=packet;
+	if(pPtr==0)
+		tail=packet;
+	
+	/* Increase number of packets: */
+	++numPackets;
+	
+	return true;
+	}
+
 /***************************************
 Methods of class Multiplexer::PipeState:
 ***************************************/
 
 Multiplexer::PipeState::PipeState(unsigned int nodeIndex,unsigned int numSlaves)
 	:pipeId(0),
-	 streamPos(0),packetLossMode(false),
+	 streamPos(0),packetLossMode(false),lossGapEnd(0),
 	 headStreamPos(0),
 	 slaveStreamPosOffsets(0),numHeadSlaves(0),
 	 barrierId(0),slaveBarrierIds(0),minSlaveBarrierId(0),
-	 slaveGatherValues(0)
-	 #if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-	 ,
-	 numResentPackets(0),numResentBytes(0)
-	 #endif
+	 slaveGatherValues(0),
+	 slaveGatherBuffers(0)
 	{
 	if(nodeIndex==0)
 		{
@@ -146,6 +173,9 @@ Multiplexer::PipeState::PipeState(unsigned int nodeIndex,unsigned int numSlaves)
 		slaveGatherValues=new unsigned int[numSlaves];
 		for(unsigned int i=0;i<numSlaves;++i)
 			slaveBarrierIds[i]=0;
+		
+		/* Initialize the slave gather buffer array: */
+		slaveGatherBuffers=new GatherBuffer[numSlaves];
 		}
 	}
 
@@ -162,6 +192,9 @@ Multiplexer::PipeState::~PipeState(void)
 	
 	/* Destroy slave gather value array: */
 	delete[] slaveGatherValues;
+	
+	/* Destroy slave gather buffer array: */
+	delete[] slaveGatherBuffers;
 	}
 	}
 
@@ -183,7 +216,8 @@ struct Message // Structure for protocol messages exchanged between master and s
 		ACKNOWLEDGMENT, // Signal that slave has received some stream packets
 		PACKETLOSS, // Signal that slave lost a stream packet
 		BARRIER, // Barrier message sent from slaves to master
-		GATHER // Message conveying a slave's gather value in a gather operation
+		GATHER, // Message conveying a slave's gather value in a gather operation
+		GATHERDATA // Message conveying a fragment of a node's data in a data gather operation
 		};
 	
 	/* Elements: */
@@ -268,8 +302,153 @@ struct GatherMessage:public BarrierMessage
 		}
 	};
 
+struct GatherDataMessage:public BarrierMessage // Message header followed by a fragment of gather data
+	{
+	/* Elements: */
+	public:
+	unsigned int dataSize; // Total size of the sending node's data in bytes
+	unsigned int fragmentOffset; // Offset of the fragment following the message header in the sending node's data
+	
+	/* Constructors and destructors: */
+	GatherDataMessage(unsigned int sNodeIndex,int sMessageId,unsigned int sPipeId,unsigned int sBarrierId,unsigned int sDataSize,unsigned int sFragmentOffset)
+		:BarrierMessage(sNodeIndex,sMessageId,sPipeId,sBarrierId),
+		 dataSize(sDataSize),fragmentOffset(sFragmentOffset)
+		{
+		}
+	};
+
+const size_t gatherFragmentSize=Packet::maxRawPacketSize-sizeof(GatherDataMessage); // Maximum size of a gather data fragment
+
+/****************
+Helper functions:
+****************/
+
+inline size_t getNumGatherFragments(size_t dataSize) // Returns the number of fragments into which a block of gather data is split; empty data is sent as a single empty fragment
+	{
+	return dataSize>0?(dataSize+gatherFragmentSize-1)/gatherFragmentSize:1;
+	}
+
+template <class ValueParam>
+void reduceArrays(unsigned int numNodes,const unsigned char* const* nodeData,const size_t* nodeDataSizes,GatherOperation::OpCode op,std::vector<unsigned char>& result) // Accumulates the arrays contributed by all nodes element-wise
+	{
+	/* Check that all nodes contributed arrays of the same size: */
+	for(unsigned int i=1;i<numNodes;++i)
+		if(nodeDataSizes[i]!=nodeDataSizes[0])
+			{
+			/* Signal the error to all nodes with a result size that cannot match any node's array size: */
+			result.assign(1,0);
+			return;
+			}
+	
+	/* Initialize the result with the master's array: */
+	result.assign(nodeData[0],nodeData[0]+nodeDataSizes[0]);
+	if(result.empty())
+		return;
+	ValueParam* values=reinterpret_cast<ValueParam*>(&result[0]);
+	size_t numValues=nodeDataSizes[0]/sizeof(ValueParam);
+	
+	/* Accumulate the slaves' arrays in node order, so that floating-point results do not depend on message arrival order: */
+	for(unsigned int node=1;node<numNodes;++node)
+		{
+		const ValueParam* nodeValues=reinterpret_cast<const ValueParam*>(nodeData[node]);
+		switch(op)
+			{
+			case GatherOperation::AND:
+				for(size_t i=0;i<numValues;++i)
+					values[i]=values[i]&&nodeValues[i];
+				break;
+			
+			case GatherOperation::OR:
+				for(size_t i=0;i<numValues;++i)
+					values[i]=values[i]||nodeValues[i];
+				break;
+			
+			case GatherOperation::MIN:
+				for(size_t i=0;i<numValues;++i)
+					if(values[i]>nodeValues[i])
+						values[i]=nodeValues[i];
+				break;
+			
+			case GatherOperation::MAX:
+				for(size_t i=0;i<numValues;++i)
+					if(values[i]<nodeValues[i])
+						values[i]=nodeValues[i];
+				break;
+			
+			case GatherOperation::SUM:
+				for(size_t i=0;i<numValues;++i)
+					values[i]+=nodeValues[i];
+				break;
+			
+			case GatherOperation::PRODUCT:
+				for(size_t i=0;i<numValues;++i)
+					values[i]*=nodeValues[i];
+				break;
+			}
+		}
+	}
+
+void concatenateData(unsigned int numNodes,const unsigned char* const* nodeData,const size_t* nodeDataSizes,GatherOperation::OpCode,std::vector<unsigned char>& result) // Concatenates the data contributed by all nodes, preceded by a table of data sizes
+	{
+	/* Write the data size table: */
+	size_t totalSize=numNodes*sizeof(unsigned int);
+	for(unsigned int i=0;i<numNodes;++i)
+		totalSize+=nodeDataSizes[i];
+	result.resize(totalSize);
+	unsigned char* resultPtr=&result[0];
+	for(unsigned int i=0;i<numNodes;++i,resultPtr+=sizeof(unsigned int))
+		{
+		unsigned int size=(unsigned int)nodeDataSizes[i];
+		memcpy(resultPtr,&size,sizeof(unsigned int));
+		}
+	
+	/* Write the data blocks: */
+	for(unsigned int i=0;i<numNodes;++i)
+		{
+		if(nodeDataSizes[i]>0)
+			memcpy(resultPtr,nodeData[i],nodeDataSizes[i]);
+		resultPtr+=nodeDataSizes[i];
+		}
+	}
+
 }
 
+/******************************************
+Methods of class Multiplexer::GatherBuffer:
+******************************************/
+
+void Multiplexer::GatherBuffer::reset(unsigned int newBarrierId,size_t newDataSize)
+	{
+	barrierId=newBarrierId;
+	data.resize(newDataSize);
+	numMissingFragments=(unsigned int)getNumGatherFragments(newDataSize);
+	receivedFragments.assign(numMissingFragments,false);
+	}
+
+bool Multiplexer::GatherBuffer::addFragment(size_t fragmentOffset,const void* fragment,size_t fragmentSize)
+	{
+	/* Check that the fragment fits the buffer's fragment layout: */
+	size_t fragmentIndex=fragmentOffset/gatherFragmentSize;
+	if(fragmentOffset%gatherFragmentSize!=0||fragmentIndex>=receivedFragments.size())
+		return false;
+	size_t expectedFragmentSize=data.size()-fragmentOffset;
+	if(expectedFragmentSize>gatherFragmentSize)
+		expectedFragmentSize=gatherFragmentSize;
+	if(fragmentSize!=expectedFragmentSize)
+		return false;
+	
+	/* Store the fragment if it is new: */
+	if(!receivedFragments[fragmentIndex])
+		{
+		if(fragmentSize>0)
+			memcpy(&data[fragmentOffset],fragment,fragmentSize);
+		receivedFragments[fragmentIndex]=true;
+		--numMissingFragments;
+		}
+	
+	return numMissingFragments==0;
+	}
+
 /****************************
 Methods of class Multiplexer:
 ****************************/
@@ -346,6 +525,10 @@ void Multiplexer::processAcknowledgment(Multiplexer::LockedPipe& pipeState,int s
 				
 				/* Wake up any callers that might be blocking on a full send queue: */
 				pipeState->receiveCond.broadcast();
+				
+				/* All slaves kept up with the stream; increase the send rate: */
+				if(numDiscarded>0)
+					adjustSendRate(false);
 				}
 			}
 		else
@@ -356,10 +539,355 @@ void Multiplexer::processAcknowledgment(Multiplexer::LockedPipe& pipeState,int s
 		}
 	}
 
+unsigned int Multiplexer::receiveDatagrams(unsigned int maxNumDatagrams,void* const* buffers,size_t bufferSize,ssize_t* datagramSizes)
+	{
+	#if CLUSTER_CONFIG_HAVE_MMSG
+	if(useBatchedIO&&maxNumDatagrams>1)
+		{
+		/* Receive as many datagrams as are waiting, blocking only for the first one: */
+		struct iovec iovecs[ioBatchSize];
+		struct mmsghdr messages[ioBatchSize];
+		if(maxNumDatagrams>ioBatchSize)
+			maxNumDatagrams=ioBatchSize;
+		memset(messages,0,maxNumDatagrams*sizeof(struct mmsghdr));
+		for(unsigned int i=0;i<maxNumDatagrams;++i)
+			{
+			iovecs[i].iov_base=buffers[i];
+			iovecs[i].iov_len=bufferSize;
+			messages[i].msg_hdr.msg_iov=&iovecs[i];
+			messages[i].msg_hdr.msg_iovlen=1;
+			}
+		int numReceived=recvmmsg(socketFd,messages,maxNumDatagrams,MSG_WAITFORONE,0);
+		if(numReceived>0)
+			{
+			for(int i=0;i<numReceived;++i)
+				datagramSizes[i]=ssize_t(messages[i].msg_len);
+			return (unsigned int)numReceived;
+			}
+		else if(errno!=ENOSYS)
+			{
+			/* Report the error like a failed single receive: */
+			datagramSizes[0]=-1;
+			return 1;
+			}
+		
+		/* The kernel does not support batched receives; fall back to single receives from now on: */
+		useBatchedIO=false;
+		}
+	#endif
+	
+	/* Receive a single datagram: */
+	datagramSizes[0]=recv(socketFd,buffers[0],bufferSize,0);
+	return 1;
+	}
+
+void Multiplexer::sendDatagrams(unsigned int numDatagrams,void* const* datagrams,const size_t* datagramSizes)
+	{
+	unsigned int numSent=0;
+	
+	#if CLUSTER_CONFIG_HAVE_MMSG
+	if(useBatchedIO&&numDatagrams>1)
+		{
+		/* Send the datagrams in batches: */
+		struct iovec iovecs[ioBatchSize];
+		struct mmsghdr messages[ioBatchSize];
+		while(numSent<numDatagrams)
+			{
+			unsigned int batchSize=numDatagrams-numSent;
+			if(batchSize>ioBatchSize)
+				batchSize=ioBatchSize;
+			memset(messages,0,batchSize*sizeof(struct mmsghdr));
+			for(unsigned int i=0;i<batchSize;++i)
+				{
+				iovecs[i].iov_base=datagrams[numSent+i];
+				iovecs[i].iov_len=datagramSizes[numSent+i];
+				messages[i].msg_hdr.msg_name=otherAddress;
+				messages[i].msg_hdr.msg_namelen=sizeof(sockaddr_in);
+				messages[i].msg_hdr.msg_iov=&iovecs[i];
+				messages[i].msg_hdr.msg_iovlen=1;
+				}
+			int result=sendmmsg(socketFd,messages,batchSize,0);
+			if(result>0)
+				numSent+=(unsigned int)result;
+			else if(errno==ENOSYS)
+				{
+				/* The kernel does not support batched sends; fall back to single sends from now on: */
+				useBatchedIO=false;
+				break;
+				}
+			else
+				{
+				/* Drop the remaining datagrams like failed single sends; the reliability protocol will recover them: */
+				return;
+				}
+			}
+		}
+	#endif
+	
+	/* Send the remaining datagrams one at a time: */
+	for(;numSent<numDatagrams;++numSent)
+		sendto(socketFd,datagrams[numSent],datagramSizes[numSent],0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+	}
+
+void Multiplexer::resendPackets(Multiplexer::LockedPipe& pipeState,unsigned int slaveNodeIndex,unsigned int streamPos,unsigned int packetPos)
+	{
+	/* Find the recently-sent packet starting at the slave's current stream position: */
+	Packet* packet;
+	for(packet=pipeState->packetList.front();packet!=0&&packet->streamPos!=streamPos;packet=packet->succ)
+		;
+	
+	/* Signal a fatal error if the required packet has already been discarded: */
+	if(packet==0)
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Fatal packet loss detected at stream position %u",slaveNodeIndex,streamPos);
+	
+	/* Re-send only the packets inside the gap reported by the slave, or all following packets if the slave did not see the end of the gap: */
+	unsigned int gapSize=packetPos-streamPos;
+	Misc::Time now=Misc::Time::now();
+	bool resent=false;
+	void* datagrams[ioBatchSize];
+	size_t datagramSizes[ioBatchSize];
+	unsigned int numDatagrams=0;
+	{
+	// SocketMutex::Lock socketLock(socketMutex);
+	for(;packet!=0&&(gapSize==0||packet->streamPos-streamPos<gapSize);packet=packet->succ)
+		{
+		/* Skip packets that were just re-sent in response to another slave's packet loss message: */
+		if(now-packet->resendTime<resendSuppressionInterval)
+			{
+			++pipeState->statistics.numSuppressedPackets;
+			continue;
+			}
+		
+		/* Add the packet to the current batch, and send the batch when it is full: */
+		datagrams[numDatagrams]=&packet->pipeId;
+		datagramSizes[numDatagrams]=packet->packetSize+2*sizeof(unsigned int);
+		if(++numDatagrams==ioBatchSize)
+			{
+			sendDatagrams(numDatagrams,datagrams,datagramSizes);
+			numDatagrams=0;
+			}
+		packet->resendTime=now;
+		++pipeState->statistics.numResentPackets;
+		pipeState->statistics.numResentBytes+=packet->packetSize;
+		resent=true;
+		}
+	
+	/* Send the last partial batch: */
+	if(numDatagrams>0)
+		sendDatagrams(numDatagrams,datagrams,datagramSizes);
+	}
+	
+	/* Packet loss indicates congestion; reduce the send rate: */
+	if(resent)
+		adjustSendRate(true);
+	}
+
+void Multiplexer::sendLossMessage(Multiplexer::LockedPipe& pipeState,unsigned int streamPos,unsigned int packetPos)
+	{
+	StreamMessage msg(nodeIndex|0x80000000U,Message::PACKETLOSS,pipeState->pipeId,streamPos,packetPos);
+	{
+	// SocketMutex::Lock socketLock(socketMutex);
+	for(int i=0;i<slaveMessageBurstSize;++i)
+		sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+	}
+	++pipeState->statistics.numLossMessages;
+	}
+
+void Multiplexer::requestLostPackets(Multiplexer::LockedPipe& pipeState,unsigned int gapEnd)
+	{
+	/* Don't request the same gap again until the master had time to re-send it: */
+	Misc::Time now=Misc::Time::now();
+	if(pipeState->packetLossMode&&pipeState->lossGapEnd==gapEnd&&now<pipeState->lossMessageTime+receiveWaitTimeout)
+		return;
+	
+	/* Send negative acknowledgment for the missing stream range to the master: */
+	sendLossMessage(pipeState,pipeState->streamPos,gapEnd);
+	
+	/* Remember the requested range to suppress duplicate loss messages: */
+	pipeState->packetLossMode=true;
+	pipeState->lossGapEnd=gapEnd;
+	pipeState->lossMessageTime=now;
+	}
+
+void Multiplexer::paceSend(size_t packetSize)
+	{
+	Misc::Time now=Misc::Time::now();
+	Misc::Time sendTime;
+	{
+	Threads::Spinlock::Lock pacingLock(pacingMutex);
+	if(maxSendRate<=0.0)
+		return;
+	
+	/* Reserve the next available send slot: */
+	if(nextSendTime<now)
+		nextSendTime=now;
+	sendTime=nextSendTime;
+	nextSendTime.increment(double(packetSize+2*sizeof(unsigned int))/sendRate);
+	}
+	
+	/* Wait until the reserved send slot: */
+	if(sendTime>now)
+		Misc::sleep(sendTime-now);
+	}
+
+void Multiplexer::adjustSendRate(bool packetLoss)
+	{
+	Misc::Time now=Misc::Time::now();
+	Threads::Spinlock::Lock pacingLock(pacingMutex);
+	if(maxSendRate<=0.0)
+		return;
+	
+	if(packetLoss)
+		{
+		/* Halve the send rate, but only once per loss event even if several slaves report it: */
+		if(now-lastRateDecreaseTime>=resendSuppressionInterval)
+			{
+			sendRate*=0.5;
+			if(sendRate<minSendRate)
+				sendRate=minSendRate;
+			lastRateDecreaseTime=now;
+			}
+		}
+	else
+		{
+		/* Additively increase the send rate: */
+		sendRate+=maxSendRate*0.01;
+		if(sendRate>maxSendRate)
+			sendRate=maxSendRate;
+		}
+	}
+
+void Multiplexer::deliverPacket(Multiplexer::LockedPipe& pipeState,Packet* packet)
+	{
+	/* Wake up sleeping receivers if the delivery queue is currently empty: */
+	if(pipeState->packetList.empty())
+		pipeState->receiveCond.signal();
+	
+	/* Append the packet to the pipe state's delivery queue: */
+	pipeState->streamPos+=packet->packetSize;
+	pipeState->packetList.push_back(packet);
+	++pipeState->statistics.numSentPackets;
+	pipeState->statistics.numSentBytes+=packet->packetSize;
+	}
+
+void Multiplexer::sendGatherData(unsigned int sendNodeIndex,unsigned int pipeId,unsigned int barrierId,const void* data,size_t dataSize)
+	{
+	/* Send the data fragments in batches: */
+	unsigned char batchBuffer[ioBatchSize*Packet::maxRawPacketSize];
+	void* datagrams[ioBatchSize];
+	size_t datagramSizes[ioBatchSize];
+	unsigned int numDatagrams=0;
+	size_t numFragments=getNumGatherFragments(dataSize);
+	for(size_t fragmentIndex=0;fragmentIndex<numFragments;++fragmentIndex)
+		{
+		/* Assemble the fragment message: */
+		size_t fragmentOffset=fragmentIndex*gatherFragmentSize;
+		size_t fragmentSize=dataSize-fragmentOffset;
+		if(fragmentSize>gatherFragmentSize)
+			fragmentSize=gatherFragmentSize;
+		unsigned char* datagram=batchBuffer+numDatagrams*Packet::maxRawPacketSize;
+		GatherDataMessage msg(sendNodeIndex,Message::GATHERDATA,pipeId,barrierId,(unsigned int)dataSize,(unsigned int)fragmentOffset);
+		memcpy(datagram,&msg,sizeof(GatherDataMessage));
+		if(fragmentSize>0)
+			memcpy(datagram+sizeof(GatherDataMessage),static_cast<const unsigned char*>(data)+fragmentOffset,fragmentSize);
+		datagrams[numDatagrams]=datagram;
+		datagramSizes[numDatagrams]=sizeof(GatherDataMessage)+fragmentSize;
+		
+		/* Send the batch when it is full: */
+		if(++numDatagrams==ioBatchSize)
+			{
+			sendDatagrams(numDatagrams,datagrams,datagramSizes);
+			numDatagrams=0;
+			}
+		}
+	
+	/* Send the last partial batch: */
+	if(numDatagrams>0)
+		sendDatagrams(numDatagrams,datagrams,datagramSizes);
+	}
+
+void Multiplexer::gatherData(unsigned int pipeId,const void* data,size_t dataSize,Multiplexer::GatherDataCombiner combiner,GatherOperation::OpCode op,std::vector<unsigned char>& result)
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to gather on closed pipe",nodeIndex);
+	
+	/* Bump up barrier ID: */
+	unsigned int nextBarrierId=pipeState->barrierId+1;
+	
+	if(nodeIndex==0)
+		{
+		/* Wait until the data from all slaves has been received: */
+		while(pipeState->minSlaveBarrierId<nextBarrierId)
+			{
+			/* Wait until the next barrier message: */
+			pipeState->barrierCond.wait(pipeState->stateMutex);
+			}
+		
+		/* Mark the gathering operation as completed: */
+		pipeState->barrierId=nextBarrierId;
+		
+		/* Combine the data from all nodes: */
+		std::vector<const unsigned char*> nodeData(numSlaves+1);
+		std::vector<size_t> nodeDataSizes(numSlaves+1);
+		nodeData[0]=static_cast<const unsigned char*>(data);
+		nodeDataSizes[0]=dataSize;
+		for(unsigned int i=0;i<numSlaves;++i)
+			{
+			const std::vector<unsigned char>& slaveData=pipeState->slaveGatherBuffers[i].data;
+			nodeData[i+1]=slaveData.empty()?0:&slaveData[0];
+			nodeDataSizes[i+1]=slaveData.size();
+			}
+		pipeState->gatherResult.barrierId=nextBarrierId;
+		combiner(numSlaves+1,&nodeData[0],&nodeDataSizes[0],op,pipeState->gatherResult.data);
+		
+		/* Send the combined data to all slaves: */
+		sendGatherData(0,pipeId,nextBarrierId,pipeState->gatherResult.data.empty()?0:&pipeState->gatherResult.data[0],pipeState->gatherResult.data.size());
+		
+		/* Reset the pipe's flow control state: */
+		pipeState->headStreamPos=pipeState->streamPos;
+		for(unsigned int i=0;i<numSlaves;++i)
+			pipeState->slaveStreamPosOffsets[i]=0;
+		pipeState->numHeadSlaves=numSlaves;
+		
+		/* Add all packets in the list to the list of free packets: */
+		if(pipeState->packetList.numPackets>0)
+			{
+			{
+			Threads::Spinlock::Lock packetPoolLock(packetPoolMutex);
+			pipeState->packetList.tail->succ=packetPoolHead;
+			packetPoolHead=pipeState->packetList.head;
+			}
+			pipeState->packetList.numPackets=0;
+			pipeState->packetList.head=0;
+			pipeState->packetList.tail=0;
+			}
+		}
+	else
+		{
+		/* Send the data to the master until the combined data is received: */
+		Misc::Time waitTimeout=Misc::Time::now();
+		while(pipeState->barrierId<nextBarrierId)
+			{
+			/* Send all data fragments to master: */
+			sendGatherData(nodeIndex|0x80000000U,pipeId,nextBarrierId,data,dataSize);
+			
+			/* Wait for arrival of the combined data: */
+			waitTimeout+=barrierWaitTimeout;
+			pipeState->barrierCond.timedWait(pipeState->stateMutex,waitTimeout);
+			}
+		}
+	
+	/* Return the combined data: */
+	result=pipeState->gatherResult.data;
+	}
+
 void* Multiplexer::packetHandlingThreadMaster(void)
 	{
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
 	// Threads::Thread::setCancelType(Threads::Thread::CANCEL_ASYNCHRONOUS);
+	Threads::Profiler::setThreadName("Cluster packet handling thread");
 	
 	/* Handle message exchange during multiplexer initialization: */
 	bool* slaveConnecteds=new bool[numSlaves];
@@ -402,371 +930,417 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 	connectionCond.broadcast();
 	}
 	
+	/* Prepare the message buffers for batched receives: */
+	void* messageBuffers[ioBatchSize];
+	for(unsigned int i=0;i<ioBatchSize;++i)
+		messageBuffers[i]=static_cast<unsigned char*>(messageBuffer)+i*Packet::maxRawPacketSize;
+	ssize_t messageSizes[ioBatchSize];
+	
 	/* Handle messages from the slaves: */
 	while(true)
 		{
-		/* Wait for a message from any slave: */
-		ssize_t numBytesReceived=recv(socketFd,messageBuffer,Packet::maxRawPacketSize,0);
-		if(numBytesReceived>0&&size_t(numBytesReceived)>=sizeof(Message))
+		/* Wait for one or more messages from any slaves: */
+		unsigned int numMessages=receiveDatagrams(ioBatchSize,messageBuffers,Packet::maxRawPacketSize,messageSizes);
+		for(unsigned int messageIndex=0;messageIndex<numMessages;++messageIndex)
 			{
-			/* Check that the message is not the echo of a server message: */
-			if(static_cast<Message*>(messageBuffer)->nodeIndex&0x80000000U)
+			void* messageBuffer=messageBuffers[messageIndex];
+			ssize_t numBytesReceived=messageSizes[messageIndex];
+			if(numBytesReceived>0&&size_t(numBytesReceived)>=sizeof(Message))
 				{
-				/* Remove the slave message indicator bit from the message's node index: */
-				unsigned int msgNodeIndex=static_cast<Message*>(messageBuffer)->nodeIndex&0x7fffffffU;
-				
-				switch(static_cast<Message*>(messageBuffer)->messageId)
+				/* Check that the message is not the echo of a server message: */
+				if(static_cast<Message*>(messageBuffer)->nodeIndex&0x80000000U)
 					{
-					case Message::CONNECTION:
-						{
-						/* One slave must have missed the connection establishment packet; send another one: */
-						Message msg(0,Message::CONNECTION);
-						{
-						// SocketMutex::Lock socketLock(socketMutex);
-						sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-						}
-						break;
-						}
+					/* Remove the slave message indicator bit from the message's node index: */
+					unsigned int msgNodeIndex=static_cast<Message*>(messageBuffer)->nodeIndex&0x7fffffffU;
 					
-					case Message::PING:
-						{
-						/* Broadcast a ping reply to all slaves: */
-						Message msg(0,Message::PING);
+					switch(static_cast<Message*>(messageBuffer)->messageId)
 						{
-						// SocketMutex::Lock socketLock(socketMutex);
-						sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-						}
-						break;
-						}
-					
-					case Message::CREATEPIPE1:
-						{
-						CreatePipe1Message* msg=static_cast<CreatePipe1Message*>(messageBuffer);
-						if(size_t(numBytesReceived)>=sizeof(CreatePipe1Message)&&size_t(numBytesReceived)==sizeof(CreatePipe1Message)+msg->idNumParts*sizeof(unsigned int))
+						case Message::CONNECTION:
 							{
-							/* Extract the originating thread's ID from the message: */
-							Threads::Thread::ID senderId(msg->idNumParts,reinterpret_cast<unsigned int*>(msg+1));
-							
-							/* Find the new pipe state corresponding to the thread ID: */
-							PipeState* newPipeState;
+							/* One slave must have missed the connection establishment packet; send another one: */
+							Message msg(0,Message::CONNECTION);
 							{
-							Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
-							NewPipeHasher::Iterator npIt=newPipes.findEntry(senderId);
-							if(npIt.isFinished())
-								{
-								/* If the new pipe state hasn't been created already, do it here: */
-								newPipeState=new PipeState(nodeIndex,numSlaves);
-								
-								/* Add the new pipe state to the new pipe map: */
-								newPipes[senderId]=newPipeState;
-								}
-							else
-								newPipeState=npIt->getDest();
+							// SocketMutex::Lock socketLock(socketMutex);
+							sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
 							}
-							
-							/* Lock the new pipe: */
-							LockedPipe pipeState(newPipeState);
-							
-							/* Check the pipe's barrier state for first-stage completion: */
-							bool sendReply=false;
-							if(pipeState->barrierId<1)
+							break;
+							}
+						
+						case Message::PING:
+							{
+							/* Broadcast a ping reply to all slaves: */
+							Message msg(0,Message::PING);
+							{
+							// SocketMutex::Lock socketLock(socketMutex);
+							sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+							}
+							break;
+							}
+						
+						case Message::CREATEPIPE1:
+							{
+							CreatePipe1Message* msg=static_cast<CreatePipe1Message*>(messageBuffer);
+							if(size_t(numBytesReceived)>=sizeof(CreatePipe1Message)&&size_t(numBytesReceived)==sizeof(CreatePipe1Message)+msg->idNumParts*sizeof(unsigned int))
 								{
-								/* Remember the slave's barrier completion: */
-								pipeState->slaveBarrierIds[msgNodeIndex-1]=1;
+								/* Extract the originating thread's ID from the message: */
+								Threads::Thread::ID senderId(msg->idNumParts,reinterpret_cast<unsigned int*>(msg+1));
 								
-								/* Check if the current barrier is complete: */
-								pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
-								for(unsigned int i=1;i<numSlaves;++i)
-									if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
-										pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
-								if(pipeState->minSlaveBarrierId>=1)
+								/* Find the new pipe state corresponding to the thread ID: */
+								PipeState* newPipeState;
+								{
+								Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
+								NewPipeHasher::Iterator npIt=newPipes.findEntry(senderId);
+								if(npIt.isFinished())
 									{
-									/* Complete the first barrier: */
-									pipeState->barrierId=1;
+									/* If the new pipe state hasn't been created already, do it here: */
+									newPipeState=new PipeState(nodeIndex,numSlaves);
 									
-									/* Assign a pipe ID to the new pipe and store it in the pipe state table: */
-									Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
-									do
-										{
-										++lastPipeId;
-										if(lastPipeId==0x80000000U) // Ensure that pipeId never has the MSB set
-											lastPipeId=1;
-										}
-									while(pipeStateTable.isEntry(lastPipeId));
-									pipeState->pipeId=lastPipeId;
-									pipeStateTable[lastPipeId]=newPipeState;
-									
-									/* Wake up the thread blocked on the new pipe: */
-									pipeState->barrierCond.signal();
-									
-									/* Send a stage-one pipe creation completion message: */
-									sendReply=true;
+									/* Add the new pipe state to the new pipe map: */
+									newPipes[senderId]=newPipeState;
 									}
+								else
+									newPipeState=npIt->getDest();
 								}
-							else
-								{
-								/* One slave must have missed a stage-one pipe creation completion message; send another one: */
-								sendReply=true;
-								}
-							
-							if(sendReply)
-								{
-								CreatePipe1Message* msg2=static_cast<CreatePipe1Message*>(messageBuffer);
-								msg2->nodeIndex=0;
-								msg2->messageId=Message::CREATEPIPE1;
-								msg2->pipeId=pipeState->pipeId;
-								msg2->idNumParts=senderId.getNumParts();
-								for(unsigned int i=0;i<msg2->idNumParts;++i)
-									reinterpret_cast<unsigned int*>(msg2+1)[i]=senderId.getPart(i);
-								{
-								// SocketMutex::Lock socketLock(socketMutex);
-								sendto(socketFd,messageBuffer,sizeof(CreatePipe1Message)+msg2->idNumParts*sizeof(unsigned int),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-								}
-								}
-							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE1 message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::CREATEPIPE2:
-						{
-						if(numBytesReceived==sizeof(PipeMessage))
-							{
-							PipeMessage* msg=static_cast<PipeMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
-								{
-								/* Check the pipe's barrier state for second-stage completion: */
-								if(pipeState->barrierId<2)
+								
+								/* Lock the new pipe: */
+								LockedPipe pipeState(newPipeState);
+								
+								/* Check the pipe's barrier state for first-stage completion: */
+								bool sendReply=false;
+								if(pipeState->barrierId<1)
 									{
 									/* Remember the slave's barrier completion: */
-									pipeState->slaveBarrierIds[msgNodeIndex-1]=2;
+									pipeState->slaveBarrierIds[msgNodeIndex-1]=1;
 									
 									/* Check if the current barrier is complete: */
 									pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
 									for(unsigned int i=1;i<numSlaves;++i)
 										if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
 											pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
-									if(pipeState->minSlaveBarrierId>=2)
+									if(pipeState->minSlaveBarrierId>=1)
 										{
-										/* Complete the second barrier: */
-										pipeState->barrierId=2;
-
+										/* Complete the first barrier: */
+										pipeState->barrierId=1;
+										
+										/* Assign a pipe ID to the new pipe and store it in the pipe state table: */
+										Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
+										do
+											{
+											++lastPipeId;
+											if(lastPipeId==0x80000000U) // Ensure that pipeId never has the MSB set
+												lastPipeId=1;
+											}
+										while(pipeStateTable.isEntry(lastPipeId));
+										pipeState->pipeId=lastPipeId;
+										pipeStateTable[lastPipeId]=newPipeState;
+										
 										/* Wake up the thread blocked on the new pipe: */
 										pipeState->barrierCond.signal();
+										
+										/* Send a stage-one pipe creation completion message: */
+										sendReply=true;
+										}
+									}
+								else
+									{
+									/* One slave must have missed a stage-one pipe creation completion message; send another one: */
+									sendReply=true;
+									}
+								
+								if(sendReply)
+									{
+									CreatePipe1Message* msg2=static_cast<CreatePipe1Message*>(messageBuffer);
+									msg2->nodeIndex=0;
+									msg2->messageId=Message::CREATEPIPE1;
+									msg2->pipeId=pipeState->pipeId;
+									msg2->idNumParts=senderId.getNumParts();
+									for(unsigned int i=0;i<msg2->idNumParts;++i)
+										reinterpret_cast<unsigned int*>(msg2+1)[i]=senderId.getPart(i);
+									{
+									// SocketMutex::Lock socketLock(socketMutex);
+									sendto(socketFd,messageBuffer,sizeof(CreatePipe1Message)+msg2->idNumParts*sizeof(unsigned int),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+									}
+									}
+								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE1 message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
+							}
+						
+						case Message::CREATEPIPE2:
+							{
+							if(numBytesReceived==sizeof(PipeMessage))
+								{
+								PipeMessage* msg=static_cast<PipeMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
+									{
+									/* Check the pipe's barrier state for second-stage completion: */
+									if(pipeState->barrierId<2)
+										{
+										/* Remember the slave's barrier completion: */
+										pipeState->slaveBarrierIds[msgNodeIndex-1]=2;
+										
+										/* Check if the current barrier is complete: */
+										pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
+										for(unsigned int i=1;i<numSlaves;++i)
+											if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
+												pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
+										if(pipeState->minSlaveBarrierId>=2)
+											{
+											/* Complete the second barrier: */
+											pipeState->barrierId=2;
+											
+											/* Wake up the thread blocked on the new pipe: */
+											pipeState->barrierCond.signal();
+											}
 										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE2 message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE2 message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE2 message of wrong size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE2 message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::ACKNOWLEDGMENT:
-						{
-						if(numBytesReceived==sizeof(StreamMessage))
+						
+						case Message::ACKNOWLEDGMENT:
 							{
-							StreamMessage* msg=static_cast<StreamMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(numBytesReceived==sizeof(StreamMessage))
 								{
-								/* Process the acknowledgment packet: */
-								processAcknowledgment(pipeState,msgNodeIndex-1,msg->streamPos);
+								StreamMessage* msg=static_cast<StreamMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
+									{
+									/* Process the acknowledgment packet: */
+									processAcknowledgment(pipeState,msgNodeIndex-1,msg->streamPos);
+									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received ACKNOWLEDGMENT message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received ACKNOWLEDGMENT message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received ACKNOWLEDGMENT message of wrong size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received ACKNOWLEDGMENT message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::PACKETLOSS:
-						{
-						if(numBytesReceived==sizeof(StreamMessage))
+						
+						case Message::PACKETLOSS:
 							{
-							StreamMessage* msg=static_cast<StreamMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(numBytesReceived==sizeof(StreamMessage))
 								{
-								/* Use the stream position reported by the client as positive acknowledgment: */
-								processAcknowledgment(pipeState,msgNodeIndex-1,msg->streamPos);
+								StreamMessage* msg=static_cast<StreamMessage*>(messageBuffer);
 								
-								/* Resend requested packets if there are any; otherwise, do nothing because master is busy: */
-								if(msg->streamPos!=pipeState->streamPos)
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
-									std::cerr<<"Packet loss of "<<msg->packetPos-msg->streamPos<<" bytes from "<<msg->streamPos<<" detected by node "<<msgNodeIndex<<", stream pos is "<<pipeState->streamPos<<", buffer starts at "<<pipeState->headStreamPos<<std::endl;
-									#endif
-									
-									/* Find the recently-sent packet starting at the slave's current stream position: */
-									Packet* packet;
-									for(packet=pipeState->packetList.front();packet!=0&&packet->streamPos!=msg->streamPos;packet=packet->succ)
-										;
-									
-									/* Signal a fatal error if the required packet has already been discarded: */
-									if(packet==0)
-										Misc::throwStdErr("Cluster::Multiplexer: Node %u: Fatal packet loss detected at stream position %u",msgNodeIndex,msg->streamPos);
+									/* Use the stream position reported by the client as positive acknowledgment: */
+									processAcknowledgment(pipeState,msgNodeIndex-1,msg->streamPos);
+									++pipeState->statistics.numLossMessages;
 									
-									{
-									/* Resend all recent packets in order: */
-									// SocketMutex::Lock socketLock(socketMutex);
-									for(;packet!=0;packet=packet->succ)
+									/* Resend requested packets if there are any; otherwise, do nothing because master is busy: */
+									if(msg->streamPos!=pipeState->streamPos)
 										{
-										sendto(socketFd,&packet->pipeId,packet->packetSize+2*sizeof(unsigned int),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-										#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-										++pipeState->numResentPackets;
-										pipeState->numResentBytes+=packet->packetSize;
+										#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
+										std::cerr<<"Packet loss of "<<msg->packetPos-msg->streamPos<<" bytes from "<<msg->streamPos<<" detected by node "<<msgNodeIndex<<", stream pos is "<<pipeState->streamPos<<", buffer starts at "<<pipeState->headStreamPos<<std::endl;
 										#endif
+										
+										/* Resend the packets the slave is missing: */
+										resendPackets(pipeState,msgNodeIndex,msg->streamPos,msg->packetPos);
 										}
 									}
-									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received PACKETLOSS message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received PACKETLOSS message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received PACKETLOSS message of wrong size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received PACKETLOSS message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::BARRIER:
-						{
-						if(numBytesReceived==sizeof(BarrierMessage))
+						
+						case Message::BARRIER:
 							{
-							BarrierMessage* msg=static_cast<BarrierMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(numBytesReceived==sizeof(BarrierMessage))
 								{
-								/* Update the barrier ID array: */
-								if(pipeState->barrierId>=msg->barrierId)
+								BarrierMessage* msg=static_cast<BarrierMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
+									{
+									/* Update the barrier ID array: */
+									if(pipeState->barrierId>=msg->barrierId)
+										{
+										/* One slave must have missed a barrier completion message; send another one: */
+										BarrierMessage msg2(0,Message::BARRIER,msg->pipeId,msg->barrierId);
+										{
+										// SocketMutex::Lock socketLock(socketMutex);
+										sendto(socketFd,&msg2,sizeof(BarrierMessage),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+										}
+										}
+									else
+										{
+										pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
+										
+										/* Check if the current barrier is complete: */
+										pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
+										for(unsigned int i=1;i<numSlaves;++i)
+											if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
+												pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
+										if(pipeState->minSlaveBarrierId>pipeState->barrierId)
+											{
+											/* Wake up thread waiting on barrier: */
+											pipeState->barrierCond.signal();
+											}
+										}
+									}
+								else
 									{
-									/* One slave must have missed a barrier completion message; send another one: */
+									/* One slave must have missed the completion message for a pipe-closing barrier; send another one: */
 									BarrierMessage msg2(0,Message::BARRIER,msg->pipeId,msg->barrierId);
 									{
 									// SocketMutex::Lock socketLock(socketMutex);
 									sendto(socketFd,&msg2,sizeof(BarrierMessage),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
 									}
 									}
-								else
+								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received BARRIER message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
+							}
+						
+						case Message::GATHER:
+							{
+							if(numBytesReceived==sizeof(GatherMessage))
+								{
+								GatherMessage* msg=static_cast<GatherMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
-									
-									/* Check if the current barrier is complete: */
-									pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
-									for(unsigned int i=1;i<numSlaves;++i)
-										if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
-											pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
-									if(pipeState->minSlaveBarrierId>pipeState->barrierId)
+									/* Update the barrier ID array: */
+									if(pipeState->barrierId>=msg->barrierId)
 										{
-										/* Wake up thread waiting on barrier: */
-										pipeState->barrierCond.signal();
+										/* One slave must have missed a gather completion message; send another one: */
+										GatherMessage msg2(0,Message::GATHER,msg->pipeId,msg->barrierId,pipeState->masterGatherValue);
+										{
+										// SocketMutex::Lock socketLock(socketMutex);
+										sendto(socketFd,&msg2,sizeof(GatherMessage),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+										}
+										}
+									else
+										{
+										pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
+										pipeState->slaveGatherValues[msgNodeIndex-1]=msg->value;
+										
+										/* Check if the current gather operation is complete: */
+										pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
+										for(unsigned int i=1;i<numSlaves;++i)
+											if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
+												pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
+										if(pipeState->minSlaveBarrierId>pipeState->barrierId)
+											{
+											/* Wake up thread waiting on barrier: */
+											pipeState->barrierCond.signal();
+											}
 										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received GATHER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								{
-								/* One slave must have missed the completion message for a pipe-closing barrier; send another one: */
-								BarrierMessage msg2(0,Message::BARRIER,msg->pipeId,msg->barrierId);
-								{
-								// SocketMutex::Lock socketLock(socketMutex);
-								sendto(socketFd,&msg2,sizeof(BarrierMessage),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-								}
-								}
+								std::cerr<<"Node "<<nodeIndex<<": received GATHER message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received BARRIER message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::GATHER:
-						{
-						if(numBytesReceived==sizeof(GatherMessage))
+						
+						case Message::GATHERDATA:
 							{
-							GatherMessage* msg=static_cast<GatherMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(size_t(numBytesReceived)>=sizeof(GatherDataMessage)&&msgNodeIndex>=1&&msgNodeIndex<=numSlaves)
 								{
-								/* Update the barrier ID array: */
-								if(pipeState->barrierId>=msg->barrierId)
-									{
-									/* One slave must have missed a gather completion message; send another one: */
-									GatherMessage msg2(0,Message::GATHER,msg->pipeId,msg->barrierId,pipeState->masterGatherValue);
-									{
-									// SocketMutex::Lock socketLock(socketMutex);
-									sendto(socketFd,&msg2,sizeof(GatherMessage),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-									}
-									}
-								else
+								GatherDataMessage* msg=static_cast<GatherDataMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
-									pipeState->slaveGatherValues[msgNodeIndex-1]=msg->value;
-									
-									/* Check if the current gather operation is complete: */
-									pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
-									for(unsigned int i=1;i<numSlaves;++i)
-										if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
-											pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
-									if(pipeState->minSlaveBarrierId>pipeState->barrierId)
+									if(pipeState->barrierId>=msg->barrierId)
 										{
-										/* Wake up thread waiting on barrier: */
-										pipeState->barrierCond.signal();
+										/* One slave must have missed the completion data; send it again once per repeated request: */
+										if(msg->fragmentOffset==0&&pipeState->gatherResult.barrierId==msg->barrierId)
+											sendGatherData(0,msg->pipeId,msg->barrierId,pipeState->gatherResult.data.empty()?0:&pipeState->gatherResult.data[0],pipeState->gatherResult.data.size());
+										}
+									else
+										{
+										/* Add the fragment to the slave's gather buffer: */
+										GatherBuffer& buffer=pipeState->slaveGatherBuffers[msgNodeIndex-1];
+										if(buffer.barrierId!=msg->barrierId)
+											buffer.reset(msg->barrierId,msg->dataSize);
+										if(buffer.addFragment(msg->fragmentOffset,msg+1,size_t(numBytesReceived)-sizeof(GatherDataMessage)))
+											{
+											/* Update the barrier ID array: */
+											pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
+											
+											/* Check if the current gather operation is complete: */
+											pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
+											for(unsigned int i=1;i<numSlaves;++i)
+												if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
+													pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
+											if(pipeState->minSlaveBarrierId>pipeState->barrierId)
+												{
+												/* Wake up thread waiting on barrier: */
+												pipeState->barrierCond.signal();
+												}
+											}
 										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received GATHERDATA message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received GATHER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received malformed GATHERDATA message of size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received GATHER message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
 						}
 					}
 				}
+			#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+			else
+				std::cerr<<"Node "<<nodeIndex<<": received short message of size "<<numBytesReceived<<std::endl;
+			#endif
 			}
-		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-		else
-			std::cerr<<"Node "<<nodeIndex<<": received short message of size "<<numBytesReceived<<std::endl;
-		#endif
 		}
 	
 	return 0;
@@ -776,6 +1350,7 @@ void* Multiplexer::packetHandlingThreadSlave(void)
 	{
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
 	// Threads::Thread::setCancelType(Threads::Thread::CANCEL_ASYNCHRONOUS);
+	Threads::Profiler::setThreadName("Cluster packet handling thread");
 	
 	/* Set the MSB on the nodeIndex to identify a slave-originating message: */
 	unsigned int sendNodeIndex=nodeIndex|0x80000000U;
@@ -833,216 +1408,272 @@ void* Multiplexer::packetHandlingThreadSlave(void)
 			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Communication error",nodeIndex);
 			}
 		
-		/* Read the waiting packet: */
-		ssize_t numBytesReceived=recv(socketFd,&slaveThreadPacket->pipeId,Packet::maxRawPacketSize,0);
-		if(numBytesReceived<0)
-			{
-			/* Try to recover from this error: */
-			#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-			std::cerr<<"Node "<<nodeIndex<<": Error "<<errno<<" on receive, slaveThreadPacket="<<slaveThreadPacket<<std::endl;
-			#endif
-			delete slaveThreadPacket;
-			slaveThreadPacket=newPacket();
-			}
-		else if(size_t(numBytesReceived)>=2*sizeof(unsigned int))
+		/* Read the waiting packet and any packets that arrived right after it: */
+		void* packetBuffers[ioBatchSize];
+		for(unsigned int i=0;i<ioBatchSize;++i)
+			packetBuffers[i]=&slaveThreadPackets[i]->pipeId;
+		ssize_t packetSizes[ioBatchSize];
+		unsigned int numPackets=receiveDatagrams(ioBatchSize,packetBuffers,Packet::maxRawPacketSize,packetSizes);
+		for(unsigned int packetIndex=0;packetIndex<numPackets;++packetIndex)
 			{
-			slaveThreadPacket->packetSize=size_t(numBytesReceived-2*sizeof(unsigned int));
-			
-			if(slaveThreadPacket->pipeId==0)
+			/* Process the packet in place; the packet handling code replaces packets that are handed off to a pipe: */
+			Packet*& slaveThreadPacket=slaveThreadPackets[packetIndex];
+			ssize_t numBytesReceived=packetSizes[packetIndex];
+			if(numBytesReceived<0)
+				{
+				/* Try to recover from this error: */
+				#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+				std::cerr<<"Node "<<nodeIndex<<": Error "<<errno<<" on receive, slaveThreadPacket="<<slaveThreadPacket<<std::endl;
+				#endif
+				delete slaveThreadPacket;
+				slaveThreadPacket=newPacket();
+				}
+			else if(size_t(numBytesReceived)>=2*sizeof(unsigned int))
 				{
-				/* It's a message for the pipe multiplexer itself: */
-				void* messageBuffer=&slaveThreadPacket->pipeId;
-				switch(static_cast<Message*>(messageBuffer)->messageId)
+				slaveThreadPacket->packetSize=size_t(numBytesReceived-2*sizeof(unsigned int));
+				
+				if(slaveThreadPacket->pipeId==0)
 					{
-					case Message::CONNECTION:
-						/* Signal connection establishment: */
+					/* It's a message for the pipe multiplexer itself: */
+					void* messageBuffer=&slaveThreadPacket->pipeId;
+					switch(static_cast<Message*>(messageBuffer)->messageId)
 						{
-						Threads::MutexCond::Lock connectionCondLock(connectionCond);
-						if(!connected)
+						case Message::CONNECTION:
+							/* Signal connection establishment: */
 							{
-							connected=true;
-							connectionCond.broadcast();
+							Threads::MutexCond::Lock connectionCondLock(connectionCond);
+							if(!connected)
+								{
+								connected=true;
+								connectionCond.broadcast();
+								}
 							}
-						}
-						break;
-					
-					case Message::PING:
-						/* Just ignore the packet... */
-						break;
-					
-					case Message::CREATEPIPE1:
-						{
-						CreatePipe1Message* msg=static_cast<CreatePipe1Message*>(messageBuffer);
-						if(size_t(numBytesReceived)>=sizeof(CreatePipe1Message)&&size_t(numBytesReceived)==sizeof(CreatePipe1Message)+msg->idNumParts*sizeof(unsigned int))
-							{
+							break;
+						
+						case Message::PING:
+							/* Just ignore the packet... */
+							break;
+						
+						case Message::CREATEPIPE1:
 							{
-							Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
-							
-							/* Check if the pipe is not yet in the pipe state table: */
-							if(!pipeStateTable.isEntry(msg->pipeId))
+							CreatePipe1Message* msg=static_cast<CreatePipe1Message*>(messageBuffer);
+							if(size_t(numBytesReceived)>=sizeof(CreatePipe1Message)&&size_t(numBytesReceived)==sizeof(CreatePipe1Message)+msg->idNumParts*sizeof(unsigned int))
 								{
-								/* Extract the originating thread's ID from the message: */
-								Threads::Thread::ID senderId(msg->idNumParts,reinterpret_cast<unsigned int*>(msg+1));
-								
-								/* Find the new pipe state corresponding to the thread ID: */
-								NewPipeHasher::Iterator npIt=newPipes.findEntry(senderId);
-								PipeState* newPipeState=npIt->getDest();
+								{
+								Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
 								
-								/* Remove the new pipe state from the new pipe map and insert it into the pipe state table: */
-								newPipes.removeEntry(npIt);
-								pipeStateTable[msg->pipeId]=newPipeState;
+								/* Check if the pipe is not yet in the pipe state table: */
+								if(!pipeStateTable.isEntry(msg->pipeId))
+									{
+									/* Extract the originating thread's ID from the message: */
+									Threads::Thread::ID senderId(msg->idNumParts,reinterpret_cast<unsigned int*>(msg+1));
+									
+									/* Find the new pipe state corresponding to the thread ID: */
+									NewPipeHasher::Iterator npIt=newPipes.findEntry(senderId);
+									PipeState* newPipeState=npIt->getDest();
+									
+									/* Remove the new pipe state from the new pipe map and insert it into the pipe state table: */
+									newPipes.removeEntry(npIt);
+									pipeStateTable[msg->pipeId]=newPipeState;
+									
+									/* Signal pipe creation completion: */
+									{
+									Threads::Mutex::Lock pipeStateLock(newPipeState->stateMutex);
+									newPipeState->pipeId=msg->pipeId;
+									newPipeState->barrierId=2;
+									newPipeState->barrierCond.signal();
+									}
+									}
+								}
 								
-								/* Signal pipe creation completion: */
+								/* Send a stage-two pipe creation message to the master: */
+								PipeMessage msg2(sendNodeIndex,Message::CREATEPIPE2,msg->pipeId);
 								{
-								Threads::Mutex::Lock pipeStateLock(newPipeState->stateMutex);
-								newPipeState->pipeId=msg->pipeId;
-								newPipeState->barrierId=2;
-								newPipeState->barrierCond.signal();
+								// SocketMutex::Lock socketLock(socketMutex);
+								for(int i=0;i<slaveMessageBurstSize;++i)
+									sendto(socketFd,&msg2,sizeof(PipeMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
 								}
 								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE1 message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
 							}
-							
-							/* Send a stage-two pipe creation message to the master: */
-							PipeMessage msg2(sendNodeIndex,Message::CREATEPIPE2,msg->pipeId);
+						
+						case Message::BARRIER:
 							{
-							// SocketMutex::Lock socketLock(socketMutex);
-							for(int i=0;i<slaveMessageBurstSize;++i)
-								sendto(socketFd,&msg2,sizeof(PipeMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
-							}
+							if(numBytesReceived==sizeof(BarrierMessage))
+								{
+								BarrierMessage* msg=static_cast<BarrierMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
+									{
+									/* Signal barrier completion if the completion message is for the current barrier: */
+									if(pipeState->barrierId<msg->barrierId)
+										{
+										pipeState->barrierId=msg->barrierId;
+										pipeState->barrierCond.signal();
+										}
+									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received BARRIER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
+								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received BARRIER message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE1 message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::BARRIER:
-						{
-						if(numBytesReceived==sizeof(BarrierMessage))
+						
+						case Message::GATHER:
 							{
-							BarrierMessage* msg=static_cast<BarrierMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(numBytesReceived==sizeof(GatherMessage))
 								{
-								/* Signal barrier completion if the completion message is for the current barrier: */
-								if(pipeState->barrierId<msg->barrierId)
+								GatherMessage* msg=static_cast<GatherMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									pipeState->barrierId=msg->barrierId;
-									pipeState->barrierCond.signal();
+									/* Signal barrier completion if the completion message is for the current barrier: */
+									if(pipeState->barrierId<msg->barrierId)
+										{
+										pipeState->barrierId=msg->barrierId;
+										pipeState->masterGatherValue=msg->value;
+										pipeState->barrierCond.signal();
+										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received GATHER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received BARRIER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received GATHER message of wrong size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received BARRIER message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::GATHER:
-						{
-						if(numBytesReceived==sizeof(GatherMessage))
+						
+						case Message::GATHERDATA:
 							{
-							GatherMessage* msg=static_cast<GatherMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(size_t(numBytesReceived)>=sizeof(GatherDataMessage))
 								{
-								/* Signal barrier completion if the completion message is for the current barrier: */
-								if(pipeState->barrierId<msg->barrierId)
+								GatherDataMessage* msg=static_cast<GatherDataMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									pipeState->barrierId=msg->barrierId;
-									pipeState->masterGatherValue=msg->value;
-									pipeState->barrierCond.signal();
+									/* Add the fragment to the completion data if it is for the current gather operation: */
+									if(pipeState->barrierId+1==msg->barrierId)
+										{
+										if(pipeState->gatherResult.barrierId!=msg->barrierId)
+											pipeState->gatherResult.reset(msg->barrierId,msg->dataSize);
+										if(pipeState->gatherResult.addFragment(msg->fragmentOffset,msg+1,size_t(numBytesReceived)-sizeof(GatherDataMessage)))
+											{
+											/* Signal completion of the gather operation: */
+											pipeState->barrierId=msg->barrierId;
+											pipeState->barrierCond.signal();
+											}
+										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received GATHERDATA message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received GATHER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received malformed GATHERDATA message of size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received GATHER message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
 						}
 					}
-				}
-			else
-				{
-				/* Get a handle on the state object of the pipe the packet is meant for: */
-				LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,slaveThreadPacket->pipeId);
-				
-				if(pipeState.isValid())
+				else
 					{
-					/* Check if the received packet is the next expected one: */
-					if(pipeState->streamPos==slaveThreadPacket->streamPos)
-						{
-						/* Disable packet loss mode: */
-						pipeState->packetLossMode=false;
-						
-						++sendAckIn;
-						if(sendAckIn==numSlaves)
-							{
-							/* Send positive acknowledgment to the master: */
-							StreamMessage msg(sendNodeIndex,Message::ACKNOWLEDGMENT,slaveThreadPacket->pipeId,pipeState->streamPos,slaveThreadPacket->streamPos);
-							{
-							// SocketMutex::Lock socketLock(socketMutex);
-							sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
-							}
-							sendAckIn=0;
-							}
-						
-						/* Wake up sleeping receivers if the delivery queue is currently empty: */
-						if(pipeState->packetList.empty())
-							pipeState->receiveCond.signal();
-						
-						/* Append the packet to the pipe state's delivery queue: */
-						pipeState->streamPos+=slaveThreadPacket->packetSize;
-						pipeState->packetList.push_back(slaveThreadPacket);
-						
-						/* Get a new packet: */
-						slaveThreadPacket=newPacket();
-						}
-					else
+					/* Get a handle on the state object of the pipe the packet is meant for: */
+					LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,slaveThreadPacket->pipeId);
+					
+					if(pipeState.isValid())
 						{
-						/* Check if there is data missing between the packet's stream position and the pipe's stream position; watch for stream position wrap-around: */
-						if(!pipeState->packetLossMode&&slaveThreadPacket->streamPos-pipeState->streamPos<=0x80000000U)
+						/* Check if the received packet is the next expected one: */
+						if(pipeState->streamPos==slaveThreadPacket->streamPos)
 							{
-							/* At least one packet must have been lost; send negative acknowledgment to the master: */
-							StreamMessage msg(sendNodeIndex,Message::PACKETLOSS,slaveThreadPacket->pipeId,pipeState->streamPos,slaveThreadPacket->streamPos);
-							{
-							// SocketMutex::Lock socketLock(socketMutex);
-							for(int i=0;i<slaveMessageBurstSize;++i)
+							/* Append the packet to the pipe state's delivery queue and get a new packet: */
+							deliverPacket(pipeState,slaveThreadPacket);
+							slaveThreadPacket=newPacket();
+							
+							/* Deliver all held-back packets that are now in order, and discard stale duplicates: */
+							while(!pipeState->outOfOrderList.empty())
+								{
+								Packet* front=pipeState->outOfOrderList.front();
+								if(front->streamPos==pipeState->streamPos)
+									deliverPacket(pipeState,pipeState->outOfOrderList.pop_front());
+								else if(front->streamPos-pipeState->streamPos>=0x80000000U)
+									deletePacket(pipeState->outOfOrderList.pop_front());
+								else
+									break;
+								}
+							
+							if(pipeState->outOfOrderList.empty())
+								{
+								/* Disable packet loss mode: */
+								pipeState->packetLossMode=false;
+								}
+							else
+								{
+								/* There is another gap in front of the held-back packets; request the missing range from the master if it wasn't requested already: */
+								requestLostPackets(pipeState,pipeState->outOfOrderList.front()->streamPos);
+								}
+							
+							++sendAckIn;
+							if(sendAckIn>=numSlaves)
+								{
+								/* Send positive acknowledgment to the master: */
+								StreamMessage msg(sendNodeIndex,Message::ACKNOWLEDGMENT,pipeState->pipeId,pipeState->streamPos,pipeState->streamPos);
+								{
+								// SocketMutex::Lock socketLock(socketMutex);
 								sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+								}
+								sendAckIn=0;
+								}
 							}
-
-							/* Enable packet loss mode to prohibit sending further loss messages until the missing packet arrives: */
-							pipeState->packetLossMode=true;
+						else if(slaveThreadPacket->streamPos-pipeState->streamPos<0x80000000U)
+							{
+							/* At least one packet must have been lost; hold back the early packet unless the hold-back list is full: */
+							unsigned int packetStreamPos=slaveThreadPacket->streamPos;
+							if(pipeState->outOfOrderList.size()<sendBufferSize&&pipeState->outOfOrderList.insertSorted(slaveThreadPacket,pipeState->streamPos))
+								{
+								++pipeState->statistics.numOutOfOrderPackets;
+								slaveThreadPacket=newPacket();
+								}
+							
+							/* Request the missing stream range from the master unless it was requested already: */
+							unsigned int gapEnd=pipeState->outOfOrderList.empty()?packetStreamPos:pipeState->outOfOrderList.front()->streamPos;
+							requestLostPackets(pipeState,gapEnd);
 							}
 						}
+					#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+					else
+						std::cerr<<"Node "<<nodeIndex<<": received stream packet for non-existent pipe "<<slaveThreadPacket->pipeId<<std::endl;
+					#endif
 					}
-				#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-				else
-					std::cerr<<"Node "<<nodeIndex<<": received stream packet for non-existent pipe "<<slaveThreadPacket->pipeId<<std::endl;
-				#endif
 				}
+			#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+			else
+				std::cerr<<"Node "<<nodeIndex<<": received short message of size "<<numBytesReceived<<std::endl;
+			#endif
 			}
-		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-		else
-			std::cerr<<"Node "<<nodeIndex<<": received short message of size "<<numBytesReceived<<std::endl;
-		#endif
 		}
 	
 	return 0;
@@ -1052,19 +1683,22 @@ Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::st
 	:numSlaves(sNumSlaves),nodeIndex(sNodeIndex),
 	 masterAddress(new sockaddr_in),
 	 otherAddress(new sockaddr_in),
-	 socketFd(0),
+	 socketFd(0),useBatchedIO(true),
 	 connected(false),
 	 newPipes(17),
 	 lastPipeId(0),
 	 pipeStateTable(17),
 	 messageBuffer(0),
-	 slaveThreadPacket(0),
+	 slaveThreadPackets(0),
 	 masterMessageBurstSize(1),slaveMessageBurstSize(1),
 	 connectionWaitTimeout(0.5),
 	 pingTimeout(10.0),maxPingRequests(3),
 	 receiveWaitTimeout(0.25),
 	 barrierWaitTimeout(0.1),
 	 sendBufferSize(20),
+	 resendSuppressionInterval(0.005),
+	 minSendRate(0.0),maxSendRate(0.0),sendRate(0.0),
+	 nextSendTime(0,0),lastRateDecreaseTime(0,0),
 	 packetPoolHead(0)
 	{
 	/* Lookup master's IP address: */
@@ -1165,12 +1799,14 @@ Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::st
 	/* Create the packet handling thread: */
 	if(nodeIndex==0)
 		{
-		messageBuffer=new unsigned char[Packet::maxRawPacketSize];
+		messageBuffer=new unsigned char[ioBatchSize*Packet::maxRawPacketSize];
 		packetHandlingThread.start(this,&Multiplexer::packetHandlingThreadMaster);
 		}
 	else
 		{
-		slaveThreadPacket=newPacket();
+		slaveThreadPackets=new Packet*[ioBatchSize];
+		for(unsigned int i=0;i<ioBatchSize;++i)
+			slaveThreadPackets[i]=newPacket();
 		packetHandlingThread.start(this,&Multiplexer::packetHandlingThreadSlave);
 		}
 	}
@@ -1181,8 +1817,13 @@ Multiplexer::~Multiplexer(void)
 	packetHandlingThread.cancel();
 	packetHandlingThread.join();
 	
-	/* Delete the packet handling thread's receive packet: */
-	delete slaveThreadPacket;
+	/* Delete the packet handling thread's receive packets: */
+	if(slaveThreadPackets!=0)
+		{
+		for(unsigned int i=0;i<ioBatchSize;++i)
+			delete slaveThreadPackets[i];
+		delete[] slaveThreadPackets;
+		}
 	delete[] static_cast<unsigned char*>(messageBuffer);
 	
 	/* Close all leftover pipes: */
@@ -1248,6 +1889,28 @@ void Multiplexer::setSendBufferSize(unsigned int newSendBufferSize)
 	sendBufferSize=newSendBufferSize;
 	}
 
+void Multiplexer::setResendSuppressionInterval(Misc::Time newResendSuppressionInterval)
+	{
+	resendSuppressionInterval=newResendSuppressionInterval;
+	}
+
+void Multiplexer::setSendRateLimits(double newMinSendRate,double newMaxSendRate)
+	{
+	Threads::Spinlock::Lock pacingLock(pacingMutex);
+	maxSendRate=newMaxSendRate>0.0?newMaxSendRate:0.0;
+	minSendRate=newMinSendRate<maxSendRate?newMinSendRate:maxSendRate;
+	if(minSendRate<0.0)
+		minSendRate=0.0;
+	
+	/* Start at the maximum send rate and back off on packet loss: */
+	sendRate=maxSendRate;
+	}
+
+void Multiplexer::setBatchedIO(bool newBatchedIO)
+	{
+	useBatchedIO=newBatchedIO;
+	}
+
 void Multiplexer::waitForConnection(void)
 	{
 	{
@@ -1407,11 +2070,12 @@ void Multiplexer::closePipe(unsigned int pipeId)
 	if(nodeIndex==0)
 		{
 		std::cerr<<"Closing pipe "<<pipeId;
-		std::cerr<<". Re-sent "<<pipeState->numResentPackets<<" packets, "<<pipeState->numResentBytes<<" bytes"<<std::endl;
+		std::cerr<<". Re-sent "<<pipeState->statistics.numResentPackets<<" packets, "<<pipeState->statistics.numResentBytes<<" bytes";
+		std::cerr<<", suppressed "<<pipeState->statistics.numSuppressedPackets<<" re-sends"<<std::endl;
 		}
 	#endif
 	
-	/* Add all packets in the list to the list of free packets: */
+	/* Add all packets in the lists to the list of free packets: */
 	{
 	Threads::Mutex::Lock pipeStateLock(pipeState->stateMutex);
 	if(pipeState->packetList.numPackets>0)
@@ -1425,12 +2089,39 @@ void Multiplexer::closePipe(unsigned int pipeId)
 		pipeState->packetList.head=0;
 		pipeState->packetList.tail=0;
 		}
+	if(pipeState->outOfOrderList.numPackets>0)
+		{
+		{
+		Threads::Spinlock::Lock packetPoolLock(packetPoolMutex);
+		pipeState->outOfOrderList.tail->succ=packetPoolHead;
+		packetPoolHead=pipeState->outOfOrderList.head;
+		}
+		pipeState->outOfOrderList.numPackets=0;
+		pipeState->outOfOrderList.head=0;
+		pipeState->outOfOrderList.tail=0;
+		}
 	}
 	
 	/* Destroy the pipe state: */
 	delete pipeState;
 	}
 
+Multiplexer::PipeStatistics Multiplexer::getPipeStatistics(unsigned int pipeId)
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to query closed pipe",nodeIndex);
+	
+	return pipeState->statistics;
+	}
+
+double Multiplexer::getSendRate(void)
+	{
+	Threads::Spinlock::Lock pacingLock(pacingMutex);
+	return sendRate;
+	}
+
 void Multiplexer::sendPacket(unsigned int pipeId,Packet* packet)
 	{
 	/* Get a handle on the state object for the given pipe: */
@@ -1455,12 +2146,18 @@ void Multiplexer::sendPacket(unsigned int pipeId,Packet* packet)
 	/* Append the packet to the pipe's "recently sent" list: */
 	packet->pipeId=pipeId;
 	packet->streamPos=pipeState->streamPos;
+	packet->resendTime=Misc::Time(0,0);
 	pipeState->streamPos+=packet->packetSize;
 	pipeState->packetList.push_back(packet);
+	++pipeState->statistics.numSentPackets;
+	pipeState->statistics.numSentBytes+=packet->packetSize;
 	
 	/* It's safe to unlock the pipe state now: */
 	pipeState.unlock();
 	
+	/* Wait for the next send slot if send rate pacing is enabled: */
+	paceSend(packet->packetSize);
+	
 	/* Send the packet across the UDP connection: */
 	{
 	// SocketMutex::Lock socketLock(socketMutex);
@@ -1487,13 +2184,12 @@ Packet* Multiplexer::receivePacket(unsigned int pipeId)
 			if(!pipeState->packetList.empty())
 				break;
 			
-			/* Send a packet loss message to the master, just to be sure: */
-			StreamMessage msg(nodeIndex|0x80000000U,Message::PACKETLOSS,pipeId,pipeState->streamPos,pipeState->streamPos);
-			{
-			// SocketMutex::Lock socketLock(socketMutex);
-			for(int i=0;i<slaveMessageBurstSize;++i)
-				sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
-			}
+			/* Send a packet loss message to the master, just to be sure; include the end of the gap if there are held-back packets: */
+			unsigned int gapEnd=pipeState->outOfOrderList.empty()?pipeState->streamPos:pipeState->outOfOrderList.front()->streamPos;
+			sendLossMessage(pipeState,pipeState->streamPos,gapEnd);
+			pipeState->packetLossMode=true;
+			pipeState->lossGapEnd=gapEnd;
+			pipeState->lossMessageTime=Misc::Time::now();
 			}
 		}
 	
@@ -1503,6 +2199,8 @@ Packet* Multiplexer::receivePacket(unsigned int pipeId)
 
 void Multiplexer::barrier(unsigned int pipeId)
 	{
+	THREADS_PROFILE_ZONE("Cluster::Multiplexer::barrier");
+	
 	/* Get a handle on the state object for the given pipe: */
 	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
 	if(!pipeState.isValid())
@@ -1571,6 +2269,8 @@ void Multiplexer::barrier(unsigned int pipeId)
 
 unsigned int Multiplexer::gather(unsigned int pipeId,unsigned int value,GatherOperation::OpCode op)
 	{
+	THREADS_PROFILE_ZONE("Cluster::Multiplexer::gather");
+	
 	/* Get a handle on the state object for the given pipe: */
 	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
 	if(!pipeState.isValid())
@@ -1677,4 +2377,61 @@ unsigned int Multiplexer::gather(unsigned int pipeId,unsigned int value,GatherOp
 	return pipeState->masterGatherValue;
 	}
 
+void Multiplexer::allReduce(unsigned int pipeId,int* values,size_t numValues,GatherOperation::OpCode op)
+	{
+	/* Exchange the arrays and copy the accumulated result: */
+	std::vector<unsigned char> result;
+	gatherData(pipeId,values,numValues*sizeof(int),reduceArrays<int>,op,result);
+	if(result.size()!=numValues*sizeof(int))
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Mismatching array sizes in allReduce",nodeIndex);
+	if(numValues>0)
+		memcpy(values,&result[0],result.size());
+	}
+
+void Multiplexer::allReduce(unsigned int pipeId,float* values,size_t numValues,GatherOperation::OpCode op)
+	{
+	/* Exchange the arrays and copy the accumulated result: */
+	std::vector<unsigned char> result;
+	gatherData(pipeId,values,numValues*sizeof(float),reduceArrays<float>,op,result);
+	if(result.size()!=numValues*sizeof(float))
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Mismatching array sizes in allReduce",nodeIndex);
+	if(numValues>0)
+		memcpy(values,&result[0],result.size());
+	}
+
+void Multiplexer::allReduce(unsigned int pipeId,double* values,size_t numValues,GatherOperation::OpCode op)
+	{
+	/* Exchange the arrays and copy the accumulated result: */
+	std::vector<unsigned char> result;
+	gatherData(pipeId,values,numValues*sizeof(double),reduceArrays<double>,op,result);
+	if(result.size()!=numValues*sizeof(double))
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Mismatching array sizes in allReduce",nodeIndex);
+	if(numValues>0)
+		memcpy(values,&result[0],result.size());
+	}
+
+void Multiplexer::allGather(unsigned int pipeId,const void* data,size_t dataSize,std::vector<std::vector<unsigned char> >& nodeData)
+	{
+	/* Exchange the data blocks: */
+	std::vector<unsigned char> result;
+	gatherData(pipeId,data,dataSize,concatenateData,GatherOperation::AND,result);
+	
+	/* Split the concatenated data blocks according to the data size table: */
+	unsigned int numNodes=numSlaves+1;
+	if(result.size()<numNodes*sizeof(unsigned int))
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Malformed allGather result",nodeIndex);
+	nodeData.resize(numNodes);
+	const unsigned char* sizePtr=&result[0];
+	size_t dataOffset=numNodes*sizeof(unsigned int);
+	for(unsigned int i=0;i<numNodes;++i,sizePtr+=sizeof(unsigned int))
+		{
+		unsigned int size;
+		memcpy(&size,sizePtr,sizeof(unsigned int));
+		if(result.size()-dataOffset<size)
+			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Malformed allGather result",nodeIndex);
+		nodeData[i].assign(result.begin()+dataOffset,result.begin()+(dataOffset+size));
+		dataOffset+=size;
+		}
+	}
+
 }
@@ -23,7 +23,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef CLUSTER_MULTIPLEXER_INCLUDED
 #define CLUSTER_MULTIPLEXER_INCLUDED
 
+#include <sys/types.h>
 #include <string>
+#include <vector>
 #include <Misc/HashTable.h>
 #include <Misc/Time.h>
 #include <Threads/Thread.h>
@@ -43,7 +45,51 @@ namespace Cluster {
 class Multiplexer
 	{
 	/* Embedded classes: */
+	public:
+	struct PipeStatistics // Structure holding communication counters for a pipe
+		{
+		/* Elements: */
+		public:
+		size_t numSentPackets; // Number of packets sent (master) or delivered (slaves) on the pipe
+		size_t numSentBytes; // Number of payload bytes sent (master) or delivered (slaves) on the pipe
+		size_t numResentPackets; // Number of packets re-sent in response to packet loss messages (master only)
+		size_t numResentBytes; // Number of payload bytes re-sent in response to packet loss messages (master only)
+		size_t numSuppressedPackets; // Number of requested re-sends that were suppressed because the packet had just been re-sent (master only)
+		size_t numLossMessages; // Number of packet loss messages received (master) or sent (slaves)
+		size_t numOutOfOrderPackets; // Number of packets that arrived ahead of a gap in the stream and were held back (slaves only)
+		
+		/* Constructors and destructors: */
+		PipeStatistics(void) // Creates zeroed counters
+			:numSentPackets(0),numSentBytes(0),
+			 numResentPackets(0),numResentBytes(0),numSuppressedPackets(0),
+			 numLossMessages(0),numOutOfOrderPackets(0)
+			{
+			}
+		};
+	
 	private:
+	struct GatherBuffer // Structure to reassemble the data of a data gather operation from fragment messages
+		{
+		/* Elements: */
+		public:
+		unsigned int barrierId; // ID of the gather operation whose data is stored in the buffer
+		std::vector<unsigned char> data; // The gathered data
+		std::vector<bool> receivedFragments; // Flags for the data fragments that have already been received
+		unsigned int numMissingFragments; // Number of data fragments that have not been received yet
+		
+		/* Constructors and destructors: */
+		GatherBuffer(void) // Creates an empty buffer
+			:barrierId(0),numMissingFragments(0)
+			{
+			}
+		
+		/* Methods: */
+		void reset(unsigned int newBarrierId,size_t newDataSize); // Prepares the buffer to receive the given amount of data for the given gather operation
+		bool addFragment(size_t fragmentOffset,const void* fragment,size_t fragmentSize); // Adds a received data fragment; returns true if all data has been received
+		};
+	
+	typedef void (*GatherDataCombiner)(unsigned int numNodes,const unsigned char* const* nodeData,const size_t* nodeDataSizes,GatherOperation::OpCode op,std::vector<unsigned char>& result); // Type for functions combining the data contributed by all nodes to a data gather operation on the master
+	
 	struct PipeState // Structure storing the current state of a pipe
 		{
 		/* Embedded classes: */
@@ -79,6 +125,7 @@ class Multiplexer
 				}
 			void push_back(Packet* packet); // Pushes the given packet on the back of the list
 			Packet* pop_front(void); // Removes the packet at the front of the list and returns pointer to it
+			bool insertSorted(Packet* packet,unsigned int baseStreamPos); // Inserts the given packet in order of stream position relative to the given base position; returns false if a packet of the same stream position is already in the list
 			};
 		
 		/* Elements: */
@@ -89,7 +136,10 @@ class Multiplexer
 		Threads::Cond barrierCond; // Condition variable all nodes wait on while processing a barrier
 		unsigned int streamPos; // Total amount of bytes that has been sent/received on this pipe so far
 		bool packetLossMode; // True if the pipe is currently recovering from lost data
+		unsigned int lossGapEnd; // End of the stream range most recently requested in a packet loss message (on the slave side)
+		Misc::Time lossMessageTime; // Time at which the most recent packet loss message was sent (on the slave side)
 		PacketList packetList; // List of packets to be delivered to readers (on the slave side) or recently sent (on the master side)
+		PacketList outOfOrderList; // List of packets that arrived after a gap in the stream, sorted by stream position (on the slave side)
 		unsigned int headStreamPos; // Stream position currently at the head of the packet list
 		unsigned int* slaveStreamPosOffsets; // Array of stream positions of the slaves relative to beginning of packet list
 		unsigned int numHeadSlaves; // Number of slaves that still have not acknowledged the first packet in the packet list
@@ -98,10 +148,9 @@ class Multiplexer
 		unsigned int minSlaveBarrierId; // Smallest barrier ID currently in the state array
 		unsigned int* slaveGatherValues; // Array of most recently received gather values from the slaves
 		unsigned int masterGatherValue; // Final value of last completed gather operation in pipe
-		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-		size_t numResentPackets;
-		size_t numResentBytes;
-		#endif
+		GatherBuffer* slaveGatherBuffers; // Array of buffers receiving the slaves' data in data gather operations (on the master side)
+		GatherBuffer gatherResult; // Final data of the last completed data gather operation (on the master side), or the buffer reassembling it (on the slave side)
+		PipeStatistics statistics; // Communication counters for this pipe
 		
 		/* Constructors and destructors: */
 		PipeState(unsigned int nodeIndex,unsigned int numSlaves); // Creates empty pipe state
@@ -175,6 +224,8 @@ class Multiplexer
 	
 	typedef Threads::Spinlock SocketMutex; // Type of mutex to serialize write access to the UDP socket
 	
+	static const unsigned int ioBatchSize=16; // Maximum number of datagrams sent or received in a single system call
+	
 	/* Elements: */
 	private:
 	unsigned int numSlaves; // Number of slaves in the multicast group
@@ -183,15 +234,16 @@ class Multiplexer
 	struct sockaddr_in* otherAddress; // Pointer to socket address of other end of multicast connection
 	SocketMutex socketMutex; // Mutex serializing (write) access to the UDP socket
 	int socketFd; // File descriptor for the UDP socket
+	volatile bool useBatchedIO; // Flag whether datagrams are sent and received in batches; reset if the kernel does not support batched socket calls
 	bool connected; // Flag to indicate whether connection between master and all slaves has been established
 	Threads::MutexCond connectionCond; // Condition variable to wait on for connection establishment
 	Threads::Mutex pipeStateTableMutex; // Mutex serializing access to the the pipe state table
 	NewPipeHasher newPipes; // Hash table to map from thread IDs to pipe states not completely opened yet
 	unsigned int lastPipeId; // ID of the most-recently created pipe
 	PipeHasher pipeStateTable; // Hash table to map from pipe IDs to pipe state table entries
-	void* messageBuffer; // A buffer to receive message packets on the master node
+	void* messageBuffer; // A buffer to receive a batch of message packets on the master node
 	Threads::Thread packetHandlingThread; // Packet handling thread
-	Packet* slaveThreadPacket; // Pointer to the one packet always held by the packet handling thread on slave nodes
+	Packet** slaveThreadPackets; // Array of packets always held by the packet handling thread on slave nodes to receive a batch of packets
 	int masterMessageBurstSize; // Number of server messages sent in a single burst
 	int slaveMessageBurstSize; // Number of client messages sent in a single burst
 	Misc::Time connectionWaitTimeout; // Timeout between connection messages from the slaves
@@ -200,12 +252,28 @@ class Multiplexer
 	Misc::Time receiveWaitTimeout; // Timeout between packet loss messages from the slaves
 	Misc::Time barrierWaitTimeout; // Timeout between barrier messages from the slaves
 	unsigned int sendBufferSize; // Maximum number of packets buffered for each pipe
+	Misc::Time resendSuppressionInterval; // Minimum time between re-sends of the same packet, to aggregate packet loss messages from multiple slaves
+	Threads::Spinlock pacingMutex; // Mutex protecting the send rate pacing state
+	double minSendRate,maxSendRate; // Range of the adaptive send rate in bytes per second; pacing is disabled if the maximum rate is zero
+	double sendRate; // Current adaptive send rate in bytes per second
+	Misc::Time nextSendTime; // Earliest time at which the next packet may be sent to adhere to the current send rate
+	Misc::Time lastRateDecreaseTime; // Time at which the send rate was most recently reduced in response to packet loss
 	Threads::Spinlock packetPoolMutex; // Mutex protecting the free packet pool
 	Packet* packetPoolHead; // Pool of recently deleted packets to minimize number of new/delete calls
 	
 	/* Private methods: */
 	Packet* allocatePacket(void);
 	void processAcknowledgment(LockedPipe& pipeState,int slaveIndex,unsigned int streamPos); // Processes an acknowlegment (positive or implied-positive) from a slave
+	unsigned int receiveDatagrams(unsigned int maxNumDatagrams,void* const* buffers,size_t bufferSize,ssize_t* datagramSizes); // Blocks until at least one datagram arrives, then receives up to the given number of already waiting datagrams into the given buffers; returns the number of received datagrams
+	void sendDatagrams(unsigned int numDatagrams,void* const* datagrams,const size_t* datagramSizes); // Sends the given datagrams to the other end of the multicast connection
+	void resendPackets(LockedPipe& pipeState,unsigned int slaveNodeIndex,unsigned int streamPos,unsigned int packetPos); // Re-sends the packets covering the stream range lost by a slave
+	void sendLossMessage(LockedPipe& pipeState,unsigned int streamPos,unsigned int packetPos); // Sends a packet loss message for the given stream range from a slave to the master
+	void requestLostPackets(LockedPipe& pipeState,unsigned int gapEnd); // Sends a packet loss message for the gap ending at the given stream position unless the same gap was already requested within the receive wait timeout
+	void paceSend(size_t packetSize); // Blocks until a packet of the given size may be sent according to the current send rate
+	void adjustSendRate(bool packetLoss); // Adjusts the adaptive send rate after receiving positive feedback or a packet loss message
+	void deliverPacket(LockedPipe& pipeState,Packet* packet); // Appends the given in-order packet to the pipe's delivery queue on a slave
+	void sendGatherData(unsigned int sendNodeIndex,unsigned int pipeId,unsigned int barrierId,const void* data,size_t dataSize); // Sends the given data for the given data gather operation as a sequence of fragment messages
+	void gatherData(unsigned int pipeId,const void* data,size_t dataSize,GatherDataCombiner combiner,GatherOperation::OpCode op,std::vector<unsigned char>& result); // Exchanges data between all nodes, combines it on the master, and returns the combined data on all nodes; implies a barrier
 	void* packetHandlingThreadMaster(void); // Packet handling thread method for the master
 	void* packetHandlingThreadSlave(void); // Packet handling thread method for the slaves
 	
@@ -256,17 +324,26 @@ class Multiplexer
 	void setReceiveWaitTimeout(Misc::Time newReceiveWaitTimeout); // Sets the timeout when waiting for data packages
 	void setBarrierWaitTimeout(Misc::Time newBarrierWaitTimeout); // Sets the timeout when waiting for barrier messages
 	void setSendBufferSize(unsigned int newSendBufferSize); // Sets the maximum number of packets held in each pipe's send queue
+	void setResendSuppressionInterval(Misc::Time newResendSuppressionInterval); // Sets the minimum time between re-sends of the same packet
+	void setSendRateLimits(double newMinSendRate,double newMaxSendRate); // Sets the range of the adaptive send rate in bytes per second; a maximum rate of zero disables send rate pacing
+	void setBatchedIO(bool newBatchedIO); // Enables or disables sending and receiving datagrams in batches; batching is only used if supported by the kernel
 	void waitForConnection(void); // Waits until all slaves have connected to the master
 	
 	/* Pipe management interface: */
 	unsigned int openPipe(void); // Creates a new multicast pipe and returns its pipe ID
 	void closePipe(unsigned int pipeId); // Destroys the multicast pipe of the given ID
+	PipeStatistics getPipeStatistics(unsigned int pipeId); // Returns the current communication counters of the pipe of the given ID
+	double getSendRate(void); // Returns the current adaptive send rate in bytes per second, or zero if send rate pacing is disabled
 	
 	/* Pipe communication interface: */
 	void sendPacket(unsigned int pipeId,Packet* packet); // Sends a packet from the master to the slaves
 	Packet* receivePacket(unsigned int pipeId); // Receives a packet from the master
 	void barrier(unsigned int pipeId); // Waits until all nodes (master + slaves) have reached the same point in the program
 	unsigned int gather(unsigned int pipeId,unsigned int value,GatherOperation::OpCode op); // Exchanges a single value between all nodes (master + slaves); implies a barrier
+	void allReduce(unsigned int pipeId,int* values,size_t numValues,GatherOperation::OpCode op); // Accumulates the given arrays element-wise across all nodes and replaces them with the result; all nodes must pass arrays of the same size; implies a barrier
+	void allReduce(unsigned int pipeId,float* values,size_t numValues,GatherOperation::OpCode op); // Ditto, for float arrays
+	void allReduce(unsigned int pipeId,double* values,size_t numValues,GatherOperation::OpCode op); // Ditto, for double arrays
+	void allGather(unsigned int pipeId,const void* data,size_t dataSize,std::vector<std::vector<unsigned char> >& nodeData); // Exchanges variable-sized blocks of data between all nodes; nodeData[i] receives the data contributed by node i; implies a barrier
 	};
 
 }
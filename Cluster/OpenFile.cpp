@@ -38,7 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 namespace Cluster {
 
-IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode)
+IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode,bool compressed)
 	{
 	IO::FilePtr result;
 	
@@ -82,12 +82,12 @@ IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::Acc
 		else if(multiplexer->isMaster())
 			{
 			/* Open a master-side shared standard file: */
-			result=new StandardFileMaster(multiplexer,fileName,accessMode);
+			result=new StandardFileMaster(multiplexer,fileName,accessMode,compressed);
 			}
 		else
 			{
 			/* Open a slave-side shared standard file: */
-			result=new StandardFileSlave(multiplexer,fileName,accessMode);
+			result=new StandardFileSlave(multiplexer,fileName,accessMode,compressed);
 			}
 		}
 	
@@ -102,10 +102,10 @@ IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::Acc
 	return result;
 	}
 
-IO::SeekableFilePtr openSeekableFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode)
+IO::SeekableFilePtr openSeekableFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode,bool compressed)
 	{
 	/* Open a potentially non-seekable file first: */
-	IO::FilePtr file=openFile(multiplexer,fileName,accessMode);
+	IO::FilePtr file=openFile(multiplexer,fileName,accessMode,compressed);
 	
 	/* Check if the file is already seekable: */
 	IO::SeekableFilePtr result=file;
@@ -33,8 +33,8 @@ class Multiplexer;
 
 namespace Cluster {
 
-IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode =IO::File::ReadOnly); // Opens a file of the given name and distributes it over a new multicast pipe
-IO::SeekableFilePtr openSeekableFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode =IO::File::ReadOnly); // Opens a seekable file of the given name and distributes it over a new multicast pipe
+IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode =IO::File::ReadOnly,bool compressed =false); // Opens a file of the given name and distributes it over a new multicast pipe; compresses the distributed data if flag is true
+IO::SeekableFilePtr openSeekableFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode =IO::File::ReadOnly,bool compressed =false); // Opens a seekable file of the given name and distributes it over a new multicast pipe; compresses the distributed data if flag is true
 IO::DirectoryPtr openDirectory(Multiplexer* multiplexer,const char* directoryName); // Opens a directory of the given name and distributes it over a new multicast pipe
 
 }
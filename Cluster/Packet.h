@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #define CLUSTER_PACKET_INCLUDED
 
 #include <string.h>
+#include <Misc/Time.h>
 #include <Cluster/Config.h>
 
 namespace Cluster {
@@ -110,13 +111,14 @@ struct Packet
 	/* Elements: */
 	Packet* succ; // Pointer to successor in packet queues
 	size_t packetSize; // Actual size of packet
+	Misc::Time resendTime; // Time at which the packet was most recently re-sent in response to packet loss (only used on master side)
 	unsigned int pipeId; // ID of the pipe this packet is intended for
 	unsigned int streamPos; // Position of packet data in entire stream that has been sent on pipe so far
 	char packet[maxPacketSize]; // Packet data
 	
 	/* Constructors and destructors: */
 	Packet(void) // Creates empty packet
-		:succ(0),packetSize(0)
+		:succ(0),packetSize(0),resendTime(0,0)
 		{
 		}
 	};
@@ -0,0 +1,265 @@
+/***********************************************************************
+PacketCompressor - Class to send blocks of data over multicast pipes as
+frames of zlib-compressed packets, and to decompress them on the slave
+nodes.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Cluster/PacketCompressor.h>
+
+#include <string.h>
+#include <Misc/SizedTypes.h>
+#include <Misc/ThrowStdErr.h>
+#include <Cluster/Packet.h>
+#include <Cluster/Multiplexer.h>
+
+namespace Cluster {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+const size_t frameHeaderSize=2*sizeof(Misc::UInt32); // Size of the frame header (uncompressed size, compressed size) at the beginning of a frame's first packet
+
+}
+
+/*********************************
+Methods of class PacketCompressor:
+*********************************/
+
+PacketCompressor::PacketCompressor(bool sCompress)
+	:compress(sCompress)
+	{
+	/* Initialize the zlib stream for raw deflate data; frames are protected by the multiplexer's reliable transport: */
+	stream.zalloc=0;
+	stream.zfree=0;
+	stream.opaque=0;
+	stream.next_in=0;
+	stream.avail_in=0;
+	int result;
+	if(compress)
+		result=deflateInit2(&stream,Z_BEST_SPEED,Z_DEFLATED,-MAX_WBITS,8,Z_DEFAULT_STRATEGY);
+	else
+		result=inflateInit2(&stream,-MAX_WBITS);
+	if(result!=Z_OK)
+		Misc::throwStdErr("Cluster::PacketCompressor: Unable to initialize zlib stream due to error %d",result);
+	}
+
+PacketCompressor::~PacketCompressor(void)
+	{
+	if(compress)
+		deflateEnd(&stream);
+	else
+		inflateEnd(&stream);
+	}
+
+void PacketCompressor::sendFrame(Multiplexer* multiplexer,unsigned int pipeId,const void* data,size_t dataSize)
+	{
+	if(dataSize>maxFrameSize)
+		Misc::throwStdErr("Cluster::PacketCompressor::sendFrame: Frame size %u exceeds maximum",(unsigned int)dataSize);
+	
+	/* Compress the data into a list of packets, leaving room for the frame header in the first packet: */
+	deflateReset(&stream);
+	stream.next_in=static_cast<Bytef*>(const_cast<void*>(data));
+	stream.avail_in=uInt(dataSize);
+	framePackets.push_back(multiplexer->newPacket());
+	stream.next_out=reinterpret_cast<Bytef*>(framePackets.back()->packet+frameHeaderSize);
+	stream.avail_out=uInt(Packet::maxPacketSize-frameHeaderSize);
+	bool compressed=true;
+	while(true)
+		{
+		int result=deflate(&stream,Z_FINISH);
+		if(result==Z_STREAM_END)
+			break;
+		if(result!=Z_OK&&result!=Z_BUF_ERROR)
+			{
+			for(std::vector<Packet*>::iterator fpIt=framePackets.begin();fpIt!=framePackets.end();++fpIt)
+				multiplexer->deletePacket(*fpIt);
+			framePackets.clear();
+			Misc::throwStdErr("Cluster::PacketCompressor::sendFrame: Internal zlib error %d",result);
+			}
+		
+		if(stream.avail_out==0)
+			{
+			/* Give up if the data does not compress: */
+			if(stream.total_out>=dataSize)
+				{
+				compressed=false;
+				break;
+				}
+			
+			/* Continue into the next packet: */
+			framePackets.back()->packetSize=Packet::maxPacketSize;
+			framePackets.push_back(multiplexer->newPacket());
+			stream.next_out=reinterpret_cast<Bytef*>(framePackets.back()->packet);
+			stream.avail_out=uInt(Packet::maxPacketSize);
+			}
+		}
+	Misc::UInt32 header[2];
+	header[0]=Misc::UInt32(dataSize);
+	header[1]=Misc::UInt32(stream.total_out);
+	if(compressed&&stream.total_out>=dataSize)
+		compressed=false;
+	
+	if(compressed)
+		{
+		/* Finalize the last packet: */
+		framePackets.back()->packetSize=Packet::maxPacketSize-stream.avail_out;
+		}
+	else
+		{
+		/* Copy the uncompressed data into the frame packets, re-using already allocated packets: */
+		header[1]=header[0];
+		const char* dataPtr=static_cast<const char*>(data);
+		size_t remaining=dataSize;
+		size_t packetSpace=Packet::maxPacketSize-frameHeaderSize;
+		size_t packetIndex=0;
+		do
+			{
+			if(packetIndex==framePackets.size())
+				framePackets.push_back(multiplexer->newPacket());
+			Packet* packet=framePackets[packetIndex];
+			char* packetPtr=packet->packet+(packetIndex==0?frameHeaderSize:0);
+			size_t copySize=remaining<packetSpace?remaining:packetSpace;
+			memcpy(packetPtr,dataPtr,copySize);
+			packet->packetSize=(packetPtr-packet->packet)+copySize;
+			dataPtr+=copySize;
+			remaining-=copySize;
+			packetSpace=Packet::maxPacketSize;
+			++packetIndex;
+			}
+		while(remaining>0);
+		
+		/* Release unused packets: */
+		while(framePackets.size()>packetIndex)
+			{
+			multiplexer->deletePacket(framePackets.back());
+			framePackets.pop_back();
+			}
+		}
+	
+	/* Write the frame header and send the packets: */
+	memcpy(framePackets.front()->packet,header,frameHeaderSize);
+	for(std::vector<Packet*>::iterator fpIt=framePackets.begin();fpIt!=framePackets.end();++fpIt)
+		multiplexer->sendPacket(pipeId,*fpIt);
+	framePackets.clear();
+	}
+
+void PacketCompressor::skipFrame(Multiplexer* multiplexer,unsigned int pipeId,size_t remaining)
+	{
+	while(remaining>0)
+		{
+		Packet* packet=multiplexer->receivePacket(pipeId);
+		size_t packetSize=packet->packetSize;
+		multiplexer->deletePacket(packet);
+		if(packetSize>=remaining)
+			break;
+		remaining-=packetSize;
+		}
+	}
+
+size_t PacketCompressor::receiveFrame(Multiplexer* multiplexer,unsigned int pipeId,Packet* firstPacket,void* buffer,size_t bufferSize)
+	{
+	/* Read the frame header: */
+	if(firstPacket->packetSize<frameHeaderSize)
+		{
+		multiplexer->deletePacket(firstPacket);
+		Misc::throwStdErr("Cluster::PacketCompressor::receiveFrame: Truncated frame header");
+		}
+	Misc::UInt32 header[2];
+	memcpy(header,firstPacket->packet,frameHeaderSize);
+	size_t dataSize=header[0];
+	size_t remaining=header[1];
+	if(remaining>dataSize)
+		{
+		/* The frame header is corrupted; there is no way to find the end of the frame: */
+		multiplexer->deletePacket(firstPacket);
+		Misc::throwStdErr("Cluster::PacketCompressor::receiveFrame: Invalid frame header");
+		}
+	if(dataSize>bufferSize)
+		{
+		/* Skip the rest of the frame to keep the pipe in sync: */
+		size_t firstPayloadSize=firstPacket->packetSize-frameHeaderSize;
+		multiplexer->deletePacket(firstPacket);
+		if(remaining>firstPayloadSize)
+			skipFrame(multiplexer,pipeId,remaining-firstPayloadSize);
+		Misc::throwStdErr("Cluster::PacketCompressor::receiveFrame: Frame size %u exceeds buffer size %u",(unsigned int)dataSize,(unsigned int)bufferSize);
+		}
+	bool compressed=remaining<dataSize;
+	if(compressed)
+		{
+		inflateReset(&stream);
+		stream.next_out=static_cast<Bytef*>(buffer);
+		stream.avail_out=uInt(dataSize);
+		}
+	
+	/* Process all packets of the frame: */
+	char* bufferPtr=static_cast<char*>(buffer);
+	Packet* packet=firstPacket;
+	const char* payload=packet->packet+frameHeaderSize;
+	size_t payloadSize=packet->packetSize-frameHeaderSize;
+	int result=Z_OK;
+	while(true)
+		{
+		if(payloadSize>remaining)
+			{
+			multiplexer->deletePacket(packet);
+			Misc::throwStdErr("Cluster::PacketCompressor::receiveFrame: Frame data exceeds frame size");
+			}
+		
+		if(compressed)
+			{
+			/* Decompress the packet's payload: */
+			stream.next_in=reinterpret_cast<Bytef*>(const_cast<char*>(payload));
+			stream.avail_in=uInt(payloadSize);
+			result=inflate(&stream,Z_NO_FLUSH);
+			}
+		else
+			{
+			/* Copy the packet's payload: */
+			memcpy(bufferPtr,payload,payloadSize);
+			bufferPtr+=payloadSize;
+			}
+		remaining-=payloadSize;
+		multiplexer->deletePacket(packet);
+		
+		if(result!=Z_OK&&result!=Z_STREAM_END)
+			{
+			/* Skip the rest of the frame to keep the pipe in sync: */
+			skipFrame(multiplexer,pipeId,remaining);
+			Misc::throwStdErr("Cluster::PacketCompressor::receiveFrame: Corrupted frame data (zlib error %d)",result);
+			}
+		if(remaining==0)
+			break;
+		
+		/* Receive the next packet: */
+		packet=multiplexer->receivePacket(pipeId);
+		payload=packet->packet;
+		payloadSize=packet->packetSize;
+		}
+	
+	if(compressed&&(result!=Z_STREAM_END||stream.total_out!=dataSize))
+		Misc::throwStdErr("Cluster::PacketCompressor::receiveFrame: Corrupted frame data");
+	
+	return dataSize;
+	}
+
+}
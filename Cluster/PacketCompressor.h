@@ -0,0 +1,70 @@
+/***********************************************************************
+PacketCompressor - Class to send blocks of data over multicast pipes as
+frames of zlib-compressed packets, and to decompress them on the slave
+nodes.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef CLUSTER_PACKETCOMPRESSOR_INCLUDED
+#define CLUSTER_PACKETCOMPRESSOR_INCLUDED
+
+#include <stddef.h>
+#include <vector>
+#include <zlib.h>
+
+/* Forward declarations: */
+namespace Cluster {
+class Multiplexer;
+struct Packet;
+}
+
+namespace Cluster {
+
+class PacketCompressor
+	{
+	/* Embedded classes: */
+	public:
+	static const size_t maxFrameSize=65536; // Maximum amount of uncompressed data in a single frame
+	
+	/* Elements: */
+	private:
+	bool compress; // Flag whether this object compresses (master side) or decompresses (slave side) frames
+	z_stream stream; // Zlib compression/decompression structure
+	std::vector<Packet*> framePackets; // List of packets holding the frame currently being compressed
+	
+	/* Private methods: */
+	static void skipFrame(Multiplexer* multiplexer,unsigned int pipeId,size_t remaining); // Receives and discards the packets holding the given amount of not yet received payload data of a frame, to keep the pipe in sync after an error
+	
+	/* Constructors and destructors: */
+	public:
+	PacketCompressor(bool sCompress); // Creates a compressor for the master side or a decompressor for the slave side
+	private:
+	PacketCompressor(const PacketCompressor& source); // Prohibit copy constructor
+	PacketCompressor& operator=(const PacketCompressor& source); // Prohibit assignment operator
+	public:
+	~PacketCompressor(void);
+	
+	/* Methods: */
+	void sendFrame(Multiplexer* multiplexer,unsigned int pipeId,const void* data,size_t dataSize); // Compresses the given data of at most maxFrameSize bytes into completely filled packets and sends them over the given pipe; sends incompressible data uncompressed
+	size_t receiveFrame(Multiplexer* multiplexer,unsigned int pipeId,Packet* firstPacket,void* buffer,size_t bufferSize); // Decompresses a frame starting with the given already received packet into the given buffer; receives the frame's remaining packets from the given pipe and returns the frame's uncompressed size; skips the frame's remaining packets before throwing an exception on a corrupted frame
+	};
+
+}
+
+#endif
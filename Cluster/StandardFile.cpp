@@ -31,6 +31,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Misc/ThrowStdErr.h>
 #include <Cluster/Packet.h>
 #include <Cluster/Multiplexer.h>
+#include <Cluster/PacketCompressor.h>
 
 #ifdef __APPLE__
 #define lseek64 lseek
@@ -85,10 +86,15 @@ size_t StandardFileMaster::readData(IO::File::Byte* buffer,size_t bufferSize)
 		if(isReadCoupled())
 			{
 			/* Forward the just-read data to the slaves: */
-			Packet* packet=multiplexer->newPacket();
-			packet->packetSize=readSize;
-			memcpy(packet->packet,buffer,readSize);
-			multiplexer->sendPacket(pipeId,packet);
+			if(compressor!=0)
+				compressor->sendFrame(multiplexer,pipeId,buffer,readSize);
+			else
+				{
+				Packet* packet=multiplexer->newPacket();
+				packet->packetSize=readSize;
+				memcpy(packet->packet,buffer,readSize);
+				multiplexer->sendPacket(pipeId,packet);
+				}
 			}
 		
 		/* Advance the read pointer: */
@@ -242,19 +248,21 @@ void StandardFileMaster::openFile(const char* fileName,IO::File::AccessMode acce
 	if(errorCode!=0)
 		{
 		/* Throw an exception: */
+		delete compressor;
 		throw OpenError(Misc::printStdErrMsg("Cluster::StandardFile: Unable to open file %s for %s due to error %d",fileName,getAccessModeName(accessMode),errorCode));
 		}
 	
-	/* Install a read buffer the size of a multicast packet: */
+	/* Install a read buffer the size of a multicast packet, or of a compressed frame: */
 	canReadThrough=false;
 	if(accessMode==ReadOnly||accessMode==ReadWrite)
-		IO::SeekableFile::resizeReadBuffer(Packet::maxPacketSize);
+		IO::SeekableFile::resizeReadBuffer(compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize);
 	}
 
-StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode)
+StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode,bool sCompressed)
 	:IO::SeekableFile(disableRead(accessMode)),ClusterPipe(sMultiplexer),
 	 fd(-1),
-	 filePos(0)
+	 filePos(0),
+	 compressor(sCompressed?new PacketCompressor(true):0)
 	{
 	/* Create flags and mode to open the file: */
 	int flags=O_CREAT;
@@ -269,7 +277,8 @@ StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fil
 StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode,int flags,int mode)
 	:SeekableFile(disableRead(accessMode)),ClusterPipe(sMultiplexer),
 	 fd(-1),
-	 filePos(0)
+	 filePos(0),
+	 compressor(0)
 	{
 	/* Open the file: */
 	openFile(fileName,accessMode,flags,mode);
@@ -281,6 +290,7 @@ StandardFileMaster::~StandardFileMaster(void)
 	flush();
 	if(fd>=0)
 		close(fd);
+	delete compressor;
 	}
 
 int StandardFileMaster::getFd(void) const
@@ -293,8 +303,8 @@ int StandardFileMaster::getFd(void) const
 
 size_t StandardFileMaster::resizeReadBuffer(size_t newReadBufferSize)
 	{
-	/* Ignore the change and return the size of a multicast packet: */
-	return Packet::maxPacketSize;
+	/* Ignore the change and return the size of a multicast packet, or of a compressed frame: */
+	return compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize;
 	}
 
 IO::SeekableFile::Offset StandardFileMaster::getSize(void) const
@@ -336,7 +346,17 @@ size_t StandardFileSlave::readData(IO::File::Byte* buffer,size_t bufferSize)
 		Packet* newPacket=multiplexer->receivePacket(pipeId);
 		
 		/* Check for error conditions: */
-		if(newPacket->packetSize!=0)
+		if(newPacket->packetSize!=0&&compressor!=0)
+			{
+			/* Decompress the frame starting with the new packet into the file's own read buffer: */
+			size_t frameSize=compressor->receiveFrame(multiplexer,pipeId,newPacket,buffer,bufferSize);
+			
+			/* Advance the read pointer: */
+			readPos+=frameSize;
+			
+			return frameSize;
+			}
+		else if(newPacket->packetSize!=0)
 			{
 			/* Install the new packet as the file's read buffer: */
 			if(packet!=0)
@@ -407,9 +427,10 @@ void StandardFileSlave::writeData(const IO::File::Byte* buffer,size_t bufferSize
 		}
 	}
 
-StandardFileSlave::StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode)
+StandardFileSlave::StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode,bool sCompressed)
 	:IO::SeekableFile(disableRead(accessMode)),ClusterPipe(sMultiplexer),
-	 packet(0)
+	 packet(0),
+	 compressor(sCompressed?new PacketCompressor(false):0)
 	{
 	/* Read the status packet from the master node: */
 	Packet* statusPacket=multiplexer->receivePacket(pipeId);
@@ -421,10 +442,14 @@ StandardFileSlave::StandardFileSlave(Multiplexer* sMultiplexer,const char* fileN
 	if(errorCode!=0)
 		{
 		/* Throw an exception: */
+		delete compressor;
 		throw OpenError(Misc::printStdErrMsg("Cluster::StandardFile: Unable to open file %s for %s due to error %d",fileName,getAccessModeName(accessMode),errorCode));
 		}
 	
+	/* Install a read buffer the size of a compressed frame if data is forwarded compressed: */
 	canReadThrough=false;
+	if(compressor!=0&&(accessMode==ReadOnly||accessMode==ReadWrite))
+		IO::SeekableFile::resizeReadBuffer(PacketCompressor::maxFrameSize);
 	}
 
 StandardFileSlave::~StandardFileSlave(void)
@@ -435,6 +460,7 @@ StandardFileSlave::~StandardFileSlave(void)
 		multiplexer->deletePacket(packet);
 		setReadBuffer(0,0,false);
 		}
+	delete compressor;
 	}
 
 int StandardFileSlave::getFd(void) const
@@ -447,14 +473,14 @@ int StandardFileSlave::getFd(void) const
 
 size_t StandardFileSlave::getReadBufferSize(void) const
 	{
-	/* Return the size of a multicast packet: */
-	return Packet::maxPacketSize;
+	/* Return the size of a multicast packet, or of a compressed frame: */
+	return compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize;
 	}
 
 size_t StandardFileSlave::resizeReadBuffer(size_t newReadBufferSize)
 	{
-	/* Ignore the change and return the size of a multicast packet: */
-	return Packet::maxPacketSize;
+	/* Ignore the change and return the size of a multicast packet, or of a compressed frame: */
+	return compressor!=0?PacketCompressor::maxFrameSize:Packet::maxPacketSize;
 	}
 
 IO::SeekableFile::Offset StandardFileSlave::getSize(void) const
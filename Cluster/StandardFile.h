@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 /* Forward declarations: */
 namespace Cluster {
 class Packet;
+class PacketCompressor;
 }
 
 namespace Cluster {
@@ -39,6 +40,7 @@ class StandardFileMaster:public IO::SeekableFile,public ClusterPipe // Class to
 	private:
 	int fd; // File descriptor of the underlying file
 	Offset filePos; // Current position of the underlying file's read/write pointer
+	PacketCompressor* compressor; // Compressor for data read from the file and forwarded to the slaves, or null if data is forwarded uncompressed
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -50,7 +52,7 @@ class StandardFileMaster:public IO::SeekableFile,public ClusterPipe // Class to
 	
 	/* Constructors and destructors: */
 	public:
-	StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly); // Opens a standard file with "DontCare" endianness setting and default flags and permissions
+	StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly,bool sCompressed =false); // Opens a standard file with "DontCare" endianness setting and default flags and permissions; compresses forwarded read data if flag is true
 	StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode,int flags,int mode =0); // Opens a standard file with "DontCare" endianness setting
 	virtual ~StandardFileMaster(void);
 	
@@ -67,6 +69,7 @@ class StandardFileSlave:public IO::SeekableFile,public ClusterPipe // Class to r
 	/* Elements: */
 	private:
 	Packet* packet; // Pointer to most recently received multicast packet; doubles as file's read buffer
+	PacketCompressor* compressor; // Decompressor for data forwarded from the master, or null if data is forwarded uncompressed
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -75,7 +78,7 @@ class StandardFileSlave:public IO::SeekableFile,public ClusterPipe // Class to r
 	
 	/* Constructors and destructors: */
 	public:
-	StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly); // Opens a standard file with "DontCare" endianness setting
+	StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly,bool sCompressed =false); // Opens a standard file with "DontCare" endianness setting; decompresses forwarded read data if flag is true; flag must match the master's
 	virtual ~StandardFileSlave(void);
 	
 	/* Methods from IO::File: */
@@ -0,0 +1,234 @@
+/***********************************************************************
+MultiplexerBenchmark - Program to measure the throughput of a multicast
+pipe between a master and a slave process on the local host, with and
+without batched socket calls.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <Misc/Time.h>
+#include <Cluster/Packet.h>
+#include <Cluster/GatherOperation.h>
+#include <Cluster/Multiplexer.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+struct BenchmarkSettings // Structure holding the benchmark's command line settings
+	{
+	/* Elements: */
+	public:
+	std::string masterHostName; // Host name of the master node
+	std::string slaveMulticastGroup; // Multicast group or host name of the slave node
+	int masterPortNumber,slavePortNumber; // Port numbers of the master and slave sockets
+	unsigned int numPackets; // Number of full-size packets to send per run
+	double maxSendRate; // Maximum send rate in bytes per second, or zero to disable pacing
+	};
+
+int runSlave(const BenchmarkSettings& settings,bool batchedIO)
+	{
+	try
+		{
+		/* Connect to the master: */
+		Cluster::Multiplexer multiplexer(1,1,settings.masterHostName,settings.masterPortNumber,settings.slaveMulticastGroup,settings.slavePortNumber);
+		multiplexer.setBatchedIO(batchedIO);
+		multiplexer.waitForConnection();
+		unsigned int pipeId=multiplexer.openPipe();
+		multiplexer.barrier(pipeId);
+		
+		/* Receive all packets and check that they arrive complete and in order: */
+		unsigned int numErrors=0;
+		for(unsigned int i=0;i<settings.numPackets;++i)
+			{
+			Cluster::Packet* packet=multiplexer.receivePacket(pipeId);
+			unsigned int packetIndex;
+			memcpy(&packetIndex,packet->packet,sizeof(unsigned int));
+			if(packet->packetSize!=Cluster::Packet::maxPacketSize||packetIndex!=i)
+				++numErrors;
+			multiplexer.deletePacket(packet);
+			}
+		
+		/* Report the slave's counters to the master: */
+		Cluster::Multiplexer::PipeStatistics stats=multiplexer.getPipeStatistics(pipeId);
+		multiplexer.gather(pipeId,numErrors,Cluster::GatherOperation::SUM);
+		multiplexer.gather(pipeId,(unsigned int)stats.numLossMessages,Cluster::GatherOperation::SUM);
+		multiplexer.gather(pipeId,(unsigned int)stats.numOutOfOrderPackets,Cluster::GatherOperation::SUM);
+		multiplexer.closePipe(pipeId);
+		}
+	catch(std::runtime_error err)
+		{
+		std::cerr<<"Slave: Caught exception "<<err.what()<<std::endl;
+		return 1;
+		}
+	
+	return 0;
+	}
+
+bool runMaster(const BenchmarkSettings& settings,bool batchedIO)
+	{
+	try
+		{
+		/* Wait for the slave to connect: */
+		Cluster::Multiplexer multiplexer(1,0,settings.masterHostName,settings.masterPortNumber,settings.slaveMulticastGroup,settings.slavePortNumber);
+		multiplexer.setBatchedIO(batchedIO);
+		multiplexer.setSendRateLimits(0.0,settings.maxSendRate);
+		multiplexer.waitForConnection();
+		unsigned int pipeId=multiplexer.openPipe();
+		multiplexer.barrier(pipeId);
+		
+		/* Send full-size packets stamped with their indices as fast as possible: */
+		Misc::Time startTime=Misc::Time::now();
+		for(unsigned int i=0;i<settings.numPackets;++i)
+			{
+			Cluster::Packet* packet=multiplexer.newPacket();
+			memset(packet->packet,int(i&0xffU),Cluster::Packet::maxPacketSize);
+			memcpy(packet->packet,&i,sizeof(unsigned int));
+			packet->packetSize=Cluster::Packet::maxPacketSize;
+			multiplexer.sendPacket(pipeId,packet);
+			}
+		
+		/* The first gather completes when the slave has received all packets: */
+		unsigned int numErrors=multiplexer.gather(pipeId,0,Cluster::GatherOperation::SUM);
+		double elapsed=toSeconds(Misc::Time::now()-startTime);
+		unsigned int numLossMessages=multiplexer.gather(pipeId,0,Cluster::GatherOperation::SUM);
+		unsigned int numOutOfOrderPackets=multiplexer.gather(pipeId,0,Cluster::GatherOperation::SUM);
+		Cluster::Multiplexer::PipeStatistics stats=multiplexer.getPipeStatistics(pipeId);
+		multiplexer.closePipe(pipeId);
+		
+		/* Print the results: */
+		double numBytes=double(settings.numPackets)*double(Cluster::Packet::maxPacketSize);
+		std::cout<<std::setw(10)<<std::left<<(batchedIO?"batched":"single")<<std::right;
+		std::cout<<std::setw(10)<<std::fixed<<std::setprecision(3)<<elapsed;
+		std::cout<<std::setw(10)<<std::setprecision(1)<<numBytes/(elapsed*1024.0*1024.0);
+		std::cout<<std::setw(12)<<std::setprecision(0)<<double(settings.numPackets)/elapsed;
+		std::cout<<std::setw(10)<<stats.numResentPackets;
+		std::cout<<std::setw(10)<<numLossMessages;
+		std::cout<<std::setw(10)<<numOutOfOrderPackets;
+		std::cout<<std::setw(8)<<numErrors<<std::endl;
+		
+		return numErrors==0;
+		}
+	catch(std::runtime_error err)
+		{
+		std::cerr<<"Master: Caught exception "<<err.what()<<std::endl;
+		return false;
+		}
+	}
+
+bool runBenchmark(const BenchmarkSettings& settings,bool batchedIO)
+	{
+	/* Run the slave in a child process: */
+	pid_t slavePid=fork();
+	if(slavePid<0)
+		{
+		std::cerr<<"Unable to fork slave process"<<std::endl;
+		return false;
+		}
+	else if(slavePid==0)
+		_exit(runSlave(settings,batchedIO));
+	
+	/* Run the master in this process and wait for the slave to finish: */
+	bool result=runMaster(settings,batchedIO);
+	int slaveStatus;
+	waitpid(slavePid,&slaveStatus,0);
+	return result&&WIFEXITED(slaveStatus)&&WEXITSTATUS(slaveStatus)==0;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	BenchmarkSettings settings;
+	settings.masterHostName="127.0.0.1";
+	settings.slaveMulticastGroup="127.0.0.1";
+	settings.masterPortNumber=26000;
+	settings.slavePortNumber=26001;
+	settings.numPackets=100000;
+	settings.maxSendRate=0.0;
+	unsigned int numRuns=3;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"master")==0&&i+1<argc)
+				{
+				settings.masterHostName=argv[i+1];
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"group")==0&&i+1<argc)
+				{
+				settings.slaveMulticastGroup=argv[i+1];
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"ports")==0&&i+2<argc)
+				{
+				settings.masterPortNumber=atoi(argv[i+1]);
+				settings.slavePortNumber=atoi(argv[i+2]);
+				i+=2;
+				}
+			else if(strcasecmp(argv[i]+1,"packets")==0&&i+1<argc)
+				{
+				settings.numPackets=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"rate")==0&&i+1<argc)
+				{
+				settings.maxSendRate=atof(argv[i+1])*1024.0*1024.0;
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"runs")==0&&i+1<argc)
+				{
+				numRuns=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-master <master host name>] [-group <slave multicast group>] [-ports <master port> <slave port>] [-packets <number of packets>] [-rate <maximum send rate in MB/s, 0 for unpaced>] [-runs <number of runs>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	std::cout<<"Master "<<settings.masterHostName<<":"<<settings.masterPortNumber<<", slaves "<<settings.slaveMulticastGroup<<":"<<settings.slavePortNumber<<", ";
+	std::cout<<settings.numPackets<<" packets of "<<Cluster::Packet::maxPacketSize<<" bytes"<<std::endl;
+	std::cout<<"Mode        Time (s)      MB/s   Packets/s    Resent     NACKs  OutOfOrd  Errors"<<std::endl;
+	
+	/* Alternate between single and batched socket calls to even out system noise: */
+	bool ok=true;
+	for(unsigned int run=0;run<numRuns&&ok;++run)
+		{
+		ok=runBenchmark(settings,false)&&ok;
+		ok=runBenchmark(settings,true)&&ok;
+		}
+	
+	return ok?0:1;
+	}
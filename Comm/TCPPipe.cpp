@@ -33,6 +33,7 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <netdb.h>
 #include <Misc/ThrowStdErr.h>
 #include <Misc/FdSet.h>
+#include <Threads/Profiler.h>
 #include <Comm/ListeningTCPSocket.h>
 
 namespace Comm {
@@ -43,6 +44,8 @@ Methods of class TCPPipe:
 
 size_t TCPPipe::readData(IO::File::Byte* buffer,size_t bufferSize)
 	{
+	THREADS_PROFILE_ZONE("Comm::TCPPipe::readData");
+	
 	/* Read more data from source: */
 	ssize_t readResult;
 	do
@@ -64,6 +67,8 @@ size_t TCPPipe::readData(IO::File::Byte* buffer,size_t bufferSize)
 
 void TCPPipe::writeData(const IO::File::Byte* buffer,size_t bufferSize)
 	{
+	THREADS_PROFILE_ZONE("Comm::TCPPipe::writeData");
+	
 	while(bufferSize>0)
 		{
 		ssize_t writeResult=::write(fd,buffer,bufferSize);
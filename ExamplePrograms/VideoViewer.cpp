@@ -40,6 +40,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Video/VideoDataFormat.h>
 #include <Video/VideoDevice.h>
 #include <Video/ImageExtractor.h>
+#include <Video/ImageExtractorBA81.h>
 #include <Vrui/Vrui.h>
 #include <Vrui/Application.h>
 
@@ -183,6 +184,7 @@ VideoViewer::VideoViewer(int& argc,char**& argv)
 	bool requestRate=false;
 	int videoRate;
 	const char* pixelFormat=0;
+	bool edgeAwareDemosaicing=false;
 	for(int i=1;i<argc;++i)
 		{
 		if(argv[i][0]=='-')
@@ -222,6 +224,22 @@ VideoViewer::VideoViewer(int& argc,char**& argv)
 				else
 					std::cerr<<"Ignoring dangling -format option"<<std::endl;
 				}
+			else if(strcasecmp(argv[i]+1,"demosaic")==0||strcasecmp(argv[i]+1,"D")==0)
+				{
+				/* Parse the demosaicing method for raw Bayer-filtered video: */
+				++i;
+				if(i<argc)
+					{
+					if(strcasecmp(argv[i],"edgeaware")==0)
+						edgeAwareDemosaicing=true;
+					else if(strcasecmp(argv[i],"bilinear")==0)
+						edgeAwareDemosaicing=false;
+					else
+						std::cerr<<"Ignoring unknown demosaicing method "<<argv[i]<<std::endl;
+					}
+				else
+					std::cerr<<"Ignoring dangling -demosaic option"<<std::endl;
+				}
 			else
 				std::cerr<<"Ignoring unknown command line option "<<argv[i]<<std::endl;
 			}
@@ -290,6 +308,16 @@ VideoViewer::VideoViewer(int& argc,char**& argv)
 	/* Create an image extractor to convert from the video device's raw image format to RGB: */
 	videoExtractor=videoDevice->createImageExtractor();
 	
+	/* Demosaic raw Bayer-filtered video frames in parallel using Vrui's task scheduler: */
+	Video::ImageExtractorBA81* bayerExtractor=dynamic_cast<Video::ImageExtractorBA81*>(videoExtractor);
+	if(bayerExtractor!=0)
+		{
+		bayerExtractor->setTaskScheduler(Vrui::getTaskScheduler());
+		if(edgeAwareDemosaicing)
+			bayerExtractor->setDemosaicingMode(Video::ImageExtractorBA81::EDGE_AWARE);
+		std::cout<<"Demosaicing cost "<<bayerExtractor->getDemosaicingCost(bayerExtractor->getDemosaicingMode())*1000.0<<" ms per frame"<<std::endl;
+		}
+	
 	/* Initialize the incoming video frame triple buffer: */
 	for(int i=0;i<3;++i)
 		{
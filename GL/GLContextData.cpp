@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <GL/GLContextData.h>
 
+#include <Threads/Profiler.h>
 #include <GL/GLLightTracker.h>
 #include <GL/GLClipPlaneTracker.h>
 #include <GL/Internal/GLThingManager.h>
@@ -82,6 +83,8 @@ void GLContextData::shutdownThingManager(void)
 
 void GLContextData::updateThings(void)
 	{
+	THREADS_PROFILE_ZONE("GLContextData::updateThings");
+	
 	GLThingManager::theThingManager.updateThings(*this);
 	}
 
@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef GLCONTEXTDATA_INCLUDED
 #define GLCONTEXTDATA_INCLUDED
 
-#include <Misc/HashTable.h>
+#include <Misc/FlatHashTable.h>
 #include <Misc/CallbackData.h>
 #include <Misc/CallbackList.h>
 #include <GL/TLSHelper.h>
@@ -52,7 +52,7 @@ class GLContextData
 		};
 	
 	private:
-	typedef Misc::HashTable<const GLObject*,GLObject::DataItem*> ItemHash; // Class for hash table mapping pointers to data items
+	typedef Misc::FlatHashTable<const GLObject*,GLObject::DataItem*> ItemHash; // Class for open-addressing hash table mapping pointers to data items
 	
 	/* Elements: */
 	static Misc::CallbackList currentContextDataChangedCallbacks; // List of callbacks called whenever the current context data object changes
@@ -63,7 +63,7 @@ class GLContextData
 	
 	/* Constructors and destructors: */
 	public:
-	GLContextData(int sTableSize,float sWaterMark =0.9f,float sGrowRate =1.7312543); // Constructs an empty context
+	GLContextData(int sTableSize,float sWaterMark =0.6f,float sGrowRate =1.7312543); // Constructs an empty context
 	~GLContextData(void);
 	
 	/* Methods to manage object initializations and clean-ups: */
@@ -25,12 +25,25 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #ifndef GEOMETRY_ARRAYKDTREE_INCLUDED
 #define GEOMETRY_ARRAYKDTREE_INCLUDED
 
+#include <stddef.h>
+#include <vector>
+#include <Misc/SizedTypes.h>
+#include <Math/Constants.h>
 #include <Geometry/Point.h>
 #include <Geometry/Box.h>
 #include <Geometry/ClosePointSet.h>
 
 #define GEOMETRY_ARRAYKDTREE_TRAVERSAL_EXPLICIT_RECURSION 1
 
+/* Forward declarations: */
+namespace IO {
+class File;
+class MemMappedFile;
+}
+namespace Threads {
+class TaskScheduler;
+}
+
 namespace Geometry {
 
 template <class StoredPointParam>
@@ -46,6 +59,102 @@ class ArrayKdTree
 	typedef Geometry::ClosePointSet<StoredPoint> ClosePointSet; // Type for nearest neighbours query results
 	
 	private:
+	struct FileHeader // Structure for the header of tree files; node array follows immediately
+		{
+		/* Elements: */
+		public:
+		char magic[16]; // File identification string
+		Misc::UInt32 byteOrderMark; // Marker to detect files written on hosts of different endianness
+		Misc::UInt32 dimension; // Dimension of stored points
+		Misc::UInt32 scalarSize; // Size of stored points' scalar type in bytes
+		Misc::UInt32 storedPointSize; // Size of stored points in bytes
+		Misc::UInt64 numNodes; // Number of nodes in the tree
+		char padding[24]; // Padding to align the node array to 64 bytes
+		};
+	
+	static const int bucketSize=16; // Maximum number of points in subtrees that are tested sequentially during batched closest point queries
+	
+	struct ClosestPointResult // Structure collecting the single closest point during batched closest point queries
+		{
+		/* Elements: */
+		public:
+		const StoredPoint* point; // Pointer to the closest point found so far
+		Scalar dist2; // Squared distance from the query position to the closest point found so far
+		
+		/* Constructors and destructors: */
+		ClosestPointResult(void)
+			:point(0),dist2(Math::Constants<Scalar>::max)
+			{
+			}
+		
+		/* Methods: */
+		Scalar getMaxSqrDist(void) const
+			{
+			return dist2;
+			}
+		void insertPoint(const StoredPoint& newPoint,Scalar newSqrDist)
+			{
+			if(dist2>newSqrDist)
+				{
+				point=&newPoint;
+				dist2=newSqrDist;
+				}
+			}
+		};
+	
+	class ClosestPointBatch // Class processing a range of a batched closest point query
+		{
+		/* Elements: */
+		private:
+		const ArrayKdTree& tree; // The queried tree
+		const Point* queryPositions; // Array of query positions
+		const StoredPoint** closestPoints; // Array of query results
+		
+		/* Constructors and destructors: */
+		public:
+		ClosestPointBatch(const ArrayKdTree& sTree,const Point* sQueryPositions,const StoredPoint** sClosestPoints)
+			:tree(sTree),queryPositions(sQueryPositions),closestPoints(sClosestPoints)
+			{
+			}
+		
+		/* Methods: */
+		void operator()(size_t begin,size_t end) const
+			{
+			for(size_t i=begin;i<end;++i)
+				{
+				ClosestPointResult result;
+				tree.findClosestPointsBucketed(queryPositions[i],result);
+				closestPoints[i]=result.point;
+				}
+			}
+		};
+	
+	class ClosePointSetBatch // Class processing a range of a batched closest points query
+		{
+		/* Elements: */
+		private:
+		const ArrayKdTree& tree; // The queried tree
+		const Point* queryPositions; // Array of query positions
+		ClosePointSet* closestPoints; // Array of query results
+		
+		/* Constructors and destructors: */
+		public:
+		ClosePointSetBatch(const ArrayKdTree& sTree,const Point* sQueryPositions,ClosePointSet* sClosestPoints)
+			:tree(sTree),queryPositions(sQueryPositions),closestPoints(sClosestPoints)
+			{
+			}
+		
+		/* Methods: */
+		void operator()(size_t begin,size_t end) const
+			{
+			for(size_t i=begin;i<end;++i)
+				{
+				closestPoints[i].clear();
+				tree.findClosestPointsBucketed(queryPositions[i],closestPoints[i]);
+				}
+			}
+		};
+	
 	struct CreateSubTreeArgs // Structure to hold arguments for subtree creation threads
 		{
 		/* Elements: */
@@ -65,8 +174,10 @@ class ArrayKdTree
 	private:
 	int numNodes; // Total number of nodes in kd-tree
 	StoredPoint* nodes; // Array of nodes
+	IO::MemMappedFile* nodeFile; // Memory-mapped tree file containing the array of nodes, or null if the array was allocated
 	
 	/* Private methods: */
+	void deleteNodes(void); // Deletes or unmaps the array of nodes
 	void createTree(int left,int right,int splitDimension); // Creates sub-kd-tree
 	void* createTreeThreaded(const CreateSubTreeArgs* args); // Creates sub-kd-tree using multiple threads
 	void checkTree(int left,int right,int splitDimension,Scalar bbMin[],Scalar bbMax[]) const; // Checks if kd-tree has correct structure
@@ -93,21 +204,24 @@ class ArrayKdTree
  	void findClosestPoint(int left,int right,int splitDimension,const Point& queryPosition,const StoredPoint*& closestPoint,Scalar& minDist2) const; // Recursively finds closest point in kd-tree
 	void findClosestPoints(int left,int right,int splitDimension,const Point& queryPosition,ClosePointSet& closestPoints) const; // Recursively finds closest points in kd-tree
 	#endif
+	template <class ResultParam>
+	void findClosestPointsBucketed(const Point& queryPosition,ResultParam& result) const; // Enters the points closest to the query position into the given result using a non-recursive traversal that tests small subtrees sequentially
 	
 	/* Constructors and destructors: */
 	public:
 	ArrayKdTree(void) // Creates empty kd-tree
-		:numNodes(0),nodes(0)
+		:numNodes(0),nodes(0),nodeFile(0)
 		{
 		}
 	ArrayKdTree(int sNumNodes) // Creates kd-tree for numNodes points, without initializing the point data
-		:numNodes(sNumNodes),nodes(new StoredPoint[numNodes])
+		:numNodes(sNumNodes),nodes(new StoredPoint[numNodes]),nodeFile(0)
 		{
 		}
 	ArrayKdTree(int sNumNodes,const StoredPoint sNodes[]); // Creates balanced kd-tree from point array
+	ArrayKdTree(const char* treeFileName); // Creates kd-tree by memory-mapping a tree file written by saveTree
 	~ArrayKdTree(void)
 		{
-		delete[] nodes;
+		deleteNodes();
 		}
 	
 	/* Methods: */
@@ -120,7 +234,7 @@ class ArrayKdTree
 		{
 		return nodes;
 		}
-	StoredPoint* accessPoints(void) // Returns pointer to point array for one-by-one updates
+	StoredPoint* accessPoints(void) // Returns pointer to point array for one-by-one updates; must not be called on memory-mapped trees
 		{
 		return nodes;
 		}
@@ -139,17 +253,17 @@ class ArrayKdTree
 	void setPoints(int newNumNodes,const StoredPoint newNodes[],int numThreads); // Ditto, but uses multiple threads
 	void donatePoints(int newNumNodes,StoredPoint* newNodes); // Creates balanced kd-tree from point array; adopts point array as own
 	void donatePoints(int newNumNodes,StoredPoint* newNodes,int numThreads); // Ditto, but uses multiple threads
-	StoredPoint* detachPoints(void) // Returns a pointer to the tree's point array and detaches it from the tree
-		{
-		StoredPoint* result=nodes;
-		numNodes=0;
-		nodes=0;
-		return result;
-		}
+	StoredPoint* detachPoints(void); // Returns a pointer to the tree's point array and detaches it from the tree; returns a copy of the point array if the tree is memory-mapped
 	const StoredPoint& getNode(int nodeIndex) const // Returns one of the octree's nodes
 		{
 		return nodes[nodeIndex];
 		}
+	bool isMapped(void) const // Returns true if the tree's point array is memory-mapped from a tree file
+		{
+		return nodeFile!=0;
+		}
+	void saveTree(IO::File& file) const; // Writes the balanced kd-tree to the given file in a format that can be memory-mapped on hosts of the same endianness; stored points must be plain data
+	void mapTree(const char* treeFileName); // Replaces the tree with a read-only memory map of the given tree file, without rebuilding the tree; nodes are paged in as they are accessed
 	void checkTree(void) const; // Checks the tree for consistency
 	template <class TraversalFunctionParam>
 	void traverseTree(TraversalFunctionParam& traversalFunction) const // Traverses tree in prefix order and calls traversal function for each node
@@ -174,6 +288,8 @@ class ArrayKdTree
 	const StoredPoint& findClosePoint(const Point& queryPosition) const; // Returns a stored point that is close to the query position
 	const StoredPoint& findClosestPoint(const Point& queryPosition) const; // Returns the stored point closest to the query position
 	ClosePointSet& findClosestPoints(const Point& queryPosition,ClosePointSet& closestPoints) const; // Returns a set of closest points
+	void findClosestPoints(size_t numQueries,const Point queryPositions[],const StoredPoint* closestPoints[],Threads::TaskScheduler* taskScheduler =0) const; // Stores pointers to the stored points closest to each of the given query positions in the given array; distributes queries across the given task scheduler's threads if not null
+	void findClosestPoints(const Point queryPositions[],std::vector<ClosePointSet>& closestPoints,Threads::TaskScheduler* taskScheduler =0) const; // Fills each close point set in the given vector with the points closest to the corresponding query position; distributes queries across the given task scheduler's threads if not null
 	};
 
 }
@@ -23,7 +23,9 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #ifndef GEOMETRY_POINTKDTREE_INCLUDED
 #define GEOMETRY_POINTKDTREE_INCLUDED
 
-#include <Misc/PoolAllocator.h>
+#include <new>
+#include <Threads/SlabAllocator.h>
+#include <Threads/TaskScheduler.h>
 #include <Geometry/Point.h>
 #include <Geometry/ClosePointSet.h>
 
@@ -60,7 +62,7 @@ class PointKdTree
 		{
 		/* Elements: */
 		public:
-		static Misc::PoolAllocator<Node> nodeAllocator; // Memory allocator for nodes
+		static Threads::SlabAllocator nodeAllocator; // Thread-safe memory allocator for nodes inserted after tree creation
 		StoredPoint point; // Point stored in node
 		Node* left; // Pointer to left child node
 		Node* right; // Pointer to right child node
@@ -70,21 +72,22 @@ class PointKdTree
 			:point(sPoint),left(sLeft),right(sRight)
 			{
 			}
-		Node(int numPoints,StoredPoint points[],int splitDimension,Scalar heap[]); // Creates sub-kd-tree for array of points; shuffles point array
-		~Node(void) // Destroys node's subtree
-			{
-			delete left;
-			delete right;
-			}
 		
 		/* Methods: */
 		void* operator new(size_t size)
 			{
-			return nodeAllocator.allocate();
+			return nodeAllocator.allocate(size);
+			}
+		void* operator new(size_t size,void* place) // Constructs a node inside a tree's contiguous node array
+			{
+			return place;
+			}
+		void operator delete(void* pointer,size_t size)
+			{
+			nodeAllocator.deallocate(pointer,size);
 			}
-		void operator delete(void* pointer)
+		void operator delete(void* pointer,void* place)
 			{
-			nodeAllocator.free(pointer);
 			}
 		
 		void insertPoint(const StoredPoint& newPoint,int splitDimension); // Inserts a new point below this node
@@ -146,34 +149,72 @@ class PointKdTree
 			}
 		};
 	
+	class CreateSubtreeTask:public Threads::TaskScheduler::Task // Class for tasks creating sub-kd-trees in parallel
+		{
+		/* Elements: */
+		private:
+		Node* nodes; // Node array receiving the sub-kd-tree
+		int numPoints; // Number of points in the sub-kd-tree
+		StoredPoint* points; // Array of points in the sub-kd-tree
+		int splitDimension; // Split dimension of the sub-kd-tree's root
+		Threads::TaskScheduler::TaskGroup& group; // Task group to which to submit tasks creating large sub-sub-kd-trees
+		
+		/* Constructors and destructors: */
+		public:
+		CreateSubtreeTask(Node* sNodes,int sNumPoints,StoredPoint* sPoints,int sSplitDimension,Threads::TaskScheduler::TaskGroup& sGroup)
+			:nodes(sNodes),numPoints(sNumPoints),points(sPoints),splitDimension(sSplitDimension),group(sGroup)
+			{
+			}
+		
+		/* Methods from Threads::TaskScheduler::Task: */
+		virtual void execute(void)
+			{
+			createSubtree(nodes,numPoints,points,splitDimension,&group);
+			}
+		};
+	
+	static const int minTaskSize=4096; // Minimum number of points in sub-kd-trees that are created as separate tasks
+	
 	/* Elements: */
+	Node* nodeBlock; // Contiguous array holding the nodes of the balanced kd-tree in depth-first order
+	int numBlockNodes; // Number of nodes in the contiguous node array
 	Node* root; // Pointer to root node
 	
+	/* Private methods: */
+	static void createSubtree(Node* nodes,int numPoints,StoredPoint points[],int splitDimension,Threads::TaskScheduler::TaskGroup* group); // Creates a balanced sub-kd-tree for the array of points in the given node array; shuffles point array; submits large sub-sub-kd-trees to the task group if not null
+	void createTree(int numPoints,StoredPoint points[],Threads::TaskScheduler* taskScheduler); // Replaces the tree with a balanced kd-tree for the array of points
+	void deleteSubtree(Node* node); // Destroys the given node and its subtree
+	void deleteTree(void); // Destroys the entire tree
+	
 	/* Constructors and destructors: */
 	public:
 	PointKdTree(void) // Creates an empty kd-tree
-		:root(0)
+		:nodeBlock(0),numBlockNodes(0),root(0)
 		{
 		}
 	PointKdTree(int numPoints,StoredPoint points[]) // Creates balanced kd-tree from point array; shuffles point array in the process
-		:root(0)
+		:nodeBlock(0),numBlockNodes(0),root(0)
+		{
+		createTree(numPoints,points,0);
+		}
+	PointKdTree(int numPoints,StoredPoint points[],Threads::TaskScheduler& taskScheduler) // Ditto, but creates subtrees in parallel using the given task scheduler
+		:nodeBlock(0),numBlockNodes(0),root(0)
 		{
-		Scalar* heap=new Scalar[numPoints];
-		root=new Node(numPoints,points,0,heap);
-		delete[] heap;
+		createTree(numPoints,points,&taskScheduler);
 		}
 	~PointKdTree(void)
 		{
-		delete root;
+		deleteTree();
 		}
 	
 	/* Methods: */
 	void setPoints(int numPoints,StoredPoint points[]) // Creates balanced kd-tree from point array; shuffles point array in the process
 		{
-		delete root;
-		Scalar* heap=new Scalar[numPoints];
-		root=new Node(numPoints,points,0,heap);
-		delete[] heap;
+		createTree(numPoints,points,0);
+		}
+	void setPoints(int numPoints,StoredPoint points[],Threads::TaskScheduler& taskScheduler) // Ditto, but creates subtrees in parallel using the given task scheduler
+		{
+		createTree(numPoints,points,&taskScheduler);
 		}
 	void insertPoint(const StoredPoint& newPoint) // Inserts a new point into the kd-tree
 		{
@@ -23,6 +23,8 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #ifndef GEOMETRY_POINTOCTREE_INCLUDED
 #define GEOMETRY_POINTOCTREE_INCLUDED
 
+#include <stddef.h>
+#include <Threads/TaskScheduler.h>
 #include <Geometry/Vector.h>
 #include <Geometry/Point.h>
 #include <Geometry/ValuedPoint.h>
@@ -82,23 +84,16 @@ class PointOctree
 		int numPoints; // Number of points contained in this node's subtree
 		StoredPoint* points; // Pointer to (sub-)array of points contained in this node's subtree
 		
-		/* Helper methods: */
-		private:
-		static int splitPoints(int direction,Scalar mid,int numPoints,StoredPoint* points); // Splits a point array
-		
 		/* Constructors and destructors: */
-		public:
 		Node(void) // Creates uninitialized node
 			{
 			}
-		~Node(void) // Destroys a node and its subtree
+		Node(int sNumPoints,StoredPoint* sPoints) // Creates a leaf node for the given subarray of points
+			:children(0),numPoints(sNumPoints),points(sPoints)
 			{
-			if(children!=0)
-				delete[] children;
 			}
 		
 		/* Methods: */
-		void initialize(const Traversal& t,int sNumPoints,StoredPoint* sPoints,int maxNumPoints,int maxDepth); // Creates subtree storing the given subarray of points
 		bool isLeaf(void) const // Checks whether a node is a leaf
 			{
 			return children==0;
@@ -132,11 +127,77 @@ class PointOctree
 			}
 		};
 	
+	class SplitBody // Class to split the sub-arrays of a node's points along one direction in parallel
+		{
+		/* Elements: */
+		private:
+		int direction; // Splitting direction
+		Scalar mid; // Splitting coordinate
+		int halfStride; // Distance between split indices of the sub-arrays to split and their boundaries
+		StoredPoint* points; // Point array of the node
+		int* split; // Array of split indices of the node
+		
+		/* Constructors and destructors: */
+		public:
+		SplitBody(int sDirection,Scalar sMid,int sHalfStride,StoredPoint* sPoints,int* sSplit)
+			:direction(sDirection),mid(sMid),halfStride(sHalfStride),points(sPoints),split(sSplit)
+			{
+			}
+		
+		/* Methods: */
+		void operator()(size_t begin,size_t end) const
+			{
+			for(size_t i=begin;i<end;++i)
+				{
+				int splitIndex=halfStride*(2*int(i)+1);
+				int left=split[splitIndex-halfStride];
+				split[splitIndex]=splitPoints(direction,mid,split[splitIndex+halfStride]-left,points+left)+left;
+				}
+			}
+		};
+	
+	class SplitLevelBody // Class to split the nodes of one tree level in parallel
+		{
+		/* Elements: */
+		private:
+		Node* nodes; // Array of the level's nodes
+		const Traversal* traversals; // Array of the level's nodes' traversal structures
+		int* splits; // Array of nine split indices for each of the level's nodes; first index is -1 for leaf nodes
+		int maxNumPoints; // Maximum number of points in leaf nodes
+		Threads::TaskScheduler* taskScheduler; // Task scheduler to split large nodes in parallel, or null
+		
+		/* Constructors and destructors: */
+		public:
+		SplitLevelBody(Node* sNodes,const Traversal* sTraversals,int* sSplits,int sMaxNumPoints,Threads::TaskScheduler* sTaskScheduler)
+			:nodes(sNodes),traversals(sTraversals),splits(sSplits),maxNumPoints(sMaxNumPoints),taskScheduler(sTaskScheduler)
+			{
+			}
+		
+		/* Methods: */
+		void operator()(size_t begin,size_t end) const
+			{
+			for(size_t i=begin;i<end;++i)
+				{
+				if(nodes[i].numPoints>maxNumPoints)
+					splitNode(traversals[i],nodes[i].numPoints,nodes[i].points,splits+i*9,taskScheduler);
+				else
+					splits[i*9]=-1;
+				}
+			}
+		};
+	
+	static const int minParallelSplitSize=65536; // Minimum number of points in nodes whose sub-arrays are split in parallel
+	
 	/* Elements: */
 	int numPoints; // The number of points in the tree
 	StoredPoint* points; // The array of points in the tree
 	Traversal rootTraversal; // Traversal structure describing the tree's root
-	Node* root; // The root node of the tree
+	Node* root; // The root node of the tree, followed by all other nodes in breadth-first order; each interior node's eight children are adjacent
+	
+	/* Private methods: */
+	static int splitPoints(int direction,Scalar mid,int numPoints,StoredPoint* points); // Splits a point array
+	static void splitNode(const Traversal& t,int numPoints,StoredPoint* points,int split[9],Threads::TaskScheduler* taskScheduler); // Splits a node's point array into the sub-arrays of its eight children
+	void createTree(int maxNumPoints,int maxDepth,Threads::TaskScheduler* taskScheduler); // Creates the node array for the current point array
 	
 	/* Constructors and destructors: */
 	public:
@@ -145,11 +206,13 @@ class PointOctree
 		{
 		}
 	PointOctree(const Point& min,const Point& max,int sNumPoints,StoredPoint* sPoints,int maxNumPoints,int maxDepth); // Creates an octree of the given size, containing the given points
+	PointOctree(const Point& min,const Point& max,int sNumPoints,StoredPoint* sPoints,int maxNumPoints,int maxDepth,Threads::TaskScheduler& taskScheduler); // Ditto, but splits nodes in parallel using the given task scheduler
 	~PointOctree(void);
 	
 	/* Methods: */
 	void clear(void); // Clears the octree
 	void setPoints(const Point& min,const Point& max,int sNumPoints,StoredPoint* sPoints,int maxNumPoints,int maxDepth);
+	void setPoints(const Point& min,const Point& max,int sNumPoints,StoredPoint* sPoints,int maxNumPoints,int maxDepth,Threads::TaskScheduler& taskScheduler); // Ditto, but splits nodes in parallel using the given task scheduler
 	const StoredPoint& findClosePoint(const Point& p) const // Returns a point "close" to the given point
 		{
 		return *root->findClosePoint(p,rootTraversal);
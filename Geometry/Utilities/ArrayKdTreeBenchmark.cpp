@@ -0,0 +1,170 @@
+/***********************************************************************
+ArrayKdTreeBenchmark - Program to compare the throughput of per-query
+and batched closest point queries on a large array-based kd-tree, with
+and without distributing batches across a task scheduler.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Templatized Geometry Library (TGL).
+
+The Templatized Geometry Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Templatized Geometry Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Templatized Geometry Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Threads/TaskScheduler.h>
+#include <Geometry/Point.h>
+#include <Geometry/ValuedPoint.h>
+#include <Geometry/ArrayKdTree.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+typedef Geometry::Point<float,3> Point;
+typedef Geometry::ValuedPoint<Point,unsigned int> StoredPoint;
+typedef Geometry::ArrayKdTree<StoredPoint> Tree;
+
+Point randomPoint(unsigned int& seed) // Returns a random point inside the unit cube
+	{
+	Point result;
+	for(int i=0;i<3;++i)
+		result[i]=float(rand_r(&seed))/float(RAND_MAX);
+	return result;
+	}
+
+void printResult(const char* name,size_t numQueries,double elapsed,double baseline,unsigned int numMismatches)
+	{
+	std::cout<<std::setw(24)<<std::left<<name<<std::right;
+	std::cout<<std::setw(10)<<std::fixed<<std::setprecision(3)<<elapsed;
+	std::cout<<std::setw(12)<<std::setprecision(0)<<double(numQueries)/elapsed;
+	std::cout<<std::setw(10)<<std::setprecision(2)<<baseline/elapsed;
+	std::cout<<std::setw(12)<<numMismatches<<std::endl;
+	}
+
+unsigned int countMismatches(size_t numQueries,const Point* queries,const StoredPoint* const* results,const StoredPoint* const* reference)
+	{
+	/* Compare distances instead of pointers, as equidistant points may be reported in either order: */
+	unsigned int numMismatches=0;
+	for(size_t i=0;i<numQueries;++i)
+		if(results[i]!=reference[i]&&Geometry::sqrDist(queries[i],*results[i])!=Geometry::sqrDist(queries[i],*reference[i]))
+			++numMismatches;
+	return numMismatches;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	int numPoints=10000000;
+	size_t numQueries=1000000;
+	unsigned int numThreads=4;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"points")==0&&i+1<argc)
+				{
+				numPoints=atoi(argv[i+1]);
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"queries")==0&&i+1<argc)
+				{
+				numQueries=size_t(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"threads")==0&&i+1<argc)
+				{
+				numThreads=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-points <number of tree points>] [-queries <number of queries>] [-threads <number of task scheduler worker threads>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	/* Create a tree of random points: */
+	unsigned int seed=1U;
+	Tree tree;
+	Misc::Time startTime=Misc::Time::now();
+	StoredPoint* points=tree.createTree(numPoints);
+	for(int i=0;i<numPoints;++i)
+		points[i]=StoredPoint(randomPoint(seed),(unsigned int)(i));
+	tree.releasePoints(numThreads>0?numThreads:1);
+	double buildTime=toSeconds(Misc::Time::now()-startTime);
+	
+	/* Create random query positions, half of them near tree points and half anywhere in the domain: */
+	Point* queries=new Point[numQueries];
+	for(size_t i=0;i<numQueries;++i)
+		{
+		if(i%2==0)
+			{
+			queries[i]=tree.accessPoints()[rand_r(&seed)%numPoints];
+			for(int j=0;j<3;++j)
+				queries[i][j]+=(float(rand_r(&seed))/float(RAND_MAX)-0.5f)*1.0e-3f;
+			}
+		else
+			queries[i]=randomPoint(seed);
+		}
+	
+	std::cout<<numPoints<<" points, built in "<<std::fixed<<std::setprecision(3)<<buildTime<<" s; "<<numQueries<<" queries"<<std::endl;
+	std::cout<<"Method                  Time (s)   Queries/s   Speedup  Mismatches"<<std::endl;
+	
+	/* Run the queries one by one: */
+	const StoredPoint** reference=new const StoredPoint*[numQueries];
+	startTime=Misc::Time::now();
+	for(size_t i=0;i<numQueries;++i)
+		reference[i]=&tree.findClosestPoint(queries[i]);
+	double baseline=toSeconds(Misc::Time::now()-startTime);
+	printResult("per-query",numQueries,baseline,baseline,0);
+	
+	/* Run the queries as a single batch in this thread: */
+	const StoredPoint** results=new const StoredPoint*[numQueries];
+	memset(results,0,numQueries*sizeof(const StoredPoint*));
+	startTime=Misc::Time::now();
+	tree.findClosestPoints(numQueries,queries,results);
+	double elapsed=toSeconds(Misc::Time::now()-startTime);
+	printResult("batched",numQueries,elapsed,baseline,countMismatches(numQueries,queries,results,reference));
+	
+	/* Run the queries as a single batch distributed across a task scheduler: */
+	if(numThreads>0)
+		{
+		Threads::TaskScheduler taskScheduler(numThreads);
+		memset(results,0,numQueries*sizeof(const StoredPoint*));
+		startTime=Misc::Time::now();
+		tree.findClosestPoints(numQueries,queries,results,&taskScheduler);
+		elapsed=toSeconds(Misc::Time::now()-startTime);
+		char name[32];
+		snprintf(name,sizeof(name),"batched, %u threads",numThreads);
+		printResult(name,numQueries,elapsed,baseline,countMismatches(numQueries,queries,results,reference));
+		}
+	
+	delete[] results;
+	delete[] reference;
+	delete[] queries;
+	
+	return 0;
+	}
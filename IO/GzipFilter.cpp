@@ -22,6 +22,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <IO/GzipFilter.h>
 
+#include <string.h>
+#include <stdexcept>
 #include <Misc/ThrowStdErr.h>
 #include <IO/StandardFile.h>
 
@@ -33,55 +35,76 @@ Methods of class GzipFilter:
 
 size_t GzipFilter::readData(File::Byte* buffer,size_t bufferSize)
 	{
-	/* Check for end-of-file: */
-	if(readEof)
-		return 0;
-	
-	/* Decompress data into the given buffer: */
-	stream.next_out=buffer;
-	stream.avail_out=bufferSize;
+	/* Decompress directly into the given buffer if there are no background threads: */
+	if(numBlocks==0)
+		return inflateData(buffer,bufferSize);
 	
-	/* Try until at least some output is produced: */
-	do
+	while(!blocksEof)
 		{
-		/* Check if the decompressor needs more input: */
-		if(stream.avail_in==0)
+		if(haveReadBlock)
 			{
-			/* Read the next glob of compressed data: */
-			void* compressedBuffer;
-			size_t compressedSize=gzippedFile->readInBuffer(compressedBuffer);
+			Threads::Mutex::Lock blockLock(blockMutex);
 			
-			/* Pass the compressed data to the decompressor: */
-			stream.next_in=static_cast<Bytef*>(compressedBuffer);
-			stream.avail_in=compressedSize;
+			/* Release the previously read block: */
+			blocks[readPos%numBlocks].state=Block::EMPTY;
+			++readPos;
+			haveReadBlock=false;
+			blockCond.broadcast();
 			}
 		
-		/* Decompress from the gzipped file's buffer: */
-		int result=inflate(&stream,Z_NO_FLUSH);
-		if(result==Z_STREAM_END)
+		if(blockMode)
 			{
-			/* Set the eof flag and clean out the decompressor: */
-			readEof=true;
-			if(inflateEnd(&stream)!=Z_OK)
+			/* Queue compressed blocks for the background threads until the ring buffer is full: */
+			while(!compressedEof&&fillPos-readPos<numBlocks)
 				{
-				if(stream.msg!=0)
-					Misc::throwStdErr("IO::GzipFilter: Error \"%s\" after decompression",stream.msg);
+				Block& block=blocks[fillPos%numBlocks];
+				if(readBgzfBlock(block))
+					{
+					Threads::Mutex::Lock blockLock(blockMutex);
+					block.state=Block::QUEUED;
+					++fillPos;
+					blockCond.broadcast();
+					}
 				else
-					Misc::throwStdErr("IO::GzipFilter: Data corruption detected after decompression");
+					compressedEof=true;
+				}
+			
+			/* Check if all blocks have been read: */
+			if(readPos==fillPos)
+				{
+				blocksEof=true;
+				break;
 				}
-			break;
 			}
-		else if(result!=Z_OK)
+		
+		/* Wait until the next block in file order has been decompressed: */
+		Block& block=blocks[readPos%numBlocks];
+		{
+		Threads::Mutex::Lock blockLock(blockMutex);
+		while(block.state!=Block::DECOMPRESSED&&block.state!=Block::FAILED)
+			blockCond.wait(blockMutex);
+		haveReadBlock=true;
+		if(block.state==Block::FAILED)
 			{
-			if(stream.msg!=0)
-				Misc::throwStdErr("IO::GzipFilter: Error \"%s\" while decompressing",stream.msg);
-			else
-				Misc::throwStdErr("IO::GzipFilter: Internal zlib error while decompressing");
+			/* Treat all further reads as end-of-file and report the error: */
+			blocksEof=true;
+			throw std::runtime_error(decompressionError);
 			}
 		}
-	while(stream.avail_out==bufferSize);
+		
+		if(block.uncompressedSize>0)
+			{
+			/* Hand the block's uncompressed data to the reader: */
+			setReadBuffer(maxBlockSize,block.uncompressed,false);
+			return block.uncompressedSize;
+			}
+		
+		/* An empty block signals end-of-file in stream mode; empty BGZF blocks are skipped: */
+		if(!blockMode)
+			blocksEof=true;
+		}
 	
-	return bufferSize-stream.avail_out;
+	return 0;
 	}
 
 void GzipFilter::writeData(const File::Byte* buffer,size_t bufferSize)
@@ -111,6 +134,12 @@ void GzipFilter::writeData(const File::Byte* buffer,size_t bufferSize)
 		}
 	}
 
+bool GzipFilter::isBgzfHeader(const File::Byte* header)
+	{
+	/* Check for a gzip member header with an extra field consisting only of a BGZF block size subfield: */
+	return header[0]==0x1fU&&header[1]==0x8bU&&header[2]==8U&&(header[3]&0x04U)!=0&&header[10]==6U&&header[11]==0U&&header[12]=='B'&&header[13]=='C'&&header[14]==2U&&header[15]==0U;
+	}
+
 void GzipFilter::init(void)
 	{
 	/* Adopt the compressed file's write mode: */
@@ -120,43 +149,101 @@ void GzipFilter::init(void)
 		Misc::throwStdErr("IO::GzipFilter: Cannot read and write from/to gzipped file simultaneously");
 	else if(canRead)
 		{
-		/* Install an output buffer for uncompressed data: */
-		resizeReadBuffer(gzippedFile->getReadBufferSize()*2);
+		/* Read the beginning of the compressed file to check whether it consists of independent BGZF blocks: */
+		headerPrefixSize=0;
+		while(headerPrefixSize<bgzfHeaderSize)
+			{
+			size_t readSize=gzippedFile->readUpTo(headerPrefix+headerPrefixSize,bgzfHeaderSize-headerPrefixSize);
+			if(readSize==0)
+				break;
+			headerPrefixSize+=readSize;
+			}
+		blockMode=numThreads>0&&headerPrefixSize==bgzfHeaderSize&&isBgzfHeader(headerPrefix);
 		
-		/* Initialize the zlib stream object: */
-		stream.next_in=Z_NULL;
-		stream.avail_in=0;
-		stream.zalloc=Z_NULL;
-		stream.zfree=Z_NULL;
-		stream.opaque=0;
-		if(inflateInit2(&stream,15+16)!=Z_OK) // Detect only gzip headers
+		if(!blockMode)
 			{
-			if(stream.msg!=0)
-				throw OpenError(Misc::printStdErrMsg("IO::GzipFilter: Error \"%s\" during initialization",stream.msg));
-			else
-				throw OpenError(Misc::printStdErrMsg("IO::GzipFilter: Internal zlib error during initialization"));
+			/* Initialize the zlib stream object: */
+			stream.next_in=Z_NULL;
+			stream.avail_in=0;
+			stream.zalloc=Z_NULL;
+			stream.zfree=Z_NULL;
+			stream.opaque=0;
+			if(inflateInit2(&stream,15+16)!=Z_OK) // Detect only gzip headers
+				{
+				if(stream.msg!=0)
+					throw OpenError(Misc::printStdErrMsg("IO::GzipFilter: Error \"%s\" during initialization",stream.msg));
+				else
+					throw OpenError(Misc::printStdErrMsg("IO::GzipFilter: Internal zlib error during initialization"));
+				}
+			
+			/* Read the gzip header to determine if the file really is gzip-compressed, starting with the already-read prefix: */
+			stream.next_in=headerPrefix;
+			stream.avail_in=headerPrefixSize;
+			bool haveHeader=false;
+			while(!haveHeader)
+				{
+				if(stream.avail_in==0)
+					{
+					/* Read the next glob of compressed data: */
+					void* compressedBuffer;
+					size_t compressedSize=gzippedFile->readInBuffer(compressedBuffer);
+					stream.next_in=static_cast<Bytef*>(compressedBuffer);
+					stream.avail_in=compressedSize;
+					}
+				
+				/* Need to assign an output buffer, even though no output will be produced: */
+				Bytef outBuffer[1];
+				stream.next_out=outBuffer;
+				stream.avail_out=1;
+				
+				/* Try processing the header: */
+				int result=inflate(&stream,Z_BLOCK);
+				if(result==Z_STREAM_END)
+					break;
+				else if(result!=Z_OK)
+					throw OpenError("IO::GzipFilter: File is not gzip-compressed");
+				
+				/* Check if the decompressor stopped right after the header: */
+				haveHeader=(stream.data_type&128)!=0;
+				}
 			}
 		
-		/* Read the gzip header to determine if the file really is gzip-compressed: */
-		while(stream.avail_in==0)
+		if(numThreads>0)
 			{
-			/* Read the next glob of compressed data: */
-			void* compressedBuffer;
-			size_t compressedSize=gzippedFile->readInBuffer(compressedBuffer);
-			stream.next_in=static_cast<Bytef*>(compressedBuffer);
-			stream.avail_in=compressedSize;
+			/* Create the decompression ring buffer: */
+			numBlocks=blockMode?numThreads*2+2:4;
+			blocks=new Block[numBlocks];
+			size_t blockBufferSize=blockMode?maxBlockSize*2:maxBlockSize;
+			blockMemory=new Byte[numBlocks*blockBufferSize];
+			for(unsigned int i=0;i<numBlocks;++i)
+				{
+				Byte* blockBuffer=blockMemory+i*blockBufferSize;
+				blocks[i].compressed=blockMode?blockBuffer:0;
+				blocks[i].compressedSize=0;
+				blocks[i].uncompressed=blockMode?blockBuffer+maxBlockSize:blockBuffer;
+				blocks[i].uncompressedSize=0;
+				blocks[i].state=Block::EMPTY;
+				}
 			
-			/* Need to assign an output buffer, even though no output will be produced: */
-			Bytef outBuffer[1];
-			stream.next_out=outBuffer;
-			stream.avail_out=1;
+			/* Start the background decompression threads; regular gzip files can only be decompressed sequentially: */
+			if(!blockMode)
+				numThreads=1;
+			decompressionThreads=new Threads::Thread[numThreads];
+			for(unsigned int i=0;i<numThreads;++i)
+				{
+				if(blockMode)
+					decompressionThreads[i].start(this,&GzipFilter::blockDecompressionThreadMethod);
+				else
+					decompressionThreads[i].start(this,&GzipFilter::streamDecompressionThreadMethod);
+				}
 			
-			/* Try processing the header: */
-			int result=inflate(&stream,Z_BLOCK);
-			if(result==Z_STREAM_END)
-				break;
-			else if(result!=Z_OK)
-				throw OpenError("IO::GzipFilter: File is not gzip-compressed");
+			/* Disable read-through; decompressed data is handed to the reader in ring buffer blocks: */
+			canReadThrough=false;
+			}
+		else
+			{
+			/* Install an output buffer for uncompressed data: */
+			resizeReadBuffer(gzippedFile->getReadBufferSize()*2);
 			}
 		}
 	else if(canWrite)
@@ -180,26 +267,270 @@ void GzipFilter::init(void)
 		}
 	}
 
-GzipFilter::GzipFilter(FilePtr sGzippedFile)
+size_t GzipFilter::inflateData(File::Byte* buffer,size_t bufferSize)
+	{
+	/* Check for end-of-file: */
+	if(readEof)
+		return 0;
+	
+	/* Decompress data into the given buffer: */
+	stream.next_out=buffer;
+	stream.avail_out=bufferSize;
+	
+	/* Try until at least some output is produced: */
+	do
+		{
+		/* Check if the decompressor needs more input: */
+		if(stream.avail_in==0)
+			{
+			/* Read the next glob of compressed data: */
+			void* compressedBuffer;
+			size_t compressedSize=gzippedFile->readInBuffer(compressedBuffer);
+			
+			/* Pass the compressed data to the decompressor: */
+			stream.next_in=static_cast<Bytef*>(compressedBuffer);
+			stream.avail_in=compressedSize;
+			}
+		
+		/* Decompress from the gzipped file's buffer: */
+		int result=inflate(&stream,Z_NO_FLUSH);
+		if(result==Z_STREAM_END)
+			{
+			/* Check if another gzip member follows the just-finished one: */
+			if(stream.avail_in==0)
+				{
+				void* compressedBuffer;
+				size_t compressedSize=gzippedFile->readInBuffer(compressedBuffer);
+				stream.next_in=static_cast<Bytef*>(compressedBuffer);
+				stream.avail_in=compressedSize;
+				}
+			if(stream.avail_in>0&&stream.next_in[0]==0x1fU)
+				{
+				/* Restart the decompressor on the next member: */
+				if(inflateReset(&stream)!=Z_OK)
+					Misc::throwStdErr("IO::GzipFilter: Internal zlib error while decompressing");
+				continue;
+				}
+			
+			/* Set the eof flag and clean out the decompressor: */
+			readEof=true;
+			if(inflateEnd(&stream)!=Z_OK)
+				{
+				if(stream.msg!=0)
+					Misc::throwStdErr("IO::GzipFilter: Error \"%s\" after decompression",stream.msg);
+				else
+					Misc::throwStdErr("IO::GzipFilter: Data corruption detected after decompression");
+				}
+			break;
+			}
+		else if(result!=Z_OK)
+			{
+			if(stream.msg!=0)
+				Misc::throwStdErr("IO::GzipFilter: Error \"%s\" while decompressing",stream.msg);
+			else
+				Misc::throwStdErr("IO::GzipFilter: Internal zlib error while decompressing");
+			}
+		}
+	while(stream.avail_out==bufferSize);
+	
+	return bufferSize-stream.avail_out;
+	}
+
+bool GzipFilter::readBgzfBlock(GzipFilter::Block& block)
+	{
+	/* Read the block's gzip member header, starting with the header prefix read during initialization: */
+	size_t headerSize=headerPrefixSize;
+	memcpy(block.compressed,headerPrefix,headerPrefixSize);
+	headerPrefixSize=0;
+	while(headerSize<bgzfHeaderSize)
+		{
+		size_t readSize=gzippedFile->readUpTo(block.compressed+headerSize,bgzfHeaderSize-headerSize);
+		if(readSize==0)
+			break;
+		headerSize+=readSize;
+		}
+	
+	/* Check for end-of-file: */
+	if(headerSize==0)
+		return false;
+	if(headerSize<bgzfHeaderSize||!isBgzfHeader(block.compressed))
+		Misc::throwStdErr("IO::GzipFilter: Malformed BGZF block header");
+	
+	/* Read the rest of the block: */
+	block.compressedSize=(size_t(block.compressed[16])|(size_t(block.compressed[17])<<8))+1;
+	if(block.compressedSize<bgzfHeaderSize+8)
+		Misc::throwStdErr("IO::GzipFilter: Malformed BGZF block header");
+	gzippedFile->readRaw(block.compressed+bgzfHeaderSize,block.compressedSize-bgzfHeaderSize);
+	
+	return true;
+	}
+
+void* GzipFilter::streamDecompressionThreadMethod(void)
+	{
+	while(true)
+		{
+		/* Wait for a free slot in the ring buffer: */
+		Block* block;
+		{
+		Threads::Mutex::Lock blockLock(blockMutex);
+		while(!shutdownThreads&&fillPos-readPos==numBlocks)
+			blockCond.wait(blockMutex);
+		if(shutdownThreads)
+			break;
+		block=&blocks[fillPos%numBlocks];
+		}
+		
+		/* Fill the block with as much decompressed data as possible: */
+		size_t blockSize=0;
+		bool failed=false;
+		std::string error;
+		try
+			{
+			while(blockSize<maxBlockSize)
+				{
+				size_t readSize=inflateData(block->uncompressed+blockSize,maxBlockSize-blockSize);
+				if(readSize==0)
+					break;
+				blockSize+=readSize;
+				}
+			}
+		catch(std::runtime_error err)
+			{
+			/* Hand the error to the reader: */
+			failed=true;
+			error=err.what();
+			}
+		
+		{
+		Threads::Mutex::Lock blockLock(blockMutex);
+		
+		/* Hand the block to the reader: */
+		block->uncompressedSize=blockSize;
+		block->state=failed?Block::FAILED:Block::DECOMPRESSED;
+		if(failed)
+			decompressionError=error;
+		++fillPos;
+		blockCond.broadcast();
+		}
+		
+		/* Stop at end-of-file or after an error: */
+		if(blockSize==0||failed)
+			break;
+		}
+	
+	return 0;
+	}
+
+void* GzipFilter::blockDecompressionThreadMethod(void)
+	{
+	/* Initialize a private zlib decompression object: */
+	z_stream blockStream;
+	blockStream.next_in=Z_NULL;
+	blockStream.avail_in=0;
+	blockStream.zalloc=Z_NULL;
+	blockStream.zfree=Z_NULL;
+	blockStream.opaque=0;
+	bool streamValid=inflateInit2(&blockStream,15+16)==Z_OK;
+	
+	while(true)
+		{
+		/* Wait for the next queued block: */
+		Block* block;
+		{
+		Threads::Mutex::Lock blockLock(blockMutex);
+		while(!shutdownThreads&&decompressPos==fillPos)
+			blockCond.wait(blockMutex);
+		if(shutdownThreads)
+			break;
+		block=&blocks[decompressPos%numBlocks];
+		++decompressPos;
+		}
+		
+		/* Decompress the block, which is a complete gzip member: */
+		size_t blockSize=0;
+		bool decompressed=false;
+		if(streamValid&&inflateReset(&blockStream)==Z_OK)
+			{
+			blockStream.next_in=block->compressed;
+			blockStream.avail_in=block->compressedSize;
+			blockStream.next_out=block->uncompressed;
+			blockStream.avail_out=maxBlockSize;
+			decompressed=inflate(&blockStream,Z_FINISH)==Z_STREAM_END;
+			blockSize=maxBlockSize-blockStream.avail_out;
+			}
+		
+		{
+		Threads::Mutex::Lock blockLock(blockMutex);
+		
+		/* Hand the block to the reader: */
+		block->uncompressedSize=blockSize;
+		if(decompressed)
+			block->state=Block::DECOMPRESSED;
+		else
+			{
+			block->state=Block::FAILED;
+			decompressionError="IO::GzipFilter: Data corruption detected in BGZF block";
+			}
+		blockCond.broadcast();
+		}
+		}
+	
+	/* Clean up: */
+	if(streamValid)
+		inflateEnd(&blockStream);
+	
+	return 0;
+	}
+
+GzipFilter::GzipFilter(FilePtr sGzippedFile,unsigned int sNumThreads)
 	:File(),
 	 gzippedFile(sGzippedFile),
-	 readEof(false)
+	 readEof(false),
+	 numThreads(sNumThreads),headerPrefixSize(0),blockMode(false),
+	 numBlocks(0),blocks(0),blockMemory(0),
+	 fillPos(0),decompressPos(0),readPos(0),
+	 haveReadBlock(false),compressedEof(false),blocksEof(false),
+	 shutdownThreads(false),decompressionThreads(0)
 	{
 	init();
 	}
 
-GzipFilter::GzipFilter(const char* gzippedFileName,File::AccessMode sAccessMode)
+GzipFilter::GzipFilter(const char* gzippedFileName,File::AccessMode sAccessMode,unsigned int sNumThreads)
 	:File(),
 	 gzippedFile(new IO::StandardFile(gzippedFileName,sAccessMode)),
-	 readEof(false)
+	 readEof(false),
+	 numThreads(sNumThreads),headerPrefixSize(0),blockMode(false),
+	 numBlocks(0),blocks(0),blockMemory(0),
+	 fillPos(0),decompressPos(0),readPos(0),
+	 haveReadBlock(false),compressedEof(false),blocksEof(false),
+	 shutdownThreads(false),decompressionThreads(0)
 	{
 	init();
 	}
 
 GzipFilter::~GzipFilter(void)
 	{
+	if(decompressionThreads!=0)
+		{
+		{
+		Threads::Mutex::Lock blockLock(blockMutex);
+		
+		/* Shut down the background decompression threads: */
+		shutdownThreads=true;
+		blockCond.broadcast();
+		}
+		for(unsigned int i=0;i<numThreads;++i)
+			decompressionThreads[i].join();
+		delete[] decompressionThreads;
+		
+		/* Release the file's read buffer and delete the ring buffer: */
+		setReadBuffer(0,0,false);
+		delete[] blocks;
+		delete[] blockMemory;
+		}
+	
 	/* Clean out the compressor/decompressor: */
-	if(getReadBufferSize()!=0&&!readEof)
+	if(getReadBufferSize()!=0&&!blockMode&&!readEof)
 		inflateEnd(&stream);
 	if(getWriteBufferSize()!=0)
 		{
@@ -233,4 +564,22 @@ GzipFilter::~GzipFilter(void)
 		}
 	}
 
+size_t GzipFilter::getReadBufferSize(void) const
+	{
+	/* Return the size of a ring buffer block if there are background threads: */
+	if(numBlocks!=0)
+		return maxBlockSize;
+	else
+		return File::getReadBufferSize();
+	}
+
+size_t GzipFilter::resizeReadBuffer(size_t newReadBufferSize)
+	{
+	/* Ignore the request if there are background threads: */
+	if(numBlocks!=0)
+		return maxBlockSize;
+	else
+		return File::resizeReadBuffer(newReadBufferSize);
+	}
+
 }
@@ -23,18 +23,62 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef IO_GZIPFILTER_INCLUDED
 #define IO_GZIPFILTER_INCLUDED
 
+#include <stddef.h>
 #include <zlib.h>
+#include <string>
+#include <Threads/Mutex.h>
+#include <Threads/Cond.h>
+#include <Threads/Thread.h>
 #include <IO/File.h>
 
 namespace IO {
 
 class GzipFilter:public IO::File
 	{
-	/* Elements: */
+	/* Embedded classes: */
 	private:
+	static const size_t bgzfHeaderSize=18; // Size of the gzip member header of a BGZF block
+	static const size_t maxBlockSize=65536; // Maximum size of compressed or uncompressed data in a decompression block
+	
+	struct Block // Structure for slots in the ring buffer of blocks being decompressed in the background
+		{
+		/* Embedded classes: */
+		public:
+		enum State // Enumerated type for block states
+			{
+			EMPTY,QUEUED,DECOMPRESSED,FAILED
+			};
+		
+		/* Elements: */
+		Byte* compressed; // Buffer for the block's compressed data; only used for BGZF blocks
+		size_t compressedSize; // Amount of compressed data in the block
+		Byte* uncompressed; // Buffer for the block's uncompressed data
+		size_t uncompressedSize; // Amount of uncompressed data in the block
+		State state; // Current state of the block
+		};
+	
+	/* Elements: */
 	FilePtr gzippedFile; // Underlying gzip-compressed file
 	z_stream stream; // Zlib compression/decompression structure
 	bool readEof; // Flag if the zlib decompressor has signaled end-of-file
+	unsigned int numThreads; // Number of requested background decompression threads; decompresses in the reader's thread if zero
+	Byte headerPrefix[bgzfHeaderSize]; // Beginning of the gzip-compressed file, read to detect BGZF files
+	size_t headerPrefixSize; // Amount of data in the header prefix
+	bool blockMode; // Flag if the file consists of independent BGZF blocks that are decompressed by a pool of background threads
+	unsigned int numBlocks; // Number of slots in the decompression ring buffer; zero if there are no background threads
+	Block* blocks; // Ring buffer of blocks being decompressed
+	Byte* blockMemory; // Memory allocated for the block buffers
+	Threads::Mutex blockMutex; // Mutex serializing access to the ring buffer's state
+	Threads::Cond blockCond; // Condition variable to signal a change in the ring buffer's state
+	unsigned int fillPos; // Number of blocks handed to the background threads
+	unsigned int decompressPos; // Number of blocks picked up by the background threads for decompression; only used in block mode
+	unsigned int readPos; // Number of blocks consumed by the reader
+	bool haveReadBlock; // Flag if the reader's current read buffer is a block from the ring buffer
+	bool compressedEof; // Flag if all compressed blocks have been read from the gzip-compressed file; only used in block mode
+	bool blocksEof; // Flag if the reader has consumed all decompressed blocks
+	std::string decompressionError; // Error message from a failed background decompression
+	bool shutdownThreads; // Flag to shut down the background decompression threads
+	Threads::Thread* decompressionThreads; // Array of background decompression threads
 	
 	/* Methods from File: */
 	protected:
@@ -43,13 +87,22 @@ class GzipFilter:public IO::File
 	
 	/* Private methods: */
 	private:
+	static bool isBgzfHeader(const Byte* header); // Returns true if the given gzip member header starts a BGZF block
 	void init(void); // Initializes the compressor/decompressor
+	size_t inflateData(Byte* buffer,size_t bufferSize); // Decompresses data from the gzip-compressed file into the given buffer; returns zero at end of file
+	bool readBgzfBlock(Block& block); // Reads the next BGZF block from the gzip-compressed file into the given block; returns false at end of file
+	void* streamDecompressionThreadMethod(void); // Method decompressing a regular gzip-compressed file in the background
+	void* blockDecompressionThreadMethod(void); // Method decompressing queued BGZF blocks in the background
 	
 	/* Constructors and destructors: */
 	public:
-	GzipFilter(FilePtr sGzippedFile); // Creates a gzip filter for the given underlying gzip-compressed file; inherits access mode from compressed file
-	GzipFilter(const char* gzippedFileName,File::AccessMode sAccessMode); // Opens the gzip-compressed file of the given name with the given access mode
+	GzipFilter(FilePtr sGzippedFile,unsigned int sNumThreads =0); // Creates a gzip filter for the given underlying gzip-compressed file; inherits access mode from compressed file; decompresses in the given number of background threads if non-zero
+	GzipFilter(const char* gzippedFileName,File::AccessMode sAccessMode,unsigned int sNumThreads =0); // Opens the gzip-compressed file of the given name with the given access mode
 	virtual ~GzipFilter(void); // Destroys the gzip filter
+	
+	/* Methods from File: */
+	virtual size_t getReadBufferSize(void) const;
+	virtual size_t resizeReadBuffer(size_t newReadBufferSize);
 	};
 
 }
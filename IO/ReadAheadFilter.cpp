@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <stdexcept>
 #include <Misc/Utility.h>
+#include <IO/StandardFile.h>
 
 namespace IO {
 
@@ -38,25 +39,31 @@ size_t ReadAheadFilter::readData(File::Byte* buffer,size_t bufferSize)
 	
 	if(haveReadOnce)
 		{
-		/* Release the just-finished buffer half: */
-		--numFullBuffers;
-		bufferCond.signal();
+		/* Release the just-finished ring buffer slot: */
+		--numFullSlots;
+		
+		/* Wake up the read-ahead thread if the ring buffer drained to the low-water mark: */
+		if(readAheadWaiting&&numFullSlots<=lowWaterMark)
+			bufferCond.signal();
 		}
 	
-	/* Check if the double buffer is empty: */
-	while(numFullBuffers==0)
+	/* Check if the ring buffer is empty: */
+	while(numFullSlots==0)
 		{
 		/* Wait for more data: */
+		readerWaiting=true;
 		bufferCond.wait(bufferMutex);
+		readerWaiting=false;
 		}
 	}
 	
-	/* Read from the next double buffer half: */
-	outBuffer=1-outBuffer;
-	setReadBuffer(bufferSizes[outBuffer],buffers[outBuffer],false);
+	/* Read from the next ring buffer slot: */
+	if(++outSlot==numSlots)
+		outSlot=0;
+	setReadBuffer(slotSize,slots[outSlot],false);
 	haveReadOnce=true;
 	
-	return bufferSizes[outBuffer];
+	return slotDataSizes[outSlot];
 	}
 
 void* ReadAheadFilter::readAheadThreadMethod(void)
@@ -67,10 +74,11 @@ void* ReadAheadFilter::readAheadThreadMethod(void)
 	
 	do
 		{
-		/* Fill the next double-buffer half: */
-		inBuffer=1-inBuffer;
-		Byte* bufPtr=buffers[inBuffer];
-		size_t bufSize=halfBufferSize;
+		/* Fill the next ring buffer slot: */
+		if(++inSlot==numSlots)
+			inSlot=0;
+		Byte* bufPtr=slots[inSlot];
+		size_t bufSize=slotSize;
 		try
 			{
 			while(bufSize>0)
@@ -85,46 +93,61 @@ void* ReadAheadFilter::readAheadThreadMethod(void)
 				bufPtr+=readSize;
 				bufSize-=readSize;
 				}
-			bufferSizes[inBuffer]=halfBufferSize-bufSize;
+			slotDataSizes[inSlot]=slotSize-bufSize;
 			}
 		catch(std::runtime_error)
 			{
 			/* Ignore the error; reader thread will treat it as end-of-file: */
-			bufferSizes[inBuffer]=0;
+			slotDataSizes[inSlot]=0;
 			}
 		
 		{
 		Threads::Mutex::Lock bufferLock(bufferMutex);
 		
-		/* Hand the filled buffer to the reader: */
-		++numFullBuffers;
-		bufferCond.signal();
+		/* Hand the filled slot to the reader: */
+		++numFullSlots;
+		if(readerWaiting)
+			bufferCond.signal();
 		
-		/* Check if the double buffer is full: */
-		while(numFullBuffers==2)
+		/* Check if the ring buffer is full: */
+		if(numFullSlots==numSlots)
 			{
-			/* Wait for room in the buffer: */
-			bufferCond.wait(bufferMutex);
+			/* Wait until the reader drained the ring buffer to the low-water mark: */
+			readAheadWaiting=true;
+			while(numFullSlots>lowWaterMark)
+				bufferCond.wait(bufferMutex);
+			readAheadWaiting=false;
 			}
 		}
 		}
-	while(bufferSizes[inBuffer]!=0);
+	while(slotDataSizes[inSlot]!=0);
 	
 	return 0;
 	}
 
-ReadAheadFilter::ReadAheadFilter(FilePtr sSource)
+ReadAheadFilter::ReadAheadFilter(FilePtr sSource,unsigned int sNumSlots,size_t sSlotSize,unsigned int sLowWaterMark)
 	:File(),
 	 source(sSource),
-	 halfBufferSize(Misc::max(source->getReadBufferSize(),size_t(8192))),
-	 inBuffer(1),outBuffer(1),numFullBuffers(0),
+	 numSlots(Misc::max(sNumSlots,2U)),
+	 lowWaterMark(sLowWaterMark!=0?Misc::min(sLowWaterMark,numSlots-1):numSlots/2),
+	 slotSize(sSlotSize!=0?sSlotSize:Misc::max(source->getReadBufferSize(),size_t(8192))),
+	 slotMemory(new Byte[slotSize*numSlots]),
+	 slots(new Byte*[numSlots]),slotDataSizes(new size_t[numSlots]),
+	 inSlot(numSlots-1),outSlot(numSlots-1),numFullSlots(0),
+	 readerWaiting(false),readAheadWaiting(false),
 	 haveReadOnce(false)
 	{
-	/* Initialize the double buffer halves: */
-	buffers[0]=new Byte[halfBufferSize*2];
-	buffers[1]=buffers[0]+halfBufferSize;
-	for(int i=0;i<2;++i)
-		bufferSizes[i]=0;
+	/* Initialize the ring buffer slots: */
+	for(unsigned int i=0;i<numSlots;++i)
+		{
+		slots[i]=slotMemory+slotSize*i;
+		slotDataSizes[i]=0;
+		}
+	
+	/* Tell the operating system to read ahead aggressively if the source is a standard file: */
+	StandardFile* standardSource=dynamic_cast<StandardFile*>(source.getPointer());
+	if(standardSource!=0)
+		standardSource->adviseSequentialRead();
 	
 	/* Start the read-ahead thread: */
 	readAheadThread.start(this,&ReadAheadFilter::readAheadThreadMethod);
@@ -142,20 +165,22 @@ ReadAheadFilter::~ReadAheadFilter(void)
 	/* Release the file's read buffer: */
 	setReadBuffer(0,0,false);
 	
-	/* Delete the double buffer: */
-	delete[] buffers[0];
+	/* Delete the ring buffer: */
+	delete[] slotMemory;
+	delete[] slots;
+	delete[] slotDataSizes;
 	}
 
 size_t ReadAheadFilter::getReadBufferSize(void) const
 	{
-	/* Return the size of a half buffer: */
-	return halfBufferSize;
+	/* Return the size of a ring buffer slot: */
+	return slotSize;
 	}
 
 size_t ReadAheadFilter::resizeReadBuffer(size_t newReadBufferSize)
 	{
 	/* Ignore the request and return the current read buffer size: */
-	return halfBufferSize;
+	return slotSize;
 	}
 
 }
@@ -38,13 +38,18 @@ class ReadAheadFilter:public File
 	Threads::Thread readAheadThread; // The background read-ahead thread
 	Threads::Mutex bufferMutex; // Mutex serializing access to the read-ahead ring buffer
 	Threads::Cond bufferCond; // Condition variable to signal a change in ring buffer state
-	size_t halfBufferSize; // Size of each half of the double buffer
-	Byte* buffers[2]; // Pointers to double buffer halves
-	unsigned int inBuffer; // Index of buffer currently read into
-	unsigned int outBuffer; // Index of buffer currently read from
-	unsigned int numFullBuffers; // Number of filled double buffer halves
-	unsigned int bufferSizes[2]; // Amount of data in the two buffer halves; amount less than full size indicates source was read completely
-	bool haveReadOnce; // Flag true if readData has consumed at least one buffer half
+	unsigned int numSlots; // Number of slots in the ring buffer
+	unsigned int lowWaterMark; // Number of full slots below which a waiting read-ahead thread resumes filling the ring buffer
+	size_t slotSize; // Size of each ring buffer slot
+	Byte* slotMemory; // Memory allocated for all ring buffer slots
+	Byte** slots; // Array of pointers to ring buffer slots
+	size_t* slotDataSizes; // Amount of data in each ring buffer slot; amount less than full size indicates source was read completely
+	unsigned int inSlot; // Index of slot currently read into
+	unsigned int outSlot; // Index of slot currently read from
+	unsigned int numFullSlots; // Number of filled ring buffer slots
+	bool readerWaiting; // Flag if the reader is waiting for a slot to be filled
+	bool readAheadWaiting; // Flag if the read-ahead thread is waiting for the number of full slots to drop to the low-water mark
+	bool haveReadOnce; // Flag true if readData has consumed at least one ring buffer slot
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -56,7 +61,7 @@ class ReadAheadFilter:public File
 	
 	/* Constructors and destructors: */
 	public:
-	ReadAheadFilter(FilePtr sSource);
+	ReadAheadFilter(FilePtr sSource,unsigned int sNumSlots =2,size_t sSlotSize =0,unsigned int sLowWaterMark =0); // Reads ahead from the given source file into a ring buffer of the given number of slots of the given size, or of the source's read buffer size if zero; once the ring buffer is full, read-ahead resumes when the number of full slots drops to the given low-water mark, or to half the number of slots if zero
 	virtual ~ReadAheadFilter(void);
 	
 	/* Methods from File: */
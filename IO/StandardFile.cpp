@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <errno.h>
 #include <unistd.h>
 #include <Misc/ThrowStdErr.h>
+#include <Threads/Profiler.h>
 
 #ifdef __APPLE__
 #define lseek64 lseek
@@ -41,6 +42,8 @@ Methods of class StandardFile:
 
 size_t StandardFile::readData(File::Byte* buffer,size_t bufferSize)
 	{
+	THREADS_PROFILE_ZONE("IO::StandardFile::readData");
+	
 	/* Check if file needs to be repositioned: */
 	if(filePos!=readPos)
 		if(lseek64(fd,readPos,SEEK_SET)<0)
@@ -70,6 +73,8 @@ size_t StandardFile::readData(File::Byte* buffer,size_t bufferSize)
 
 void StandardFile::writeData(const File::Byte* buffer,size_t bufferSize)
 	{
+	THREADS_PROFILE_ZONE("IO::StandardFile::writeData");
+	
 	/* Check if file needs to be repositioned: */
 	if(filePos!=writePos)
 		if(lseek64(fd,writePos,SEEK_SET)<0)
@@ -200,4 +205,12 @@ SeekableFile::Offset StandardFile::getSize(void) const
 	return statBuffer.st_size;
 	}
 
+void StandardFile::adviseSequentialRead(void)
+	{
+	#ifdef POSIX_FADV_SEQUENTIAL
+	/* Advise the kernel about the access pattern of the entire file: */
+	posix_fadvise(fd,0,0,POSIX_FADV_SEQUENTIAL);
+	#endif
+	}
+
 }
@@ -54,6 +54,9 @@ class StandardFile:public SeekableFile
 	
 	/* Methods from SeekableFile: */
 	virtual Offset getSize(void) const;
+	
+	/* New methods: */
+	void adviseSequentialRead(void); // Tells the operating system that the file will be read sequentially, to enlarge its read-ahead window; ignored where not supported
 	};
 
 }
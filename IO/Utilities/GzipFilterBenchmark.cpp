@@ -0,0 +1,338 @@
+/***********************************************************************
+GzipFilterBenchmark - Program to check that serial, pipelined, and
+parallel decompression of gzip-compressed, BGZF-compressed, and ZIP
+archive data deliver identical data, and to measure their throughput.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the I/O Support Library (IO).
+
+The I/O Support Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The I/O Support Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the I/O Support Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <zlib.h>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <Misc/ThrowStdErr.h>
+#include <Misc/Time.h>
+#include <IO/File.h>
+#include <IO/FixedMemoryFile.h>
+#include <IO/GzipFilter.h>
+#include <IO/ZipArchive.h>
+
+typedef std::vector<unsigned char> Buffer;
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+void createTestData(size_t size,Buffer& data) // Creates compressible text-like test data
+	{
+	static const char* words[16]=
+		{
+		"vertex ","normal ","color ","0.125 ","-3.5 ","17 ","42.0 ","texture ",
+		"1e-6 ","-0.75 ","face ","9 ","2048 ","group ","0.5 ","-12.25 "
+		};
+	unsigned int seed=1U;
+	data.clear();
+	data.reserve(size+16);
+	while(data.size()<size)
+		{
+		/* Append a line of random words: */
+		int numWords=rand_r(&seed)%8+2;
+		for(int i=0;i<numWords;++i)
+			{
+			const char* word=words[rand_r(&seed)%16];
+			data.insert(data.end(),word,word+strlen(word));
+			}
+		data.push_back('\n');
+		}
+	data.resize(size);
+	}
+
+void put16(Buffer& buffer,unsigned int value)
+	{
+	buffer.push_back((unsigned char)(value&0xffU));
+	buffer.push_back((unsigned char)((value>>8)&0xffU));
+	}
+
+void put32(Buffer& buffer,unsigned long value)
+	{
+	put16(buffer,(unsigned int)(value&0xffffU));
+	put16(buffer,(unsigned int)((value>>16)&0xffffU));
+	}
+
+void deflateData(const unsigned char* data,size_t dataSize,int windowBits,Buffer& compressed) // Appends the compressed data to the given buffer
+	{
+	z_stream stream;
+	memset(&stream,0,sizeof(z_stream));
+	if(deflateInit2(&stream,Z_DEFAULT_COMPRESSION,Z_DEFLATED,windowBits,8,Z_DEFAULT_STRATEGY)!=Z_OK)
+		Misc::throwStdErr("deflateData: Unable to initialize compressor");
+	size_t offset=compressed.size();
+	compressed.resize(offset+deflateBound(&stream,uLong(dataSize)));
+	stream.next_in=const_cast<Bytef*>(data);
+	stream.avail_in=uInt(dataSize);
+	stream.next_out=&compressed[offset];
+	stream.avail_out=uInt(compressed.size()-offset);
+	int result=deflate(&stream,Z_FINISH);
+	compressed.resize(compressed.size()-stream.avail_out);
+	deflateEnd(&stream);
+	if(result!=Z_STREAM_END)
+		Misc::throwStdErr("deflateData: Unable to compress data");
+	}
+
+void createGzip(const Buffer& data,Buffer& gzip) // Compresses the data into a single gzip member
+	{
+	gzip.clear();
+	deflateData(&data[0],data.size(),15+16,gzip);
+	}
+
+void createBgzf(const Buffer& data,Buffer& bgzf) // Compresses the data into independent BGZF blocks, followed by an empty end-of-file block
+	{
+	bgzf.clear();
+	const size_t maxInputSize=65280;
+	for(size_t offset=0;offset<=data.size();offset+=maxInputSize)
+		{
+		/* Compress the next block's data, or no data for the end-of-file block: */
+		size_t inputSize=data.size()-offset<maxInputSize?data.size()-offset:maxInputSize;
+		const unsigned char* input=inputSize>0?&data[offset]:0;
+		Buffer deflated;
+		deflateData(input,inputSize,-15,deflated);
+		size_t blockSize=18+deflated.size()+8;
+		if(blockSize>65536)
+			Misc::throwStdErr("createBgzf: Block does not fit into BGZF block size");
+		
+		/* Write the gzip member header with the BGZF extra field: */
+		static const unsigned char header[16]={0x1fU,0x8bU,8U,4U,0U,0U,0U,0U,0U,0xffU,6U,0U,'B','C',2U,0U};
+		bgzf.insert(bgzf.end(),header,header+16);
+		put16(bgzf,(unsigned int)(blockSize-1));
+		
+		/* Write the compressed data and the gzip member trailer: */
+		bgzf.insert(bgzf.end(),deflated.begin(),deflated.end());
+		put32(bgzf,crc32(crc32(0L,Z_NULL,0),input,uInt(inputSize)));
+		put32(bgzf,(unsigned long)inputSize);
+		
+		if(inputSize==0)
+			break;
+		}
+	}
+
+void createZip(const Buffer& data,const char* fileName,Buffer& zip) // Stores the data as a single deflated entry of the given name in a ZIP archive
+	{
+	zip.clear();
+	Buffer deflated;
+	deflateData(&data[0],data.size(),-15,deflated);
+	unsigned long crc=crc32(crc32(0L,Z_NULL,0),&data[0],uInt(data.size()));
+	unsigned int fileNameLength=(unsigned int)strlen(fileName);
+	
+	/* Write the local file header and the compressed data: */
+	put32(zip,0x04034b50UL);
+	put16(zip,20U); // Version needed to extract
+	put16(zip,0U); // Flags
+	put16(zip,8U); // Compression method
+	put16(zip,0U); // Modification time
+	put16(zip,0U); // Modification date
+	put32(zip,crc);
+	put32(zip,(unsigned long)deflated.size());
+	put32(zip,(unsigned long)data.size());
+	put16(zip,fileNameLength);
+	put16(zip,0U); // Extra field length
+	zip.insert(zip.end(),fileName,fileName+fileNameLength);
+	zip.insert(zip.end(),deflated.begin(),deflated.end());
+	
+	/* Write the central directory: */
+	size_t directoryPos=zip.size();
+	put32(zip,0x02014b50UL);
+	put16(zip,20U); // Version made by
+	put16(zip,20U); // Version needed to extract
+	put16(zip,0U); // Flags
+	put16(zip,8U); // Compression method
+	put16(zip,0U); // Modification time
+	put16(zip,0U); // Modification date
+	put32(zip,crc);
+	put32(zip,(unsigned long)deflated.size());
+	put32(zip,(unsigned long)data.size());
+	put16(zip,fileNameLength);
+	put16(zip,0U); // Extra field length
+	put16(zip,0U); // File comment length
+	put16(zip,0U); // Disk number
+	put16(zip,0U); // Internal file attributes
+	put32(zip,0UL); // External file attributes
+	put32(zip,0UL); // Offset of local file header
+	zip.insert(zip.end(),fileName,fileName+fileNameLength);
+	size_t directorySize=zip.size()-directoryPos;
+	
+	/* Write the end-of-central-directory entry: */
+	put32(zip,0x06054b50UL);
+	put16(zip,0U); // Number of this disk
+	put16(zip,0U); // Disk containing the central directory
+	put16(zip,1U); // Number of entries on this disk
+	put16(zip,1U); // Total number of entries
+	put32(zip,(unsigned long)directorySize);
+	put32(zip,(unsigned long)directoryPos);
+	put16(zip,0U); // Comment length
+	}
+
+/*********************************************************************
+Read-only file delivering data from a memory buffer in pieces of at
+most the requested size, like a pipe or socket:
+*********************************************************************/
+
+class MemorySource:public IO::File
+	{
+	/* Elements: */
+	private:
+	const unsigned char* data; // Pointer to the remaining data
+	size_t remaining; // Amount of remaining data
+	
+	/* Protected methods from IO::File: */
+	protected:
+	virtual size_t readData(Byte* buffer,size_t bufferSize)
+		{
+		size_t readSize=bufferSize<remaining?bufferSize:remaining;
+		memcpy(buffer,data,readSize);
+		data+=readSize;
+		remaining-=readSize;
+		return readSize;
+		}
+	
+	/* Constructors and destructors: */
+	public:
+	MemorySource(const Buffer& sData)
+		:IO::File(ReadOnly),
+		 data(&sData[0]),remaining(sData.size())
+		{
+		}
+	};
+
+bool runBenchmark(const char* format,const char* mode,unsigned int numThreads,IO::FilePtr file,const Buffer& data,Misc::Time startTime)
+	{
+	/* Read the entire file and compare it to the original data: */
+	size_t totalSize=0;
+	bool ok=true;
+	while(!file->eof())
+		{
+		void* buffer;
+		size_t chunkSize=file->readInBuffer(buffer,65536);
+		if(totalSize+chunkSize>data.size()||memcmp(buffer,&data[totalSize],chunkSize)!=0)
+			ok=false;
+		totalSize+=chunkSize;
+		}
+	ok=ok&&totalSize==data.size();
+	double elapsed=toSeconds(Misc::Time::now()-startTime);
+	
+	/* Print the results: */
+	std::cout<<std::setw(8)<<std::left<<format<<std::setw(12)<<mode<<std::right;
+	std::cout<<std::setw(8)<<numThreads;
+	std::cout<<std::setw(10)<<std::fixed<<std::setprecision(3)<<elapsed;
+	std::cout<<std::setw(10)<<std::setprecision(1)<<double(totalSize)/(elapsed*1024.0*1024.0);
+	std::cout<<std::setw(8)<<(ok?"ok":"FAILED")<<std::endl;
+	
+	return ok;
+	}
+
+bool runGzipBenchmark(const char* format,const char* mode,const Buffer& compressed,unsigned int numThreads,const Buffer& data)
+	{
+	Misc::Time startTime=Misc::Time::now();
+	IO::FilePtr file=new IO::GzipFilter(new MemorySource(compressed),numThreads);
+	return runBenchmark(format,mode,numThreads,file,data,startTime);
+	}
+
+bool runZipBenchmark(const char* mode,const Buffer& zip,bool pipelined,const Buffer& data)
+	{
+	/* Open the archive from a copy of the archive data in memory: */
+	IO::FixedMemoryFile* archiveFile=new IO::FixedMemoryFile(zip.size());
+	memcpy(archiveFile->getMemory(),&zip[0],zip.size());
+	IO::ZipArchive archive(archiveFile);
+	
+	Misc::Time startTime=Misc::Time::now();
+	IO::FilePtr file=archive.openFile(archive.findFile("data.txt"),pipelined);
+	return runBenchmark("ZIP",mode,pipelined?1:0,file,data,startTime);
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	size_t dataSize=size_t(64)*1024*1024;
+	unsigned int maxNumThreads=8;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"size")==0&&i+1<argc)
+				{
+				dataSize=size_t(atof(argv[i+1])*1024.0*1024.0);
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"maxThreads")==0&&i+1<argc)
+				{
+				maxNumThreads=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-size <uncompressed data size in MB>] [-maxThreads <maximum number of decompression threads>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	if(dataSize<1)
+		dataSize=1;
+	
+	bool ok=true;
+	try
+		{
+		/* Create the test data in all compressed formats: */
+		Buffer data,gzip,bgzf,zip;
+		createTestData(dataSize,data);
+		createGzip(data,gzip);
+		createBgzf(data,bgzf);
+		createZip(data,"data.txt",zip);
+		
+		std::cout<<std::fixed<<std::setprecision(1)<<double(data.size())/(1024.0*1024.0)<<" MB of data; ";
+		std::cout<<"gzip "<<double(gzip.size())/(1024.0*1024.0)<<" MB, ";
+		std::cout<<"BGZF "<<double(bgzf.size())/(1024.0*1024.0)<<" MB, ";
+		std::cout<<"ZIP "<<double(zip.size())/(1024.0*1024.0)<<" MB"<<std::endl;
+		std::cout<<"Format  Mode         Threads  Time (s)      MB/s  Result"<<std::endl;
+		
+		/* Regular gzip files are decompressed in the reader's thread or by a single background thread: */
+		ok=runGzipBenchmark("gzip","serial",gzip,0,data)&&ok;
+		ok=runGzipBenchmark("gzip","pipelined",gzip,1,data)&&ok;
+		
+		/* BGZF files are decompressed as a multi-member file, or in parallel by increasing numbers of background threads: */
+		ok=runGzipBenchmark("BGZF","serial",bgzf,0,data)&&ok;
+		for(unsigned int numThreads=1;numThreads<=maxNumThreads;numThreads*=2)
+			ok=runGzipBenchmark("BGZF","parallel",bgzf,numThreads,data)&&ok;
+		
+		/* ZIP archive entries are decompressed in the reader's thread or by a read-ahead filter: */
+		ok=runZipBenchmark("serial",zip,false,data)&&ok;
+		ok=runZipBenchmark("pipelined",zip,true,data)&&ok;
+		}
+	catch(std::runtime_error err)
+		{
+		std::cerr<<"Caught exception "<<err.what()<<std::endl;
+		return 1;
+		}
+	
+	return ok?0:1;
+	}
@@ -0,0 +1,239 @@
+/***********************************************************************
+ReadAheadBenchmark - Program to measure the sustained throughput of a
+read-ahead filter versus its number of ring buffer slots, reading from
+a synthetic source with occasional stalls like a network file system,
+or from a real file.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the I/O Support Library (IO).
+
+The I/O Support Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The I/O Support Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the I/O Support Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <Misc/Time.h>
+#include <IO/File.h>
+#include <IO/StandardFile.h>
+#include <IO/ReadAheadFilter.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+void simulateDelay(double seconds)
+	{
+	if(seconds>0.0)
+		{
+		Misc::Time wait(seconds);
+		nanosleep(&wait,0);
+		}
+	}
+
+/*********************************************************************
+File delivering a fixed amount of data at a given bandwidth, with
+randomly placed stalls; uses a fixed random seed so that all benchmark
+runs see the same sequence of stalls:
+*********************************************************************/
+
+class SyntheticSource:public IO::File
+	{
+	/* Elements: */
+	private:
+	size_t remaining; // Amount of data left to deliver
+	double bandwidth; // Transfer rate in bytes per second
+	double stallProbability; // Probability that a read stalls
+	double stallTime; // Duration of a stall in seconds
+	unsigned int seed; // State of the random number generator
+	
+	/* Protected methods from IO::File: */
+	protected:
+	virtual size_t readData(Byte* buffer,size_t bufferSize)
+		{
+		/* Deliver at most the remaining amount of data: */
+		size_t readSize=bufferSize<remaining?bufferSize:remaining;
+		remaining-=readSize;
+		
+		/* Simulate the transfer time and an occasional stall: */
+		double transferTime=double(readSize)/bandwidth;
+		if(double(rand_r(&seed))<stallProbability*double(RAND_MAX))
+			transferTime+=stallTime;
+		simulateDelay(transferTime);
+		
+		/* "Read" the data: */
+		memset(buffer,int(remaining&0xffU),readSize);
+		
+		return readSize;
+		}
+	
+	/* Constructors and destructors: */
+	public:
+	SyntheticSource(size_t sSize,double sBandwidth,double sStallProbability,double sStallTime)
+		:IO::File(ReadOnly),
+		 remaining(sSize),bandwidth(sBandwidth),
+		 stallProbability(sStallProbability),stallTime(sStallTime),
+		 seed(1U)
+		{
+		}
+	};
+
+struct BenchmarkSettings // Structure holding the benchmark's command line settings
+	{
+	/* Elements: */
+	public:
+	const char* fileName; // Name of a real file to read, or null to use a synthetic source
+	size_t dataSize; // Amount of data delivered by the synthetic source
+	double sourceBandwidth; // Transfer rate of the synthetic source in bytes per second
+	double stallProbability; // Probability that a read from the synthetic source stalls
+	double stallTime; // Duration of a synthetic source stall in seconds
+	double consumerRate; // Processing rate of the consumer in bytes per second, or zero to consume as fast as possible
+	size_t slotSize; // Size of each read-ahead ring buffer slot
+	};
+
+void runBenchmark(const BenchmarkSettings& settings,unsigned int numSlots)
+	{
+	/* Create the source file: */
+	IO::FilePtr source;
+	if(settings.fileName!=0)
+		source=new IO::StandardFile(settings.fileName);
+	else
+		source=new SyntheticSource(settings.dataSize,settings.sourceBandwidth,settings.stallProbability,settings.stallTime);
+	source->resizeReadBuffer(settings.slotSize);
+	
+	/* Wrap the source into a read-ahead filter unless the number of slots is zero: */
+	IO::FilePtr file=numSlots>0?IO::FilePtr(new IO::ReadAheadFilter(source,numSlots,settings.slotSize)):source;
+	
+	/* Consume the entire file in chunks, simulating processing time per chunk: */
+	Misc::Time startTime=Misc::Time::now();
+	size_t totalSize=0;
+	while(!file->eof())
+		{
+		void* buffer;
+		size_t chunkSize=file->readInBuffer(buffer,settings.slotSize);
+		totalSize+=chunkSize;
+		if(settings.consumerRate>0.0)
+			simulateDelay(double(chunkSize)/settings.consumerRate);
+		}
+	double elapsed=toSeconds(Misc::Time::now()-startTime);
+	
+	/* Print the results: */
+	if(numSlots>0)
+		std::cout<<std::setw(8)<<numSlots;
+	else
+		std::cout<<std::setw(8)<<"direct";
+	std::cout<<std::setw(12)<<std::fixed<<std::setprecision(1)<<double(totalSize)/(1024.0*1024.0);
+	std::cout<<std::setw(10)<<std::setprecision(3)<<elapsed;
+	std::cout<<std::setw(10)<<std::setprecision(1)<<double(totalSize)/(elapsed*1024.0*1024.0)<<std::endl;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	BenchmarkSettings settings;
+	settings.fileName=0;
+	settings.dataSize=size_t(256)*1024*1024;
+	settings.sourceBandwidth=400.0*1024.0*1024.0;
+	settings.stallProbability=0.02;
+	settings.stallTime=0.02;
+	settings.consumerRate=300.0*1024.0*1024.0;
+	settings.slotSize=256*1024;
+	unsigned int maxNumSlots=32;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"file")==0&&i+1<argc)
+				{
+				settings.fileName=argv[i+1];
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"size")==0&&i+1<argc)
+				{
+				settings.dataSize=size_t(atof(argv[i+1])*1024.0*1024.0);
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"source")==0&&i+1<argc)
+				{
+				settings.sourceBandwidth=atof(argv[i+1])*1024.0*1024.0;
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"stalls")==0&&i+2<argc)
+				{
+				settings.stallProbability=atof(argv[i+1]);
+				settings.stallTime=atof(argv[i+2])*0.001;
+				i+=2;
+				}
+			else if(strcasecmp(argv[i]+1,"consumer")==0&&i+1<argc)
+				{
+				settings.consumerRate=atof(argv[i+1])*1024.0*1024.0;
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"slotSize")==0&&i+1<argc)
+				{
+				settings.slotSize=size_t(atoi(argv[i+1]))*1024;
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"maxSlots")==0&&i+1<argc)
+				{
+				maxNumSlots=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-file <file name>] [-size <synthetic data size in MB>] [-source <synthetic source bandwidth in MB/s>] [-stalls <stall probability per read> <stall time in ms>] [-consumer <consumer rate in MB/s, 0 for unthrottled>] [-slotSize <slot size in KB>] [-maxSlots <maximum number of slots>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	if(settings.fileName!=0)
+		std::cout<<"Source file "<<settings.fileName;
+	else
+		{
+		std::cout<<"Synthetic source "<<settings.sourceBandwidth/(1024.0*1024.0)<<" MB/s, ";
+		std::cout<<settings.stallProbability*100.0<<"% stalls of "<<settings.stallTime*1000.0<<" ms";
+		}
+	std::cout<<", consumer ";
+	if(settings.consumerRate>0.0)
+		std::cout<<settings.consumerRate/(1024.0*1024.0)<<" MB/s";
+	else
+		std::cout<<"unthrottled";
+	std::cout<<", slot size "<<settings.slotSize/1024<<" KB"<<std::endl;
+	std::cout<<"   Slots   Size (MB)  Time (s)      MB/s"<<std::endl;
+	
+	try
+		{
+		/* Read without a filter, then with increasing numbers of slots: */
+		runBenchmark(settings,0);
+		for(unsigned int numSlots=2;numSlots<=maxNumSlots;numSlots*=2)
+			runBenchmark(settings,numSlots);
+		}
+	catch(std::runtime_error err)
+		{
+		std::cerr<<"Caught exception "<<err.what()<<std::endl;
+		return 1;
+		}
+	
+	return 0;
+	}
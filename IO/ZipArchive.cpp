@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Misc/ThrowStdErr.h>
 #include <IO/StandardFile.h>
 #include <IO/FixedMemoryFile.h>
+#include <IO/ReadAheadFilter.h>
 
 namespace IO {
 
@@ -657,7 +658,7 @@ ZipArchive::FileID ZipArchive::findFile(const char* fileName)
 	throw FileNotFoundError(fileName);
 	}
 
-FilePtr ZipArchive::openFile(const ZipArchive::FileID& fileId)
+FilePtr ZipArchive::openFile(const ZipArchive::FileID& fileId,bool pipelined)
 	{
 	/* Read the file's header: */
 	archive->setReadPosAbs(fileId.filePos);
@@ -678,6 +679,17 @@ FilePtr ZipArchive::openFile(const ZipArchive::FileID& fileId)
 	archive->skip<char>(fileNameLength);
 	archive->skip<char>(extraFieldLength);
 	
+	if(pipelined)
+		{
+		/* Read the compressed data into memory, so that the background thread does not share the archive file with other readers: */
+		FixedMemoryFile* compressed=new FixedMemoryFile(compressedSize);
+		SeekableFilePtr compressedFile=compressed;
+		archive->read<char>(static_cast<char*>(compressed->getMemory()),compressedSize);
+		
+		/* Create and return a result file decompressing in a background thread: */
+		return new ReadAheadFilter(new ZipArchiveStreamingFile(compressedFile,compressionMethod,0,compressedSize));
+		}
+	
 	/* Create and return the result file: */
 	return new ZipArchiveStreamingFile(archive,compressionMethod,archive->getReadPos(),compressedSize);
 	}
@@ -141,7 +141,7 @@ class ZipArchive:public Misc::RefCounted
 	DirectoryIterator readDirectory(void); // Returns a new directory iterator
 	DirectoryIterator& getNextEntry(DirectoryIterator& dIt); // Advances the directory iterator to the next entry
 	FileID findFile(const char* fileName); // Returns a file identifier for a file of the given name; throws exception if file does not exist
-	FilePtr openFile(const FileID& fileId); // Returns a file for streaming reading
+	FilePtr openFile(const FileID& fileId,bool pipelined =false); // Returns a file for streaming reading; decompresses ahead of the reader in a background thread if pipelined is true
 	SeekableFilePtr openSeekableFile(const FileID& fileId); // Returns a file for seekable reading
 	DirectoryPtr openDirectory(const char* directoryName); // Returns a directory object representing the given directory name
 	};
@@ -0,0 +1,125 @@
+/***********************************************************************
+AsyncImageWriter - Class to write RGB images to files in a pool of
+background threads, to keep image encoding and file I/O out of
+latency-sensitive threads.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Image Handling Library (Images).
+
+The Image Handling Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Image Handling Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Image Handling Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Images/AsyncImageWriter.h>
+
+#include <string.h>
+#include <string>
+#include <stdexcept>
+#include <iostream>
+#include <Threads/Profiler.h>
+#include <Images/WriteImageFile.h>
+
+namespace Images {
+
+/************************************************
+Declaration of class AsyncImageWriter::WriteTask:
+************************************************/
+
+class AsyncImageWriter::WriteTask:public Threads::TaskScheduler::Task
+	{
+	/* Elements: */
+	private:
+	AsyncImageWriter& writer; // Image writer that submitted the task
+	RGBImage image; // Image to write; the task holds the only reference to the image's pixels
+	std::string imageFileName; // Name of the image file to write
+	
+	/* Constructors and destructors: */
+	public:
+	WriteTask(AsyncImageWriter& sWriter,const RGBImage& sImage,const char* sImageFileName)
+		:writer(sWriter),image(sImage),imageFileName(sImageFileName)
+		{
+		}
+	
+	/* Methods from Threads::TaskScheduler::Task: */
+	virtual void execute(void);
+	};
+
+/********************************************
+Methods of class AsyncImageWriter::WriteTask:
+********************************************/
+
+void AsyncImageWriter::WriteTask::execute(void)
+	{
+	THREADS_PROFILE_ZONE("Images::AsyncImageWriter::writeImage");
+	
+	try
+		{
+		Images::writeImageFile(image,imageFileName.c_str());
+		}
+	catch(std::runtime_error err)
+		{
+		/* Print an error message and carry on; tasks must not throw: */
+		std::cerr<<"Images::AsyncImageWriter: Caught exception "<<err.what()<<" while writing image file "<<imageFileName<<std::endl;
+		writer.numFailedImages.preAdd(1U);
+		}
+	
+	/* Release the image before the writer is notified: */
+	image=RGBImage();
+	writer.numPendingImages.preSub(1U);
+	}
+
+/*********************************
+Methods of class AsyncImageWriter:
+*********************************/
+
+AsyncImageWriter::AsyncImageWriter(unsigned int numThreads)
+	:scheduler(numThreads>0?numThreads:1),
+	 writeTasks(scheduler),
+	 numPendingImages(0U),numFailedImages(0U)
+	{
+	}
+
+AsyncImageWriter::~AsyncImageWriter(void)
+	{
+	/* Wait until all submitted images have been written: */
+	writeTasks.wait();
+	}
+
+void AsyncImageWriter::writeImageFile(RGBImage& image,const char* imageFileName)
+	{
+	/* Hand the image's pixels to a new task and invalidate the caller's image, so the task holds the only reference: */
+	WriteTask* task=new WriteTask(*this,image,imageFileName);
+	image=RGBImage();
+	
+	/* Submit the task: */
+	numPendingImages.preAdd(1U);
+	writeTasks.spawn(task);
+	}
+
+void AsyncImageWriter::writeImageFile(unsigned int width,unsigned int height,const unsigned char* image,const char* imageFileName)
+	{
+	/* Copy the image buffer into a private image: */
+	RGBImage copy(width,height);
+	memcpy(copy.modifyPixels(),image,size_t(width)*size_t(height)*3);
+	
+	/* Queue the private image: */
+	writeImageFile(copy,imageFileName);
+	}
+
+void AsyncImageWriter::waitForCompletion(void)
+	{
+	writeTasks.wait();
+	}
+
+}
@@ -0,0 +1,71 @@
+/***********************************************************************
+AsyncImageWriter - Class to write RGB images to files in a pool of
+background threads, to keep image encoding and file I/O out of
+latency-sensitive threads.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Image Handling Library (Images).
+
+The Image Handling Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Image Handling Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Image Handling Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef IMAGES_ASYNCIMAGEWRITER_INCLUDED
+#define IMAGES_ASYNCIMAGEWRITER_INCLUDED
+
+#include <Threads/Atomic.h>
+#include <Threads/TaskScheduler.h>
+#include <Images/RGBImage.h>
+
+namespace Images {
+
+class AsyncImageWriter
+	{
+	/* Embedded classes: */
+	private:
+	class WriteTask; // Class for tasks writing a single image file
+	friend class WriteTask;
+	
+	/* Elements: */
+	Threads::TaskScheduler scheduler; // Private pool of image writing threads; not shared with compute tasks to keep long-running writes out of their way
+	Threads::TaskScheduler::TaskGroup writeTasks; // Task group containing all submitted image writing tasks
+	Threads::Atomic<unsigned int> numPendingImages; // Number of submitted images that have not been written yet
+	Threads::Atomic<unsigned int> numFailedImages; // Number of images that could not be written
+	
+	/* Constructors and destructors: */
+	public:
+	AsyncImageWriter(unsigned int numThreads =1); // Creates an image writer with the given number of background threads; uses at least one thread
+	private:
+	AsyncImageWriter(const AsyncImageWriter& source); // Prohibit copy constructor
+	AsyncImageWriter& operator=(const AsyncImageWriter& source); // Prohibit assignment operator
+	public:
+	~AsyncImageWriter(void); // Waits until all submitted images have been written
+	
+	/* Methods: */
+	void writeImageFile(RGBImage& image,const char* imageFileName); // Queues the given image for writing without copying its pixels; image must not be shared with other image objects, and is invalidated on return
+	void writeImageFile(unsigned int width,unsigned int height,const unsigned char* image,const char* imageFileName); // Queues a copy of the given raw RGB image buffer for writing; buffer can be reused on return
+	unsigned int getNumPendingImages(void) const // Returns the number of submitted images that have not been written yet
+		{
+		return numPendingImages.get();
+		}
+	unsigned int getNumFailedImages(void) const // Returns the number of images that could not be written
+		{
+		return numFailedImages.get();
+		}
+	void waitForCompletion(void); // Blocks until all submitted images have been written
+	};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+/***********************************************************************
+ArenaAllocator - Class to allocate transient memory blocks by bumping a
+pointer through large chunks of memory, and to release all allocated
+blocks at once.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Miscellaneous Support Library (Misc).
+
+The Miscellaneous Support Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Miscellaneous Support Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Miscellaneous Support Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Misc/ArenaAllocator.h>
+
+#include <stdlib.h>
+#include <new>
+
+namespace Misc {
+
+/*******************************
+Methods of class ArenaAllocator:
+*******************************/
+
+void* ArenaAllocator::allocateChunk(size_t size,size_t alignment)
+	{
+	/* Allocate a new chunk large enough to hold the aligned block: */
+	size_t newChunkSize=chunkSize;
+	if(newChunkSize<size+alignment)
+		newChunkSize=size+alignment;
+	Chunk* newChunk=static_cast<Chunk*>(malloc(headerSize+newChunkSize));
+	if(newChunk==0)
+		throw std::bad_alloc();
+	newChunk->succ=firstChunk;
+	newChunk->size=newChunkSize;
+	firstChunk=newChunk;
+	bytesReserved+=newChunkSize;
+	
+	/* Allocate the block from the new chunk: */
+	nextPtr=reinterpret_cast<char*>(newChunk)+headerSize;
+	endPtr=nextPtr+newChunkSize;
+	return allocate(size,alignment);
+	}
+
+ArenaAllocator::ArenaAllocator(size_t sChunkSize)
+	:chunkSize(sChunkSize),firstChunk(0),nextPtr(0),endPtr(0),
+	 bytesAllocated(0),peakBytesAllocated(0),bytesReserved(0)
+	{
+	}
+
+ArenaAllocator::~ArenaAllocator(void)
+	{
+	/* Release all chunks: */
+	while(firstChunk!=0)
+		{
+		Chunk* succ=firstChunk->succ;
+		free(firstChunk);
+		firstChunk=succ;
+		}
+	}
+
+void ArenaAllocator::reset(void)
+	{
+	/* Update the allocation high water mark: */
+	if(peakBytesAllocated<bytesAllocated)
+		peakBytesAllocated=bytesAllocated;
+	bytesAllocated=0;
+	
+	if(firstChunk!=0&&firstChunk->succ!=0)
+		{
+		/* Replace multiple chunks by a single chunk holding all of their memory, so that the next allocation cycle does not have to allocate chunks: */
+		size_t totalSize=0;
+		while(firstChunk!=0)
+			{
+			Chunk* succ=firstChunk->succ;
+			totalSize+=firstChunk->size;
+			free(firstChunk);
+			firstChunk=succ;
+			}
+		bytesReserved=0;
+		nextPtr=endPtr=0;
+		if(chunkSize<totalSize)
+			chunkSize=totalSize;
+		allocateChunk(0,1);
+		}
+	else if(firstChunk!=0)
+		{
+		/* Rewind the single chunk: */
+		nextPtr=reinterpret_cast<char*>(firstChunk)+headerSize;
+		}
+	}
+
+}
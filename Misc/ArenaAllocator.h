@@ -0,0 +1,100 @@
+/***********************************************************************
+ArenaAllocator - Class to allocate transient memory blocks by bumping a
+pointer through large chunks of memory, and to release all allocated
+blocks at once.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Miscellaneous Support Library (Misc).
+
+The Miscellaneous Support Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Miscellaneous Support Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Miscellaneous Support Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef MISC_ARENAALLOCATOR_INCLUDED
+#define MISC_ARENAALLOCATOR_INCLUDED
+
+#include <stddef.h>
+
+namespace Misc {
+
+class ArenaAllocator
+	{
+	/* Embedded classes: */
+	private:
+	struct Chunk // Structure for headers of memory chunks
+		{
+		/* Elements: */
+		public:
+		Chunk* succ; // Pointer to the previously allocated chunk
+		size_t size; // Usable size of the chunk in bytes
+		};
+	
+	/* Elements: */
+	static const size_t headerSize=(sizeof(Chunk)+15)&~size_t(15); // Size of chunk headers, padded to keep chunk memory aligned
+	size_t chunkSize; // Minimum usable size of newly allocated chunks
+	Chunk* firstChunk; // Pointer to the current chunk; chunks are linked in reverse order of allocation
+	char* nextPtr; // Pointer to the first unused byte in the current chunk
+	char* endPtr; // Pointer behind the last byte of the current chunk
+	size_t bytesAllocated; // Number of bytes allocated since the last reset
+	size_t peakBytesAllocated; // Highest number of bytes allocated between two resets
+	size_t bytesReserved; // Number of bytes in all chunks
+	
+	/* Private methods: */
+	void* allocateChunk(size_t size,size_t alignment); // Allocates a new chunk holding at least the given number of bytes at the given alignment, and allocates the block from it
+	
+	/* Constructors and destructors: */
+	public:
+	ArenaAllocator(size_t sChunkSize =65536); // Creates an empty arena allocating chunks of at least the given size
+	private:
+	ArenaAllocator(const ArenaAllocator& source); // Prohibit copy constructor
+	ArenaAllocator& operator=(const ArenaAllocator& source); // Prohibit assignment operator
+	public:
+	~ArenaAllocator(void); // Releases all memory
+	
+	/* Methods: */
+	void* allocate(size_t size,size_t alignment =16) // Allocates a block of the given size and power-of-two alignment
+		{
+		/* Align the next free pointer: */
+		char* result=reinterpret_cast<char*>((reinterpret_cast<size_t>(nextPtr)+(alignment-1))&~(alignment-1));
+		if(result+size>endPtr||result<nextPtr)
+			return allocateChunk(size,alignment);
+		
+		nextPtr=result+size;
+		bytesAllocated+=size;
+		return result;
+		}
+	template <class ElementParam>
+	ElementParam* allocateArray(size_t numElements) // Allocates an uninitialized array of the given number of elements; element type must not need construction or destruction
+		{
+		return static_cast<ElementParam*>(allocate(numElements*sizeof(ElementParam)));
+		}
+	void reset(void); // Releases all allocated blocks at once; keeps enough memory to satisfy the previous allocation volume without allocating new chunks
+	size_t getBytesAllocated(void) const // Returns the number of bytes allocated since the last reset
+		{
+		return bytesAllocated;
+		}
+	size_t getPeakBytesAllocated(void) const // Returns the highest number of bytes allocated between two resets
+		{
+		return peakBytesAllocated>bytesAllocated?peakBytesAllocated:bytesAllocated;
+		}
+	size_t getBytesReserved(void) const // Returns the number of bytes currently held by the arena
+		{
+		return bytesReserved;
+		}
+	};
+
+}
+
+#endif
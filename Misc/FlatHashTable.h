@@ -0,0 +1,454 @@
+/***********************************************************************
+FlatHashTable - Class for storing and finding values (open addressing
+version using Robin Hood linear probing). Drop-in replacement for
+Misc::HashTable with better cache behavior for small entries.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Miscellaneous Support Library (Misc).
+
+The Miscellaneous Support Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Miscellaneous Support Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Miscellaneous Support Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef MISC_FLATHASHTABLE_INCLUDED
+#define MISC_FLATHASHTABLE_INCLUDED
+
+#include <new>
+#include <algorithm>
+#include <stdexcept>
+#include <Misc/StandardHashFunction.h>
+#include <Misc/HashTable.h>
+
+namespace Misc {
+
+/***********************************************************************
+Usage prerequisites:
+- class Source must provide operator!=
+- classes Source and Dest must be copy-constructible and assignable
+- class HashFunction must provide static size_t hash(const Source&
+  source,size_t tableSize)
+Differences to Misc::HashTable:
+- Entries are stored directly in the table array; inserting an entry can
+  move other entries, and therefore invalidates all iterators and entry
+  references except the reference returned by operator[] itself.
+- Removing an entry shifts following entries backwards, and invalidates
+  all iterators.
+- Probe sequences grow quickly with table usage; the default water mark
+  is lower than Misc::HashTable's, and water marks above 0.7 make
+  lookups in tables that do not fit into the CPU caches several times
+  slower.
+***********************************************************************/
+
+template <class Source,class Dest,class HashFunction =StandardHashFunction<Source> >
+class FlatHashTable
+	{
+	/* Embedded classes: */
+	public:
+	typedef HashTableEntry<Source,Dest> Entry; // Type for hash table entries
+	
+	class EntryNotFoundError:public std::runtime_error // Class for exceptions when requested hash table entry does not exist
+		{
+		/* Elements: */
+		public:
+		Source entrySource; // Requested non-existent entry source value
+		
+		/* Constructors and destructors: */
+		EntryNotFoundError(const Source& sEntrySource)
+			:std::runtime_error("Requested entry not found in hash table"),
+			 entrySource(sEntrySource)
+			{
+			}
+		virtual ~EntryNotFoundError(void) throw()
+			{
+			}
+		};
+	
+	class Iterator
+		{
+		friend class FlatHashTable;
+		
+		/* Elements: */
+		private:
+		FlatHashTable* table; // Pointer to table this iterator is pointing into
+		size_t index; // Index of current table slot
+		
+		/* Constructors and destructors: */
+		public:
+		Iterator(void) // Creates invalid iterator
+			:table(0),index(0)
+			{
+			}
+		private:
+		Iterator(FlatHashTable* sTable,size_t sIndex) // Creates iterator to the first used slot at or after the given index
+			:table(sTable),index(sIndex)
+			{
+			while(index<table->tableSize&&table->probeLengths[index]==0)
+				++index;
+			}
+		
+		/* Methods: */
+		public:
+		bool isFinished(void) const
+			{
+			return index>=table->tableSize;
+			}
+		friend bool operator==(const Iterator& it1,const Iterator& it2)
+			{
+			return it1.index==it2.index;
+			}
+		friend bool operator!=(const Iterator& it1,const Iterator& it2)
+			{
+			return it1.index!=it2.index;
+			}
+		Entry& operator*(void) const
+			{
+			return table->entries[index];
+			}
+		Entry* operator->(void) const
+			{
+			return table->entries+index;
+			}
+		Iterator& operator++(void)
+			{
+			/* Go to the next used slot: */
+			do
+				{
+				++index;
+				}
+			while(index<table->tableSize&&table->probeLengths[index]==0);
+			return *this;
+			}
+		};
+	
+	class ConstIterator
+		{
+		friend class FlatHashTable;
+		
+		/* Elements: */
+		private:
+		const FlatHashTable* table; // Pointer to table this iterator is pointing into
+		size_t index; // Index of current table slot
+		
+		/* Constructors and destructors: */
+		public:
+		ConstIterator(void) // Creates invalid iterator
+			:table(0),index(0)
+			{
+			}
+		private:
+		ConstIterator(const FlatHashTable* sTable,size_t sIndex) // Creates iterator to the first used slot at or after the given index
+			:table(sTable),index(sIndex)
+			{
+			while(index<table->tableSize&&table->probeLengths[index]==0)
+				++index;
+			}
+		
+		/* Methods: */
+		public:
+		bool isFinished(void) const
+			{
+			return index>=table->tableSize;
+			}
+		friend bool operator==(const ConstIterator& it1,const ConstIterator& it2)
+			{
+			return it1.index==it2.index;
+			}
+		friend bool operator!=(const ConstIterator& it1,const ConstIterator& it2)
+			{
+			return it1.index!=it2.index;
+			}
+		const Entry& operator*(void) const
+			{
+			return table->entries[index];
+			}
+		const Entry* operator->(void) const
+			{
+			return table->entries+index;
+			}
+		ConstIterator& operator++(void)
+			{
+			/* Go to the next used slot: */
+			do
+				{
+				++index;
+				}
+			while(index<table->tableSize&&table->probeLengths[index]==0);
+			return *this;
+			}
+		};
+	
+	friend class Iterator;
+	friend class ConstIterator;
+	
+	/* Elements: */
+	private:
+	size_t tableSize; // Current table size
+	float waterMark; // Maximum table usage ratio
+	float growRate; // Rate the table grows at
+	unsigned int* probeLengths; // Array of per-slot probe lengths; 0 for empty slots, otherwise distance from the entry's home slot plus one
+	Entry* entries; // Array of uninitialized table slots; only slots with non-zero probe length contain constructed entries
+	size_t usedEntries; // Number of entries currently used
+	size_t maxEntries; // Maximum number of entries at current table size
+	
+	/* Private methods: */
+	static Entry* allocateEntries(size_t numEntries) // Allocates an array of uninitialized table slots
+		{
+		return static_cast<Entry*>(::operator new(numEntries*sizeof(Entry)));
+		}
+	size_t nextIndex(size_t index) const // Returns the index of the slot following the given one, with wrap-around
+		{
+		++index;
+		return index!=tableSize?index:0;
+		}
+	size_t findIndex(const Source& findSource) const // Returns the index of the slot containing the given source, or tableSize if there is no such entry
+		{
+		/* Probe from the source's home slot until an entry closer to its own home slot is encountered: */
+		size_t index=HashFunction::hash(findSource,tableSize);
+		for(unsigned int probeLength=1;probeLength<=probeLengths[index];++probeLength,index=nextIndex(index))
+			{
+			/* Only compare entries that share the searched source's home slot: */
+			if(probeLengths[index]==probeLength&&!(entries[index].getSource()!=findSource))
+				return index;
+			}
+		
+		return tableSize;
+		}
+	size_t placeEntry(const Entry& newEntry) // Places an entry known not to be in the table without checking the water mark; returns index of the entry's slot
+		{
+		size_t result=tableSize;
+		size_t index=HashFunction::hash(newEntry.getSource(),tableSize);
+		unsigned int probeLength=1;
+		Entry carried(newEntry);
+		while(probeLengths[index]!=0)
+			{
+			/* Displace the slot's entry if it is closer to its home slot than the carried entry: */
+			if(probeLengths[index]<probeLength)
+				{
+				std::swap(entries[index],carried);
+				std::swap(probeLengths[index],probeLength);
+				if(result==tableSize)
+					result=index;
+				}
+			
+			index=nextIndex(index);
+			++probeLength;
+			}
+		
+		/* Put the carried entry into the empty slot: */
+		new(entries+index) Entry(carried);
+		probeLengths[index]=probeLength;
+		if(result==tableSize)
+			result=index;
+		
+		return result;
+		}
+	void removeIndex(size_t index) // Removes the entry in the given slot
+		{
+		entries[index].~Entry();
+		
+		/* Shift all following displaced entries back by one slot: */
+		size_t next=nextIndex(index);
+		while(probeLengths[next]>1)
+			{
+			new(entries+index) Entry(entries[next]);
+			entries[next].~Entry();
+			probeLengths[index]=probeLengths[next]-1;
+			index=next;
+			next=nextIndex(next);
+			}
+		probeLengths[index]=0;
+		
+		--usedEntries;
+		}
+	void destroyEntries(void) // Destroys all used table entries
+		{
+		for(size_t i=0;i<tableSize;++i)
+			if(probeLengths[i]!=0)
+				{
+				entries[i].~Entry();
+				probeLengths[i]=0;
+				}
+		}
+	void growTable(size_t newTableSize) // Changes the table size without deleting current entries
+		{
+		/* Never shrink the table below the size required to hold the current entries: */
+		if(newTableSize<1)
+			newTableSize=1;
+		if(newTableSize*waterMark<usedEntries)
+			newTableSize=(size_t)(usedEntries/waterMark)+1;
+		
+		/* Allocate new table slots: */
+		size_t oldTableSize=tableSize;
+		unsigned int* oldProbeLengths=probeLengths;
+		Entry* oldEntries=entries;
+		tableSize=newTableSize;
+		probeLengths=new unsigned int[tableSize];
+		std::fill(probeLengths,probeLengths+tableSize,0U);
+		entries=allocateEntries(tableSize);
+		
+		/* Move all entries to the new table: */
+		for(size_t i=0;i<oldTableSize;++i)
+			if(oldProbeLengths[i]!=0)
+				{
+				placeEntry(oldEntries[i]);
+				oldEntries[i].~Entry();
+				}
+		
+		/* Delete the old table: */
+		delete[] oldProbeLengths;
+		::operator delete(oldEntries);
+		maxEntries=(size_t)(tableSize*waterMark);
+		}
+	size_t insertEntry(const Entry& newEntry) // Inserts an entry known not to be in the table; returns index of the entry's slot
+		{
+		/* Grow the table before inserting so that the new entry's slot stays valid: */
+		while(usedEntries>=maxEntries)
+			growTable((size_t)(tableSize*growRate)+1);
+		
+		size_t result=placeEntry(newEntry);
+		++usedEntries;
+		return result;
+		}
+	
+	/* Constructors and destructors: */
+	public:
+	FlatHashTable(size_t sTableSize,float sWaterMark =0.6f,float sGrowRate =1.7312543)
+		:tableSize(sTableSize>0?sTableSize:1),waterMark(sWaterMark),growRate(sGrowRate),
+		 probeLengths(new unsigned int[tableSize]),entries(allocateEntries(tableSize)),
+		 usedEntries(0),maxEntries((size_t)(tableSize*waterMark))
+		{
+		std::fill(probeLengths,probeLengths+tableSize,0U);
+		}
+	private:
+	FlatHashTable(const FlatHashTable& source); // Prohibit copy constructor
+	FlatHashTable& operator=(const FlatHashTable& source); // Prohibit assignment operator
+	public:
+	~FlatHashTable(void)
+		{
+		/* Destroy all used hash table entries: */
+		destroyEntries();
+		
+		/* Delete the table slots: */
+		delete[] probeLengths;
+		::operator delete(entries);
+		}
+	
+	/* Methods: */
+	void setTableSize(size_t newTableSize)
+		{
+		growTable(newTableSize);
+		}
+	void clear(void)
+		{
+		/* Destroy all used hash table entries: */
+		destroyEntries();
+		
+		usedEntries=0;
+		}
+	size_t getNumEntries(void) const // Returns the number of entries currently in the hash table
+		{
+		return usedEntries;
+		}
+	bool setEntry(const Entry& newEntry)
+		{
+		size_t index=findIndex(newEntry.getSource());
+		if(index!=tableSize)
+			{
+			/* Set value of existing entry: */
+			entries[index]=newEntry;
+			return true;
+			}
+		else
+			{
+			/* Insert new entry: */
+			insertEntry(newEntry);
+			return false;
+			}
+		}
+	void removeEntry(const Source& findSource) // Removes entry
+		{
+		size_t index=findIndex(findSource);
+		if(index!=tableSize)
+			removeIndex(index);
+		}
+	bool isEntry(const Source& findSource) const
+		{
+		return findIndex(findSource)!=tableSize;
+		}
+	bool isEntry(const Entry& entry) const // Wrapper for isEntry function
+		{
+		return isEntry(entry.getSource());
+		}
+	const Entry& getEntry(const Source& findSource) const // Returns reference to entry; throws exception if entry is not found
+		{
+		size_t index=findIndex(findSource);
+		if(index==tableSize)
+			throw EntryNotFoundError(findSource);
+		
+		return entries[index];
+		}
+	Entry& getEntry(const Source& findSource) // Ditto
+		{
+		size_t index=findIndex(findSource);
+		if(index==tableSize)
+			throw EntryNotFoundError(findSource);
+		
+		return entries[index];
+		}
+	Entry& operator[](const Source& source) // Returns reference to entry; inserts new entry if source is not found
+		{
+		size_t index=findIndex(source);
+		if(index==tableSize)
+			{
+			/* Insert new entry with default destination: */
+			index=insertEntry(Entry(source));
+			}
+		
+		return entries[index];
+		}
+	Iterator begin(void)
+		{
+		return Iterator(this,0); // Create iterator to first entry
+		}
+	ConstIterator begin(void) const
+		{
+		return ConstIterator(this,0); // Create iterator to first entry
+		}
+	Iterator end(void)
+		{
+		return Iterator(this,tableSize); // Create iterator past end of table
+		}
+	ConstIterator end(void) const
+		{
+		return ConstIterator(this,tableSize); // Create iterator past end of table
+		}
+	Iterator findEntry(const Source& findSource)
+		{
+		return Iterator(this,findIndex(findSource)); // Return valid iterator or end iterator
+		}
+	ConstIterator findEntry(const Source& findSource) const
+		{
+		return ConstIterator(this,findIndex(findSource)); // Return valid iterator or end iterator
+		}
+	void removeEntry(const Iterator& it) // Removes entry pointed to by iterator
+		{
+		if(it.table==this&&it.index<tableSize&&probeLengths[it.index]!=0)
+			removeIndex(it.index);
+		}
+	};
+
+}
+
+#endif
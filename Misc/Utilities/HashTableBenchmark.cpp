@@ -0,0 +1,194 @@
+/***********************************************************************
+HashTableBenchmark - Program to compare the insertion, lookup, iteration
+and removal performance of the chained and open-addressing hash tables
+using pointer keys.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Miscellaneous Support Library (Misc).
+
+The Miscellaneous Support Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Miscellaneous Support Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Miscellaneous Support Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Misc/HashTable.h>
+#include <Misc/FlatHashTable.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+struct Object // Stand-in for heap-allocated objects used as hash table keys
+	{
+	/* Elements: */
+	public:
+	char data[48];
+	};
+
+struct Keys // Structure holding the key sets for one benchmark size
+	{
+	/* Elements: */
+	public:
+	std::vector<Object*> objects; // Heap-allocated key objects
+	std::vector<const Object*> insertOrder; // Keys in insertion order
+	std::vector<const Object*> lookupOrder; // The same keys in a different random order
+	std::vector<const Object*> missingKeys; // Keys not inserted into the table
+	};
+
+class Timer // Helper class to time a benchmark phase and print its per-operation time
+	{
+	/* Elements: */
+	private:
+	Misc::Time startTime;
+	
+	/* Constructors and destructors: */
+	public:
+	Timer(void)
+		:startTime(Misc::Time::now())
+		{
+		}
+	
+	/* Methods: */
+	void print(size_t numOperations) const
+		{
+		double elapsed=toSeconds(Misc::Time::now()-startTime);
+		std::cout<<std::setw(10)<<std::fixed<<std::setprecision(1)<<elapsed*1.0e9/double(numOperations);
+		}
+	};
+
+template <class TableParam>
+void runBenchmark(const char* name,const Keys& keys,unsigned int numRounds)
+	{
+	size_t numKeys=keys.insertOrder.size();
+	size_t checksum=0;
+	std::cout<<std::setw(14)<<std::left<<name<<std::right<<std::setw(10)<<numKeys;
+	
+	/* Insert all keys into a table starting at the default size used by GLContextData: */
+	TableParam table(101);
+	{
+	Timer timer;
+	for(size_t i=0;i<numKeys;++i)
+		table.setEntry(typename TableParam::Entry(keys.insertOrder[i],i));
+	timer.print(numKeys);
+	}
+	
+	/* Look up all keys in random order: */
+	{
+	Timer timer;
+	for(unsigned int round=0;round<numRounds;++round)
+		for(std::vector<const Object*>::const_iterator kIt=keys.lookupOrder.begin();kIt!=keys.lookupOrder.end();++kIt)
+			{
+			typename TableParam::Iterator tIt=table.findEntry(*kIt);
+			if(!tIt.isFinished())
+				checksum+=tIt->getDest();
+			}
+	timer.print(numKeys*numRounds);
+	}
+	
+	/* Look up keys that are not in the table: */
+	{
+	Timer timer;
+	for(unsigned int round=0;round<numRounds;++round)
+		for(std::vector<const Object*>::const_iterator kIt=keys.missingKeys.begin();kIt!=keys.missingKeys.end();++kIt)
+			if(table.isEntry(*kIt))
+				++checksum;
+	timer.print(numKeys*numRounds);
+	}
+	
+	/* Iterate through all entries: */
+	{
+	Timer timer;
+	for(unsigned int round=0;round<numRounds;++round)
+		for(typename TableParam::Iterator tIt=table.begin();!tIt.isFinished();++tIt)
+			checksum+=tIt->getDest();
+	timer.print(numKeys*numRounds);
+	}
+	
+	/* Remove all keys in random order: */
+	{
+	Timer timer;
+	for(std::vector<const Object*>::const_iterator kIt=keys.lookupOrder.begin();kIt!=keys.lookupOrder.end();++kIt)
+		table.removeEntry(*kIt);
+	timer.print(numKeys);
+	}
+	
+	std::cout<<std::setw(8)<<table.getNumEntries()<<std::setw(20)<<checksum<<std::endl;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	size_t maxNumKeys=1000000;
+	size_t numLookups=10000000;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"maxKeys")==0&&i+1<argc)
+				{
+				maxNumKeys=size_t(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"lookups")==0&&i+1<argc)
+				{
+				numLookups=size_t(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-maxKeys <maximum number of keys>] [-lookups <number of lookups per table size>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	std::cout<<"Times in ns per operation"<<std::endl;
+	std::cout<<"Table               Keys    Insert    Lookup      Miss   Iterate    Remove    Left            Checksum"<<std::endl;
+	
+	for(size_t numKeys=100;numKeys<=maxNumKeys;numKeys*=10)
+		{
+		/* Allocate twice the number of key objects, and use half of them as missing keys: */
+		Keys keys;
+		srand(1);
+		for(size_t i=0;i<numKeys*2;++i)
+			keys.objects.push_back(new Object);
+		std::random_shuffle(keys.objects.begin(),keys.objects.end());
+		keys.insertOrder.assign(keys.objects.begin(),keys.objects.begin()+numKeys);
+		keys.missingKeys.assign(keys.objects.begin()+numKeys,keys.objects.end());
+		keys.lookupOrder=keys.insertOrder;
+		std::random_shuffle(keys.lookupOrder.begin(),keys.lookupOrder.end());
+		
+		/* Run the same number of lookups for all table sizes: */
+		unsigned int numRounds=(unsigned int)((numLookups+numKeys-1)/numKeys);
+		runBenchmark<Misc::HashTable<const Object*,size_t> >("HashTable",keys,numRounds);
+		runBenchmark<Misc::FlatHashTable<const Object*,size_t> >("FlatHashTable",keys,numRounds);
+		
+		for(std::vector<Object*>::iterator oIt=keys.objects.begin();oIt!=keys.objects.end();++oIt)
+			delete *oIt;
+		}
+	
+	return 0;
+	}
@@ -41,12 +41,16 @@ class Atomic
 	/* Elements: */
 	private:
 	#if !THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
-	Spinlock mutex; // Busy-wait (if available) mutual exclusion semaphore protecting the atomic value
+	mutable Spinlock mutex; // Busy-wait (if available) mutual exclusion semaphore protecting the atomic value
 	#endif
 	Value value; // The object's current value
 	
 	/* Constructors and destructors: */
 	public:
+	Atomic(void) // Initializes the object with a zero value
+		:value(0)
+		{
+		}
 	Atomic(Value sValue) // Initializes the object with the given value
 		:value(sValue)
 		{
@@ -58,6 +62,31 @@ class Atomic
 	/* Methods: */
 	public:
 	
+	/* Access methods; both act as full memory barriers: */
+	Value get(void) const // Returns the current value
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		__sync_synchronize();
+		Value result=const_cast<const volatile Value&>(value);
+		__sync_synchronize();
+		return result;
+		#else
+		Spinlock::Lock lock(mutex);
+		return value;
+		#endif
+		}
+	void set(Value newValue) // Sets the value
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		__sync_synchronize();
+		const_cast<volatile Value&>(value)=newValue;
+		__sync_synchronize();
+		#else
+		Spinlock::Lock lock(mutex);
+		value=newValue;
+		#endif
+		}
+	
 	/* Pre-operation methods; return atomic value after operation: */
 	Value preAdd(Value other) // Pre-addition
 		{
@@ -0,0 +1,158 @@
+/***********************************************************************
+EventCount - Class to block threads until a lock-free data structure
+changes state, without requiring producers to take a lock. Uses futexes
+where available, and falls back to a mutex and condition variable
+otherwise.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef THREADS_EVENTCOUNT_INCLUDED
+#define THREADS_EVENTCOUNT_INCLUDED
+
+#include <Threads/Config.h>
+#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS&&defined(__linux__)
+#define THREADS_EVENTCOUNT_USE_FUTEX 1
+#else
+#define THREADS_EVENTCOUNT_USE_FUTEX 0
+#endif
+#if THREADS_EVENTCOUNT_USE_FUTEX
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <Threads/Mutex.h>
+#include <Threads/Cond.h>
+#endif
+
+namespace Threads {
+
+class EventCount
+	{
+	/* Elements: */
+	private:
+	volatile unsigned long long state; // Current epoch in the upper 32 bits, number of threads waiting for the end of the current epoch in the lower 32 bits
+	#if !THREADS_EVENTCOUNT_USE_FUTEX
+	Mutex epochMutex; // Mutex serializing waiting for and signaling the end of an epoch; also protects the state if there are no built-in atomic operations
+	Cond epochCond; // Condition variable to signal the end of an epoch
+	#endif
+	
+	/* Private methods: */
+	static int getEpoch(unsigned long long state) // Returns the epoch of the given state
+		{
+		return int(state>>32);
+		}
+	#if THREADS_EVENTCOUNT_USE_FUTEX
+	int* getEpochWord(void) // Returns the address of the epoch half of the state, to wait on with a futex
+		{
+		#if __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
+		return const_cast<int*>(reinterpret_cast<volatile int*>(&state))+1;
+		#else
+		return const_cast<int*>(reinterpret_cast<volatile int*>(&state));
+		#endif
+		}
+	#endif
+	
+	/* Constructors and destructors: */
+	public:
+	EventCount(void) // Creates an event count without waiting threads
+		:state(0ULL)
+		{
+		}
+	private:
+	EventCount(const EventCount& source); // Prohibit copy constructor
+	EventCount& operator=(const EventCount& source); // Prohibit assignment operator
+	
+	/* Methods: */
+	public:
+	int prepareWait(void) // Registers the calling thread as a waiter; caller must re-check its wait condition and then call wait or cancelWait; returns key to pass to wait or cancelWait
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		return getEpoch(__sync_add_and_fetch(&state,1ULL));
+		#else
+		Mutex::Lock epochLock(epochMutex);
+		return getEpoch(++state);
+		#endif
+		}
+	void cancelWait(int key) // Unregisters the calling thread after its wait condition became false after calling prepareWait
+		{
+		/* Remove the thread from the waiter count unless a notification already did: */
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		unsigned long long oldState=state;
+		while(getEpoch(oldState)==key)
+			{
+			unsigned long long seenState=__sync_val_compare_and_swap(&state,oldState,oldState-1ULL);
+			if(seenState==oldState)
+				break;
+			oldState=seenState;
+			}
+		#else
+		Mutex::Lock epochLock(epochMutex);
+		if(getEpoch(state)==key)
+			--state;
+		#endif
+		}
+	void wait(int key) // Blocks the calling thread until a notification after the call to prepareWait that returned the given key
+		{
+		#if THREADS_EVENTCOUNT_USE_FUTEX
+		while(getEpoch(state)==key)
+			syscall(SYS_futex,getEpochWord(),FUTEX_WAIT_PRIVATE,key,0,0,0);
+		#else
+		Mutex::Lock epochLock(epochMutex);
+		while(getEpoch(state)==key)
+			epochCond.wait(epochMutex);
+		#endif
+		}
+	void notifyAll(void) // Wakes up all waiting threads; caller must have made its state change visible beforehand
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		/* Only enter the kernel if there are threads that have not been woken up yet: */
+		__sync_synchronize();
+		unsigned long long oldState=state;
+		while((oldState&0xffffffffULL)!=0ULL)
+			{
+			/* Start a new epoch without waiting threads: */
+			unsigned long long seenState=__sync_val_compare_and_swap(&state,oldState,(oldState&~0xffffffffULL)+(1ULL<<32));
+			if(seenState==oldState)
+				{
+				#if THREADS_EVENTCOUNT_USE_FUTEX
+				syscall(SYS_futex,getEpochWord(),FUTEX_WAKE_PRIVATE,INT_MAX,0,0,0);
+				#else
+				Mutex::Lock epochLock(epochMutex);
+				epochCond.broadcast();
+				#endif
+				break;
+				}
+			oldState=seenState;
+			}
+		#else
+		/* Start a new epoch without waiting threads if there are threads that have not been woken up yet: */
+		Mutex::Lock epochLock(epochMutex);
+		if((state&0xffffffffULL)!=0ULL)
+			{
+			state=(state&~0xffffffffULL)+(1ULL<<32);
+			epochCond.broadcast();
+			}
+		#endif
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+/***********************************************************************
+MpmcQueue - Lock-free limited-size queue to send data from one or more
+producers to one or more consumers. Producers and consumers only block,
+without taking locks, while the queue is full or empty, respectively.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef THREADS_MPMCQUEUE_INCLUDED
+#define THREADS_MPMCQUEUE_INCLUDED
+
+#include <stddef.h>
+#include <Threads/Config.h>
+#if !THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+#include <Threads/Spinlock.h>
+#endif
+#include <Threads/EventCount.h>
+
+namespace Threads {
+
+template <class ValueParam>
+class MpmcQueue
+	{
+	/* Embedded classes: */
+	public:
+	typedef ValueParam Value; // Type of communicated data
+	
+	private:
+	static const size_t cacheLineSize=64; // Assumed size of a CPU cache line in bytes
+	static const unsigned int numSpins=100; // Number of times to retry an operation on a full or empty queue before blocking
+	
+	struct Cell // Structure for queue slots
+		{
+		/* Elements: */
+		public:
+		volatile size_t sequence; // Free-running index at which the slot can next be written (if equal) or read (if one larger)
+		Value value; // Value stored in the slot
+		};
+	
+	struct Position // Structure for a free-running queue position, padded to occupy its own cache line
+		{
+		/* Elements: */
+		public:
+		volatile size_t index; // Free-running index of the next slot to be claimed
+		char padding[cacheLineSize-sizeof(size_t)]; // Padding to the end of the cache line
+		};
+	
+	/* Elements: */
+	Cell* cells; // Array of queue slots
+	size_t cellMask; // Bit mask to convert free-running indices to slot indices
+	char padding[cacheLineSize]; // Padding to separate the producers' position from the read-only elements above
+	Position tail; // Position claimed by the next producer
+	Position head; // Position claimed by the next consumer
+	#if !THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+	Spinlock queueMutex; // Busy-wait (if available) mutual exclusion semaphore serializing all queue operations
+	#endif
+	EventCount notEmptyEvent; // Event signaled when the queue becomes non-empty
+	EventCount notFullEvent; // Event signaled when the queue becomes non-full
+	
+	/* Constructors and destructors: */
+	public:
+	MpmcQueue(size_t maxQueueLength) // Creates a queue that can hold at least the given number of elements
+		{
+		/* Round the queue size up to the next power of two: */
+		size_t numCells=2;
+		while(numCells<maxQueueLength)
+			numCells<<=1;
+		cellMask=numCells-1;
+		cells=new Cell[numCells];
+		for(size_t i=0;i<numCells;++i)
+			cells[i].sequence=i;
+		tail.index=0;
+		head.index=0;
+		}
+	private:
+	MpmcQueue(const MpmcQueue& source); // Prohibit copy constructor
+	MpmcQueue& operator=(const MpmcQueue& source); // Prohibit assignment operator
+	public:
+	~MpmcQueue(void) // Destroys the queue and its contents
+		{
+		delete[] cells;
+		}
+	
+	/* Methods: */
+	bool tryPush(const Value& value) // Pushes the given value into the queue if it is not full; returns false if the queue was full
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		
+		/* Claim the next free slot: */
+		Cell* cell;
+		size_t index=tail.index;
+		while(true)
+			{
+			cell=&cells[index&cellMask];
+			size_t sequence=cell->sequence;
+			__sync_synchronize();
+			ptrdiff_t diff=ptrdiff_t(sequence)-ptrdiff_t(index);
+			if(diff==0)
+				{
+				/* Try claiming the slot: */
+				size_t oldIndex=__sync_val_compare_and_swap(&tail.index,index,index+1);
+				if(oldIndex==index)
+					break;
+				index=oldIndex;
+				}
+			else if(diff<0)
+				{
+				/* The slot has not been read since the last round; queue is full: */
+				return false;
+				}
+			else
+				{
+				/* Another producer claimed the slot; try again: */
+				index=tail.index;
+				}
+			}
+		
+		/* Store the value and publish the slot to consumers: */
+		cell->value=value;
+		__sync_synchronize();
+		cell->sequence=index+1;
+		
+		#else
+		
+		{
+		/* Store the value in the next slot unless the queue is full: */
+		Spinlock::Lock queueLock(queueMutex);
+		Cell& cell=cells[tail.index&cellMask];
+		if(cell.sequence!=tail.index)
+			return false;
+		cell.value=value;
+		cell.sequence=tail.index+1;
+		++tail.index;
+		}
+		
+		#endif
+		
+		/* Wake up consumers blocked on an empty queue: */
+		notEmptyEvent.notifyAll();
+		
+		return true;
+		}
+	void push(const Value& value) // Pushes the given value into the queue; blocks if queue is full
+		{
+		/* Retry for a short while before blocking: */
+		bool pushed=tryPush(value);
+		for(unsigned int spin=0;!pushed&&spin<numSpins;++spin)
+			pushed=tryPush(value);
+		while(!pushed)
+			{
+			/* Block until a consumer removes an element: */
+			int key=notFullEvent.prepareWait();
+			pushed=tryPush(value);
+			if(pushed)
+				notFullEvent.cancelWait(key);
+			else
+				{
+				notFullEvent.wait(key);
+				pushed=tryPush(value);
+				}
+			}
+		}
+	bool tryPop(Value& value) // Removes the first value from the queue and stores it in the given variable if the queue is not empty; returns false if the queue was empty
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		
+		/* Claim the next full slot: */
+		Cell* cell;
+		size_t index=head.index;
+		while(true)
+			{
+			cell=&cells[index&cellMask];
+			size_t sequence=cell->sequence;
+			__sync_synchronize();
+			ptrdiff_t diff=ptrdiff_t(sequence)-ptrdiff_t(index+1);
+			if(diff==0)
+				{
+				/* Try claiming the slot: */
+				size_t oldIndex=__sync_val_compare_and_swap(&head.index,index,index+1);
+				if(oldIndex==index)
+					break;
+				index=oldIndex;
+				}
+			else if(diff<0)
+				{
+				/* The slot has not been written since the last round; queue is empty: */
+				return false;
+				}
+			else
+				{
+				/* Another consumer claimed the slot; try again: */
+				index=head.index;
+				}
+			}
+		
+		/* Retrieve the value and release the slot to producers for the next round: */
+		value=cell->value;
+		__sync_synchronize();
+		cell->sequence=index+cellMask+1;
+		
+		#else
+		
+		{
+		/* Retrieve the value from the first slot unless the queue is empty: */
+		Spinlock::Lock queueLock(queueMutex);
+		Cell& cell=cells[head.index&cellMask];
+		if(cell.sequence!=head.index+1)
+			return false;
+		value=cell.value;
+		cell.sequence=head.index+cellMask+1;
+		++head.index;
+		}
+		
+		#endif
+		
+		/* Wake up producers blocked on a full queue: */
+		notFullEvent.notifyAll();
+		
+		return true;
+		}
+	Value pop(void) // Returns and removes the first value from the queue; blocks if queue is empty
+		{
+		Value result;
+		/* Retry for a short while before blocking: */
+		bool popped=tryPop(result);
+		for(unsigned int spin=0;!popped&&spin<numSpins;++spin)
+			popped=tryPop(result);
+		while(!popped)
+			{
+			/* Block until a producer inserts an element: */
+			int key=notEmptyEvent.prepareWait();
+			popped=tryPop(result);
+			if(popped)
+				notEmptyEvent.cancelWait(key);
+			else
+				{
+				notEmptyEvent.wait(key);
+				popped=tryPop(result);
+				}
+			}
+		
+		return result;
+		}
+	};
+
+}
+
+#endif
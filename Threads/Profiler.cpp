@@ -0,0 +1,288 @@
+/***********************************************************************
+Profiler - Class to record the start and end times of named code zones
+executed by any number of threads into per-thread buffers, and to write
+them as Chrome trace event files for offline analysis.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Threads/Profiler.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <Misc/ThrowStdErr.h>
+#include <Threads/Atomic.h>
+#include <Threads/Mutex.h>
+
+namespace Threads {
+
+/******************************************
+Declaration of struct Profiler::ThreadBuffer:
+******************************************/
+
+struct Profiler::ThreadBuffer
+	{
+	/* Elements: */
+	public:
+	ThreadBuffer* succ; // Pointer to the next buffer in the buffer list
+	unsigned int threadIndex; // Index identifying the buffer's thread in trace files
+	char threadName[64]; // Name of the buffer's thread in trace files
+	bool retired; // Flag whether the buffer's thread has exited
+	unsigned int generation; // Recording session to which the buffer's events belong; only accessed by the buffer's thread
+	size_t maxNumEvents; // Number of events the buffer can hold
+	Event* events; // Array of recorded events
+	size_t numEvents; // Number of recorded events; only accessed by the buffer's thread
+	Atomic<unsigned int> publishedGeneration; // Recording session to which the events published to trace writers belong
+	Atomic<size_t> numPublishedEvents; // Number of completely recorded events published to trace writers
+	Atomic<size_t> numDroppedEvents; // Number of events dropped because the buffer was full
+	};
+
+namespace {
+
+/****************************
+Global state of the profiler:
+****************************/
+
+pthread_once_t bufferKeyOnce=PTHREAD_ONCE_INIT; // Guard to create the thread buffer key exactly once
+pthread_key_t bufferKey; // Process-wide key to find the calling thread's event buffer
+Mutex bufferListMutex; // Mutex serializing changes to the buffer list and recording sessions
+unsigned int nextThreadIndex=0; // Index to assign to the next thread creating an event buffer
+Atomic<unsigned int> generation(0U); // Index of the current recording session; zero if there has been no session yet
+size_t maxNumEventsPerThread=0; // Size of event buffers in the current recording session
+Misc::UInt64 timeBase=0; // Time at which the current recording session started
+
+/****************
+Helper functions:
+****************/
+
+void writeJsonString(FILE* file,const char* string) // Writes the given string as a quoted JSON string
+	{
+	fputc('\"',file);
+	for(const char* sPtr=string;*sPtr!='\0';++sPtr)
+		{
+		if(*sPtr=='\"'||*sPtr=='\\')
+			{
+			fputc('\\',file);
+			fputc(*sPtr,file);
+			}
+		else if((unsigned char)(*sPtr)<0x20U)
+			fprintf(file,"\\u%04x",(unsigned int)(unsigned char)(*sPtr));
+		else
+			fputc(*sPtr,file);
+		}
+	fputc('\"',file);
+	}
+
+}
+
+/*********************************
+Static elements of class Profiler:
+*********************************/
+
+volatile bool Profiler::active=false;
+Profiler::ThreadBuffer* Profiler::firstBuffer=0;
+
+/*************************
+Methods of class Profiler:
+*************************/
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer(void)
+	{
+	/* Return the calling thread's existing buffer: */
+	pthread_once(&bufferKeyOnce,createBufferKey);
+	ThreadBuffer* buffer=static_cast<ThreadBuffer*>(pthread_getspecific(bufferKey));
+	if(buffer!=0)
+		return buffer;
+	
+	/* Create an empty buffer; events are allocated once the thread records in an active session: */
+	buffer=new ThreadBuffer;
+	buffer->retired=false;
+	buffer->generation=0;
+	buffer->maxNumEvents=0;
+	buffer->events=0;
+	buffer->numEvents=0;
+	
+	/* Link the buffer into the buffer list: */
+	{
+	Mutex::Lock bufferListLock(bufferListMutex);
+	buffer->threadIndex=nextThreadIndex;
+	++nextThreadIndex;
+	snprintf(buffer->threadName,sizeof(buffer->threadName),"Thread %u",buffer->threadIndex);
+	buffer->succ=firstBuffer;
+	firstBuffer=buffer;
+	}
+	
+	/* Associate the buffer with the calling thread: */
+	pthread_setspecific(bufferKey,buffer);
+	
+	return buffer;
+	}
+
+void Profiler::createBufferKey(void)
+	{
+	pthread_key_create(&bufferKey,destroyThreadBuffer);
+	}
+
+void Profiler::destroyThreadBuffer(void* buffer)
+	{
+	/* Keep the buffer's events until the next recording session, but mark it for deletion: */
+	Mutex::Lock bufferListLock(bufferListMutex);
+	static_cast<ThreadBuffer*>(buffer)->retired=true;
+	}
+
+void Profiler::record(const char* name,Misc::UInt64 startTime,Misc::UInt64 endTime)
+	{
+	ThreadBuffer* buffer=getThreadBuffer();
+	
+	/* Discard the buffer's events if a new recording session started: */
+	unsigned int currentGeneration=generation.get();
+	if(buffer->generation!=currentGeneration)
+		{
+		/* Reallocate the event array if the buffer size changed: */
+		size_t newMaxNumEvents=maxNumEventsPerThread;
+		if(buffer->maxNumEvents!=newMaxNumEvents)
+			{
+			delete[] buffer->events;
+			buffer->events=new Event[newMaxNumEvents];
+			buffer->maxNumEvents=newMaxNumEvents;
+			}
+		buffer->numEvents=0;
+		buffer->generation=currentGeneration;
+		
+		/* Publish the reset buffer: */
+		buffer->numPublishedEvents.set(0);
+		buffer->numDroppedEvents.set(0);
+		buffer->publishedGeneration.set(currentGeneration);
+		}
+	
+	/* Store the event and publish it to trace writers: */
+	if(buffer->numEvents<buffer->maxNumEvents)
+		{
+		Event& event=buffer->events[buffer->numEvents];
+		event.name=name;
+		event.startTime=startTime;
+		event.duration=endTime-startTime;
+		++buffer->numEvents;
+		buffer->numPublishedEvents.set(buffer->numEvents);
+		}
+	else
+		buffer->numDroppedEvents.preAdd(1);
+	}
+
+void Profiler::setThreadName(const char* newThreadName)
+	{
+	ThreadBuffer* buffer=getThreadBuffer();
+	
+	Mutex::Lock bufferListLock(bufferListMutex);
+	strncpy(buffer->threadName,newThreadName,sizeof(buffer->threadName)-1);
+	buffer->threadName[sizeof(buffer->threadName)-1]='\0';
+	}
+
+void Profiler::start(size_t newMaxNumEventsPerThread)
+	{
+	Mutex::Lock bufferListLock(bufferListMutex);
+	
+	/* Delete the buffers of threads that exited: */
+	ThreadBuffer** bufferPtr=&firstBuffer;
+	while(*bufferPtr!=0)
+		{
+		ThreadBuffer* buffer=*bufferPtr;
+		if(buffer->retired)
+			{
+			*bufferPtr=buffer->succ;
+			delete[] buffer->events;
+			delete buffer;
+			}
+		else
+			bufferPtr=&buffer->succ;
+		}
+	
+	/* Start a new recording session; threads discard their old events on their next recorded event: */
+	maxNumEventsPerThread=newMaxNumEventsPerThread;
+	timeBase=getTime();
+	if(generation.preAdd(1U)==0U)
+		generation.preAdd(1U);
+	active=true;
+	}
+
+void Profiler::stop(void)
+	{
+	active=false;
+	}
+
+size_t Profiler::getNumDroppedEvents(void)
+	{
+	Mutex::Lock bufferListLock(bufferListMutex);
+	
+	size_t result=0;
+	for(ThreadBuffer* bPtr=firstBuffer;bPtr!=0;bPtr=bPtr->succ)
+		if(bPtr->publishedGeneration.get()==generation.get())
+			result+=bPtr->numDroppedEvents.get();
+	return result;
+	}
+
+void Profiler::writeTrace(const char* traceFileName)
+	{
+	Mutex::Lock bufferListLock(bufferListMutex);
+	
+	/* Open the trace file: */
+	FILE* traceFile=fopen(traceFileName,"wt");
+	if(traceFile==0)
+		Misc::throwStdErr("Threads::Profiler::writeTrace: Unable to open trace file %s",traceFileName);
+	
+	fprintf(traceFile,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	int pid=int(getpid());
+	bool first=true;
+	for(ThreadBuffer* bPtr=firstBuffer;bPtr!=0;bPtr=bPtr->succ)
+		{
+		/* Skip buffers that did not record anything in the current session: */
+		unsigned int currentGeneration=generation.get();
+		if(currentGeneration==0||bPtr->publishedGeneration.get()!=currentGeneration)
+			continue;
+		
+		/* Take a snapshot of the buffer's completely recorded events: */
+		size_t numEvents=bPtr->numPublishedEvents.get();
+		
+		/* Write a metadata event naming the thread: */
+		if(!first)
+			fprintf(traceFile,",\n");
+		first=false;
+		fprintf(traceFile,"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",pid,bPtr->threadIndex);
+		writeJsonString(traceFile,bPtr->threadName);
+		fprintf(traceFile,",\"droppedEvents\":%lu}}",(unsigned long)bPtr->numDroppedEvents.get());
+		
+		/* Write all events as complete events with microsecond time stamps: */
+		for(size_t i=0;i<numEvents;++i)
+			{
+			const Event& event=bPtr->events[i];
+			fprintf(traceFile,",\n{\"name\":");
+			writeJsonString(traceFile,event.name);
+			fprintf(traceFile,",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",pid,bPtr->threadIndex,double(event.startTime-timeBase)*1.0e-3,double(event.duration)*1.0e-3);
+			}
+		}
+	fprintf(traceFile,"\n]}\n");
+	
+	/* Close the trace file and check for errors: */
+	bool error=ferror(traceFile)!=0;
+	if(fclose(traceFile)!=0||error)
+		Misc::throwStdErr("Threads::Profiler::writeTrace: Error while writing trace file %s",traceFileName);
+	}
+
+}
@@ -0,0 +1,119 @@
+/***********************************************************************
+Profiler - Class to record the start and end times of named code zones
+executed by any number of threads into per-thread buffers, and to write
+them as Chrome trace event files for offline analysis.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef THREADS_PROFILER_INCLUDED
+#define THREADS_PROFILER_INCLUDED
+
+#include <stddef.h>
+#include <time.h>
+#include <Misc/SizedTypes.h>
+#include <Threads/Config.h>
+
+namespace Threads {
+
+class Profiler
+	{
+	/* Embedded classes: */
+	public:
+	class Zone // Class to record the execution of a named code zone during the lifetime of a zone object
+		{
+		/* Elements: */
+		private:
+		const char* name; // Name of the zone; must be a string with static storage duration
+		Misc::UInt64 startTime; // Time at which the zone was entered, or zero if the profiler was not recording
+		
+		/* Constructors and destructors: */
+		public:
+		Zone(const char* sName) // Enters the zone of the given name
+			:name(sName),
+			 startTime(active?getTime():0U)
+			{
+			}
+		~Zone(void) // Leaves the zone
+			{
+			if(startTime!=0U)
+				record(name,startTime,getTime());
+			}
+		};
+	
+	private:
+	struct Event // Structure for a recorded execution of a code zone
+		{
+		/* Elements: */
+		public:
+		const char* name; // Name of the zone
+		Misc::UInt64 startTime; // Time at which the zone was entered
+		Misc::UInt64 duration; // Time spent inside the zone
+		};
+	
+	struct ThreadBuffer; // Structure holding the events recorded by a single thread
+	
+	/* Elements: */
+	static volatile bool active; // Flag whether the profiler is currently recording
+	static ThreadBuffer* firstBuffer; // Head of the list of all threads' event buffers
+	
+	/* Private methods: */
+	static void createBufferKey(void); // Creates the process-wide key to find threads' event buffers
+	static ThreadBuffer* getThreadBuffer(void); // Returns the calling thread's event buffer; creates it on first use
+	static void destroyThreadBuffer(void* buffer); // Retires the event buffer of an exiting thread
+	static void record(const char* name,Misc::UInt64 startTime,Misc::UInt64 endTime); // Records an execution of the given zone by the calling thread
+	
+	/* Methods: */
+	public:
+	static Misc::UInt64 getTime(void) // Returns the current time of a monotonic clock in nanoseconds
+		{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		return Misc::UInt64(now.tv_sec)*1000000000U+Misc::UInt64(now.tv_nsec);
+		}
+	static bool isActive(void) // Returns true if the profiler is currently recording
+		{
+		return active;
+		}
+	static void setThreadName(const char* newThreadName); // Sets the name under which the calling thread's zones appear in trace files
+	static void start(size_t newMaxNumEventsPerThread =65536); // Discards all previously recorded events and starts recording at most the given number of events per thread
+	static void stop(void); // Stops recording; recorded events are retained until the next call to start
+	static size_t getNumDroppedEvents(void); // Returns the number of events that were not recorded because their threads' buffers were full
+	static void writeTrace(const char* traceFileName); // Writes all events recorded since the last call to start to a Chrome trace event file of the given name; can be called while the profiler is recording
+	};
+
+}
+
+/*****************************************************************
+Macro to profile the rest of the enclosing scope as a named zone,
+which vanishes if the profiler is not compiled into the library:
+*****************************************************************/
+
+#if THREADS_CONFIG_PROFILER
+
+#define THREADS_PROFILER_ZONE_VARIABLE2(line) threadsProfilerZone##line
+#define THREADS_PROFILER_ZONE_VARIABLE(line) THREADS_PROFILER_ZONE_VARIABLE2(line)
+#define THREADS_PROFILE_ZONE(name) Threads::Profiler::Zone THREADS_PROFILER_ZONE_VARIABLE(__LINE__)(name)
+
+#else
+
+#define THREADS_PROFILE_ZONE(name)
+
+#endif
+
+#endif
@@ -0,0 +1,281 @@
+/***********************************************************************
+SlabAllocator - Thread-safe memory allocator for small objects, which
+rounds request sizes up to a set of size classes, carves blocks from
+large slabs, and keeps per-thread caches of free blocks to avoid lock
+contention between threads.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Threads/SlabAllocator.h>
+
+#include <stdlib.h>
+#include <new>
+
+namespace Threads {
+
+/******************************
+Methods of class SlabAllocator:
+******************************/
+
+size_t SlabAllocator::getClassSize(unsigned int sizeClass)
+	{
+	if(sizeClass<8U)
+		return size_t(sizeClass+1U)*16U;
+	
+	/* Each power of two is split into four equally-spaced classes: */
+	unsigned int p=7U+(sizeClass-8U)/4U;
+	unsigned int k=(sizeClass-8U)%4U;
+	return size_t(5U+k)<<(p-2U);
+	}
+
+unsigned int SlabAllocator::getBatchSize(unsigned int sizeClass)
+	{
+	/* Move about 32KB of blocks at once, but at least four and at most 64 blocks: */
+	size_t batchSize=32768U/getClassSize(sizeClass);
+	if(batchSize<4U)
+		batchSize=4U;
+	if(batchSize>64U)
+		batchSize=64U;
+	return (unsigned int)batchSize;
+	}
+
+void SlabAllocator::destroyCache(void* cache)
+	{
+	ThreadCache* threadCache=static_cast<ThreadCache*>(cache);
+	threadCache->allocator->releaseCache(threadCache);
+	}
+
+SlabAllocator::ThreadCache* SlabAllocator::createCache(void)
+	{
+	/* Create an empty cache: */
+	ThreadCache* cache=new ThreadCache;
+	cache->allocator=this;
+	cache->pred=0;
+	for(unsigned int i=0;i<numSizeClasses;++i)
+		{
+		cache->heads[i]=0;
+		cache->numFree[i]=0;
+		cache->numAllocated[i]=0;
+		}
+	
+	/* Link the cache into the cache list: */
+	{
+	Mutex::Lock cacheListLock(cacheListMutex);
+	cache->succ=firstCache;
+	if(firstCache!=0)
+		firstCache->pred=cache;
+	firstCache=cache;
+	}
+	
+	/* Associate the cache with the calling thread: */
+	pthread_setspecific(cacheKey,cache);
+	
+	return cache;
+	}
+
+void SlabAllocator::releaseCache(SlabAllocator::ThreadCache* cache)
+	{
+	/* Return all free blocks to the central free lists: */
+	for(unsigned int i=0;i<numSizeClasses;++i)
+		if(cache->numFree[i]>0)
+			drainCache(cache,i,cache->numFree[i]);
+	
+	{
+	Mutex::Lock cacheListLock(cacheListMutex);
+	
+	/* Retain the cache's allocation counts for statistics: */
+	for(unsigned int i=0;i<numSizeClasses;++i)
+		retiredNumAllocated[i]+=cache->numAllocated[i];
+	
+	/* Unlink the cache from the cache list: */
+	if(cache->pred!=0)
+		cache->pred->succ=cache->succ;
+	else
+		firstCache=cache->succ;
+	if(cache->succ!=0)
+		cache->succ->pred=cache->pred;
+	}
+	
+	delete cache;
+	}
+
+void SlabAllocator::refillCache(SlabAllocator::ThreadCache* cache,unsigned int sizeClass)
+	{
+	size_t classSize=getClassSize(sizeClass);
+	unsigned int batchSize=getBatchSize(sizeClass);
+	SizeClass& sc=sizeClasses[sizeClass];
+	
+	unsigned int numBlocks=0;
+	bool newSlab=false;
+	{
+	Spinlock::Lock classLock(sc.mutex);
+	
+	/* Carve a new slab into free blocks if the central free list is empty: */
+	if(sc.head==0)
+		{
+		char* slab=static_cast<char*>(malloc(slabSize));
+		if(slab==0)
+			throw std::bad_alloc();
+		sc.slabs.push_back(slab);
+		newSlab=true;
+		
+		size_t numSlabBlocks=slabSize/classSize;
+		char* blockPtr=slab+(numSlabBlocks-1)*classSize;
+		for(size_t i=0;i<numSlabBlocks;++i,blockPtr-=classSize)
+			{
+			FreeBlock* block=reinterpret_cast<FreeBlock*>(blockPtr);
+			block->succ=sc.head;
+			sc.head=block;
+			}
+		}
+	
+	/* Move a batch of blocks to the cache: */
+	while(numBlocks<batchSize&&sc.head!=0)
+		{
+		FreeBlock* block=sc.head;
+		sc.head=block->succ;
+		block->succ=cache->heads[sizeClass];
+		cache->heads[sizeClass]=block;
+		++numBlocks;
+		}
+	}
+	cache->numFree[sizeClass]+=numBlocks;
+	
+	/* Update the statistics: */
+	Spinlock::Lock statsLock(statsMutex);
+	if(newSlab)
+		bytesReserved+=slabSize;
+	bytesHandedOut+=numBlocks*classSize;
+	if(peakBytesHandedOut<bytesHandedOut)
+		peakBytesHandedOut=bytesHandedOut;
+	}
+
+void SlabAllocator::drainCache(SlabAllocator::ThreadCache* cache,unsigned int sizeClass,unsigned int numBlocks)
+	{
+	/* Detach the given number of blocks from the front of the cache's free list: */
+	FreeBlock* first=cache->heads[sizeClass];
+	FreeBlock* last=first;
+	for(unsigned int i=1;i<numBlocks;++i)
+		last=last->succ;
+	cache->heads[sizeClass]=last->succ;
+	cache->numFree[sizeClass]-=numBlocks;
+	
+	/* Splice the detached blocks into the central free list: */
+	{
+	SizeClass& sc=sizeClasses[sizeClass];
+	Spinlock::Lock classLock(sc.mutex);
+	last->succ=sc.head;
+	sc.head=first;
+	}
+	
+	/* Update the statistics: */
+	Spinlock::Lock statsLock(statsMutex);
+	bytesHandedOut-=numBlocks*getClassSize(sizeClass);
+	}
+
+void* SlabAllocator::allocateLarge(size_t size)
+	{
+	void* result=malloc(size);
+	if(result==0)
+		throw std::bad_alloc();
+	
+	/* Update the statistics: */
+	Spinlock::Lock statsLock(statsMutex);
+	bytesReserved+=size;
+	bytesHandedOut+=size;
+	if(peakBytesHandedOut<bytesHandedOut)
+		peakBytesHandedOut=bytesHandedOut;
+	bytesInLargeBlocks+=size;
+	++numLargeBlocks;
+	
+	return result;
+	}
+
+void SlabAllocator::deallocateLarge(void* block,size_t size)
+	{
+	free(block);
+	
+	/* Update the statistics: */
+	Spinlock::Lock statsLock(statsMutex);
+	bytesReserved-=size;
+	bytesHandedOut-=size;
+	bytesInLargeBlocks-=size;
+	--numLargeBlocks;
+	}
+
+SlabAllocator::SlabAllocator(void)
+	:firstCache(0),
+	 bytesReserved(0),bytesHandedOut(0),peakBytesHandedOut(0),
+	 bytesInLargeBlocks(0),numLargeBlocks(0)
+	{
+	pthread_key_create(&cacheKey,destroyCache);
+	for(unsigned int i=0;i<numSizeClasses;++i)
+		retiredNumAllocated[i]=0;
+	}
+
+SlabAllocator::~SlabAllocator(void)
+	{
+	/* Detach the allocator from all threads; thread caches are not returned on thread exit anymore: */
+	pthread_key_delete(cacheKey);
+	
+	/* Delete all thread caches: */
+	while(firstCache!=0)
+		{
+		ThreadCache* succ=firstCache->succ;
+		delete firstCache;
+		firstCache=succ;
+		}
+	
+	/* Release all slabs: */
+	for(unsigned int i=0;i<numSizeClasses;++i)
+		for(std::vector<void*>::iterator sIt=sizeClasses[i].slabs.begin();sIt!=sizeClasses[i].slabs.end();++sIt)
+			free(*sIt);
+	}
+
+SlabAllocator::Statistics SlabAllocator::getStatistics(void)
+	{
+	Statistics result;
+	
+	/* Sum up the allocation counts of all thread caches; counts of running threads are sampled without synchronization: */
+	size_t slabBytesInUse=0;
+	{
+	Mutex::Lock cacheListLock(cacheListMutex);
+	for(unsigned int i=0;i<numSizeClasses;++i)
+		{
+		ptrdiff_t numBlocks=retiredNumAllocated[i];
+		for(ThreadCache* cPtr=firstCache;cPtr!=0;cPtr=cPtr->succ)
+			numBlocks+=cPtr->numAllocated[i];
+		result.numBlocks[i]=numBlocks>0?size_t(numBlocks):0U;
+		slabBytesInUse+=result.numBlocks[i]*getClassSize(i);
+		}
+	}
+	
+	/* Split the bytes handed out from slabs into allocated blocks and free blocks held in thread caches: */
+	Spinlock::Lock statsLock(statsMutex);
+	size_t slabBytesHandedOut=bytesHandedOut-bytesInLargeBlocks;
+	result.bytesReserved=bytesReserved;
+	result.bytesInUse=slabBytesInUse+bytesInLargeBlocks;
+	result.bytesCached=slabBytesHandedOut>slabBytesInUse?slabBytesHandedOut-slabBytesInUse:0U;
+	result.peakBytesHandedOut=peakBytesHandedOut;
+	result.numLargeBlocks=numLargeBlocks;
+	
+	return result;
+	}
+
+}
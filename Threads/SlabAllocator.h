@@ -0,0 +1,190 @@
+/***********************************************************************
+SlabAllocator - Thread-safe memory allocator for small objects, which
+rounds request sizes up to a set of size classes, carves blocks from
+large slabs, and keeps per-thread caches of free blocks to avoid lock
+contention between threads.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef THREADS_SLABALLOCATOR_INCLUDED
+#define THREADS_SLABALLOCATOR_INCLUDED
+
+#include <stddef.h>
+#include <pthread.h>
+#include <vector>
+#include <Threads/Spinlock.h>
+#include <Threads/Mutex.h>
+
+namespace Threads {
+
+class SlabAllocator
+	{
+	/* Embedded classes: */
+	public:
+	static const unsigned int numSizeClasses=36; // Number of size classes, from 16 bytes up to 16384 bytes
+	static const size_t maxClassSize=16384; // Largest request size served from slabs; larger requests are passed to malloc
+	static const size_t slabSize=65536; // Size of memory slabs carved into blocks
+	
+	struct Statistics // Structure reporting the allocator's memory use
+		{
+		/* Elements: */
+		public:
+		size_t bytesReserved; // Number of bytes in slabs and large blocks obtained from the system
+		size_t bytesInUse; // Number of bytes in blocks currently allocated by the application, rounded up to their size classes
+		size_t bytesCached; // Number of bytes in free blocks held in per-thread caches
+		size_t peakBytesHandedOut; // Highest number of bytes in use or held in per-thread caches since the allocator was created
+		size_t numBlocks[numSizeClasses]; // Number of currently allocated blocks per size class
+		size_t numLargeBlocks; // Number of currently allocated blocks larger than the largest size class
+		};
+	
+	private:
+	struct FreeBlock // Structure overlaying free memory blocks to link them into free lists
+		{
+		/* Elements: */
+		public:
+		FreeBlock* succ; // Pointer to next free block in the same list
+		};
+	
+	struct ThreadCache // Structure holding free blocks for exclusive use by a single thread
+		{
+		/* Elements: */
+		public:
+		SlabAllocator* allocator; // Pointer to the allocator owning this cache
+		ThreadCache* pred; // Pointer to previous cache in allocator's cache list
+		ThreadCache* succ; // Pointer to next cache in allocator's cache list
+		FreeBlock* heads[numSizeClasses]; // Heads of the per-class free lists
+		unsigned int numFree[numSizeClasses]; // Number of blocks in the per-class free lists
+		ptrdiff_t numAllocated[numSizeClasses]; // Number of blocks allocated minus number of blocks released by the cache's thread
+		};
+	
+	struct SizeClass // Structure holding the central free list of a size class
+		{
+		/* Elements: */
+		public:
+		Spinlock mutex; // Lock protecting the size class
+		FreeBlock* head; // Head of the central free list
+		std::vector<void*> slabs; // List of slabs carved for this size class
+		char padding[64]; // Padding to keep the locks of neighboring size classes on separate cache lines
+		
+		/* Constructors and destructors: */
+		SizeClass(void)
+			:head(0)
+			{
+			}
+		};
+	
+	/* Elements: */
+	pthread_key_t cacheKey; // Process-wide key to find the calling thread's cache
+	SizeClass sizeClasses[numSizeClasses]; // Array of central size classes
+	Mutex cacheListMutex; // Mutex protecting the list of thread caches
+	ThreadCache* firstCache; // Head of the list of thread caches
+	ptrdiff_t retiredNumAllocated[numSizeClasses]; // Block counts of the caches of threads that have already exited
+	Spinlock statsMutex; // Lock protecting the memory use statistics
+	size_t bytesReserved; // Number of bytes in slabs and large blocks
+	size_t bytesHandedOut; // Number of bytes handed out to thread caches or as large blocks
+	size_t peakBytesHandedOut; // Highest number of bytes handed out
+	size_t bytesInLargeBlocks; // Number of bytes in currently allocated large blocks
+	size_t numLargeBlocks; // Number of currently allocated large blocks
+	
+	/* Private methods: */
+	static unsigned int getSizeClass(size_t size) // Returns the index of the smallest size class holding the given number of bytes
+		{
+		if(size<=128)
+			return size>0?(unsigned int)((size-1)>>4):0U;
+		
+		/* Find the highest set bit of the size minus one and use the next two bits to select one of four classes per power of two: */
+		size_t s=size-1;
+		unsigned int p=7;
+		while((s>>(p+1))!=0)
+			++p;
+		return 8U+(p-7U)*4U+(unsigned int)((s>>(p-2))&0x3U);
+		}
+	static size_t getClassSize(unsigned int sizeClass); // Returns the block size of the given size class
+	static unsigned int getBatchSize(unsigned int sizeClass); // Returns the number of blocks moved between a thread cache and the central free lists at once
+	static void destroyCache(void* cache); // Returns the cache of an exiting thread to its allocator
+	ThreadCache* getCache(void) // Returns the calling thread's cache; creates it on first use
+		{
+		ThreadCache* cache=static_cast<ThreadCache*>(pthread_getspecific(cacheKey));
+		if(cache==0)
+			cache=createCache();
+		return cache;
+		}
+	ThreadCache* createCache(void); // Creates a cache for the calling thread
+	void releaseCache(ThreadCache* cache); // Moves all free blocks from the given cache to the central free lists and deletes the cache
+	void refillCache(ThreadCache* cache,unsigned int sizeClass); // Moves a batch of free blocks of the given size class from the central free list to the given cache
+	void drainCache(ThreadCache* cache,unsigned int sizeClass,unsigned int numBlocks); // Moves the given number of free blocks of the given size class from the given cache to the central free list
+	void* allocateLarge(size_t size); // Allocates a block larger than the largest size class
+	void deallocateLarge(void* block,size_t size); // Releases a block larger than the largest size class
+	
+	/* Constructors and destructors: */
+	public:
+	SlabAllocator(void); // Creates an empty allocator
+	private:
+	SlabAllocator(const SlabAllocator& source); // Prohibit copy constructor
+	SlabAllocator& operator=(const SlabAllocator& source); // Prohibit assignment operator
+	public:
+	~SlabAllocator(void); // Releases all memory; blocks still allocated become invalid
+	
+	/* Methods: */
+	void* allocate(size_t size) // Allocates a block of at least the given size, aligned to 16 bytes
+		{
+		if(size>maxClassSize)
+			return allocateLarge(size);
+		
+		/* Take a block from the calling thread's cache: */
+		unsigned int sizeClass=getSizeClass(size);
+		ThreadCache* cache=getCache();
+		if(cache->heads[sizeClass]==0)
+			refillCache(cache,sizeClass);
+		FreeBlock* result=cache->heads[sizeClass];
+		cache->heads[sizeClass]=result->succ;
+		--cache->numFree[sizeClass];
+		++cache->numAllocated[sizeClass];
+		return result;
+		}
+	void deallocate(void* block,size_t size) // Releases a block previously allocated with the same size from any thread
+		{
+		if(block==0)
+			return;
+		if(size>maxClassSize)
+			{
+			deallocateLarge(block,size);
+			return;
+			}
+		
+		/* Put the block into the calling thread's cache: */
+		unsigned int sizeClass=getSizeClass(size);
+		ThreadCache* cache=getCache();
+		FreeBlock* freeBlock=static_cast<FreeBlock*>(block);
+		freeBlock->succ=cache->heads[sizeClass];
+		cache->heads[sizeClass]=freeBlock;
+		++cache->numFree[sizeClass];
+		--cache->numAllocated[sizeClass];
+		
+		/* Return half of the cache's blocks to the central free list if the cache grows too large: */
+		unsigned int batchSize=getBatchSize(sizeClass);
+		if(cache->numFree[sizeClass]>batchSize*2U)
+			drainCache(cache,sizeClass,batchSize);
+		}
+	Statistics getStatistics(void); // Returns the allocator's current memory use
+	};
+
+}
+
+#endif
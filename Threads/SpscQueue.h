@@ -0,0 +1,215 @@
+/***********************************************************************
+SpscQueue - Lock-free limited-size queue to send data from a single
+producer to a single consumer. Producer and consumer only block, without
+taking locks, while the queue is full or empty, respectively.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef THREADS_SPSCQUEUE_INCLUDED
+#define THREADS_SPSCQUEUE_INCLUDED
+
+#include <stddef.h>
+#include <Threads/Config.h>
+#if !THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+#include <Threads/Spinlock.h>
+#endif
+#include <Threads/EventCount.h>
+
+namespace Threads {
+
+template <class ValueParam>
+class SpscQueue
+	{
+	/* Embedded classes: */
+	public:
+	typedef ValueParam Value; // Type of communicated data
+	
+	private:
+	static const size_t cacheLineSize=64; // Assumed size of a CPU cache line in bytes
+	static const unsigned int numSpins=100; // Number of times to retry an operation on a full or empty queue before blocking
+	
+	struct Position // Structure for a queue position owned by one side of the queue, padded to occupy its own cache line
+		{
+		/* Elements: */
+		public:
+		volatile size_t index; // Free-running index of the owning side's next slot
+		size_t otherIndex; // Most recently seen index of the other side, to avoid touching its cache line on every operation
+		char padding[cacheLineSize-2*sizeof(size_t)]; // Padding to the end of the cache line
+		};
+	
+	/* Elements: */
+	Value* slots; // Array of queue slots
+	size_t numSlots; // Number of queue slots; power of two
+	size_t slotMask; // Bit mask to convert free-running indices to slot indices
+	char padding[cacheLineSize]; // Padding to separate the producer's position from the read-only elements above
+	Position tail; // Producer's position; other index is consumer's position
+	Position head; // Consumer's position; other index is producer's position
+	#if !THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+	Spinlock positionMutex; // Busy-wait (if available) mutual exclusion semaphore protecting the positions in lieu of memory barriers
+	#endif
+	EventCount notEmptyEvent; // Event signaled when the queue becomes non-empty
+	EventCount notFullEvent; // Event signaled when the queue becomes non-full
+	
+	/* Constructors and destructors: */
+	public:
+	SpscQueue(size_t maxQueueLength) // Creates a queue that can hold at least the given number of elements
+		:numSlots(1)
+		{
+		/* Round the queue size up to the next power of two: */
+		while(numSlots<maxQueueLength)
+			numSlots<<=1;
+		slotMask=numSlots-1;
+		slots=new Value[numSlots];
+		tail.index=0;
+		tail.otherIndex=0;
+		head.index=0;
+		head.otherIndex=0;
+		}
+	private:
+	SpscQueue(const SpscQueue& source); // Prohibit copy constructor
+	SpscQueue& operator=(const SpscQueue& source); // Prohibit assignment operator
+	public:
+	~SpscQueue(void) // Destroys the queue and its contents
+		{
+		delete[] slots;
+		}
+	
+	/* Methods: */
+	bool tryPush(const Value& value) // Pushes the given value into the queue if it is not full; returns false if the queue was full; must only be called by the producer
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		
+		/* Check if the queue is full, using the most recently seen consumer position first: */
+		size_t index=tail.index;
+		if(index-tail.otherIndex==numSlots)
+			{
+			tail.otherIndex=head.index;
+			__sync_synchronize();
+			if(index-tail.otherIndex==numSlots)
+				return false;
+			}
+		
+		/* Insert the new element and publish it to the consumer: */
+		slots[index&slotMask]=value;
+		__sync_synchronize();
+		tail.index=index+1;
+		
+		#else
+		
+		{
+		/* Insert the new element unless the queue is full: */
+		Spinlock::Lock positionLock(positionMutex);
+		if(tail.index-head.index==numSlots)
+			return false;
+		slots[tail.index&slotMask]=value;
+		++tail.index;
+		}
+		
+		#endif
+		
+		/* Wake up the consumer if it is blocked on an empty queue: */
+		notEmptyEvent.notifyAll();
+		
+		return true;
+		}
+	void push(const Value& value) // Pushes the given value into the queue; blocks if queue is full; must only be called by the producer
+		{
+		/* Retry for a short while before blocking: */
+		bool pushed=tryPush(value);
+		for(unsigned int spin=0;!pushed&&spin<numSpins;++spin)
+			pushed=tryPush(value);
+		while(!pushed)
+			{
+			/* Block until the consumer removes an element: */
+			int key=notFullEvent.prepareWait();
+			pushed=tryPush(value);
+			if(pushed)
+				notFullEvent.cancelWait(key);
+			else
+				{
+				notFullEvent.wait(key);
+				pushed=tryPush(value);
+				}
+			}
+		}
+	bool tryPop(Value& value) // Removes the first value from the queue and stores it in the given variable if the queue is not empty; returns false if the queue was empty; must only be called by the consumer
+		{
+		#if THREADS_CONFIG_HAVE_BUILTIN_ATOMICS
+		
+		/* Check if the queue is empty, using the most recently seen producer position first: */
+		size_t index=head.index;
+		if(index==head.otherIndex)
+			{
+			head.otherIndex=tail.index;
+			__sync_synchronize();
+			if(index==head.otherIndex)
+				return false;
+			}
+		
+		/* Retrieve the first element and release its slot to the producer: */
+		value=slots[index&slotMask];
+		__sync_synchronize();
+		head.index=index+1;
+		
+		#else
+		
+		{
+		/* Retrieve the first element unless the queue is empty: */
+		Spinlock::Lock positionLock(positionMutex);
+		if(head.index==tail.index)
+			return false;
+		value=slots[head.index&slotMask];
+		++head.index;
+		}
+		
+		#endif
+		
+		/* Wake up the producer if it is blocked on a full queue: */
+		notFullEvent.notifyAll();
+		
+		return true;
+		}
+	Value pop(void) // Returns and removes the first value from the queue; blocks if queue is empty; must only be called by the consumer
+		{
+		Value result;
+		/* Retry for a short while before blocking: */
+		bool popped=tryPop(result);
+		for(unsigned int spin=0;!popped&&spin<numSpins;++spin)
+			popped=tryPop(result);
+		while(!popped)
+			{
+			/* Block until the producer inserts an element: */
+			int key=notEmptyEvent.prepareWait();
+			popped=tryPop(result);
+			if(popped)
+				notEmptyEvent.cancelWait(key);
+			else
+				{
+				notEmptyEvent.wait(key);
+				popped=tryPop(result);
+				}
+			}
+		
+		return result;
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,233 @@
+/***********************************************************************
+TaskScheduler - Class to execute tasks in a pool of worker threads that
+balance their load by stealing tasks from each other's queues.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Threads/TaskScheduler.h>
+
+#include <unistd.h>
+#include <Threads/Profiler.h>
+
+namespace Threads {
+
+/*****************************************
+Methods of class TaskScheduler::TaskGroup:
+*****************************************/
+
+void TaskScheduler::TaskGroup::spawn(TaskScheduler::Task* task)
+	{
+	/* Add the task to the group: */
+	task->group=this;
+	{
+	Mutex::Lock groupLock(groupMutex);
+	++numPendingTasks;
+	}
+	
+	/* Execute the task immediately if the scheduler has no worker threads: */
+	if(scheduler.numWorkers==0)
+		scheduler.executeTask(task);
+	else
+		scheduler.pushTask(task);
+	}
+
+void TaskScheduler::TaskGroup::wait(void)
+	{
+	unsigned int dequeIndex=scheduler.getDequeIndex();
+	while(true)
+		{
+		{
+		Mutex::Lock groupLock(groupMutex);
+		if(numPendingTasks==0)
+			break;
+		}
+		
+		/* Help executing queued tasks while the group's tasks are pending: */
+		Task* task=scheduler.popTask(dequeIndex);
+		if(task!=0)
+			scheduler.executeTask(task);
+		else
+			{
+			/* Block until the group's last pending task completes: */
+			Mutex::Lock groupLock(groupMutex);
+			while(numPendingTasks!=0)
+				groupCond.wait(groupMutex);
+			break;
+			}
+		}
+	}
+
+/******************************
+Methods of class TaskScheduler:
+******************************/
+
+unsigned int TaskScheduler::getDequeIndex(void) const
+	{
+	/* Check if the calling thread is one of the worker threads: */
+	Thread* thread=Thread::getThreadObject();
+	if(thread>=workers&&thread<workers+numWorkers)
+		return thread-workers;
+	else
+		return numWorkers;
+	}
+
+void TaskScheduler::pushTask(TaskScheduler::Task* task)
+	{
+	/* Append the task to the calling thread's queue: */
+	TaskDeque& deque=deques[getDequeIndex()];
+	{
+	Spinlock::Lock dequeLock(deque.mutex);
+	deque.tasks.push_back(task);
+	}
+	numQueuedTasks.preAdd(1U);
+	
+	/* Wake up an idle worker thread: */
+	if(numIdleWorkers.get()!=0U)
+		{
+		Mutex::Lock idleLock(idleMutex);
+		idleCond.signal();
+		}
+	}
+
+TaskScheduler::Task* TaskScheduler::popTask(unsigned int dequeIndex)
+	{
+	Task* result=0;
+	
+	/* Take the most recently queued task from the given queue: */
+	{
+	TaskDeque& deque=deques[dequeIndex];
+	Spinlock::Lock dequeLock(deque.mutex);
+	if(!deque.tasks.empty())
+		{
+		result=deque.tasks.back();
+		deque.tasks.pop_back();
+		}
+	}
+	
+	/* Steal the least recently queued task from one of the other queues: */
+	for(unsigned int i=1;result==0&&i<=numWorkers;++i)
+		{
+		TaskDeque& deque=deques[(dequeIndex+i)%(numWorkers+1)];
+		Spinlock::Lock dequeLock(deque.mutex);
+		if(!deque.tasks.empty())
+			{
+			result=deque.tasks.front();
+			deque.tasks.pop_front();
+			}
+		}
+	
+	if(result!=0)
+		numQueuedTasks.preSub(1U);
+	
+	return result;
+	}
+
+void TaskScheduler::executeTask(TaskScheduler::Task* task)
+	{
+	/* Execute and delete the task: */
+	TaskGroup* group=task->group;
+	{
+	THREADS_PROFILE_ZONE("Threads::TaskScheduler::executeTask");
+	task->execute();
+	}
+	delete task;
+	
+	/* Notify the task's group: */
+	Mutex::Lock groupLock(group->groupMutex);
+	if(--group->numPendingTasks==0)
+		group->groupCond.broadcast();
+	}
+
+size_t TaskScheduler::calcGrainSize(size_t rangeSize,size_t grainSize) const
+	{
+	/* Split the range into a few sub-ranges per thread to balance the load if no size was given: */
+	if(grainSize==0)
+		grainSize=rangeSize/(size_t(numWorkers+1)*4);
+	if(grainSize<1)
+		grainSize=1;
+	
+	return grainSize;
+	}
+
+void* TaskScheduler::workerThreadMethod(unsigned int workerIndex)
+	{
+	Profiler::setThreadName("Task scheduler worker thread");
+	
+	while(true)
+		{
+		/* Execute the next available task: */
+		Task* task=popTask(workerIndex);
+		if(task!=0)
+			{
+			executeTask(task);
+			continue;
+			}
+		
+		/* Wait for more tasks: */
+		Mutex::Lock idleLock(idleMutex);
+		if(shutdown)
+			break;
+		numIdleWorkers.preAdd(1U);
+		if(numQueuedTasks.get()==0U)
+			idleCond.wait(idleMutex);
+		numIdleWorkers.preSub(1U);
+		}
+	
+	return 0;
+	}
+
+TaskScheduler::TaskScheduler(unsigned int sNumWorkers)
+	:numWorkers(sNumWorkers),
+	 deques(new TaskDeque[numWorkers+1]),
+	 numQueuedTasks(0U),
+	 numIdleWorkers(0U),shutdown(false),
+	 workers(0)
+	{
+	/* Start the worker threads: */
+	if(numWorkers>0)
+		{
+		workers=new Thread[numWorkers];
+		for(unsigned int i=0;i<numWorkers;++i)
+			workers[i].start(this,&TaskScheduler::workerThreadMethod,i);
+		}
+	}
+
+TaskScheduler::~TaskScheduler(void)
+	{
+	/* Shut down the worker threads: */
+	{
+	Mutex::Lock idleLock(idleMutex);
+	shutdown=true;
+	idleCond.broadcast();
+	}
+	for(unsigned int i=0;i<numWorkers;++i)
+		workers[i].join();
+	delete[] workers;
+	
+	/* Delete the task queues: */
+	delete[] deques;
+	}
+
+unsigned int TaskScheduler::getNumProcessors(void)
+	{
+	long numProcessors=sysconf(_SC_NPROCESSORS_ONLN);
+	return numProcessors>0?(unsigned int)(numProcessors):1U;
+	}
+
+}
@@ -0,0 +1,227 @@
+/***********************************************************************
+TaskScheduler - Class to execute tasks in a pool of worker threads that
+balance their load by stealing tasks from each other's queues.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef THREADS_TASKSCHEDULER_INCLUDED
+#define THREADS_TASKSCHEDULER_INCLUDED
+
+#include <stddef.h>
+#include <deque>
+#include <vector>
+#include <Threads/Spinlock.h>
+#include <Threads/Atomic.h>
+#include <Threads/Mutex.h>
+#include <Threads/Cond.h>
+#include <Threads/Thread.h>
+
+namespace Threads {
+
+class TaskScheduler
+	{
+	/* Embedded classes: */
+	public:
+	class TaskGroup;
+	
+	class Task // Abstract base class for tasks; tasks must not throw exceptions from their execute methods
+		{
+		friend class TaskScheduler;
+		friend class TaskGroup;
+		
+		/* Elements: */
+		private:
+		TaskGroup* group; // Task group to which the task was submitted
+		
+		/* Constructors and destructors: */
+		public:
+		Task(void)
+			:group(0)
+			{
+			}
+		virtual ~Task(void)
+			{
+			}
+		
+		/* Methods: */
+		virtual void execute(void) =0; // Executes the task
+		};
+	
+	class TaskGroup // Class to submit tasks to a scheduler and wait for their completion
+		{
+		friend class TaskScheduler;
+		
+		/* Elements: */
+		private:
+		TaskScheduler& scheduler; // Scheduler executing the group's tasks
+		Mutex groupMutex; // Mutex serializing access to the number of pending tasks
+		Cond groupCond; // Condition variable to signal completion of all pending tasks
+		unsigned int numPendingTasks; // Number of submitted tasks that have not completed yet
+		
+		/* Constructors and destructors: */
+		public:
+		TaskGroup(TaskScheduler& sScheduler) // Creates an empty task group for the given scheduler
+			:scheduler(sScheduler),
+			 numPendingTasks(0)
+			{
+			}
+		private:
+		TaskGroup(const TaskGroup& source); // Prohibit copy constructor
+		TaskGroup& operator=(const TaskGroup& source); // Prohibit assignment operator
+		public:
+		~TaskGroup(void) // Waits for all pending tasks to complete
+			{
+			wait();
+			}
+		
+		/* Methods: */
+		void spawn(Task* task); // Submits the given task for execution; scheduler deletes the task after it has been executed
+		void wait(void); // Blocks until all submitted tasks have completed; executes queued tasks in the meantime
+		};
+	
+	private:
+	struct TaskDeque // Structure for double-ended task queues owned by individual threads
+		{
+		/* Elements: */
+		public:
+		Spinlock mutex; // Lock serializing access to the queue
+		std::deque<Task*> tasks; // Queued tasks; owner pushes and pops at the back, thieves steal from the front
+		char padding[64]; // Padding to keep adjacent queues' locks out of the same CPU cache line
+		};
+	
+	template <class BodyParam>
+	class RangeTask:public Task // Class for tasks processing a sub-range of a parallel loop
+		{
+		/* Elements: */
+		private:
+		const BodyParam& body; // Loop body
+		size_t begin,end; // Processed sub-range
+		
+		/* Constructors and destructors: */
+		public:
+		RangeTask(const BodyParam& sBody,size_t sBegin,size_t sEnd)
+			:body(sBody),begin(sBegin),end(sEnd)
+			{
+			}
+		
+		/* Methods from Task: */
+		virtual void execute(void)
+			{
+			body(begin,end);
+			}
+		};
+	
+	template <class ValueParam,class BodyParam>
+	class ReduceTask:public Task // Class for tasks calculating the partial result of a parallel reduction over a sub-range
+		{
+		/* Elements: */
+		private:
+		const BodyParam& body; // Reduction body
+		size_t begin,end; // Processed sub-range
+		ValueParam& result; // Storage for the partial result
+		
+		/* Constructors and destructors: */
+		public:
+		ReduceTask(const BodyParam& sBody,size_t sBegin,size_t sEnd,ValueParam& sResult)
+			:body(sBody),begin(sBegin),end(sEnd),result(sResult)
+			{
+			}
+		
+		/* Methods from Task: */
+		virtual void execute(void)
+			{
+			result=body(begin,end);
+			}
+		};
+	
+	/* Elements: */
+	unsigned int numWorkers; // Number of worker threads
+	TaskDeque* deques; // Array of task queues for the worker threads, followed by a shared queue for tasks submitted by other threads
+	Atomic<unsigned int> numQueuedTasks; // Total number of tasks in all queues
+	Mutex idleMutex; // Mutex serializing idle worker threads
+	Cond idleCond; // Condition variable to wake up idle worker threads
+	Atomic<unsigned int> numIdleWorkers; // Number of worker threads that are waiting for tasks
+	bool shutdown; // Flag to shut down the worker threads
+	Thread* workers; // Array of worker threads
+	
+	/* Private methods: */
+	unsigned int getDequeIndex(void) const; // Returns the index of the task queue owned by the calling thread
+	void pushTask(Task* task); // Queues the given task in the calling thread's task queue
+	Task* popTask(unsigned int dequeIndex); // Returns the most recently queued task from the given task queue, or the least recently queued task from another queue; returns 0 if all queues are empty
+	void executeTask(Task* task); // Executes and deletes the given task and notifies its task group
+	size_t calcGrainSize(size_t rangeSize,size_t grainSize) const; // Returns the sub-range size for a parallel loop of the given range size
+	void* workerThreadMethod(unsigned int workerIndex); // Method run by the worker threads
+	
+	/* Constructors and destructors: */
+	public:
+	TaskScheduler(unsigned int sNumWorkers); // Creates a scheduler with the given number of worker threads; executes tasks in the submitting thread if zero
+	private:
+	TaskScheduler(const TaskScheduler& source); // Prohibit copy constructor
+	TaskScheduler& operator=(const TaskScheduler& source); // Prohibit assignment operator
+	public:
+	~TaskScheduler(void); // Shuts down the worker threads; all task groups must have completed
+	
+	/* Methods: */
+	static unsigned int getNumProcessors(void); // Returns the number of online processors in the host
+	unsigned int getNumWorkers(void) const // Returns the number of worker threads
+		{
+		return numWorkers;
+		}
+	template <class BodyParam>
+	void parallelFor(size_t begin,size_t end,const BodyParam& body,size_t grainSize =0) // Calls body(subBegin,subEnd) for disjoint sub-ranges of at most the given size, or a size based on the number of worker threads if zero, covering [begin,end); returns when all calls have completed
+		{
+		if(begin>=end)
+			return;
+		grainSize=calcGrainSize(end-begin,grainSize);
+		
+		/* Submit a task for each sub-range: */
+		TaskGroup group(*this);
+		for(size_t subBegin=begin;subBegin<end;subBegin+=grainSize)
+			group.spawn(new RangeTask<BodyParam>(body,subBegin,end-subBegin>grainSize?subBegin+grainSize:end));
+		group.wait();
+		}
+	template <class ValueParam,class BodyParam,class CombinerParam>
+	ValueParam parallelReduce(size_t begin,size_t end,const ValueParam& identity,const BodyParam& body,const CombinerParam& combiner,size_t grainSize =0) // Calls body(subBegin,subEnd) to calculate partial results for disjoint sub-ranges covering [begin,end), and returns the partial results combined in sub-range order via combiner(left,right), starting from the given identity value
+		{
+		ValueParam result=identity;
+		if(begin>=end)
+			return result;
+		grainSize=calcGrainSize(end-begin,grainSize);
+		
+		/* Submit a task for each sub-range: */
+		std::vector<ValueParam> partialResults((end-begin+grainSize-1)/grainSize,identity);
+		{
+		TaskGroup group(*this);
+		typename std::vector<ValueParam>::iterator prIt=partialResults.begin();
+		for(size_t subBegin=begin;subBegin<end;subBegin+=grainSize,++prIt)
+			group.spawn(new ReduceTask<ValueParam,BodyParam>(body,subBegin,end-subBegin>grainSize?subBegin+grainSize:end,*prIt));
+		group.wait();
+		}
+		
+		/* Combine the partial results: */
+		for(typename std::vector<ValueParam>::iterator prIt=partialResults.begin();prIt!=partialResults.end();++prIt)
+			result=combiner(result,*prIt);
+		
+		return result;
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,195 @@
+/***********************************************************************
+QueueBenchmark - Program to measure the throughput of the mutex-based
+and lock-free queue classes under contention from increasing numbers of
+producer and consumer threads.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Portable Threading Library (Threads).
+
+The Portable Threading Library is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Portable Threading Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Threading Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Threads/Thread.h>
+#include <Threads/Queue.h>
+#include <Threads/LimitedQueue.h>
+#include <Threads/SpscQueue.h>
+#include <Threads/MpmcQueue.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+template <class QueueParam>
+inline QueueParam* createQueue(size_t maxQueueLength) // Creates a bounded queue
+	{
+	return new QueueParam(maxQueueLength);
+	}
+
+template <>
+inline Threads::Queue<unsigned int>* createQueue<Threads::Queue<unsigned int> >(size_t maxQueueLength) // Creates an unbounded queue
+	{
+	return new Threads::Queue<unsigned int>;
+	}
+
+/*********************************************************************
+Producer and consumer threads; producers push a sequence of values, and
+consumers pop a fixed number of values and sum them up:
+*********************************************************************/
+
+template <class QueueParam>
+struct Producer
+	{
+	/* Elements: */
+	public:
+	QueueParam* queue; // The queue to push into
+	unsigned int first,numValues; // First value and number of values to push
+	
+	/* Methods: */
+	void* threadMethod(void)
+		{
+		for(unsigned int i=0;i<numValues;++i)
+			queue->push(first+i);
+		return 0;
+		}
+	};
+
+template <class QueueParam>
+struct Consumer
+	{
+	/* Elements: */
+	public:
+	QueueParam* queue; // The queue to pop from
+	unsigned int numValues; // Number of values to pop
+	unsigned long long sum; // Sum of all popped values
+	
+	/* Methods: */
+	void* threadMethod(void)
+		{
+		sum=0;
+		for(unsigned int i=0;i<numValues;++i)
+			sum+=queue->pop();
+		return 0;
+		}
+	};
+
+template <class QueueParam>
+void runBenchmark(const char* name,unsigned int numThreads,unsigned int numValues,size_t maxQueueLength)
+	{
+	/* Split the values evenly between equal numbers of producers and consumers: */
+	unsigned int numPairs=numThreads/2;
+	unsigned int valuesPerThread=numValues/numPairs;
+	QueueParam* queue=createQueue<QueueParam>(maxQueueLength);
+	Producer<QueueParam>* producers=new Producer<QueueParam>[numPairs];
+	Consumer<QueueParam>* consumers=new Consumer<QueueParam>[numPairs];
+	Threads::Thread* threads=new Threads::Thread[numPairs*2];
+	
+	/* Start all threads and wait for them to finish: */
+	Misc::Time startTime=Misc::Time::now();
+	for(unsigned int i=0;i<numPairs;++i)
+		{
+		consumers[i].queue=queue;
+		consumers[i].numValues=valuesPerThread;
+		threads[numPairs+i].start(&consumers[i],&Consumer<QueueParam>::threadMethod);
+		producers[i].queue=queue;
+		producers[i].first=i*valuesPerThread;
+		producers[i].numValues=valuesPerThread;
+		threads[i].start(&producers[i],&Producer<QueueParam>::threadMethod);
+		}
+	for(unsigned int i=0;i<numPairs*2;++i)
+		threads[i].join();
+	double elapsed=toSeconds(Misc::Time::now()-startTime);
+	
+	/* Check that every value was received exactly once: */
+	unsigned long long totalValues=(unsigned long long)(numPairs)*(unsigned long long)(valuesPerThread);
+	unsigned long long sum=0;
+	for(unsigned int i=0;i<numPairs;++i)
+		sum+=consumers[i].sum;
+	bool ok=sum==totalValues*(totalValues-1)/2;
+	
+	/* Print the results: */
+	std::cout<<std::setw(14)<<std::left<<name<<std::right;
+	std::cout<<std::setw(8)<<numThreads;
+	std::cout<<std::setw(10)<<std::fixed<<std::setprecision(3)<<elapsed;
+	std::cout<<std::setw(12)<<std::setprecision(2)<<double(totalValues)/(elapsed*1.0e6);
+	std::cout<<std::setw(8)<<(ok?"ok":"FAILED")<<std::endl;
+	
+	delete[] threads;
+	delete[] consumers;
+	delete[] producers;
+	delete queue;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	unsigned int numValues=2000000;
+	size_t maxQueueLength=1024;
+	unsigned int maxNumThreads=32;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"values")==0&&i+1<argc)
+				{
+				numValues=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"queueSize")==0&&i+1<argc)
+				{
+				maxQueueLength=size_t(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"maxThreads")==0&&i+1<argc)
+				{
+				maxNumThreads=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-values <number of values>] [-queueSize <bounded queue length>] [-maxThreads <maximum number of threads>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	std::cout<<numValues<<" values, bounded queue length "<<maxQueueLength<<std::endl;
+	std::cout<<"Queue          Threads  Time (s)  Mvalues/s  Result"<<std::endl;
+	
+	/* The single-producer/single-consumer case, supported by all queues: */
+	runBenchmark<Threads::Queue<unsigned int> >("Queue",2,numValues,maxQueueLength);
+	runBenchmark<Threads::LimitedQueue<unsigned int> >("LimitedQueue",2,numValues,maxQueueLength);
+	runBenchmark<Threads::SpscQueue<unsigned int> >("SpscQueue",2,numValues,maxQueueLength);
+	runBenchmark<Threads::MpmcQueue<unsigned int> >("MpmcQueue",2,numValues,maxQueueLength);
+	
+	/* Increasing numbers of producers and consumers, supported by the multi-threaded queues: */
+	for(unsigned int numThreads=4;numThreads<=maxNumThreads;numThreads*=2)
+		{
+		runBenchmark<Threads::Queue<unsigned int> >("Queue",numThreads,numValues,maxQueueLength);
+		runBenchmark<Threads::LimitedQueue<unsigned int> >("LimitedQueue",numThreads,numValues,maxQueueLength);
+		runBenchmark<Threads::MpmcQueue<unsigned int> >("MpmcQueue",numThreads,numValues,maxQueueLength);
+		}
+	
+	return 0;
+	}
@@ -140,13 +140,13 @@ void VRDevice::addVirtualDevice(Vrui::VRDeviceDescriptor* newDevice)
 	deviceManager->addVirtualDevice(newDevice);
 	}
 
-void VRDevice::setTrackerState(int deviceTrackerIndex,const Vrui::VRDeviceState::TrackerState& state)
+void VRDevice::setTrackerState(int deviceTrackerIndex,const Vrui::VRDeviceState::TrackerState& state,Vrui::VRDeviceState::TimeStamp timeStamp)
 	{
 	Vrui::VRDeviceState::TrackerState calibratedState=state;
 	if(calibrator!=0)
 		calibrator->calibrate(deviceTrackerIndex,calibratedState);
 	calibratedState.positionOrientation*=trackerPostTransformations[deviceTrackerIndex];
-	deviceManager->setTrackerState(trackerIndices[deviceTrackerIndex],calibratedState);
+	deviceManager->setTrackerState(trackerIndices[deviceTrackerIndex],calibratedState,timeStamp);
 	}
 
 void VRDevice::setButtonState(int deviceButtonIndex,Vrui::VRDeviceState::ButtonState newState)
@@ -77,7 +77,11 @@ class VRDevice
 	void setNumValuators(int newNumValuators,const Misc::ConfigurationFile& configFile,const std::string* valuatorNames =0); // Sets number of valuators
 	void addVirtualDevice(Vrui::VRDeviceDescriptor* newDevice); // Passes the given new virtual input device to the device manager
 	void calcVelocities(int deviceTrackerIndex,Vrui::VRDeviceState::TrackerState& newState); // Calculates tracker velocities based on elapsed time since last measurement
-	void setTrackerState(int deviceTrackerIndex,const Vrui::VRDeviceState::TrackerState& state); // Sets (and calibrates) a tracker (device index given)
+	void setTrackerState(int deviceTrackerIndex,const Vrui::VRDeviceState::TrackerState& state,Vrui::VRDeviceState::TimeStamp timeStamp); // Sets (and calibrates) a tracker sampled at the given time (device index given)
+	void setTrackerState(int deviceTrackerIndex,const Vrui::VRDeviceState::TrackerState& state) // Sets (and calibrates) a tracker sampled at the current time (device index given)
+		{
+		setTrackerState(deviceTrackerIndex,state,Vrui::VRDeviceState::getTimeStamp());
+		}
 	void setButtonState(int deviceButtonIndex,Vrui::VRDeviceState::ButtonState newState); // Sets a button state (device index given)
 	void setValuatorState(int deviceValuatorIndex,Vrui::VRDeviceState::ValuatorState newState); // Sets a valuator state (device index given)
 	void updateState(void); // Notifies the device manager that this device's state can be sent to clients
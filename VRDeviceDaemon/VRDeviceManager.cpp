@@ -228,10 +228,11 @@ VRCalibrator* VRDeviceManager::createCalibrator(const std::string& calibratorTyp
 	return calibratorFactory->createObject(configFile);
 	}
 
-void VRDeviceManager::setTrackerState(int trackerIndex,const Vrui::VRDeviceState::TrackerState& newTrackerState)
+void VRDeviceManager::setTrackerState(int trackerIndex,const Vrui::VRDeviceState::TrackerState& newTrackerState,Vrui::VRDeviceState::TimeStamp newTimeStamp)
 	{
 	Threads::Mutex::Lock stateLock(stateMutex);
 	state.setTrackerState(trackerIndex,newTrackerState);
+	state.setTrackerTimeStamp(trackerIndex,newTimeStamp);
 	
 	if(trackerUpdateNotificationEnabled)
 		{
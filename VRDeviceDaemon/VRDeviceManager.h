@@ -115,7 +115,11 @@ class VRDeviceManager
 	void addVirtualDevice(Vrui::VRDeviceDescriptor* newVirtualDevice); // Adds a virtual device; is adopted by device manager
 	
 	/* Methods to communicate with device driver modules during operation: */
-	void setTrackerState(int trackerIndex,const Vrui::VRDeviceState::TrackerState& newTrackerState); // Updates state of single tracker
+	void setTrackerState(int trackerIndex,const Vrui::VRDeviceState::TrackerState& newTrackerState,Vrui::VRDeviceState::TimeStamp newTimeStamp); // Updates state of single tracker sampled at the given time
+	void setTrackerState(int trackerIndex,const Vrui::VRDeviceState::TrackerState& newTrackerState) // Updates state of single tracker sampled at the current time
+		{
+		setTrackerState(trackerIndex,newTrackerState,Vrui::VRDeviceState::getTimeStamp());
+		}
 	void setButtonState(int buttonIndex,Vrui::VRDeviceState::ButtonState newButtonState); // Updates state of single button
 	void setValuatorState(int valuatorIndex,Vrui::VRDeviceState::ValuatorState newValuatorState); // Updates state of single valuator
 	void updateState(void); // Tells device manager that the current state should be considered "complete"
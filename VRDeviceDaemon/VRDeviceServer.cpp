@@ -23,18 +23,219 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <VRDeviceDaemon/VRDeviceServer.h>
 
+#include <errno.h>
+#include <string.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 #include <stdexcept>
+#include <Misc/ThrowStdErr.h>
 #include <Misc/StandardValueCoders.h>
+#include <Misc/StandardMarshallers.h>
 #include <Misc/ConfigurationFile.h>
+#include <IO/FixedMemoryFile.h>
+#include <IO/VariableMemoryFile.h>
 #include <Vrui/Internal/VRDeviceDescriptor.h>
+#include <Vrui/Internal/VRDeviceSharedState.h>
 
 #include <VRDeviceDaemon/VRDeviceManager.h>
 
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+struct MessageSink // Helper structure to copy the contents of a variable memory file into a message buffer
+	{
+	/* Elements: */
+	public:
+	std::vector<unsigned char>& data; // Buffer receiving the message
+	
+	/* Constructors and destructors: */
+	MessageSink(std::vector<unsigned char>& sData)
+		:data(sData)
+		{
+		}
+	
+	/* Methods: */
+	void writeRaw(const void* buffer,size_t bufferSize)
+		{
+		const unsigned char* bPtr=static_cast<const unsigned char*>(buffer);
+		data.insert(data.end(),bPtr,bPtr+bufferSize);
+		}
+	};
+
+size_t getMessageSize(const unsigned char* data,size_t dataSize) // Returns the size of the complete client message at the beginning of the given buffer, or 0 if the message is not complete yet
+	{
+	typedef Vrui::VRDevicePipe::MessageIdType MessageIdType;
+	typedef Vrui::VRDeviceSubscription::IndexType IndexType;
+	
+	if(dataSize<sizeof(MessageIdType))
+		return 0;
+	MessageIdType message;
+	memcpy(&message,data,sizeof(MessageIdType));
+	size_t messageSize=sizeof(MessageIdType);
+	switch(message)
+		{
+		case Vrui::VRDevicePipe::CONNECT_REQUEST:
+			messageSize+=sizeof(unsigned int);
+			break;
+		
+		case Vrui::VRDevicePipe::ATTACHSHAREDMEMORY_REQUEST:
+			messageSize+=sizeof(unsigned char);
+			break;
+		
+		case Vrui::VRDevicePipe::SUBSCRIBE_REQUEST:
+			/* Parse the subscription's three index lists: */
+			for(int list=0;list<3;++list)
+				{
+				if(dataSize<messageSize+sizeof(IndexType))
+					return 0;
+				IndexType numIndices;
+				memcpy(&numIndices,data+messageSize,sizeof(IndexType));
+				messageSize+=sizeof(IndexType)*(1+size_t(numIndices));
+				}
+			messageSize+=sizeof(unsigned int);
+			break;
+		
+		default:
+			/* All other messages do not have payloads: */
+			;
+		}
+	
+	return dataSize>=messageSize?messageSize:0;
+	}
+
+}
+
 /*******************************
 Methods of class VRDeviceServer:
 *******************************/
 
+void VRDeviceServer::writeState(VRDeviceServer::ClientData* clientData,bool forceKeyframe,IO::File& sink)
+	{
+	if(clientData->subscribed)
+		{
+		/* Check whether to send a full keyframe to resynchronize the client: */
+		bool keyframe=forceKeyframe||clientData->keyframePending||clientData->numDeltasSinceKeyframe>=clientData->subscription.keyframeInterval;
+		
+		/* Write delta packet reply message: */
+		sink.write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::PACKET_DELTA_REPLY);
+		
+		/* Write all subscribed state components that changed since the last packet: */
+		clientData->subscription.writeDelta(deviceManager->getState(),clientData->sentState,keyframe,clientData->protocolVersion>=5U,sink);
+		if(keyframe)
+			{
+			clientData->numDeltasSinceKeyframe=0;
+			clientData->keyframePending=false;
+			}
+		else
+			++clientData->numDeltasSinceKeyframe;
+		}
+	else
+		{
+		/* Write packet reply message: */
+		sink.write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::PACKET_REPLY);
+		
+		/* Write server state: */
+		deviceManager->getState().write(sink);
+		if(clientData->protocolVersion>=5U)
+			deviceManager->getState().writeTrackerTimeStamps(sink);
+		}
+	}
+
+void VRDeviceServer::sendState(VRDeviceServer::ClientData* clientData,bool forceKeyframe)
+	{
+	writeState(clientData,forceKeyframe,clientData->pipe);
+	clientData->pipe.flush();
+	}
+
+void VRDeviceServer::handleSubscribeRequest(VRDeviceServer::ClientData* clientData,IO::File& source)
+	{
+	/* Read the client's subscription: */
+	Vrui::VRDeviceSubscription newSubscription;
+	newSubscription.read(source);
+	
+	/* Lock the server state and the client's pipe to update the client's subscription: */
+	deviceManager->lockState();
+	{
+	Threads::Mutex::Lock pipeLock(clientData->pipeMutex);
+	
+	/* Remove invalid indices from the new subscription: */
+	const Vrui::VRDeviceState& state=deviceManager->getState();
+	newSubscription.clip(state);
+	
+	/* An empty subscription reverts the client to receiving full state packets: */
+	clientData->subscribed=!newSubscription.empty();
+	clientData->subscription=newSubscription;
+	if(clientData->subscribed)
+		clientData->sentState.setLayout(state.getNumTrackers(),state.getNumButtons(),state.getNumValuators());
+	clientData->numDeltasSinceKeyframe=0;
+	}
+	deviceManager->unlockState();
+	
+	#ifdef VERBOSE
+	if(clientData->subscribed)
+		printf("VRDeviceServer: Client subscribed to %u trackers, %u buttons, %u valuators\n",(unsigned int)(clientData->subscription.trackerIndices.size()),(unsigned int)(clientData->subscription.buttonIndices.size()),(unsigned int)(clientData->subscription.valuatorIndices.size()));
+	else
+		printf("VRDeviceServer: Client cancelled its subscription\n");
+	fflush(stdout);
+	#endif
+	}
+
+void VRDeviceServer::writeSharedMemoryReply(IO::File& sink)
+	{
+	sink.write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::SHAREDMEMORY_REPLY);
+	if(sharedState!=0)
+		{
+		/* Send the segment's name and key: */
+		Misc::Marshaller<std::string>::write(sharedState->getName(),sink);
+		sink.write<Vrui::VRDeviceSharedState::Key>(sharedState->getKey());
+		}
+	else
+		{
+		/* Send an empty name to indicate that there is no shared memory segment: */
+		Misc::Marshaller<std::string>::write(std::string(),sink);
+		sink.write<Vrui::VRDeviceSharedState::Key>(0);
+		}
+	}
+
+void VRDeviceServer::activateClient(VRDeviceServer::ClientData* clientData)
+	{
+	/* Start VR devices if this is the first active client: */
+	if(numActiveClients==0)
+		deviceManager->start();
+	
+	/* Activate the client: */
+	clientData->active=true;
+	++numActiveClients;
+	}
+
+void VRDeviceServer::deactivateClient(VRDeviceServer::ClientData* clientData)
+	{
+	if(clientData->streaming)
+		{
+		/* Leave streaming mode: */
+		clientData->streaming=false;
+		}
+	if(clientData->active)
+		{
+		/* Deactivate client: */
+		clientData->active=false;
+		--numActiveClients;
+		
+		/* Stop VR devices if this was the last active client: */
+		if(numActiveClients==0)
+			deviceManager->stop();
+		}
+	}
+
 void* VRDeviceServer::listenThreadMethod(void)
 	{
 	/* Enable immediate cancellation of this thread: */
@@ -73,15 +274,10 @@ void* VRDeviceServer::clientCommunicationThreadMethod(VRDeviceServer::ClientData
 	
 	Vrui::VRDevicePipe& pipe=clientData->pipe;
 	
-	enum State
-		{
-		START,CONNECTED,ACTIVE,STREAMING,FINISH
-		};
-	
 	try
 		{
 		/* Execute client communication protocol state machine: */
-		State state=START; // Current client state
+		ClientState state=START; // Current client state
 		while(state!=FINISH)
 			{
 			/* Read the next message from the client: */
@@ -135,22 +331,48 @@ void* VRDeviceServer::clientCommunicationThreadMethod(VRDeviceServer::ClientData
 						{
 						case Vrui::VRDevicePipe::ACTIVATE_REQUEST:
 							{
-							/* Lock the client list: */
+							/* Lock the client list and activate the client: */
 							Threads::Mutex::Lock clientListLock(clientListMutex);
-							
-							/* Start VR devices if this is the first active client: */
-							if(numActiveClients==0)
-								deviceManager->start();
-							
-							/* Activate the client: */
-							clientData->active=true;
-							++numActiveClients;
+							activateClient(clientData);
 							}
 							
 							/* Go to active state: */
 							state=ACTIVE;
 							break;
 						
+						case Vrui::VRDevicePipe::SUBSCRIBE_REQUEST:
+							if(clientData->protocolVersion>=3U)
+								handleSubscribeRequest(clientData,pipe);
+							else
+								state=FINISH;
+							break;
+						
+						case Vrui::VRDevicePipe::SHAREDMEMORY_REQUEST:
+							if(clientData->protocolVersion>=4U)
+								{
+								/* Lock the pipe for writing: */
+								Threads::Mutex::Lock pipeLock(clientData->pipeMutex);
+								
+								/* Send the shared memory segment's name and key: */
+								writeSharedMemoryReply(pipe);
+								pipe.flush();
+								}
+							else
+								state=FINISH;
+							break;
+						
+						case Vrui::VRDevicePipe::ATTACHSHAREDMEMORY_REQUEST:
+							if(clientData->protocolVersion>=4U)
+								{
+								/* Lock the pipe to synchronize with the streaming thread: */
+								bool attach=pipe.read<unsigned char>()!=0;
+								Threads::Mutex::Lock pipeLock(clientData->pipeMutex);
+								clientData->sharedMemory=attach&&sharedState!=0;
+								}
+							else
+								state=FINISH;
+							break;
+						
 						default:
 							state=FINISH;
 						}
@@ -173,12 +395,8 @@ void* VRDeviceServer::clientCommunicationThreadMethod(VRDeviceServer::ClientData
 									clientData->streaming=true;
 									}
 								
-								/* Send packet reply message: */
-								pipe.writeMessage(Vrui::VRDevicePipe::PACKET_REPLY);
-								
-								/* Send server state: */
-								deviceManager->getState().write(pipe);
-								pipe.flush();
+								/* Send server state; subscribed clients receive a keyframe: */
+								sendState(clientData,true);
 								}
 							catch(...)
 								{
@@ -195,22 +413,48 @@ void* VRDeviceServer::clientCommunicationThreadMethod(VRDeviceServer::ClientData
 						
 						case Vrui::VRDevicePipe::DEACTIVATE_REQUEST:
 							{
-							/* Lock the client list: */
+							/* Lock the client list and deactivate the client: */
 							Threads::Mutex::Lock clientListLock(clientListMutex);
-							
-							/* Deactivate client: */
-							clientData->active=false;
-							--numActiveClients;
-							
-							/* Stop VR devices if this was the last active client: */
-							if(numActiveClients==0)
-								deviceManager->stop();
+							deactivateClient(clientData);
 							}
 							
 							/* Go to connected state: */
 							state=CONNECTED;
 							break;
 						
+						case Vrui::VRDevicePipe::SUBSCRIBE_REQUEST:
+							if(clientData->protocolVersion>=3U)
+								handleSubscribeRequest(clientData,pipe);
+							else
+								state=FINISH;
+							break;
+						
+						case Vrui::VRDevicePipe::SHAREDMEMORY_REQUEST:
+							if(clientData->protocolVersion>=4U)
+								{
+								/* Lock the pipe for writing: */
+								Threads::Mutex::Lock pipeLock(clientData->pipeMutex);
+								
+								/* Send the shared memory segment's name and key: */
+								writeSharedMemoryReply(pipe);
+								pipe.flush();
+								}
+							else
+								state=FINISH;
+							break;
+						
+						case Vrui::VRDevicePipe::ATTACHSHAREDMEMORY_REQUEST:
+							if(clientData->protocolVersion>=4U)
+								{
+								/* Lock the pipe to synchronize with the streaming thread: */
+								bool attach=pipe.read<unsigned char>()!=0;
+								Threads::Mutex::Lock pipeLock(clientData->pipeMutex);
+								clientData->sharedMemory=attach&&sharedState!=0;
+								}
+							else
+								state=FINISH;
+							break;
+						
 						default:
 							state=FINISH;
 						}
@@ -261,21 +505,7 @@ void* VRDeviceServer::clientCommunicationThreadMethod(VRDeviceServer::ClientData
 	/* Cleanly deactivate client: */
 	{
 	Threads::Mutex::Lock clientListLock(clientListMutex);
-	if(clientData->streaming)
-		{
-		/* Leave streaming mode: */
-		clientData->streaming=false;
-		}
-	if(clientData->active)
-		{
-		/* Deactivate client: */
-		clientData->active=false;
-		--numActiveClients;
-		
-		/* Stop VR devices if this was the last active client: */
-		if(numActiveClients==0)
-			deviceManager->stop();
-		}
+	deactivateClient(clientData);
 	
 	/* Remove client from list: */
 	ClientList::iterator clIt;
@@ -302,6 +532,9 @@ void* VRDeviceServer::streamingThreadMethod(void)
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
 	// Threads::Thread::setCancelType(Threads::Thread::CANCEL_ASYNCHRONOUS);
 	
+	/* Buffer to serialize state packets in event-driven mode: */
+	IO::VariableMemoryFile stateMessage;
+	
 	while(true)
 		{
 		/* Wait for the next update notification from the device manager: */
@@ -314,6 +547,32 @@ void* VRDeviceServer::streamingThreadMethod(void)
 		/* Lock the device manager's current state: */
 		deviceManager->lockState();
 		
+		/* Publish the current state to clients on the same host: */
+		if(sharedState!=0)
+			sharedState->publish(deviceManager->getState());
+		
+		if(eventDriven)
+			{
+			/* Queue the current state for all clients in streaming mode and send as much as possible without blocking: */
+			for(ClientList::iterator clIt=clientList.begin();clIt!=clientList.end();++clIt)
+				if((*clIt)->streaming&&!(*clIt)->sharedMemory)
+					{
+					stateMessage.clear();
+					writeState(*clIt,false,stateMessage);
+					enqueueMessage(*clIt,stateMessage,true,(*clIt)->subscribed);
+					if(!flushClient(*clIt))
+						{
+						/* Shut down the client's socket; the I/O thread will disconnect the client: */
+						(*clIt)->pipe.shutdown(true,true);
+						}
+					}
+			
+			/* Unlock the device manager's state: */
+			deviceManager->unlockState();
+			
+			continue;
+			}
+		
 		/* Iterate through all clients in streaming mode: */
 		std::vector<ClientList::iterator> deadClients;
 		for(ClientList::iterator clIt=clientList.begin();clIt!=clientList.end();++clIt)
@@ -321,16 +580,12 @@ void* VRDeviceServer::streamingThreadMethod(void)
 			/* Lock the client's pipe: */
 			Threads::Mutex::Lock clientPipeLock((*clIt)->pipeMutex);
 			
-			if((*clIt)->streaming)
+			if((*clIt)->streaming&&!(*clIt)->sharedMemory)
 				{
 				try
 					{
-					/* Send packet reply message: */
-					(*clIt)->pipe.writeMessage(Vrui::VRDevicePipe::PACKET_REPLY);
-					
 					/* Send server state: */
-					deviceManager->getState().write((*clIt)->pipe);
-					(*clIt)->pipe.flush();
+					sendState(*clIt,false);
 					}
 				catch(std::runtime_error err)
 					{
@@ -363,28 +618,353 @@ void* VRDeviceServer::streamingThreadMethod(void)
 			(**dcIt)->communicationThread.join();
 			
 			/* Cleanly deactivate client: */
-			if((**dcIt)->streaming)
+			deactivateClient(**dcIt);
+			delete **dcIt;
+			
+			/* Remove client from list: */
+			clientList.erase(*dcIt);
+			}
+		}
+		}
+	
+	return 0;
+	}
+
+void VRDeviceServer::enqueueMessage(VRDeviceServer::ClientData* clientData,IO::VariableMemoryFile& message,bool droppable,bool delta)
+	{
+	OutboundQueue& queue=clientData->outQueue;
+	
+	if(droppable)
+		{
+		/* Count the number of queued state packets: */
+		size_t numQueuedPackets=0;
+		for(OutboundQueue::iterator oqIt=queue.begin();oqIt!=queue.end();++oqIt)
+			if(oqIt->droppable)
+				++numQueuedPackets;
+		
+		/* Drop the oldest state packets that have not been partially sent until there is room for the new packet: */
+		OutboundQueue::iterator oqIt=queue.begin();
+		if(oqIt!=queue.end()&&clientData->outHeadSent>0)
+			++oqIt;
+		while(numQueuedPackets>=maxQueuedPackets&&oqIt!=queue.end())
+			{
+			if(oqIt->droppable)
 				{
-				/* Leave streaming mode: */
-				(**dcIt)->streaming=false;
+				/* A dropped delta packet desynchronizes the client; send a keyframe next: */
+				if(oqIt->delta)
+					clientData->keyframePending=true;
+				
+				oqIt=queue.erase(oqIt);
+				--numQueuedPackets;
+				++clientData->numDroppedPackets;
 				}
-			if((**dcIt)->active)
+			else
+				++oqIt;
+			}
+		}
+	
+	/* Append the message to the client's queue: */
+	queue.push_back(OutboundMessage());
+	OutboundMessage& newMessage=queue.back();
+	newMessage.data.reserve(message.getDataSize());
+	MessageSink sink(newMessage.data);
+	message.writeToSink(sink);
+	newMessage.droppable=droppable;
+	newMessage.delta=delta;
+	}
+
+bool VRDeviceServer::flushClient(VRDeviceServer::ClientData* clientData)
+	{
+	#ifdef __linux__
+	int fd=clientData->pipe.getFd();
+	OutboundQueue& queue=clientData->outQueue;
+	
+	/* Send queued messages until the socket's send buffer is full: */
+	while(!queue.empty())
+		{
+		OutboundMessage& head=queue.front();
+		ssize_t numSent=send(fd,&head.data[clientData->outHeadSent],head.data.size()-clientData->outHeadSent,MSG_NOSIGNAL|MSG_DONTWAIT);
+		if(numSent>=0)
+			{
+			clientData->outHeadSent+=size_t(numSent);
+			if(clientData->outHeadSent==head.data.size())
 				{
-				/* Deactivate client: */
-				(**dcIt)->active=false;
-				--numActiveClients;
-				
-				/* Stop VR devices if this was the last active client: */
-				if(numActiveClients==0)
-					deviceManager->stop();
+				queue.pop_front();
+				clientData->outHeadSent=0;
 				}
-			delete **dcIt;
+			}
+		else if(errno==EAGAIN||errno==EWOULDBLOCK)
+			break;
+		else if(errno!=EINTR)
+			return false;
+		}
+	
+	/* Only monitor the socket for writability while there is queued data: */
+	bool waitForWrite=!queue.empty();
+	if(clientData->waitingForWrite!=waitForWrite)
+		{
+		epoll_event event;
+		event.events=waitForWrite?EPOLLIN|EPOLLOUT:EPOLLIN;
+		event.data.ptr=clientData;
+		if(epoll_ctl(epollFd,EPOLL_CTL_MOD,fd,&event)<0)
+			return false;
+		clientData->waitingForWrite=waitForWrite;
+		}
+	#endif
+	
+	return true;
+	}
+
+bool VRDeviceServer::handleClientMessage(VRDeviceServer::ClientData* clientData,IO::File& message)
+	{
+	Vrui::VRDevicePipe::MessageIdType messageId=message.read<Vrui::VRDevicePipe::MessageIdType>();
+	IO::VariableMemoryFile reply;
+	
+	/* Handle the message based on the client's current state: */
+	switch(clientData->state)
+		{
+		case START:
+			if(messageId!=Vrui::VRDevicePipe::CONNECT_REQUEST)
+				return false;
 			
-			/* Remove client from list: */
-			clientList.erase(*dcIt);
+			/* Negotiate the protocol version: */
+			clientData->protocolVersion=message.read<unsigned int>();
+			if(clientData->protocolVersion>Vrui::VRDevicePipe::protocolVersionNumber)
+				clientData->protocolVersion=Vrui::VRDevicePipe::protocolVersionNumber;
+			
+			/* Send connect reply message, server layout, and the layout of all virtual devices: */
+			reply.write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::CONNECT_REPLY);
+			reply.write<unsigned int>(clientData->protocolVersion);
+			deviceManager->getState().writeLayout(reply);
+			if(clientData->protocolVersion>=2U)
+				{
+				reply.write<int>(deviceManager->getNumVirtualDevices());
+				for(int deviceIndex=0;deviceIndex<deviceManager->getNumVirtualDevices();++deviceIndex)
+					deviceManager->getVirtualDevice(deviceIndex).write(reply);
+				}
+			enqueueMessage(clientData,reply,false,false);
+			
+			clientData->state=CONNECTED;
+			break;
+		
+		case CONNECTED:
+			if(messageId==Vrui::VRDevicePipe::ACTIVATE_REQUEST)
+				{
+				activateClient(clientData);
+				clientData->state=ACTIVE;
+				}
+			else if(messageId==Vrui::VRDevicePipe::SUBSCRIBE_REQUEST&&clientData->protocolVersion>=3U)
+				handleSubscribeRequest(clientData,message);
+			else if(messageId==Vrui::VRDevicePipe::SHAREDMEMORY_REQUEST&&clientData->protocolVersion>=4U)
+				{
+				writeSharedMemoryReply(reply);
+				enqueueMessage(clientData,reply,false,false);
+				}
+			else if(messageId==Vrui::VRDevicePipe::ATTACHSHAREDMEMORY_REQUEST&&clientData->protocolVersion>=4U)
+				clientData->sharedMemory=message.read<unsigned char>()!=0&&sharedState!=0;
+			else
+				return false;
+			break;
+		
+		case ACTIVE:
+			if(messageId==Vrui::VRDevicePipe::PACKET_REQUEST||messageId==Vrui::VRDevicePipe::STARTSTREAM_REQUEST)
+				{
+				/* Send the server state; subscribed clients receive a keyframe: */
+				deviceManager->lockState();
+				writeState(clientData,true,reply);
+				if(messageId==Vrui::VRDevicePipe::STARTSTREAM_REQUEST)
+					{
+					clientData->streaming=true;
+					clientData->state=STREAMING;
+					}
+				deviceManager->unlockState();
+				enqueueMessage(clientData,reply,false,false);
+				}
+			else if(messageId==Vrui::VRDevicePipe::DEACTIVATE_REQUEST)
+				{
+				deactivateClient(clientData);
+				clientData->state=CONNECTED;
+				}
+			else if(messageId==Vrui::VRDevicePipe::SUBSCRIBE_REQUEST&&clientData->protocolVersion>=3U)
+				handleSubscribeRequest(clientData,message);
+			else if(messageId==Vrui::VRDevicePipe::SHAREDMEMORY_REQUEST&&clientData->protocolVersion>=4U)
+				{
+				writeSharedMemoryReply(reply);
+				enqueueMessage(clientData,reply,false,false);
+				}
+			else if(messageId==Vrui::VRDevicePipe::ATTACHSHAREDMEMORY_REQUEST&&clientData->protocolVersion>=4U)
+				clientData->sharedMemory=message.read<unsigned char>()!=0&&sharedState!=0;
+			else
+				return false;
+			break;
+		
+		case STREAMING:
+			if(messageId==Vrui::VRDevicePipe::STOPSTREAM_REQUEST)
+				{
+				/* Disable streaming and send stopstream reply message after all queued packets: */
+				clientData->streaming=false;
+				reply.write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::STOPSTREAM_REPLY);
+				enqueueMessage(clientData,reply,false,false);
+				clientData->state=ACTIVE;
+				}
+			else if(messageId!=Vrui::VRDevicePipe::PACKET_REQUEST)
+				return false;
+			break;
+		
+		default:
+			return false;
+		}
+	
+	return true;
+	}
+
+bool VRDeviceServer::receiveClientData(VRDeviceServer::ClientData* clientData)
+	{
+	/* Read all pending data from the client's socket: */
+	int fd=clientData->pipe.getFd();
+	std::vector<unsigned char>& inBuffer=clientData->inBuffer;
+	while(true)
+		{
+		unsigned char buffer[1024];
+		ssize_t numRead=recv(fd,buffer,sizeof(buffer),MSG_DONTWAIT);
+		if(numRead>0)
+			inBuffer.insert(inBuffer.end(),buffer,buffer+numRead);
+		else if(numRead==0)
+			{
+			/* The client closed the connection: */
+			return false;
 			}
+		else if(errno==EAGAIN||errno==EWOULDBLOCK)
+			break;
+		else if(errno!=EINTR)
+			return false;
 		}
+	
+	/* Handle all complete messages: */
+	size_t messageStart=0;
+	bool result=true;
+	while(result&&messageStart<inBuffer.size())
+		{
+		size_t messageSize=getMessageSize(&inBuffer[messageStart],inBuffer.size()-messageStart);
+		if(messageSize==0)
+			break;
+		
+		try
+			{
+			IO::FixedMemoryFile message(messageSize);
+			memcpy(message.getMemory(),&inBuffer[messageStart],messageSize);
+			result=handleClientMessage(clientData,message);
+			}
+		catch(std::runtime_error err)
+			{
+			/* Print error message to stderr and disconnect the client: */
+			fprintf(stderr,"VRDeviceServer: Terminating client connection due to exception\n  %s\n",err.what());
+			fflush(stderr);
+			result=false;
+			}
+		messageStart+=messageSize;
 		}
+	inBuffer.erase(inBuffer.begin(),inBuffer.begin()+messageStart);
+	
+	return result;
+	}
+
+void VRDeviceServer::disconnectClient(VRDeviceServer::ClientData* clientData)
+	{
+	#ifdef __linux__
+	/* Stop monitoring the client's socket: */
+	epoll_ctl(epollFd,EPOLL_CTL_DEL,clientData->pipe.getFd(),0);
+	#endif
+	
+	/* Cleanly deactivate client: */
+	deactivateClient(clientData);
+	
+	/* Remove client from list: */
+	ClientList::iterator clIt;
+	for(clIt=clientList.begin();clIt!=clientList.end()&&*clIt!=clientData;++clIt)
+		;
+	clientList.erase(clIt);
+	
+	#ifdef VERBOSE
+	printf("VRDeviceServer: Disconnected client after dropping %u state packets\n",clientData->numDroppedPackets);
+	fflush(stdout);
+	#endif
+	
+	/* Disconnect client: */
+	delete clientData;
+	}
+
+void* VRDeviceServer::reactorThreadMethod(void)
+	{
+	/* Enable immediate cancellation of this thread: */
+	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
+	
+	#ifdef __linux__
+	while(true)
+		{
+		/* Wait for events on the listening socket or any client sockets: */
+		epoll_event events[32];
+		int numEvents=epoll_wait(epollFd,events,32,-1);
+		if(numEvents<0)
+			{
+			if(errno==EINTR)
+				continue;
+			fprintf(stderr,"VRDeviceServer: Shutting down I/O thread due to error %s\n",strerror(errno));
+			fflush(stderr);
+			break;
+			}
+		
+		/* Lock client list: */
+		Threads::Mutex::Lock clientListLock(clientListMutex);
+		
+		/* Handle all events: */
+		for(int eventIndex=0;eventIndex<numEvents;++eventIndex)
+			{
+			if(events[eventIndex].data.ptr==0)
+				{
+				/* Accept the next incoming connection: */
+				try
+					{
+					ClientData* newClient=new ClientData(listenSocket);
+					#ifdef VERBOSE
+					printf("VRDeviceServer: Connecting new client from %s, port %d\n",newClient->pipe.getPeerHostName().c_str(),newClient->pipe.getPeerPortId());
+					fflush(stdout);
+					#endif
+					
+					/* Switch the client's socket to non-blocking I/O and monitor it: */
+					int fd=newClient->pipe.getFd();
+					epoll_event event;
+					event.events=EPOLLIN;
+					event.data.ptr=newClient;
+					if(fcntl(fd,F_SETFL,fcntl(fd,F_GETFL)|O_NONBLOCK)<0||epoll_ctl(epollFd,EPOLL_CTL_ADD,fd,&event)<0)
+						{
+						delete newClient;
+						Misc::throwStdErr("Unable to monitor client socket due to error %s",strerror(errno));
+						}
+					clientList.push_back(newClient);
+					}
+				catch(std::runtime_error err)
+					{
+					/* Print error message to stderr, but ignore exception otherwise: */
+					fprintf(stderr,"VRDeviceServer: Ignoring client connection due to exception\n  %s\n",err.what());
+					fflush(stderr);
+					}
+				}
+			else
+				{
+				/* Receive pending messages and send any queued data: */
+				ClientData* clientData=static_cast<ClientData*>(events[eventIndex].data.ptr);
+				bool ok=true;
+				if(events[eventIndex].events&(EPOLLIN|EPOLLHUP|EPOLLERR))
+					ok=receiveClientData(clientData);
+				if(ok)
+					ok=flushClient(clientData);
+				if(!ok)
+					disconnectClient(clientData);
+				}
+			}
+		}
+	#endif
 	
 	return 0;
 	}
@@ -392,13 +972,77 @@ void* VRDeviceServer::streamingThreadMethod(void)
 VRDeviceServer::VRDeviceServer(VRDeviceManager* sDeviceManager,const Misc::ConfigurationFile& configFile)
 	:deviceManager(sDeviceManager),
 	 listenSocket(configFile.retrieveValue<int>("./serverPort"),-1),
-	 numActiveClients(0)
+	 numActiveClients(0),
+	 eventDriven(configFile.retrieveValue<bool>("./eventDriven",false)),
+	 maxQueuedPackets(configFile.retrieveValue<unsigned int>("./maxQueuedPackets",4)),
+	 epollFd(-1),
+	 sharedState(0)
 	{
+	#ifdef __linux__
+	if(eventDriven)
+		{
+		/* Create the event queue and monitor the listening socket: */
+		epollFd=epoll_create(16);
+		if(epollFd<0)
+			Misc::throwStdErr("VRDeviceServer::VRDeviceServer: Unable to create event queue due to error %s",strerror(errno));
+		epoll_event event;
+		event.events=EPOLLIN;
+		event.data.ptr=0;
+		if(epoll_ctl(epollFd,EPOLL_CTL_ADD,listenSocket.getFd(),&event)<0)
+			{
+			close(epollFd);
+			Misc::throwStdErr("VRDeviceServer::VRDeviceServer: Unable to monitor listening socket due to error %s",strerror(errno));
+			}
+		}
+	#else
+	if(eventDriven)
+		{
+		fprintf(stderr,"VRDeviceServer: Event-driven mode not supported on this platform; using one thread per client\n");
+		fflush(stderr);
+		eventDriven=false;
+		}
+	#endif
+	if(maxQueuedPackets<1)
+		maxQueuedPackets=1;
+	
+	/* Create a shared memory segment to publish device states to clients on the same host: */
+	std::string sharedMemoryName=configFile.retrieveString("./sharedMemoryName","");
+	if(!sharedMemoryName.empty())
+		{
+		if(Vrui::VRDeviceSharedState::isSupported())
+			{
+			deviceManager->lockState();
+			try
+				{
+				sharedState=new Vrui::VRDeviceSharedState(sharedMemoryName.c_str(),deviceManager->getState());
+				}
+			catch(std::runtime_error err)
+				{
+				fprintf(stderr,"VRDeviceServer: Disabling shared memory transport due to exception\n  %s\n",err.what());
+				fflush(stderr);
+				}
+			deviceManager->unlockState();
+			}
+		else
+			{
+			fprintf(stderr,"VRDeviceServer: Shared memory transport not supported on this platform\n");
+			fflush(stderr);
+			}
+		}
+	
 	/* Enable tracker update notification: */
 	deviceManager->enableTrackerUpdateNotification(&trackerUpdateCompleteCond);
 	
-	/* Start connection initiating thread: */
-	listenThread.start(this,&VRDeviceServer::listenThreadMethod);
+	if(eventDriven)
+		{
+		/* Start the thread handling all client I/O: */
+		reactorThread.start(this,&VRDeviceServer::reactorThreadMethod);
+		}
+	else
+		{
+		/* Start connection initiating thread: */
+		listenThread.start(this,&VRDeviceServer::listenThreadMethod);
+		}
 	
 	/* Start streaming thread: */
 	streamingThread.start(this,&VRDeviceServer::streamingThreadMethod);
@@ -406,6 +1050,13 @@ VRDeviceServer::VRDeviceServer(VRDeviceManager* sDeviceManager,const Misc::Confi
 
 VRDeviceServer::~VRDeviceServer(void)
 	{
+	if(eventDriven)
+		{
+		/* Stop the client I/O thread before locking the client list: */
+		reactorThread.cancel();
+		reactorThread.join();
+		}
+	
 	/* Lock client list: */
 	{
 	Threads::Mutex::Lock clientListLock(clientListMutex);
@@ -414,17 +1065,23 @@ VRDeviceServer::~VRDeviceServer(void)
 	streamingThread.cancel();
 	streamingThread.join();
 	
-	/* Stop connection initiating thread: */
-	listenThread.cancel();
-	listenThread.join();
+	if(!eventDriven)
+		{
+		/* Stop connection initiating thread: */
+		listenThread.cancel();
+		listenThread.join();
+		}
 	
 	/* Disconnect all clients: */
 	deviceManager->lockState();
 	for(ClientList::iterator clIt=clientList.begin();clIt!=clientList.end();++clIt)
 		{
-		/* Stop client communication thread: */
-		(*clIt)->communicationThread.cancel();
-		(*clIt)->communicationThread.join();
+		if(!eventDriven)
+			{
+			/* Stop client communication thread: */
+			(*clIt)->communicationThread.cancel();
+			(*clIt)->communicationThread.join();
+			}
 		
 		/* Delete client data object (closing TCP socket): */
 		delete *clIt;
@@ -438,4 +1095,10 @@ VRDeviceServer::~VRDeviceServer(void)
 	
 	/* Disable tracker update notification: */
 	deviceManager->disableTrackerUpdateNotification();
+	
+	if(epollFd>=0)
+		close(epollFd);
+	
+	/* Remove the shared memory segment: */
+	delete sharedState;
 	}
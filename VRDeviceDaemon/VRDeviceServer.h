@@ -22,22 +22,48 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 ***********************************************************************/
 
 #include <vector>
+#include <deque>
 #include <Threads/Thread.h>
 #include <Threads/Mutex.h>
 #include <Threads/MutexCond.h>
 #include <Comm/ListeningTCPSocket.h>
+#include <Vrui/Internal/VRDeviceState.h>
 #include <Vrui/Internal/VRDevicePipe.h>
+#include <Vrui/Internal/VRDeviceSubscription.h>
 
 /* Forward declarations: */
 namespace Misc {
 class ConfigurationFile;
 }
+namespace IO {
+class File;
+class VariableMemoryFile;
+}
+namespace Vrui {
+class VRDeviceSharedState;
+}
 class VRDeviceManager;
 
 class VRDeviceServer
 	{
 	/* Embedded classes: */
 	private:
+	enum ClientState // Enumerated type for states of the client communication protocol
+		{
+		START,CONNECTED,ACTIVE,STREAMING,FINISH
+		};
+	
+	struct OutboundMessage // Structure for messages queued for sending to a client in event-driven mode
+		{
+		/* Elements: */
+		public:
+		std::vector<unsigned char> data; // Serialized message
+		bool droppable; // Flag whether the message is a streamed state packet that may be dropped if the client falls behind
+		bool delta; // Flag whether the message is a delta-encoded state packet
+		};
+	
+	typedef std::deque<OutboundMessage> OutboundQueue; // Type for queues of outbound messages
+	
 	class ClientData // Class containing state of connected client
 		{
 		/* Elements: */
@@ -48,10 +74,26 @@ class VRDeviceServer
 		unsigned int protocolVersion; // Version of the VR device daemon protocol to use with this client
 		volatile bool active; // Flag if the client is active
 		volatile bool streaming; // Flag if the client is streaming
+		bool subscribed; // Flag if the client subscribed to a subset of the server state and receives delta-encoded packets
+		Vrui::VRDeviceSubscription subscription; // Subset of server state the client subscribed to
+		Vrui::VRDeviceState sentState; // Server state as last sent to a subscribed client
+		unsigned int numDeltasSinceKeyframe; // Number of delta packets sent to a subscribed client since the last keyframe packet
+		bool keyframePending; // Flag whether the next state packet sent to a subscribed client must be a keyframe
+		bool sharedMemory; // Flag whether the client reads streamed states from the server's shared memory segment
+		
+		/* State for event-driven mode: */
+		ClientState state; // Current state of the client communication protocol
+		std::vector<unsigned char> inBuffer; // Buffer holding partially received messages
+		OutboundQueue outQueue; // Queue of messages waiting to be sent to the client
+		size_t outHeadSent; // Number of bytes of the first queued message that have already been sent
+		bool waitingForWrite; // Flag whether the client's socket is currently monitored for writability
+		unsigned int numDroppedPackets; // Number of streamed state packets dropped because the client fell behind
 		
 		/* Constructors and destructors: */
 		ClientData(Comm::ListeningTCPSocket& listenSocket) // Accepts next incoming connection on given listening socket and establishes VR device connection
-			:pipe(listenSocket),protocolVersion(0),active(false),streaming(false)
+			:pipe(listenSocket),protocolVersion(0),active(false),streaming(false),
+			 subscribed(false),numDeltasSinceKeyframe(0),keyframePending(false),sharedMemory(false),
+			 state(START),outHeadSent(0),waitingForWrite(false),numDroppedPackets(0)
 			{
 			};
 		};
@@ -68,11 +110,28 @@ class VRDeviceServer
 	int numActiveClients; // Number of clients that are currently active
 	Threads::Thread streamingThread; // Thread to stream device states to clients
 	Threads::MutexCond trackerUpdateCompleteCond; // Tracker update notification condition variable
+	bool eventDriven; // Flag whether all clients are handled by a single event-driven I/O thread instead of one thread per client
+	size_t maxQueuedPackets; // Maximum number of streamed state packets queued for a client in event-driven mode before the oldest ones are dropped
+	int epollFd; // File descriptor of the event queue multiplexing all client sockets in event-driven mode
+	Threads::Thread reactorThread; // Thread handling all client I/O in event-driven mode
+	Vrui::VRDeviceSharedState* sharedState; // Shared memory segment to publish device states to clients on the same host, or null if disabled
 	
 	/* Private methods: */
+	void writeState(ClientData* clientData,bool forceKeyframe,IO::File& sink); // Writes a state packet for the given client to the given sink; server state must be locked
+	void sendState(ClientData* clientData,bool forceKeyframe); // Sends the current server state to the given client; pipe and server state must be locked
+	void handleSubscribeRequest(ClientData* clientData,IO::File& source); // Reads a subscription request from the given source and updates the given client's subscription
+	void writeSharedMemoryReply(IO::File& sink); // Writes a reply to a shared memory request to the given sink
+	void activateClient(ClientData* clientData); // Activates the given client; client list must be locked
+	void deactivateClient(ClientData* clientData); // Deactivates the given client and stops streaming; client list must be locked
 	void* listenThreadMethod(void); // Connection initiating thread method
 	void* clientCommunicationThreadMethod(ClientData* clientData); // Client communication thread method
 	void* streamingThreadMethod(void); // Method to stream device states to all clients who are currently streaming
+	void enqueueMessage(ClientData* clientData,IO::VariableMemoryFile& message,bool droppable,bool delta); // Queues the given message for sending to the given client in event-driven mode; client list must be locked
+	bool flushClient(ClientData* clientData); // Sends as much queued data as possible to the given client without blocking; returns false if the connection failed; client list must be locked
+	bool handleClientMessage(ClientData* clientData,IO::File& message); // Handles a complete message received from the given client in event-driven mode; returns false if the client must be disconnected; client list must be locked
+	bool receiveClientData(ClientData* clientData); // Reads pending data from the given client in event-driven mode and handles all complete messages; returns false if the client must be disconnected; client list must be locked
+	void disconnectClient(ClientData* clientData); // Disconnects the given client in event-driven mode; client list must be locked
+	void* reactorThreadMethod(void); // Method handling all client I/O in event-driven mode
 	
 	/* Constructors and destructors: */
 	public:
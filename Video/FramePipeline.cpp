@@ -0,0 +1,131 @@
+/***********************************************************************
+FramePipeline - Class to capture frames from a video device in a
+background thread and hand them to a list of processing stages by
+reference, returning each frame buffer to the video device when the last
+stage releases it.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Video/FramePipeline.h>
+
+#include <stdexcept>
+#include <iostream>
+#include <Threads/Profiler.h>
+#include <Video/FrameBuffer.h>
+#include <Video/VideoDevice.h>
+
+namespace Video {
+
+/******************************
+Methods of class FramePipeline:
+******************************/
+
+void FramePipeline::releaseFrame(FramePipeline::Frame* frame)
+	{
+	/* Return the frame buffer to the video device's capture queue: */
+	try
+		{
+		device.enqueueFrame(frame->buffer);
+		}
+	catch(std::runtime_error err)
+		{
+		/* Print an error message and carry on; the device will run out of frame buffers eventually: */
+		std::cerr<<"Video::FramePipeline: Caught exception "<<err.what()<<" while returning frame "<<frame->index<<std::endl;
+		}
+	numHeldFrames.preSub(1U);
+	
+	delete frame;
+	}
+
+void* FramePipeline::captureThreadMethod(void)
+	{
+	Threads::Profiler::setThreadName("Video frame pipeline capture thread");
+	
+	while(keepCapturing)
+		{
+		/* Dequeue the next frame buffer; this blocks until the video device delivers a frame: */
+		FrameBuffer* buffer;
+		try
+			{
+			buffer=device.dequeueFrame();
+			}
+		catch(std::runtime_error err)
+			{
+			if(keepCapturing)
+				std::cerr<<"Video::FramePipeline: Caught exception "<<err.what()<<" while capturing; shutting down capture"<<std::endl;
+			break;
+			}
+		
+		/* Wrap the frame buffer into a frame and hand it to all stages: */
+		numHeldFrames.preAdd(1U);
+		{
+		THREADS_PROFILE_ZONE("Video::FramePipeline::processFrame");
+		FramePtr frame=new Frame(this,buffer,numCapturedFrames);
+		++numCapturedFrames;
+		for(std::vector<Stage*>::iterator sIt=stages.begin();sIt!=stages.end();++sIt)
+			(*sIt)->processFrame(frame);
+		
+		/* The frame is returned to the video device here unless a stage kept a reference to it */
+		}
+		}
+	
+	return 0;
+	}
+
+FramePipeline::FramePipeline(VideoDevice& sDevice)
+	:device(sDevice),
+	 keepCapturing(false),
+	 numCapturedFrames(0),numHeldFrames(0U)
+	{
+	}
+
+FramePipeline::~FramePipeline(void)
+	{
+	/* Stop capturing if still active: */
+	if(keepCapturing)
+		stop();
+	}
+
+void FramePipeline::addStage(FramePipeline::Stage* stage)
+	{
+	stages.push_back(stage);
+	}
+
+void FramePipeline::start(void)
+	{
+	/* Start streaming without a callback; the capture thread dequeues frames itself: */
+	numCapturedFrames=0;
+	device.startStreaming();
+	
+	/* Start the capture thread: */
+	keepCapturing=true;
+	captureThread.start(this,&FramePipeline::captureThreadMethod);
+	}
+
+void FramePipeline::stop(void)
+	{
+	/* Stop streaming first, which wakes up the capture thread if it is blocked waiting for the next frame: */
+	keepCapturing=false;
+	device.stopStreaming();
+	
+	/* Shut down the capture thread: */
+	captureThread.join();
+	}
+
+}
@@ -0,0 +1,143 @@
+/***********************************************************************
+FramePipeline - Class to capture frames from a video device in a
+background thread and hand them to a list of processing stages by
+reference, returning each frame buffer to the video device when the last
+stage releases it.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef VIDEO_FRAMEPIPELINE_INCLUDED
+#define VIDEO_FRAMEPIPELINE_INCLUDED
+
+#include <vector>
+#include <Misc/Time.h>
+#include <Misc/Autopointer.h>
+#include <Threads/Atomic.h>
+#include <Threads/Thread.h>
+
+/* Forward declarations: */
+namespace Video {
+class FrameBuffer;
+class VideoDevice;
+}
+
+namespace Video {
+
+class FramePipeline
+	{
+	/* Embedded classes: */
+	public:
+	class Frame // Class for reference-counted handles to frame buffers dequeued from the video device
+		{
+		friend class FramePipeline;
+		
+		/* Elements: */
+		private:
+		FramePipeline* pipeline; // Pointer to the pipeline that captured the frame
+		FrameBuffer* buffer; // Pointer to the video device's frame buffer
+		unsigned int index; // Running index of the frame since streaming started
+		Misc::Time captureTime; // Time at which the frame was dequeued from the video device
+		Threads::Atomic<unsigned int> refCount; // Number of autopointers referencing the frame
+		
+		/* Constructors and destructors: */
+		Frame(FramePipeline* sPipeline,FrameBuffer* sBuffer,unsigned int sIndex)
+			:pipeline(sPipeline),buffer(sBuffer),index(sIndex),
+			 captureTime(Misc::Time::now()),
+			 refCount(0U)
+			{
+			}
+		
+		/* Methods: */
+		public:
+		void ref(void) // Adds a reference to the frame; can be called from any thread
+			{
+			refCount.preAdd(1U);
+			}
+		void unref(void) // Removes a reference from the frame; returns the frame buffer to the video device when the reference count reaches zero
+			{
+			if(refCount.preSub(1U)==0U)
+				pipeline->releaseFrame(this);
+			}
+		const FrameBuffer* getBuffer(void) const // Returns the frame's buffer; buffer contents must not be changed
+			{
+			return buffer;
+			}
+		unsigned int getIndex(void) const // Returns the frame's running index
+			{
+			return index;
+			}
+		const Misc::Time& getCaptureTime(void) const // Returns the time at which the frame was captured
+			{
+			return captureTime;
+			}
+		};
+	
+	typedef Misc::Autopointer<Frame> FramePtr; // Type for pointers to frames that keep the frame's buffer out of the video device's capture queue
+	
+	class Stage // Abstract base class for pipeline stages
+		{
+		/* Constructors and destructors: */
+		public:
+		virtual ~Stage(void)
+			{
+			}
+		
+		/* Methods: */
+		virtual void processFrame(const FramePtr& frame) =0; // Called from the capture thread for each captured frame; stage can keep copies of the frame pointer to hold on to the frame buffer
+		};
+	
+	/* Elements: */
+	private:
+	VideoDevice& device; // Video device from which frames are captured
+	std::vector<Stage*> stages; // List of stages receiving captured frames, in order
+	Threads::Thread captureThread; // Thread dequeueing frames from the video device and handing them to the stages
+	volatile bool keepCapturing; // Flag to shut down the capture thread
+	unsigned int numCapturedFrames; // Number of frames captured since streaming started
+	Threads::Atomic<unsigned int> numHeldFrames; // Number of captured frames that have not been returned to the video device yet
+	
+	/* Private methods: */
+	void releaseFrame(Frame* frame); // Returns the given frame's buffer to the video device and destroys the frame
+	void* captureThreadMethod(void); // Method running the capture thread
+	
+	/* Constructors and destructors: */
+	public:
+	FramePipeline(VideoDevice& sDevice); // Creates a pipeline for the given video device, which must already have allocated frame buffers
+	private:
+	FramePipeline(const FramePipeline& source); // Prohibit copy constructor
+	FramePipeline& operator=(const FramePipeline& source); // Prohibit assignment operator
+	public:
+	~FramePipeline(void); // Stops capturing; all frames must have been released before the pipeline is destroyed
+	
+	/* Methods: */
+	void addStage(Stage* stage); // Appends a stage to the pipeline; stage is not owned by the pipeline; must not be called while capturing
+	void start(void); // Starts streaming video capture
+	void stop(void); // Stops streaming video capture; frames still held by stages are returned to the video device when released
+	unsigned int getNumCapturedFrames(void) const // Returns the number of frames captured since streaming started
+		{
+		return numCapturedFrames;
+		}
+	unsigned int getNumHeldFrames(void) const // Returns the number of frames currently held by stages
+		{
+		return numHeldFrames.get();
+		}
+	};
+
+}
+
+#endif
@@ -42,6 +42,10 @@ class ImageExtractor
 	virtual void extractGrey(const FrameBuffer* frame,void* image) =0; // Extracts an 8-bit greyscale image from the given video buffer
 	virtual void extractRGB(const FrameBuffer* frame,void* image) =0; // Extracts an 8-bit RGB image from the given video buffer
 	virtual void extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride) =0; // Extracts a Y'CbCr image using 4:2:0 downsampling from the given video buffer
+	virtual bool getYpCbCr420Planes(const FrameBuffer* frame,const unsigned char* planes[3],unsigned int strides[3]) const // Returns pointers to and strides of the Y', Cb, and Cr planes inside the given video buffer and true if the buffer already contains a Y'CbCr image using 4:2:0 downsampling; returns false otherwise
+		{
+		return false;
+		}
 	};
 
 }
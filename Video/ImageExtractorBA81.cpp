@@ -22,9 +22,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <Video/ImageExtractorBA81.h>
 
+#include <vector>
 #include <Misc/SizedTypes.h>
+#include <Misc/Timer.h>
+#include <Threads/TaskScheduler.h>
 #include <Video/FrameBuffer.h>
-#include <Video/Colorspaces.h>
+#include <Video/Internal/ColorspaceKernels.h>
 
 namespace Video {
 
@@ -54,49 +57,127 @@ inline unsigned char rgbToGrey(unsigned char r,unsigned char g,unsigned char b)
 	return (unsigned char)(((unsigned int)r*306U+(unsigned int)g*601U+(unsigned int)b*117U+512U)>>10);
 	}
 
+class ConvertYpCbCr420Body // Loop body to convert ranges of row pairs of a bottom-up RGB image to Y'CbCr 4:2:0
+	{
+	/* Elements: */
+	private:
+	const unsigned char* rgb; // Pointer to the RGB image
+	unsigned int width,height; // Image size
+	unsigned char* yp; // Pointer to the first row of the Y' plane
+	unsigned int ypStride;
+	unsigned char* cb; // Pointer to the first row of the Cb plane
+	unsigned int cbStride;
+	unsigned char* cr; // Pointer to the first row of the Cr plane
+	unsigned int crStride;
+	
+	/* Constructors and destructors: */
+	public:
+	ConvertYpCbCr420Body(const unsigned char* sRgb,const unsigned int sSize[2],void* sYp,unsigned int sYpStride,void* sCb,unsigned int sCbStride,void* sCr,unsigned int sCrStride)
+		:rgb(sRgb),width(sSize[0]),height(sSize[1]),
+		 yp(static_cast<unsigned char*>(sYp)),ypStride(sYpStride),
+		 cb(static_cast<unsigned char*>(sCb)),cbStride(sCbStride),
+		 cr(static_cast<unsigned char*>(sCr)),crStride(sCrStride)
+		{
+		}
+	
+	/* Methods: */
+	void operator()(size_t rowPairBegin,size_t rowPairEnd) const
+		{
+		const ColorspaceKernels& kernels=ColorspaceKernels::get();
+		const unsigned char* fRowPtr=rgb+(height-1-rowPairBegin*2)*width*3;
+		unsigned char* ypRowPtr=yp+rowPairBegin*2*ypStride;
+		unsigned char* cbRowPtr=cb+rowPairBegin*cbStride;
+		unsigned char* crRowPtr=cr+rowPairBegin*crStride;
+		for(size_t rowPair=rowPairBegin;rowPair<rowPairEnd;++rowPair)
+			{
+			/* Convert the pair of pixel rows to Y'CbCr and subsample the chroma components: */
+			kernels.rgbToYpcbcr420(fRowPtr,fRowPtr-width*3,ypRowPtr,ypRowPtr+ypStride,cbRowPtr,crRowPtr,width);
+			
+			/* Go to the next pixel row: */
+			fRowPtr-=width*3*2;
+			ypRowPtr+=ypStride*2;
+			cbRowPtr+=cbStride;
+			crRowPtr+=crStride;
+			}
+		}
+	};
+
 }
 
+/******************************************************
+Declaration of struct ImageExtractorBA81::ExtractBody:
+******************************************************/
+
+struct ImageExtractorBA81::ExtractBody
+	{
+	/* Elements: */
+	public:
+	ImageExtractorBA81* extractor; // Extractor converting the frame
+	ImageExtractorBA81::ExtractMethod method; // Method converting ranges of row pairs
+	ImageExtractorBA81::DemosaicingMode mode; // Demosaicing method
+	const FrameBuffer* frame; // Converted raw frame
+	void* image; // Image receiving the converted frame
+	
+	/* Constructors and destructors: */
+	ExtractBody(ImageExtractorBA81* sExtractor,ImageExtractorBA81::ExtractMethod sMethod,ImageExtractorBA81::DemosaicingMode sMode,const FrameBuffer* sFrame,void* sImage)
+		:extractor(sExtractor),method(sMethod),mode(sMode),frame(sFrame),image(sImage)
+		{
+		}
+	
+	/* Methods: */
+	void operator()(size_t rowPairBegin,size_t rowPairEnd) const
+		{
+		(extractor->*method)(mode,frame,image,(unsigned int)rowPairBegin,(unsigned int)rowPairEnd);
+		}
+	};
+
 /***********************************
 Methods of class ImageExtractorBA81:
 ***********************************/
 
-void ImageExtractorBA81::extractGreyFromBGGR(const FrameBuffer* frame,void* image)
+void ImageExtractorBA81::extractGreyFromBGGR(ImageExtractorBA81::DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd)
 	{
 	/* Convert the Bayer-filtered image to greyscale via RGB: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
+	void (*bayerToGrey)(const unsigned char*,ptrdiff_t,bool,bool,unsigned char*,unsigned int)=mode==EDGE_AWARE?kernels.bayerToGreyEdgeAware:kernels.bayerToGrey;
 	int stride=size[0];
+	unsigned int numRowPairs=(size[1]-1)/2;
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* cRowPtr=reinterpret_cast<unsigned char*>(image);
 	cRowPtr+=(size[1]-1)*stride;
+	const unsigned char* rPtr;
+	unsigned char* cPtr;
 	
-	/* Convert the first row: */
-	const unsigned char* rPtr=rRowPtr;
-	unsigned char* cPtr=cRowPtr;
-	
-	/* Convert the first row's first (B) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[stride+1],avg(rPtr[1],rPtr[stride]),rPtr[0]);
-	++rPtr;
-	
-	/* Convert the first row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairBegin==0)
 		{
-		/* Convert the odd (G) pixel: */
-		*(cPtr++)=rgbToGrey(rPtr[stride],rPtr[0],avg(rPtr[-1],rPtr[1]));
-		++rPtr;
+		/* Convert the first row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
 		
-		/* Convert the even (B) pixel: */
-		*(cPtr++)=rgbToGrey(avg(rPtr[stride-1],rPtr[stride+1]),avg(rPtr[-1],rPtr[1],rPtr[stride]),rPtr[0]);
+		/* Convert the first row's first (B) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[stride+1],avg(rPtr[1],rPtr[stride]),rPtr[0]);
 		++rPtr;
+		
+		/* Convert the first row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (G) pixel: */
+			*(cPtr++)=rgbToGrey(rPtr[stride],rPtr[0],avg(rPtr[-1],rPtr[1]));
+			++rPtr;
+			
+			/* Convert the even (B) pixel: */
+			*(cPtr++)=rgbToGrey(avg(rPtr[stride-1],rPtr[stride+1]),avg(rPtr[-1],rPtr[1],rPtr[stride]),rPtr[0]);
+			++rPtr;
+			}
+		
+		/* Convert the first row's last (G) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[stride],rPtr[0],rPtr[-1]);
 		}
 	
-	/* Convert the first row's last (G) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[stride],rPtr[0],rPtr[-1]);
-	++rPtr;
-	
-	rRowPtr+=stride;
-	cRowPtr-=stride;
-	
-	/* Convert the central rows: */
-	for(unsigned int y=1;y<size[1]-1;y+=2)
+	/* Convert the central rows in the given range of row pairs: */
+	rRowPtr=frame->start+(rowPairBegin*2+1)*stride;
+	cRowPtr=reinterpret_cast<unsigned char*>(image)+(size[1]-2-rowPairBegin*2)*stride;
+	for(unsigned int rowPair=rowPairBegin;rowPair<rowPairEnd;++rowPair)
 		{
 		/* Convert the odd row: */
 		rPtr=rRowPtr;
@@ -107,16 +188,9 @@ void ImageExtractorBA81::extractGreyFromBGGR(const FrameBuffer* frame,void* imag
 		++rPtr;
 		
 		/* Convert the odd row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (R) pixel: */
-			*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]),avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]));
-			++rPtr;
-			
-			/* Convert the even (G) pixel: */
-			*(cPtr++)=rgbToGrey(avg(rPtr[-1],rPtr[1]),rPtr[0],avg(rPtr[-stride],rPtr[stride]));
-			++rPtr;
-			}
+		bayerToGrey(rPtr,stride,true,true,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=size[0]-2;
 		
 		/* Convert the odd row's last (R) pixel: */
 		*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1],rPtr[stride]),avg(rPtr[-stride-1],rPtr[stride-1]));
@@ -134,16 +208,9 @@ void ImageExtractorBA81::extractGreyFromBGGR(const FrameBuffer* frame,void* imag
 		++rPtr;
 		
 		/* Convert the even row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (G) pixel: */
-			*(cPtr++)=rgbToGrey(avg(rPtr[-stride],rPtr[stride]),rPtr[0],avg(rPtr[-1],rPtr[1]));
-			++rPtr;
-			
-			/* Convert the even (B) pixel: */
-			*(cPtr++)=rgbToGrey(avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]),avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]),rPtr[0]);
-			++rPtr;
-			}
+		bayerToGrey(rPtr,stride,false,false,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=size[0]-2;
 		
 		/* Convert the even row's last (G) pixel: */
 		*(cPtr++)=rgbToGrey(avg(rPtr[-stride],rPtr[stride]),rPtr[0],rPtr[-1]);
@@ -153,67 +220,76 @@ void ImageExtractorBA81::extractGreyFromBGGR(const FrameBuffer* frame,void* imag
 		cRowPtr-=stride;
 		}
 	
-	/* Convert the last row: */
-	rPtr=rRowPtr;
-	cPtr=cRowPtr;
-	
-	/* Convert the last row's first (G) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[1],rPtr[0],rPtr[-stride]);
-	++rPtr;
-	
-	/* Convert the last row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairEnd==numRowPairs)
 		{
-		/* Convert the odd (R) pixel: */
-		*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1],rPtr[1]),avg(rPtr[-stride-1],rPtr[-stride+1]));
-		++rPtr;
+		/* Convert the last row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
 		
-		/* Convert the even (G) pixel: */
-		*(cPtr++)=rgbToGrey(avg(rPtr[-1],rPtr[1]),rPtr[0],rPtr[-stride]);
+		/* Convert the last row's first (G) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[1],rPtr[0],rPtr[-stride]);
 		++rPtr;
+		
+		/* Convert the last row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (R) pixel: */
+			*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1],rPtr[1]),avg(rPtr[-stride-1],rPtr[-stride+1]));
+			++rPtr;
+			
+			/* Convert the even (G) pixel: */
+			*(cPtr++)=rgbToGrey(avg(rPtr[-1],rPtr[1]),rPtr[0],rPtr[-stride]);
+			++rPtr;
+			}
+		
+		/* Convert the last row's last (R) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1]),rPtr[-stride-1]);
 		}
-	
-	/* Convert the last row's last (R) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1]),rPtr[-stride-1]);
 	}
 
-void ImageExtractorBA81::extractGreyFromRGGB(const FrameBuffer* frame,void* image)
+void ImageExtractorBA81::extractGreyFromRGGB(ImageExtractorBA81::DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd)
 	{
 	/* Convert the Bayer-filtered image to greyscale via RGB: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
+	void (*bayerToGrey)(const unsigned char*,ptrdiff_t,bool,bool,unsigned char*,unsigned int)=mode==EDGE_AWARE?kernels.bayerToGreyEdgeAware:kernels.bayerToGrey;
 	int stride=size[0];
+	unsigned int numRowPairs=(size[1]-1)/2;
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* cRowPtr=reinterpret_cast<unsigned char*>(image);
 	cRowPtr+=(size[1]-1)*stride;
+	const unsigned char* rPtr;
+	unsigned char* cPtr;
 	
-	/* Convert the first row: */
-	const unsigned char* rPtr=rRowPtr;
-	unsigned char* cPtr=cRowPtr;
-	
-	/* Convert the first row's first (R) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[1],rPtr[stride]),rPtr[stride+1]);
-	++rPtr;
-	
-	/* Convert the first row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairBegin==0)
 		{
-		/* Convert the odd (G) pixel: */
-		*(cPtr++)=rgbToGrey(avg(rPtr[-1],rPtr[1]),rPtr[0],rPtr[stride]);
-		++rPtr;
+		/* Convert the first row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
 		
-		/* Convert the even (R) pixel: */
-		*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-1],rPtr[1],rPtr[stride]),avg(rPtr[stride-1],rPtr[stride+1]));
+		/* Convert the first row's first (R) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[1],rPtr[stride]),rPtr[stride+1]);
 		++rPtr;
+		
+		/* Convert the first row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (G) pixel: */
+			*(cPtr++)=rgbToGrey(avg(rPtr[-1],rPtr[1]),rPtr[0],rPtr[stride]);
+			++rPtr;
+			
+			/* Convert the even (R) pixel: */
+			*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-1],rPtr[1],rPtr[stride]),avg(rPtr[stride-1],rPtr[stride+1]));
+			++rPtr;
+			}
+		
+		/* Convert the first row's last (G) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[-1],rPtr[0],rPtr[stride]);
 		}
 	
-	/* Convert the first row's last (G) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[-1],rPtr[0],rPtr[stride]);
-	++rPtr;
-	
-	rRowPtr+=stride;
-	cRowPtr-=stride;
-	
-	/* Convert the central rows: */
-	for(unsigned int y=1;y<size[1]-1;y+=2)
+	/* Convert the central rows in the given range of row pairs: */
+	rRowPtr=frame->start+(rowPairBegin*2+1)*stride;
+	cRowPtr=reinterpret_cast<unsigned char*>(image)+(size[1]-2-rowPairBegin*2)*stride;
+	for(unsigned int rowPair=rowPairBegin;rowPair<rowPairEnd;++rowPair)
 		{
 		/* Convert the odd row: */
 		rPtr=rRowPtr;
@@ -224,16 +300,9 @@ void ImageExtractorBA81::extractGreyFromRGGB(const FrameBuffer* frame,void* imag
 		++rPtr;
 		
 		/* Convert the odd row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (B) pixel: */
-			*(cPtr++)=rgbToGrey(avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]),avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]),rPtr[0]);
-			++rPtr;
-			
-			/* Convert the even (G) pixel: */
-			*(cPtr++)=rgbToGrey(avg(rPtr[-stride],rPtr[stride]),rPtr[0],avg(rPtr[-1],rPtr[1]));
-			++rPtr;
-			}
+		bayerToGrey(rPtr,stride,false,true,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=size[0]-2;
 		
 		/* Convert the odd row's last (B) pixel: */
 		*(cPtr++)=rgbToGrey(avg(rPtr[-stride-1],rPtr[stride-1]),avg(rPtr[-stride],rPtr[-1],rPtr[stride]),rPtr[0]);
@@ -251,16 +320,9 @@ void ImageExtractorBA81::extractGreyFromRGGB(const FrameBuffer* frame,void* imag
 		++rPtr;
 		
 		/* Convert the even row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (G) pixel: */
-			*(cPtr++)=rgbToGrey(avg(rPtr[-1],rPtr[1]),rPtr[0],avg(rPtr[-stride],rPtr[stride]));
-			++rPtr;
-			
-			/* Convert the even (R) pixel: */
-			*(cPtr++)=rgbToGrey(rPtr[0],avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]),avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]));
-			++rPtr;
-			}
+		bayerToGrey(rPtr,stride,true,false,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=size[0]-2;
 		
 		/* Convert the even row's last (G) pixel: */
 		*(cPtr++)=rgbToGrey(rPtr[-1],rPtr[0],avg(rPtr[-stride],rPtr[stride]));
@@ -270,75 +332,84 @@ void ImageExtractorBA81::extractGreyFromRGGB(const FrameBuffer* frame,void* imag
 		cRowPtr-=stride;
 		}
 	
-	/* Convert the last row: */
-	rPtr=rRowPtr;
-	cPtr=cRowPtr;
-	
-	/* Convert the last row's first (G) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[-stride],rPtr[0],rPtr[1]);
-	++rPtr;
-	
-	/* Convert the last row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairEnd==numRowPairs)
 		{
-		/* Convert the odd (B) pixel: */
-		*(cPtr++)=rgbToGrey(avg(rPtr[-stride-1],rPtr[-stride+1]),avg(rPtr[-stride],rPtr[-1],rPtr[1]),rPtr[0]);
-		++rPtr;
+		/* Convert the last row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
 		
-		/* Convert the even (G) pixel: */
-		*(cPtr++)=rgbToGrey(rPtr[-stride],rPtr[0],avg(rPtr[-1],rPtr[1]));
+		/* Convert the last row's first (G) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[-stride],rPtr[0],rPtr[1]);
 		++rPtr;
+		
+		/* Convert the last row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (B) pixel: */
+			*(cPtr++)=rgbToGrey(avg(rPtr[-stride-1],rPtr[-stride+1]),avg(rPtr[-stride],rPtr[-1],rPtr[1]),rPtr[0]);
+			++rPtr;
+			
+			/* Convert the even (G) pixel: */
+			*(cPtr++)=rgbToGrey(rPtr[-stride],rPtr[0],avg(rPtr[-1],rPtr[1]));
+			++rPtr;
+			}
+		
+		/* Convert the last row's last (B) pixel: */
+		*(cPtr++)=rgbToGrey(rPtr[-stride-1],avg(rPtr[-stride],rPtr[-1]),rPtr[0]);
 		}
-	
-	/* Convert the last row's last (B) pixel: */
-	*(cPtr++)=rgbToGrey(rPtr[-stride-1],avg(rPtr[-stride],rPtr[-1]),rPtr[0]);
 	}
 
-void ImageExtractorBA81::extractRGBFromBGGR(const FrameBuffer* frame,void* image)
+void ImageExtractorBA81::extractRGBFromBGGR(ImageExtractorBA81::DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd)
 	{
 	/* Convert the Bayer-filtered image to RGB: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
+	void (*bayerToRgb)(const unsigned char*,ptrdiff_t,bool,bool,unsigned char*,unsigned int)=mode==EDGE_AWARE?kernels.bayerToRgbEdgeAware:kernels.bayerToRgb;
 	int stride=size[0];
+	unsigned int numRowPairs=(size[1]-1)/2;
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* cRowPtr=reinterpret_cast<unsigned char*>(image);
 	cRowPtr+=(size[1]-1)*stride*3;
+	const unsigned char* rPtr;
+	unsigned char* cPtr;
 	
-	/* Convert the first row: */
-	const unsigned char* rPtr=rRowPtr;
-	unsigned char* cPtr=cRowPtr;
-	
-	/* Convert the first row's first (B) pixel: */
-	*(cPtr++)=rPtr[stride+1];
-	*(cPtr++)=avg(rPtr[1],rPtr[stride]);
-	*(cPtr++)=rPtr[0];
-	++rPtr;
-	
-	/* Convert the first row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairBegin==0)
 		{
-		/* Convert the odd (G) pixel: */
-		*(cPtr++)=rPtr[stride];
+		/* Convert the first row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
+		
+		/* Convert the first row's first (B) pixel: */
+		*(cPtr++)=rPtr[stride+1];
+		*(cPtr++)=avg(rPtr[1],rPtr[stride]);
 		*(cPtr++)=rPtr[0];
-		*(cPtr++)=avg(rPtr[-1],rPtr[1]);
 		++rPtr;
 		
-		/* Convert the even (B) pixel: */
-		*(cPtr++)=avg(rPtr[stride-1],rPtr[stride+1]);
-		*(cPtr++)=avg(rPtr[-1],rPtr[1],rPtr[stride]);
+		/* Convert the first row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (G) pixel: */
+			*(cPtr++)=rPtr[stride];
+			*(cPtr++)=rPtr[0];
+			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+			++rPtr;
+			
+			/* Convert the even (B) pixel: */
+			*(cPtr++)=avg(rPtr[stride-1],rPtr[stride+1]);
+			*(cPtr++)=avg(rPtr[-1],rPtr[1],rPtr[stride]);
+			*(cPtr++)=rPtr[0];
+			++rPtr;
+			}
+		
+		/* Convert the first row's last (G) pixel: */
+		*(cPtr++)=rPtr[stride];
 		*(cPtr++)=rPtr[0];
-		++rPtr;
+		*(cPtr++)=rPtr[-1];
 		}
 	
-	/* Convert the first row's last (G) pixel: */
-	*(cPtr++)=rPtr[stride];
-	*(cPtr++)=rPtr[0];
-	*(cPtr++)=rPtr[-1];
-	++rPtr;
-	
-	rRowPtr+=stride;
-	cRowPtr-=stride*3;
-	
-	/* Convert the central rows: */
-	for(unsigned int y=1;y<size[1]-1;y+=2)
+	/* Convert the central rows in the given range of row pairs: */
+	rRowPtr=frame->start+(rowPairBegin*2+1)*stride;
+	cRowPtr=reinterpret_cast<unsigned char*>(image)+(size[1]-2-rowPairBegin*2)*stride*3;
+	for(unsigned int rowPair=rowPairBegin;rowPair<rowPairEnd;++rowPair)
 		{
 		/* Convert the odd row: */
 		rPtr=rRowPtr;
@@ -351,20 +422,9 @@ void ImageExtractorBA81::extractRGBFromBGGR(const FrameBuffer* frame,void* image
 		++rPtr;
 		
 		/* Convert the odd row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (R) pixel: */
-			*(cPtr++)=rPtr[0];
-			*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]);
-			*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]);
-			++rPtr;
-			
-			/* Convert the even (G) pixel: */
-			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
-			*(cPtr++)=rPtr[0];
-			*(cPtr++)=avg(rPtr[-stride],rPtr[stride]);
-			++rPtr;
-			}
+		bayerToRgb(rPtr,stride,true,true,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=(size[0]-2)*3;
 		
 		/* Convert the odd row's last (R) pixel: */
 		*(cPtr++)=rPtr[0];
@@ -386,20 +446,9 @@ void ImageExtractorBA81::extractRGBFromBGGR(const FrameBuffer* frame,void* image
 		++rPtr;
 		
 		/* Convert the even row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (G) pixel: */
-			*(cPtr++)=avg(rPtr[-stride],rPtr[stride]);
-			*(cPtr++)=rPtr[0];
-			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
-			++rPtr;
-			
-			/* Convert the even (B) pixel: */
-			*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]);
-			*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]);
-			*(cPtr++)=rPtr[0];
-			++rPtr;
-			}
+		bayerToRgb(rPtr,stride,false,false,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=(size[0]-2)*3;
 		
 		/* Convert the even row's last (G) pixel: */
 		*(cPtr++)=avg(rPtr[-stride],rPtr[stride]);
@@ -411,83 +460,92 @@ void ImageExtractorBA81::extractRGBFromBGGR(const FrameBuffer* frame,void* image
 		cRowPtr-=stride*3;
 		}
 	
-	/* Convert the last row: */
-	rPtr=rRowPtr;
-	cPtr=cRowPtr;
-	
-	/* Convert the last row's first (G) pixel: */
-	*(cPtr++)=rPtr[1];
-	*(cPtr++)=rPtr[0];
-	*(cPtr++)=rPtr[-stride];
-	++rPtr;
-	
-	/* Convert the last row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairEnd==numRowPairs)
 		{
-		/* Convert the odd (R) pixel: */
-		*(cPtr++)=rPtr[0];
-		*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1]);
-		*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1]);
-		++rPtr;
+		/* Convert the last row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
 		
-		/* Convert the even (G) pixel: */
-		*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+		/* Convert the last row's first (G) pixel: */
+		*(cPtr++)=rPtr[1];
 		*(cPtr++)=rPtr[0];
 		*(cPtr++)=rPtr[-stride];
 		++rPtr;
+		
+		/* Convert the last row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (R) pixel: */
+			*(cPtr++)=rPtr[0];
+			*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1]);
+			*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1]);
+			++rPtr;
+			
+			/* Convert the even (G) pixel: */
+			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+			*(cPtr++)=rPtr[0];
+			*(cPtr++)=rPtr[-stride];
+			++rPtr;
+			}
+		
+		/* Convert the last row's last (R) pixel: */
+		*(cPtr++)=rPtr[0];
+		*(cPtr++)=avg(rPtr[-stride],rPtr[-1]);
+		*(cPtr++)=rPtr[-stride-1];
 		}
-	
-	/* Convert the last row's last (R) pixel: */
-	*(cPtr++)=rPtr[0];
-	*(cPtr++)=avg(rPtr[-stride],rPtr[-1]);
-	*(cPtr++)=rPtr[-stride-1];
 	}
 
-void ImageExtractorBA81::extractRGBFromRGGB(const FrameBuffer* frame,void* image)
+void ImageExtractorBA81::extractRGBFromRGGB(ImageExtractorBA81::DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd)
 	{
 	/* Convert the Bayer-filtered image to RGB: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
+	void (*bayerToRgb)(const unsigned char*,ptrdiff_t,bool,bool,unsigned char*,unsigned int)=mode==EDGE_AWARE?kernels.bayerToRgbEdgeAware:kernels.bayerToRgb;
 	int stride=size[0];
+	unsigned int numRowPairs=(size[1]-1)/2;
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* cRowPtr=reinterpret_cast<unsigned char*>(image);
 	cRowPtr+=(size[1]-1)*stride*3;
+	const unsigned char* rPtr;
+	unsigned char* cPtr;
 	
-	/* Convert the first row: */
-	const unsigned char* rPtr=rRowPtr;
-	unsigned char* cPtr=cRowPtr;
-	
-	/* Convert the first row's first (R) pixel: */
-	*(cPtr++)=rPtr[0];
-	*(cPtr++)=avg(rPtr[1],rPtr[stride]);
-	*(cPtr++)=rPtr[stride+1];
-	++rPtr;
-	
-	/* Convert the first row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairBegin==0)
 		{
-		/* Convert the odd (G) pixel: */
-		*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+		/* Convert the first row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
+		
+		/* Convert the first row's first (R) pixel: */
 		*(cPtr++)=rPtr[0];
-		*(cPtr++)=rPtr[stride];
+		*(cPtr++)=avg(rPtr[1],rPtr[stride]);
+		*(cPtr++)=rPtr[stride+1];
 		++rPtr;
 		
-		/* Convert the even (R) pixel: */
+		/* Convert the first row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (G) pixel: */
+			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+			*(cPtr++)=rPtr[0];
+			*(cPtr++)=rPtr[stride];
+			++rPtr;
+			
+			/* Convert the even (R) pixel: */
+			*(cPtr++)=rPtr[0];
+			*(cPtr++)=avg(rPtr[-1],rPtr[1],rPtr[stride]);
+			*(cPtr++)=avg(rPtr[stride-1],rPtr[stride+1]);
+			++rPtr;
+			}
+		
+		/* Convert the first row's last (G) pixel: */
+		*(cPtr++)=rPtr[-1];
 		*(cPtr++)=rPtr[0];
-		*(cPtr++)=avg(rPtr[-1],rPtr[1],rPtr[stride]);
-		*(cPtr++)=avg(rPtr[stride-1],rPtr[stride+1]);
-		++rPtr;
+		*(cPtr++)=rPtr[stride];
 		}
 	
-	/* Convert the first row's last (G) pixel: */
-	*(cPtr++)=rPtr[-1];
-	*(cPtr++)=rPtr[0];
-	*(cPtr++)=rPtr[stride];
-	++rPtr;
-	
-	rRowPtr+=stride;
-	cRowPtr-=stride*3;
-	
-	/* Convert the central rows: */
-	for(unsigned int y=1;y<size[1]-1;y+=2)
+	/* Convert the central rows in the given range of row pairs: */
+	rRowPtr=frame->start+(rowPairBegin*2+1)*stride;
+	cRowPtr=reinterpret_cast<unsigned char*>(image)+(size[1]-2-rowPairBegin*2)*stride*3;
+	for(unsigned int rowPair=rowPairBegin;rowPair<rowPairEnd;++rowPair)
 		{
 		/* Convert the odd row: */
 		rPtr=rRowPtr;
@@ -500,20 +558,9 @@ void ImageExtractorBA81::extractRGBFromRGGB(const FrameBuffer* frame,void* image
 		++rPtr;
 		
 		/* Convert the odd row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (B) pixel: */
-			*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]);
-			*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]);
-			*(cPtr++)=rPtr[0];
-			++rPtr;
-			
-			/* Convert the even (G) pixel: */
-			*(cPtr++)=avg(rPtr[-stride],rPtr[stride]);
-			*(cPtr++)=rPtr[0];
-			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
-			++rPtr;
-			}
+		bayerToRgb(rPtr,stride,false,true,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=(size[0]-2)*3;
 		
 		/* Convert the odd row's last (B) pixel: */
 		*(cPtr++)=avg(rPtr[-stride-1],rPtr[stride-1]);
@@ -535,20 +582,9 @@ void ImageExtractorBA81::extractRGBFromRGGB(const FrameBuffer* frame,void* image
 		++rPtr;
 		
 		/* Convert the even row's central pixels: */
-		for(unsigned x=1;x<size[0]-1;x+=2)
-			{
-			/* Convert the odd (G) pixel: */
-			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
-			*(cPtr++)=rPtr[0];
-			*(cPtr++)=avg(rPtr[-stride],rPtr[stride]);
-			++rPtr;
-			
-			/* Convert the even (R) pixel: */
-			*(cPtr++)=rPtr[0];
-			*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1],rPtr[stride]);
-			*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1],rPtr[stride-1],rPtr[stride+1]);
-			++rPtr;
-			}
+		bayerToRgb(rPtr,stride,true,false,cPtr,size[0]-2);
+		rPtr+=size[0]-2;
+		cPtr+=(size[0]-2)*3;
 		
 		/* Convert the even row's last (G) pixel: */
 		*(cPtr++)=rPtr[-1];
@@ -560,56 +596,66 @@ void ImageExtractorBA81::extractRGBFromRGGB(const FrameBuffer* frame,void* image
 		cRowPtr-=stride*3;
 		}
 	
-	/* Convert the last row: */
-	rPtr=rRowPtr;
-	cPtr=cRowPtr;
-	
-	/* Convert the last row's first (G) pixel: */
-	*(cPtr++)=rPtr[-stride];
-	*(cPtr++)=rPtr[0];
-	*(cPtr++)=rPtr[1];
-	++rPtr;
-	
-	/* Convert the last row's central pixels: */
-	for(unsigned int x=1;x<size[0]-1;x+=2)
+	if(rowPairEnd==numRowPairs)
 		{
-		/* Convert the odd (B) pixel: */
-		*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1]);
-		*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1]);
-		*(cPtr++)=rPtr[0];
-		++rPtr;
+		/* Convert the last row: */
+		rPtr=rRowPtr;
+		cPtr=cRowPtr;
 		
-		/* Convert the even (G) pixel: */
+		/* Convert the last row's first (G) pixel: */
 		*(cPtr++)=rPtr[-stride];
 		*(cPtr++)=rPtr[0];
-		*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+		*(cPtr++)=rPtr[1];
 		++rPtr;
+		
+		/* Convert the last row's central pixels: */
+		for(unsigned int x=1;x<size[0]-1;x+=2)
+			{
+			/* Convert the odd (B) pixel: */
+			*(cPtr++)=avg(rPtr[-stride-1],rPtr[-stride+1]);
+			*(cPtr++)=avg(rPtr[-stride],rPtr[-1],rPtr[1]);
+			*(cPtr++)=rPtr[0];
+			++rPtr;
+			
+			/* Convert the even (G) pixel: */
+			*(cPtr++)=rPtr[-stride];
+			*(cPtr++)=rPtr[0];
+			*(cPtr++)=avg(rPtr[-1],rPtr[1]);
+			++rPtr;
+			}
+		
+		/* Convert the last row's last (B) pixel: */
+		*(cPtr++)=rPtr[-stride-1];
+		*(cPtr++)=avg(rPtr[-stride],rPtr[-1]);
+		*(cPtr++)=rPtr[0];
 		}
-	
-	/* Convert the last row's last (B) pixel: */
-	*(cPtr++)=rPtr[-stride-1];
-	*(cPtr++)=avg(rPtr[-stride],rPtr[-1]);
-	*(cPtr++)=rPtr[0];
 	}
 
-ImageExtractorBA81::ImageExtractorBA81(const unsigned int sSize[2],BayerPattern sBayerPattern)
-	:bayerPattern(sBayerPattern)
+void ImageExtractorBA81::extract(ImageExtractorBA81::ExtractMethod method,ImageExtractorBA81::DemosaicingMode mode,const FrameBuffer* frame,void* image)
 	{
-	/* Copy the frame size: */
-	for(int i=0;i<2;++i)
-		size[i]=sSize[i];
+	unsigned int numRowPairs=(size[1]-1)/2;
+	if(taskScheduler!=0)
+		{
+		/* Convert bands of row pairs in parallel: */
+		taskScheduler->parallelFor(0,numRowPairs,ExtractBody(this,method,mode,frame,image));
+		}
+	else
+		{
+		/* Convert all row pairs in the calling thread: */
+		(this->*method)(mode,frame,image,0,numRowPairs);
+		}
 	}
 
-void ImageExtractorBA81::extractGrey(const FrameBuffer* frame,void* image)
+void ImageExtractorBA81::extractRGB(ImageExtractorBA81::DemosaicingMode mode,const FrameBuffer* frame,void* image)
 	{
 	switch(bayerPattern)
 		{
 		case BAYER_RGGB:
-			extractGreyFromRGGB(frame,image);
+			extract(&ImageExtractorBA81::extractRGBFromRGGB,mode,frame,image);
 			break;
 		
 		case BAYER_BGGR:
-			extractGreyFromBGGR(frame,image);
+			extract(&ImageExtractorBA81::extractRGBFromBGGR,mode,frame,image);
 			break;
 		
 		default:
@@ -617,85 +663,117 @@ void ImageExtractorBA81::extractGrey(const FrameBuffer* frame,void* image)
 		}
 	}
 
-void ImageExtractorBA81::extractRGB(const FrameBuffer* frame,void* image)
+ImageExtractorBA81::ImageExtractorBA81(const unsigned int sSize[2],BayerPattern sBayerPattern)
+	:bayerPattern(sBayerPattern),
+	 taskScheduler(0),
+	 demosaicingMode(BILINEAR),
+	 lastExtractionTime(0.0)
 	{
+	/* Copy the frame size: */
+	for(int i=0;i<2;++i)
+		size[i]=sSize[i];
+	
+	/* Invalidate the demosaicing cost estimates: */
+	for(int i=0;i<NUM_DEMOSAICINGMODES;++i)
+		demosaicingCosts[i]=-1.0;
+	}
+
+void ImageExtractorBA81::extractGrey(const FrameBuffer* frame,void* image)
+	{
+	Misc::Timer timer;
 	switch(bayerPattern)
 		{
 		case BAYER_RGGB:
-			extractRGBFromRGGB(frame,image);
+			extract(&ImageExtractorBA81::extractGreyFromRGGB,demosaicingMode,frame,image);
 			break;
 		
 		case BAYER_BGGR:
-			extractRGBFromBGGR(frame,image);
+			extract(&ImageExtractorBA81::extractGreyFromBGGR,demosaicingMode,frame,image);
 			break;
 		
 		default:
 			;
 		}
+	timer.elapse();
+	lastExtractionTime=timer.getTime();
+	}
+
+void ImageExtractorBA81::extractRGB(const FrameBuffer* frame,void* image)
+	{
+	Misc::Timer timer;
+	extractRGB(demosaicingMode,frame,image);
+	timer.elapse();
+	lastExtractionTime=timer.getTime();
 	}
 
 void ImageExtractorBA81::extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride)
 	{
+	Misc::Timer timer;
+	
 	/* Convert the raw image into a temporary RGB image (not very efficient): */
 	unsigned char* tempImage=new unsigned char[size[0]*size[1]*3];
-	switch(bayerPattern)
-		{
-		case BAYER_RGGB:
-			extractRGBFromRGGB(frame,tempImage);
-			break;
-		
-		case BAYER_BGGR:
-			extractRGBFromBGGR(frame,tempImage);
-			break;
-		
-		default:
-			;
-		}
+	extractRGB(demosaicingMode,frame,tempImage);
 	
 	/* Process temporary pixels in 2x2 blocks: */
-	const unsigned char* fRowPtr=tempImage+(size[1]-1)*size[0]*3;
-	unsigned char* ypRowPtr=static_cast<unsigned char*>(yp);
-	unsigned char* cbRowPtr=static_cast<unsigned char*>(cb);
-	unsigned char* crRowPtr=static_cast<unsigned char*>(cr);
-	for(unsigned int y=0;y<size[1];y+=2)
+	ConvertYpCbCr420Body body(tempImage,size,yp,ypStride,cb,cbStride,cr,crStride);
+	if(taskScheduler!=0)
+		taskScheduler->parallelFor(0,size[1]/2,body);
+	else
+		body(0,size[1]/2);
+	
+	/* Delete the temporary RGB image: */
+	delete[] tempImage;
+	
+	timer.elapse();
+	lastExtractionTime=timer.getTime();
+	}
+
+void ImageExtractorBA81::setTaskScheduler(Threads::TaskScheduler* newTaskScheduler)
+	{
+	taskScheduler=newTaskScheduler;
+	
+	/* Invalidate the demosaicing cost estimates: */
+	for(int i=0;i<NUM_DEMOSAICINGMODES;++i)
+		demosaicingCosts[i]=-1.0;
+	}
+
+void ImageExtractorBA81::setDemosaicingMode(ImageExtractorBA81::DemosaicingMode newDemosaicingMode)
+	{
+	demosaicingMode=newDemosaicingMode;
+	}
+
+double ImageExtractorBA81::getDemosaicingCost(ImageExtractorBA81::DemosaicingMode mode)
+	{
+	if(demosaicingCosts[mode]<0.0)
 		{
-		const unsigned char* fPtr=fRowPtr;
-		unsigned char* ypPtr=ypRowPtr;
-		unsigned char* cbPtr=cbRowPtr;
-		unsigned char* crPtr=crRowPtr;
-		for(unsigned int x=0;x<size[0];x+=2)
+		/* Create a synthetic raw frame: */
+		size_t frameSize=size_t(size[0])*size_t(size[1]);
+		std::vector<unsigned char> rawFrame(frameSize);
+		unsigned int seed=0x12345678U;
+		for(size_t i=0;i<frameSize;++i)
 			{
-			/* Convert the 2x2 pixel block to Y'CbCr: */
-			unsigned char ypcbcr[4][3];
-			Video::rgbToYpcbcr(fPtr,ypcbcr[0]);
-			Video::rgbToYpcbcr(fPtr+3,ypcbcr[1]);
-			Video::rgbToYpcbcr(fPtr-size[0]*3,ypcbcr[2]);
-			Video::rgbToYpcbcr(fPtr-size[0]*3+3,ypcbcr[3]);
-			
-			/* Subsample and store the Y'CbCr components: */
-			ypPtr[0]=ypcbcr[0][0];
-			ypPtr[1]=ypcbcr[1][0];
-			ypPtr[ypStride]=ypcbcr[2][0];
-			ypPtr[ypStride+1]=ypcbcr[3][0];
-			*cbPtr=(unsigned char)((int(ypcbcr[0][1])+int(ypcbcr[1][1])+int(ypcbcr[2][1])+int(ypcbcr[3][1])+2)>>2);
-			*crPtr=(unsigned char)((int(ypcbcr[0][2])+int(ypcbcr[1][2])+int(ypcbcr[2][2])+int(ypcbcr[3][2])+2)>>2);
-			
-			/* Go to the next pixel: */
-			fPtr+=3*2;
-			ypPtr+=2;
-			++cbPtr;
-			++crPtr;
+			seed=seed*1664525U+1013904223U;
+			rawFrame[i]=(unsigned char)(seed>>24);
 			}
-		
-		/* Go to the next pixel row: */
-		fRowPtr-=size[0]*3*2;
-		ypRowPtr+=ypStride*2;
-		cbRowPtr+=cbStride;
-		crRowPtr+=crStride;
+		FrameBuffer frame;
+		frame.start=&rawFrame[0];
+		frame.size=frame.used=frameSize;
+		std::vector<unsigned char> image(frameSize*3);
+		
+		/* Take the shortest of several extractions in the given mode as the estimated cost; the first extraction warms up caches and is not counted: */
+		double minTime=0.0;
+		for(int pass=0;pass<4;++pass)
+			{
+			Misc::Timer timer;
+			extractRGB(mode,&frame,&image[0]);
+			timer.elapse();
+			if(pass==1||(pass>1&&minTime>timer.getTime()))
+				minTime=timer.getTime();
+			}
+		demosaicingCosts[mode]=minTime;
 		}
 	
-	/* Delete the temporary RGB image: */
-	delete[] tempImage;
+	return demosaicingCosts[mode];
 	}
 
 }
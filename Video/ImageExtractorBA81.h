@@ -26,20 +26,43 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Video/BayerPattern.h>
 #include <Video/ImageExtractor.h>
 
+/* Forward declarations: */
+namespace Threads {
+class TaskScheduler;
+}
+
 namespace Video {
 
 class ImageExtractorBA81:public ImageExtractor
 	{
-	/* Elements: */
+	/* Embedded classes: */
+	public:
+	enum DemosaicingMode // Enumerated type for methods to interpolate missing color components
+		{
+		BILINEAR=0, // Averages the nearest samples of each color
+		EDGE_AWARE, // Interpolates green along the direction of the smaller gradient, and red and blue via their differences to green
+		NUM_DEMOSAICINGMODES
+		};
+	
 	private:
+	typedef void (ImageExtractorBA81::*ExtractMethod)(DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd); // Type for methods converting a range of row pairs with a demosaicing method
+	struct ExtractBody; // Loop body to convert ranges of row pairs from within a task scheduler
+	
+	/* Elements: */
 	unsigned int size[2]; // Frame width and height
 	BayerPattern bayerPattern; // Bayer color filter pattern used by the raw video stream
+	Threads::TaskScheduler* taskScheduler; // Task scheduler to convert bands of rows in parallel, or null to convert in the calling thread
+	DemosaicingMode demosaicingMode; // Current demosaicing method
+	double demosaicingCosts[NUM_DEMOSAICINGMODES]; // Estimated times in seconds to convert one frame with each demosaicing method, or negative if not yet estimated
+	double lastExtractionTime; // Time in seconds spent in the most recent image extraction
 	
 	/* Private methods: */
-	void extractGreyFromBGGR(const FrameBuffer* frame,void* image);
-	void extractGreyFromRGGB(const FrameBuffer* frame,void* image);
-	void extractRGBFromBGGR(const FrameBuffer* frame,void* image);
-	void extractRGBFromRGGB(const FrameBuffer* frame,void* image);
+	void extractGreyFromBGGR(DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd); // Convert the given range of row pairs between the first and last row; rows are converted with the first or last pair, respectively
+	void extractGreyFromRGGB(DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd);
+	void extractRGBFromBGGR(DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd);
+	void extractRGBFromRGGB(DemosaicingMode mode,const FrameBuffer* frame,void* image,unsigned int rowPairBegin,unsigned int rowPairEnd);
+	void extract(ExtractMethod method,DemosaicingMode mode,const FrameBuffer* frame,void* image); // Converts an entire frame with the given method and demosaicing method, in parallel if there is a task scheduler
+	void extractRGB(DemosaicingMode mode,const FrameBuffer* frame,void* image); // Converts an entire frame to RGB with the given demosaicing method
 	
 	/* Constructors and destructors: */
 	public:
@@ -50,6 +73,19 @@ class ImageExtractorBA81:public ImageExtractor
 	virtual void extractGrey(const FrameBuffer* frame,void* image);
 	virtual void extractRGB(const FrameBuffer* frame,void* image);
 	virtual void extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride);
+	
+	/* New methods: */
+	void setTaskScheduler(Threads::TaskScheduler* newTaskScheduler); // Sets the task scheduler to convert bands of rows in parallel; converts in the calling thread if null
+	DemosaicingMode getDemosaicingMode(void) const // Returns the current demosaicing method
+		{
+		return demosaicingMode;
+		}
+	void setDemosaicingMode(DemosaicingMode newDemosaicingMode); // Sets the demosaicing method for subsequent extractions
+	double getDemosaicingCost(DemosaicingMode mode); // Returns the estimated time in seconds to extract an RGB image from one frame with the given demosaicing method and the current task scheduler; does not change the current demosaicing method or the most recent extraction time
+	double getLastExtractionTime(void) const // Returns the time in seconds spent in the most recent image extraction
+		{
+		return lastExtractionTime;
+		}
 	};
 
 }
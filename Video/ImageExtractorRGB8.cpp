@@ -23,16 +23,72 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Video/ImageExtractorRGB8.h>
 
 #include <string.h>
+#include <Threads/TaskScheduler.h>
 #include <Video/FrameBuffer.h>
-#include <Video/Colorspaces.h>
+#include <Video/Internal/ColorspaceKernels.h>
 
 namespace Video {
 
+namespace {
+
+/**************
+Helper classes:
+**************/
+
+class ConvertYpCbCr420Body // Loop body to convert ranges of row pairs of a bottom-up RGB frame to Y'CbCr 4:2:0
+	{
+	/* Elements: */
+	private:
+	const unsigned char* rgb; // Pointer to the RGB frame
+	unsigned int width,height; // Frame size
+	unsigned char* yp; // Pointer to the first row of the Y' plane
+	unsigned int ypStride;
+	unsigned char* cb; // Pointer to the first row of the Cb plane
+	unsigned int cbStride;
+	unsigned char* cr; // Pointer to the first row of the Cr plane
+	unsigned int crStride;
+	
+	/* Constructors and destructors: */
+	public:
+	ConvertYpCbCr420Body(const unsigned char* sRgb,const unsigned int sSize[2],void* sYp,unsigned int sYpStride,void* sCb,unsigned int sCbStride,void* sCr,unsigned int sCrStride)
+		:rgb(sRgb),width(sSize[0]),height(sSize[1]),
+		 yp(static_cast<unsigned char*>(sYp)),ypStride(sYpStride),
+		 cb(static_cast<unsigned char*>(sCb)),cbStride(sCbStride),
+		 cr(static_cast<unsigned char*>(sCr)),crStride(sCrStride)
+		{
+		}
+	
+	/* Methods: */
+	void operator()(size_t rowPairBegin,size_t rowPairEnd) const
+		{
+		/* Process pixels in 2x2 blocks: */
+		const ColorspaceKernels& kernels=ColorspaceKernels::get();
+		const unsigned char* fRowPtr=rgb+(height-1-rowPairBegin*2)*width*3;
+		unsigned char* ypRowPtr=yp+rowPairBegin*2*ypStride;
+		unsigned char* cbRowPtr=cb+rowPairBegin*cbStride;
+		unsigned char* crRowPtr=cr+rowPairBegin*crStride;
+		for(size_t rowPair=rowPairBegin;rowPair<rowPairEnd;++rowPair)
+			{
+			/* Convert the pair of pixel rows to Y'CbCr and subsample the chroma components: */
+			kernels.rgbToYpcbcr420(fRowPtr,fRowPtr-width*3,ypRowPtr,ypRowPtr+ypStride,cbRowPtr,crRowPtr,width);
+			
+			/* Go to the next pixel row: */
+			fRowPtr-=width*3*2;
+			ypRowPtr+=ypStride*2;
+			cbRowPtr+=cbStride;
+			crRowPtr+=crStride;
+			}
+		}
+	};
+
+}
+
 /***********************************
 Methods of class ImageExtractorRGB8:
 ***********************************/
 
 ImageExtractorRGB8::ImageExtractorRGB8(const unsigned int sSize[2])
+	:taskScheduler(0)
 	{
 	/* Copy the frame size: */
 	for(int i=0;i<2;++i)
@@ -42,19 +98,12 @@ ImageExtractorRGB8::ImageExtractorRGB8(const unsigned int sSize[2])
 void ImageExtractorRGB8::extractGrey(const FrameBuffer* frame,void* image)
 	{
 	/* Convert the frame's pixels to grey: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* gRowPtr=static_cast<unsigned char*>(image);
 	gRowPtr+=(size[1]-1)*size[0];
 	for(unsigned int y=0;y<size[1];++y,rRowPtr+=size[0]*3,gRowPtr-=size[0])
-		{
-		const unsigned char* rPtr=rRowPtr;
-		unsigned char* gPtr=gRowPtr;
-		for(unsigned int x=0;x<size[0];++x,++gPtr,rPtr+=3)
-			{
-			/* Convert RGB to grey: */
-			*gPtr=(unsigned char)(((unsigned int)rPtr[0]*306U+(unsigned int)rPtr[1]*601U+(unsigned int)rPtr[2]*117U)>>10);
-			}
-		}
+		kernels.rgbToGrey(rRowPtr,gRowPtr,size[0]);
 	}
 
 void ImageExtractorRGB8::extractRGB(const FrameBuffer* frame,void* image)
@@ -65,47 +114,17 @@ void ImageExtractorRGB8::extractRGB(const FrameBuffer* frame,void* image)
 
 void ImageExtractorRGB8::extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride)
 	{
-	/* Process pixels in 2x2 blocks: */
-	const unsigned char* fRowPtr=frame->start+(size[1]-1)*size[0]*3;
-	unsigned char* ypRowPtr=static_cast<unsigned char*>(yp);
-	unsigned char* cbRowPtr=static_cast<unsigned char*>(cb);
-	unsigned char* crRowPtr=static_cast<unsigned char*>(cr);
-	for(unsigned int y=0;y<size[1];y+=2)
-		{
-		const unsigned char* fPtr=fRowPtr;
-		unsigned char* ypPtr=ypRowPtr;
-		unsigned char* cbPtr=cbRowPtr;
-		unsigned char* crPtr=crRowPtr;
-		for(unsigned int x=0;x<size[0];x+=2)
-			{
-			/* Convert the 2x2 pixel block to Y'CbCr: */
-			unsigned char ypcbcr[4][3];
-			Video::rgbToYpcbcr(fPtr,ypcbcr[0]);
-			Video::rgbToYpcbcr(fPtr+3,ypcbcr[1]);
-			Video::rgbToYpcbcr(fPtr-size[0]*3,ypcbcr[2]);
-			Video::rgbToYpcbcr(fPtr-size[0]*3+3,ypcbcr[3]);
-			
-			/* Subsample and store the Y'CbCr components: */
-			ypPtr[0]=ypcbcr[0][0];
-			ypPtr[1]=ypcbcr[1][0];
-			ypPtr[ypStride]=ypcbcr[2][0];
-			ypPtr[ypStride+1]=ypcbcr[3][0];
-			*cbPtr=(unsigned char)((int(ypcbcr[0][1])+int(ypcbcr[1][1])+int(ypcbcr[2][1])+int(ypcbcr[3][1])+2)>>2);
-			*crPtr=(unsigned char)((int(ypcbcr[0][2])+int(ypcbcr[1][2])+int(ypcbcr[2][2])+int(ypcbcr[3][2])+2)>>2);
-			
-			/* Go to the next pixel: */
-			fPtr+=3*2;
-			ypPtr+=2;
-			++cbPtr;
-			++crPtr;
-			}
-		
-		/* Go to the next pixel row: */
-		fRowPtr-=size[0]*3*2;
-		ypRowPtr+=ypStride*2;
-		cbRowPtr+=cbStride;
-		crRowPtr+=crStride;
-		}
+	/* Convert pairs of pixel rows, in parallel if there is a task scheduler: */
+	ConvertYpCbCr420Body body(frame->start,size,yp,ypStride,cb,cbStride,cr,crStride);
+	if(taskScheduler!=0)
+		taskScheduler->parallelFor(0,size[1]/2,body);
+	else
+		body(0,size[1]/2);
+	}
+
+void ImageExtractorRGB8::setTaskScheduler(Threads::TaskScheduler* newTaskScheduler)
+	{
+	taskScheduler=newTaskScheduler;
 	}
 
 }
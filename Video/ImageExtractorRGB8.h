@@ -25,6 +25,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <Video/ImageExtractor.h>
 
+/* Forward declarations: */
+namespace Threads {
+class TaskScheduler;
+}
+
 namespace Video {
 
 class ImageExtractorRGB8:public ImageExtractor
@@ -32,6 +37,7 @@ class ImageExtractorRGB8:public ImageExtractor
 	/* Elements: */
 	private:
 	unsigned int size[2]; // Frame width and height
+	Threads::TaskScheduler* taskScheduler; // Task scheduler to convert bands of rows in parallel, or null to convert in the calling thread
 	
 	/* Constructors and destructors: */
 	public:
@@ -42,6 +48,9 @@ class ImageExtractorRGB8:public ImageExtractor
 	virtual void extractGrey(const FrameBuffer* frame,void* image);
 	virtual void extractRGB(const FrameBuffer* frame,void* image);
 	virtual void extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride);
+	
+	/* New methods: */
+	void setTaskScheduler(Threads::TaskScheduler* newTaskScheduler); // Sets the task scheduler to convert bands of rows to Y'CbCr 4:2:0 in parallel; converts in the calling thread if null
 	};
 
 }
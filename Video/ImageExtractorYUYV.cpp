@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Video/ImageExtractorYUYV.h>
 
 #include <Video/FrameBuffer.h>
-#include <Video/Colorspaces.h>
+#include <Video/Internal/ColorspaceKernels.h>
 
 namespace Video {
 
@@ -41,90 +41,44 @@ ImageExtractorYUYV::ImageExtractorYUYV(const unsigned int sSize[2])
 void ImageExtractorYUYV::extractGrey(const FrameBuffer* frame,void* image)
 	{
 	/* Convert the frame's Y' channel to Y: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* gRowPtr=static_cast<unsigned char*>(image);
 	gRowPtr+=(size[1]-1)*size[0];
 	for(unsigned int y=0;y<size[1];++y,rRowPtr+=size[0]*2,gRowPtr-=size[0])
-		{
-		const unsigned char* rPtr=rRowPtr;
-		unsigned char* gPtr=gRowPtr;
-		for(unsigned int x=0;x<size[0];++x,++gPtr,rPtr+=2)
-			{
-			/* Convert from Y' to Y: */
-			if(*rPtr<=16)
-				*gPtr=0;
-			else if(*rPtr>=236)
-				*gPtr=255;
-			else
-				*gPtr=(unsigned char)(((int(rPtr[0])-16)*256)/220);
-			}
-		}
+		kernels.ypcbcr422ToY(rRowPtr,ColorspaceKernels::YUYV,gRowPtr,size[0]);
 	}
 
 void ImageExtractorYUYV::extractRGB(const FrameBuffer* frame,void* image)
 	{
 	/* Convert the frame from Y'CbCr to RGB: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
 	const unsigned char* rRowPtr=frame->start;
 	unsigned char* cRowPtr=static_cast<unsigned char*>(image);
 	cRowPtr+=(size[1]-1)*size[0]*3;
 	for(unsigned int y=0;y<size[1];++y,rRowPtr+=size[0]*2,cRowPtr-=size[0]*3)
-		{
-		const unsigned char* rPtr=rRowPtr;
-		unsigned char* cPtr=cRowPtr;
-		for(unsigned int x=0;x<size[0];x+=2,cPtr+=2*3,rPtr+=4)
-			{
-			/* Convert first pixel: */
-			unsigned char ypcbcr[3];
-			ypcbcr[0]=rPtr[0];
-			ypcbcr[1]=rPtr[1];
-			ypcbcr[2]=rPtr[3];
-			Video::ypcbcrToRgb(ypcbcr,cPtr);
-			
-			/* Convert second pixel: */
-			ypcbcr[0]=rPtr[2];
-			Video::ypcbcrToRgb(ypcbcr,cPtr+3);
-			}
-		}
+		kernels.ypcbcr422ToRgb(rRowPtr,ColorspaceKernels::YUYV,cRowPtr,size[0]);
 	}
 
 void ImageExtractorYUYV::extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride)
 	{
 	/* Process all blocks of two pixel rows: */
-	const unsigned char* framePtr=frame->start;
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
+	const unsigned char* frameRowPtr=frame->start;
 	unsigned char* ypRowPtr=static_cast<unsigned char*>(yp);
 	unsigned char* cbRowPtr=static_cast<unsigned char*>(cb);
 	unsigned char* crRowPtr=static_cast<unsigned char*>(cr);
 	for(unsigned int y=0;y<size[1];y+=2)
 		{
 		/* Process an even row by keeping its Cb values: */
-		unsigned char* ypPtr=ypRowPtr;
-		unsigned char* cbPtr=cbRowPtr;
-		for(unsigned int x=0;x<size[0];x+=2)
-			{
-			/* Get Yp and Cb from even pixel: */
-			*(ypPtr++)=*(framePtr++);
-			*(cbPtr++)=*(framePtr++);
-			
-			/* Get Yp from odd pixel: */
-			*(ypPtr++)=*(framePtr++);
-			++framePtr;
-			}
+		kernels.ypcbcr422ToYpC(frameRowPtr,ColorspaceKernels::YUYV,0,ypRowPtr,cbRowPtr,size[0]);
+		frameRowPtr+=size[0]*2;
 		ypRowPtr+=ypStride;
 		cbRowPtr+=cbStride;
 		
 		/* Process an odd row by keeping its Cr values: */
-		ypPtr=ypRowPtr;
-		unsigned char* crPtr=crRowPtr;
-		for(unsigned int x=0;x<size[0];x+=2)
-			{
-			/* Get Yp from even pixel: */
-			*(ypPtr++)=*(framePtr++);
-			++framePtr;
-			
-			/* Get Yp and Cr from odd pixel: */
-			*(ypPtr++)=*(framePtr++);
-			*(crPtr++)=*(framePtr++);
-			}
+		kernels.ypcbcr422ToYpC(frameRowPtr,ColorspaceKernels::YUYV,1,ypRowPtr,crRowPtr,size[0]);
+		frameRowPtr+=size[0]*2;
 		ypRowPtr+=ypStride;
 		crRowPtr+=crStride;
 		}
@@ -24,7 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <string.h>
 #include <Video/FrameBuffer.h>
-#include <Video/Colorspaces.h>
+#include <Video/Internal/ColorspaceKernels.h>
 
 namespace Video {
 
@@ -50,64 +50,28 @@ ImageExtractorYV12::ImageExtractorYV12(const unsigned int sSize[2],ptrdiff_t ypO
 void ImageExtractorYV12::extractGrey(const FrameBuffer* frame,void* image)
 	{
 	/* Convert the frame's Y' channel to Y: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
 	const unsigned char* rRowPtr=frame->start+planes[0].offset;
 	unsigned char* gRowPtr=static_cast<unsigned char*>(image);
 	gRowPtr+=(size[1]-1)*size[0];
 	for(unsigned int y=0;y<size[1];++y,rRowPtr+=planes[0].stride,gRowPtr-=size[0])
-		{
-		const unsigned char* rPtr=rRowPtr;
-		unsigned char* gPtr=gRowPtr;
-		for(unsigned int x=0;x<size[0];++x,++rPtr,++gPtr)
-			{
-			/* Convert from Y' to Y: */
-			if(*rPtr<=16)
-				*gPtr=0;
-			else if(*rPtr>=236)
-				*gPtr=255;
-			else
-				*gPtr=(unsigned char)(((int(rPtr[0])-16)*256)/220);
-			}
-		}
+		kernels.ypToY(rRowPtr,gRowPtr,size[0]);
 	}
 
 void ImageExtractorYV12::extractRGB(const FrameBuffer* frame,void* image)
 	{
-	/* Convert the frame from Y'CbCr 4:2:0 to RGB by processing blocks of 2x2 pixels: */
+	/* Convert the frame from Y'CbCr 4:2:0 to RGB by processing pairs of pixel rows: */
+	const ColorspaceKernels& kernels=ColorspaceKernels::get();
 	unsigned char* resultRowPtr=static_cast<unsigned char*>(image)+(size[1]-1)*size[0]*3;
 	const unsigned char* ypRowPtr=frame->start+planes[0].offset;
 	const unsigned char* cbRowPtr=frame->start+planes[1].offset;
 	const unsigned char* crRowPtr=frame->start+planes[2].offset;
 	for(unsigned int y=0;y<size[1];y+=2)
 		{
-		unsigned char* resultPtr=resultRowPtr;
-		const unsigned char* ypPtr=ypRowPtr;
-		const unsigned char* cbPtr=cbRowPtr;
-		const unsigned char* crPtr=crRowPtr;
-		for(unsigned int x=0;x<size[0];x+=2)
-			{
-			/* Convert the four pixels in the 2x2 block from Y'CbCr to RGB: */
-			unsigned char ypcbcr[3];
-			ypcbcr[0]=ypPtr[0];
-			ypcbcr[1]=*cbPtr;
-			ypcbcr[2]=*crPtr;
-			Video::ypcbcrToRgb(ypcbcr,resultPtr);
-			
-			ypcbcr[0]=ypPtr[1];
-			Video::ypcbcrToRgb(ypcbcr,resultPtr+3);
-			
-			ypcbcr[0]=ypPtr[planes[0].stride];
-			Video::ypcbcrToRgb(ypcbcr,resultPtr-size[0]*3);
-			
-			ypcbcr[0]=ypPtr[planes[0].stride+1];
-			Video::ypcbcrToRgb(ypcbcr,resultPtr-size[0]*3+3);
-			
-			/* Go to the next pixel: */
-			resultPtr+=2*3;
-			ypPtr+=2;
-			++cbPtr;
-			++crPtr;
-			}
-
+		/* Convert the two pixel rows sharing the same row of chroma values: */
+		kernels.ypcbcr420ToRgb(ypRowPtr,cbRowPtr,crRowPtr,resultRowPtr,size[0]);
+		kernels.ypcbcr420ToRgb(ypRowPtr+planes[0].stride,cbRowPtr,crRowPtr,resultRowPtr-size[0]*3,size[0]);
+		
 		/* Go to the next row: */
 		resultRowPtr-=2*size[0]*3;
 		ypRowPtr+=2*planes[0].stride;
@@ -135,7 +99,7 @@ void ImageExtractorYV12::extractYpCbCr420(const FrameBuffer* frame,void* yp,unsi
 		const unsigned char* cbcrSrcRowPtr=frame->start+planes[cbcr+1].offset;
 		unsigned char* cbcrRowPtr=static_cast<unsigned char*>(cbcr==1?cr:cb);
 		unsigned int cbcrStride=cbcr==1?crStride:cbStride;
-		for(unsigned int y=0;y<size[1];++y)
+		for(unsigned int y=0;y<size[1]/2;++y)
 			{
 			memcpy(cbcrRowPtr,cbcrSrcRowPtr,size[0]/2);
 			cbcrSrcRowPtr+=planes[cbcr+1].stride;
@@ -144,4 +108,16 @@ void ImageExtractorYV12::extractYpCbCr420(const FrameBuffer* frame,void* yp,unsi
 		}
 	}
 
+bool ImageExtractorYV12::getYpCbCr420Planes(const FrameBuffer* frame,const unsigned char* framePlanes[3],unsigned int frameStrides[3]) const
+	{
+	/* Return the planes inside the frame buffer directly: */
+	for(int i=0;i<3;++i)
+		{
+		framePlanes[i]=frame->start+planes[i].offset;
+		frameStrides[i]=(unsigned int)(planes[i].stride);
+		}
+	
+	return true;
+	}
+
 }
@@ -54,6 +54,7 @@ class ImageExtractorYV12:public ImageExtractor
 	virtual void extractGrey(const FrameBuffer* frame,void* image);
 	virtual void extractRGB(const FrameBuffer* frame,void* image);
 	virtual void extractYpCbCr420(const FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride);
+	virtual bool getYpCbCr420Planes(const FrameBuffer* frame,const unsigned char* planes[3],unsigned int strides[3]) const;
 	};
 
 }
@@ -0,0 +1,375 @@
+/***********************************************************************
+ColorspaceKernels - Structure holding pointers to functions converting
+single rows of video frame pixels between color spaces, selected at run-
+time for the instruction set of the host CPU.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Video/Internal/ColorspaceKernels.h>
+
+#include <stdlib.h>
+#include <Video/Colorspaces.h>
+
+namespace Video {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+inline unsigned char ypToYPixel(unsigned char yp)
+	{
+	/* Convert from Y' to Y: */
+	if(yp<=16)
+		return 0;
+	else if(yp>=236)
+		return 255;
+	else
+		return (unsigned char)(((int(yp)-16)*256)/220);
+	}
+
+inline unsigned char avg(unsigned char v1,unsigned char v2)
+	{
+	return (unsigned char)(((unsigned int)(v1)+(unsigned int)(v2)+1U)/2U);
+	}
+
+inline unsigned char avg(unsigned char v1,unsigned char v2,unsigned char v3,unsigned char v4)
+	{
+	return (unsigned char)(((unsigned int)(v1)+(unsigned int)(v2)+(unsigned int)(v3)+(unsigned int)(v4)+2U)/4U);
+	}
+
+inline void bayerPixelToRgb(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool primary,unsigned char rgb[3])
+	{
+	/* Interpolate the primary, green, and secondary colors: */
+	unsigned char p,g,s;
+	if(primary)
+		{
+		p=raw[0];
+		g=avg(raw[-stride],raw[-1],raw[1],raw[stride]);
+		s=avg(raw[-stride-1],raw[-stride+1],raw[stride-1],raw[stride+1]);
+		}
+	else
+		{
+		p=avg(raw[-1],raw[1]);
+		g=raw[0];
+		s=avg(raw[-stride],raw[stride]);
+		}
+	
+	/* Assign the interpolated colors to RGB: */
+	rgb[0]=primaryRed?p:s;
+	rgb[1]=g;
+	rgb[2]=primaryRed?s:p;
+	}
+
+inline unsigned char clampByte(int v)
+	{
+	return (unsigned char)(v<0?0:v>255?255:v);
+	}
+
+inline void bayerPixelToRgbEdgeAware(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool primary,unsigned char rgb[3])
+	{
+	/* Interpolate the primary, green, and secondary colors: */
+	int p,g,s;
+	if(primary)
+		{
+		/* Interpolate green along the direction with the smaller green gradient: */
+		int gh=abs(int(raw[-1])-int(raw[1]));
+		int gv=abs(int(raw[-stride])-int(raw[stride]));
+		int gSum=int(raw[-stride])+int(raw[-1])+int(raw[1])+int(raw[stride]);
+		int gHorizontal=(int(raw[-1])+int(raw[1])+1)>>1;
+		int gVertical=(int(raw[-stride])+int(raw[stride])+1)>>1;
+		int gAll=(gSum+2)>>2;
+		g=gh<gv?gHorizontal:gv<gh?gVertical:gAll;
+		
+		p=raw[0];
+		
+		/* Interpolate the secondary color's difference to green from the diagonal neighbors: */
+		int sSum=int(raw[-stride-1])+int(raw[-stride+1])+int(raw[stride-1])+int(raw[stride+1]);
+		s=g+((sSum-gSum+2)>>2);
+		}
+	else
+		{
+		g=raw[0];
+		
+		/* Interpolate the primary and secondary colors' differences to green, estimating green at the horizontal and vertical neighbors from the diagonal neighbors: */
+		int gLeft=int(raw[-stride-1])+int(raw[stride-1]);
+		int gRight=int(raw[-stride+1])+int(raw[stride+1]);
+		int gUp=int(raw[-stride-1])+int(raw[-stride+1]);
+		int gDown=int(raw[stride-1])+int(raw[stride+1]);
+		p=g+((2*(int(raw[-1])+int(raw[1]))-gLeft-gRight+2)>>2);
+		s=g+((2*(int(raw[-stride])+int(raw[stride]))-gUp-gDown+2)>>2);
+		}
+	
+	/* Assign the interpolated colors to RGB: */
+	rgb[0]=clampByte(primaryRed?p:s);
+	rgb[1]=(unsigned char)g;
+	rgb[2]=clampByte(primaryRed?s:p);
+	}
+
+/**************
+Scalar kernels:
+**************/
+
+void ypToYScalar(const unsigned char* yp,unsigned char* y,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;++x)
+		y[x]=ypToYPixel(yp[x]);
+	}
+
+void ypcbcr422ToYScalar(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,unsigned char* y,unsigned int width)
+	{
+	const unsigned char* ypPtr=ypcbcr+(pixelOrder==ColorspaceKernels::UYVY?1:0);
+	for(unsigned int x=0;x<width;++x,ypPtr+=2)
+		y[x]=ypToYPixel(*ypPtr);
+	}
+
+void ypcbcr422ToRgbScalar(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,unsigned char* rgb,unsigned int width)
+	{
+	/* Get the byte offsets of the pixel pairs' components: */
+	int yp0Offset,yp1Offset,cbOffset,crOffset;
+	if(pixelOrder==ColorspaceKernels::UYVY)
+		{
+		yp0Offset=1;
+		yp1Offset=3;
+		cbOffset=0;
+		crOffset=2;
+		}
+	else
+		{
+		yp0Offset=0;
+		yp1Offset=2;
+		cbOffset=1;
+		crOffset=3;
+		}
+	
+	for(unsigned int x=0;x<width;x+=2,ypcbcr+=4,rgb+=2*3)
+		{
+		/* Convert first pixel: */
+		unsigned char pixel[3];
+		pixel[0]=ypcbcr[yp0Offset];
+		pixel[1]=ypcbcr[cbOffset];
+		pixel[2]=ypcbcr[crOffset];
+		ypcbcrToRgb(pixel,rgb);
+		
+		/* Convert second pixel: */
+		pixel[0]=ypcbcr[yp1Offset];
+		ypcbcrToRgb(pixel,rgb+3);
+		}
+	}
+
+void ypcbcr422ToYpCScalar(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,int chroma,unsigned char* yp,unsigned char* c,unsigned int width)
+	{
+	const unsigned char* ypPtr=ypcbcr+(pixelOrder==ColorspaceKernels::UYVY?1:0);
+	const unsigned char* cPtr=ypcbcr+(pixelOrder==ColorspaceKernels::UYVY?0:1)+chroma*2;
+	for(unsigned int x=0;x<width;x+=2,ypPtr+=4,cPtr+=4)
+		{
+		*(yp++)=ypPtr[0];
+		*(yp++)=ypPtr[2];
+		*(c++)=*cPtr;
+		}
+	}
+
+void ypcbcr420ToRgbScalar(const unsigned char* yp,const unsigned char* cb,const unsigned char* cr,unsigned char* rgb,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;x+=2,yp+=2,rgb+=2*3)
+		{
+		/* Convert the two pixels sharing the same chroma values: */
+		unsigned char pixel[3];
+		pixel[0]=yp[0];
+		pixel[1]=*(cb++);
+		pixel[2]=*(cr++);
+		ypcbcrToRgb(pixel,rgb);
+		
+		pixel[0]=yp[1];
+		ypcbcrToRgb(pixel,rgb+3);
+		}
+	}
+
+void rgbToGreyScalar(const unsigned char* rgb,unsigned char* grey,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;++x,rgb+=3)
+		grey[x]=(unsigned char)(((unsigned int)rgb[0]*306U+(unsigned int)rgb[1]*601U+(unsigned int)rgb[2]*117U)>>10);
+	}
+
+void rgbToYpcbcr420Scalar(const unsigned char* rgb0,const unsigned char* rgb1,unsigned char* yp0,unsigned char* yp1,unsigned char* cb,unsigned char* cr,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;x+=2,rgb0+=2*3,rgb1+=2*3)
+		{
+		/* Convert the 2x2 pixel block to Y'CbCr: */
+		unsigned char ypcbcr[4][3];
+		rgbToYpcbcr(rgb0,ypcbcr[0]);
+		rgbToYpcbcr(rgb0+3,ypcbcr[1]);
+		rgbToYpcbcr(rgb1,ypcbcr[2]);
+		rgbToYpcbcr(rgb1+3,ypcbcr[3]);
+		
+		/* Subsample and store the Y'CbCr components: */
+		*(yp0++)=ypcbcr[0][0];
+		*(yp0++)=ypcbcr[1][0];
+		*(yp1++)=ypcbcr[2][0];
+		*(yp1++)=ypcbcr[3][0];
+		*(cb++)=(unsigned char)((int(ypcbcr[0][1])+int(ypcbcr[1][1])+int(ypcbcr[2][1])+int(ypcbcr[3][1])+2)>>2);
+		*(cr++)=(unsigned char)((int(ypcbcr[0][2])+int(ypcbcr[1][2])+int(ypcbcr[2][2])+int(ypcbcr[3][2])+2)>>2);
+		}
+	}
+
+void bayerToRgbScalar(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* rgb,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;x+=2,raw+=2,rgb+=2*3)
+		{
+		bayerPixelToRgb(raw,stride,primaryRed,firstPrimary,rgb);
+		bayerPixelToRgb(raw+1,stride,primaryRed,!firstPrimary,rgb+3);
+		}
+	}
+
+void bayerToGreyScalar(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* grey,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;++x,++raw)
+		{
+		unsigned char rgb[3];
+		bayerPixelToRgb(raw,stride,primaryRed,((x&0x1U)==0U)==firstPrimary,rgb);
+		grey[x]=(unsigned char)(((unsigned int)rgb[0]*306U+(unsigned int)rgb[1]*601U+(unsigned int)rgb[2]*117U+512U)>>10);
+		}
+	}
+
+void bayerToRgbEdgeAwareScalar(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* rgb,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;x+=2,raw+=2,rgb+=2*3)
+		{
+		bayerPixelToRgbEdgeAware(raw,stride,primaryRed,firstPrimary,rgb);
+		bayerPixelToRgbEdgeAware(raw+1,stride,primaryRed,!firstPrimary,rgb+3);
+		}
+	}
+
+void bayerToGreyEdgeAwareScalar(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* grey,unsigned int width)
+	{
+	for(unsigned int x=0;x<width;++x,++raw)
+		{
+		unsigned char rgb[3];
+		bayerPixelToRgbEdgeAware(raw,stride,primaryRed,((x&0x1U)==0U)==firstPrimary,rgb);
+		grey[x]=(unsigned char)(((unsigned int)rgb[0]*306U+(unsigned int)rgb[1]*601U+(unsigned int)rgb[2]*117U+512U)>>10);
+		}
+	}
+
+/*****************************************
+Kernel tables for all instruction sets:
+*****************************************/
+
+struct KernelTables
+	{
+	/* Elements: */
+	public:
+	ColorspaceKernels scalar; // Scalar kernels; always available
+	ColorspaceKernels best; // Most efficient kernels supported by the host CPU
+	#if VIDEO_CONFIG_HAVE_X86_SIMD
+	ColorspaceKernels sse2; // Kernels using SSE2 instructions
+	ColorspaceKernels avx2; // Kernels using AVX2 instructions
+	bool haveSSE2,haveAVX2; // Flags whether the host CPU supports the respective instruction sets
+	#endif
+	
+	/* Constructors and destructors: */
+	KernelTables(void)
+		{
+		initColorspaceKernelsScalar(scalar);
+		best=scalar;
+		
+		#if VIDEO_CONFIG_HAVE_X86_SIMD
+		
+		/* Query the host CPU's instruction sets: */
+		__builtin_cpu_init();
+		haveSSE2=__builtin_cpu_supports("sse2");
+		haveAVX2=haveSSE2&&__builtin_cpu_supports("avx2");
+		
+		/* Initialize the SIMD kernels; each falls back to the previous set for rows not covered by SIMD code: */
+		sse2=scalar;
+		if(haveSSE2)
+			{
+			initColorspaceKernelsSSE2(sse2);
+			best=sse2;
+			}
+		avx2=sse2;
+		if(haveAVX2)
+			{
+			initColorspaceKernelsAVX2(avx2);
+			best=avx2;
+			}
+		
+		#endif
+		}
+	};
+
+const KernelTables& getKernelTables(void)
+	{
+	static KernelTables kernelTables;
+	return kernelTables;
+	}
+
+}
+
+/*********************************
+Methods of struct ColorspaceKernels:
+*********************************/
+
+const ColorspaceKernels& ColorspaceKernels::get(void)
+	{
+	return getKernelTables().best;
+	}
+
+const ColorspaceKernels& ColorspaceKernels::get(ColorspaceKernels::InstructionSet instructionSet)
+	{
+	const KernelTables& kt=getKernelTables();
+	switch(instructionSet)
+		{
+		case SCALAR:
+			return kt.scalar;
+		
+		#if VIDEO_CONFIG_HAVE_X86_SIMD
+		case SSE2:
+			return kt.haveSSE2?kt.sse2:kt.best;
+		
+		case AVX2:
+			return kt.haveAVX2?kt.avx2:kt.best;
+		#endif
+		
+		default:
+			return kt.best;
+		}
+	}
+
+/***********************************
+Initialization of the scalar kernels:
+***********************************/
+
+void initColorspaceKernelsScalar(ColorspaceKernels& kernels)
+	{
+	kernels.instructionSet=ColorspaceKernels::SCALAR;
+	kernels.ypToY=ypToYScalar;
+	kernels.ypcbcr422ToY=ypcbcr422ToYScalar;
+	kernels.ypcbcr422ToRgb=ypcbcr422ToRgbScalar;
+	kernels.ypcbcr422ToYpC=ypcbcr422ToYpCScalar;
+	kernels.ypcbcr420ToRgb=ypcbcr420ToRgbScalar;
+	kernels.rgbToGrey=rgbToGreyScalar;
+	kernels.rgbToYpcbcr420=rgbToYpcbcr420Scalar;
+	kernels.bayerToRgb=bayerToRgbScalar;
+	kernels.bayerToGrey=bayerToGreyScalar;
+	kernels.bayerToRgbEdgeAware=bayerToRgbEdgeAwareScalar;
+	kernels.bayerToGreyEdgeAware=bayerToGreyEdgeAwareScalar;
+	}
+
+}
@@ -0,0 +1,84 @@
+/***********************************************************************
+ColorspaceKernels - Structure holding pointers to functions converting
+single rows of video frame pixels between color spaces, selected at run-
+time for the instruction set of the host CPU.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef VIDEO_INTERNAL_COLORSPACEKERNELS_INCLUDED
+#define VIDEO_INTERNAL_COLORSPACEKERNELS_INCLUDED
+
+#include <stddef.h>
+#include <Video/Config.h>
+
+namespace Video {
+
+struct ColorspaceKernels
+	{
+	/* Embedded classes: */
+	public:
+	enum InstructionSet // Enumerated type for instruction sets for which kernels exist
+		{
+		SCALAR=0,SSE2,AVX2
+		};
+	
+	enum PixelOrder422 // Enumerated type for byte orders of Y'CbCr 4:2:2 pixel pairs
+		{
+		YUYV=0, // Y'0, Cb, Y'1, Cr
+		UYVY // Cb, Y'0, Cr, Y'1
+		};
+	
+	/* Elements: */
+	InstructionSet instructionSet; // Instruction set used by the kernels
+	
+	/* Conversions from Y'CbCr: */
+	void (*ypToY)(const unsigned char* yp,unsigned char* y,unsigned int width); // Converts a row of Y' values to Y
+	void (*ypcbcr422ToY)(const unsigned char* ypcbcr,PixelOrder422 pixelOrder,unsigned char* y,unsigned int width); // Converts the Y' values of a row of Y'CbCr 4:2:2 pixels to Y; width must be even
+	void (*ypcbcr422ToRgb)(const unsigned char* ypcbcr,PixelOrder422 pixelOrder,unsigned char* rgb,unsigned int width); // Converts a row of Y'CbCr 4:2:2 pixels to RGB; width must be even
+	void (*ypcbcr422ToYpC)(const unsigned char* ypcbcr,PixelOrder422 pixelOrder,int chroma,unsigned char* yp,unsigned char* c,unsigned int width); // Splits a row of Y'CbCr 4:2:2 pixels into Y' and the Cb (chroma=0) or Cr (chroma=1) values; width must be even
+	void (*ypcbcr420ToRgb)(const unsigned char* yp,const unsigned char* cb,const unsigned char* cr,unsigned char* rgb,unsigned int width); // Converts a row of Y' values and its half-width row of Cb and Cr values to RGB; width must be even
+	
+	/* Conversions from RGB: */
+	void (*rgbToGrey)(const unsigned char* rgb,unsigned char* grey,unsigned int width); // Converts a row of RGB pixels to grey
+	void (*rgbToYpcbcr420)(const unsigned char* rgb0,const unsigned char* rgb1,unsigned char* yp0,unsigned char* yp1,unsigned char* cb,unsigned char* cr,unsigned int width); // Converts two rows of RGB pixels to two rows of Y' values and one half-width row each of averaged Cb and Cr values; width must be even
+	
+	/* Conversions from Bayer-filtered raw pixels: */
+	void (*bayerToRgb)(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* rgb,unsigned int width); // Interpolates the interior pixels of a raw row with neighbors in all directions and a non-green primary color (red if primaryRed is true) at every other pixel, starting at the first pixel if firstPrimary is true; width must be even
+	void (*bayerToGrey)(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* grey,unsigned int width); // Same as bayerToRgb, but converts the interpolated pixels to grey
+	void (*bayerToRgbEdgeAware)(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* rgb,unsigned int width); // Same as bayerToRgb, but interpolates green along edges and the other colors via their differences to green
+	void (*bayerToGreyEdgeAware)(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* grey,unsigned int width); // Same as bayerToRgbEdgeAware, but converts the interpolated pixels to grey
+	
+	/* Methods: */
+	static const ColorspaceKernels& get(void); // Returns the most efficient kernels supported by the host CPU
+	static const ColorspaceKernels& get(InstructionSet instructionSet); // Returns the kernels for the given instruction set, or the most efficient kernels supported by the host CPU if it does not support the given instruction set
+	};
+
+/************************************************************
+Functions to initialize kernels for specific instruction sets:
+************************************************************/
+
+void initColorspaceKernelsScalar(ColorspaceKernels& kernels);
+#if VIDEO_CONFIG_HAVE_X86_SIMD
+void initColorspaceKernelsSSE2(ColorspaceKernels& kernels);
+void initColorspaceKernelsAVX2(ColorspaceKernels& kernels);
+#endif
+
+}
+
+#endif
@@ -0,0 +1,514 @@
+/***********************************************************************
+ColorspaceKernelsAVX2 - Row conversion kernels using AVX2 instructions.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+/***********************************************************************
+The kernels in this file follow the SSE2 kernels, but operate on 256-bit
+vectors. Most AVX2 instructions operate on two independent 128-bit
+lanes; unpacking and re-packing vectors in the same order therefore
+preserves pixel order, and only the final stores need to pick pixels
+from the two lanes. This file is compiled with AVX2 code generation
+enabled, and must therefore not include any headers defining inline
+functions used by other files.
+***********************************************************************/
+
+#include <Video/Internal/ColorspaceKernels.h>
+
+#include <string.h>
+#include <immintrin.h>
+
+namespace Video {
+
+namespace {
+
+/**************
+Global kernels:
+**************/
+
+ColorspaceKernels fallback; // Kernels processing the pixels left over by the vectorized loops
+
+/****************
+Helper functions:
+****************/
+
+inline __m256i coefficients(int c0,int c1) // Returns a vector of pairs of 16-bit coefficients for multiply-add
+	{
+	return _mm256_set1_epi32(int(((unsigned int)(c1)&0xffffU)<<16|((unsigned int)(c0)&0xffffU)));
+	}
+
+inline __m256i combine(__m128i lo,__m128i hi) // Combines two 128-bit vectors into one 256-bit vector
+	{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo),hi,1);
+	}
+
+inline __m128i packLanes(__m256i v) // Returns the low eight bytes of both lanes of the given vector as one 128-bit vector
+	{
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(v,_MM_SHUFFLE(3,1,2,0)));
+	}
+
+inline void loadRgb16(const unsigned char* rgb,__m256i& r,__m256i& g,__m256i& b) // Loads sixteen RGB pixels as 16-bit component values without reading past the last pixel
+	{
+	/* Expand the pixels to 32-bit RGBX, with pixels 0-3 and 8-11 in the first vector, and pixels 4-7 and 12-15 in the second: */
+	__m256i expand0=_mm256_setr_epi8(0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,-1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,-1);
+	__m256i expand1=_mm256_setr_epi8(0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,-1,4,5,6,-1,7,8,9,-1,10,11,12,-1,13,14,15,-1);
+	const __m128i* rgbPtr=reinterpret_cast<const __m128i*>(rgb);
+	__m256i x0=_mm256_shuffle_epi8(combine(_mm_loadu_si128(rgbPtr),_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb+24))),expand0);
+	__m256i x1=_mm256_shuffle_epi8(combine(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb+12)),_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb+32))),expand1);
+	
+	/* Separate the components: */
+	__m256i mask=_mm256_set1_epi32(0xff);
+	r=_mm256_packs_epi32(_mm256_and_si256(x0,mask),_mm256_and_si256(x1,mask));
+	g=_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(x0,8),mask),_mm256_and_si256(_mm256_srli_epi32(x1,8),mask));
+	b=_mm256_packs_epi32(_mm256_srli_epi32(x0,16),_mm256_srli_epi32(x1,16));
+	}
+
+inline void storeRgbx(unsigned char* rgb0,unsigned char* rgb1,__m256i rgbx) // Stores the four 32-bit RGBX pixels in each lane as 12 bytes of RGB
+	{
+	__m256i compact=_mm256_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1,0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+	__m256i c=_mm256_shuffle_epi8(rgbx,compact);
+	__m128i c0=_mm256_castsi256_si128(c);
+	__m128i c1=_mm256_extracti128_si256(c,1);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(rgb0),c0);
+	int last=_mm_cvtsi128_si32(_mm_srli_si128(c0,8));
+	memcpy(rgb0+8,&last,4);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(rgb1),c1);
+	last=_mm_cvtsi128_si32(_mm_srli_si128(c1,8));
+	memcpy(rgb1+8,&last,4);
+	}
+
+inline void storeRgb16(unsigned char* rgb,__m256i r,__m256i g,__m256i b) // Stores sixteen pixels from the low eight bytes of both lanes of separate component vectors
+	{
+	__m256i rg=_mm256_unpacklo_epi8(r,g);
+	__m256i bz=_mm256_unpacklo_epi8(b,_mm256_setzero_si256());
+	storeRgbx(rgb,rgb+24,_mm256_unpacklo_epi16(rg,bz));
+	storeRgbx(rgb+12,rgb+36,_mm256_unpackhi_epi16(rg,bz));
+	}
+
+inline void storeRgb32(unsigned char* rgb,__m256i r,__m256i g,__m256i b) // Stores thirty-two pixels from separate component vectors
+	{
+	__m256i zero=_mm256_setzero_si256();
+	__m256i rg=_mm256_unpacklo_epi8(r,g);
+	__m256i bz=_mm256_unpacklo_epi8(b,zero);
+	storeRgbx(rgb,rgb+48,_mm256_unpacklo_epi16(rg,bz));
+	storeRgbx(rgb+12,rgb+60,_mm256_unpackhi_epi16(rg,bz));
+	rg=_mm256_unpackhi_epi8(r,g);
+	bz=_mm256_unpackhi_epi8(b,zero);
+	storeRgbx(rgb+24,rgb+72,_mm256_unpacklo_epi16(rg,bz));
+	storeRgbx(rgb+36,rgb+84,_mm256_unpackhi_epi16(rg,bz));
+	}
+
+inline __m256i ypToY16(__m256i yp) // Converts 16-bit Y' values to Y
+	{
+	/* Calculate (Y'-16)*256/220, clamped to [0, 256], by multiplying with a reciprocal: */
+	__m256i d=_mm256_min_epi16(_mm256_subs_epu16(yp,_mm256_set1_epi16(16)),_mm256_set1_epi16(220));
+	return _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_slli_epi16(d,8),_mm256_set1_epi16(short(38131))),7);
+	}
+
+inline __m256i clampFixed16(__m256i lo,__m256i hi) // Converts two vectors of 16.16 fixed-point values to one vector of 16-bit values clamped to [0, 255]
+	{
+	__m256i result=_mm256_packs_epi32(_mm256_srai_epi32(lo,16),_mm256_srai_epi32(hi,16));
+	return _mm256_min_epi16(_mm256_max_epi16(result,_mm256_setzero_si256()),_mm256_set1_epi16(255));
+	}
+
+inline void yuvToRgb16(__m256i y,__m256i u,__m256i v,__m256i& r,__m256i& g,__m256i& b) // Converts sixteen 16-bit YUV pixels to RGB in the low eight bytes of both lanes of the result vectors
+	{
+	__m256i zero=_mm256_setzero_si256();
+	__m256i round=_mm256_set1_epi32(32768);
+	
+	/* Interleave the components for multiply-add: */
+	__m256i yuLo=_mm256_unpacklo_epi16(y,u);
+	__m256i yuHi=_mm256_unpackhi_epi16(y,u);
+	__m256i yvLo=_mm256_unpacklo_epi16(y,v);
+	__m256i yvHi=_mm256_unpackhi_epi16(y,v);
+	__m256i v2Lo=_mm256_unpacklo_epi16(v,_mm256_set1_epi16(2));
+	__m256i v2Hi=_mm256_unpackhi_epi16(v,_mm256_set1_epi16(2));
+	
+	/* R=76309*y+104597*v: */
+	__m256i h=_mm256_add_epi16(y,_mm256_add_epi16(v,v));
+	__m256i cr=coefficients(10773,-26475);
+	__m256i lo=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yvLo,cr),round),_mm256_unpacklo_epi16(zero,h));
+	__m256i hi=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yvHi,cr),round),_mm256_unpackhi_epi16(zero,h));
+	r=clampFixed16(lo,hi);
+	
+	/* G=76309*y-25675*u-53279*v: */
+	h=_mm256_sub_epi16(y,v);
+	__m256i cg1=coefficients(10773,-25675);
+	__m256i cg2=coefficients(12257,16384);
+	lo=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo,cg1),_mm256_madd_epi16(v2Lo,cg2)),_mm256_unpacklo_epi16(zero,h));
+	hi=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi,cg1),_mm256_madd_epi16(v2Hi,cg2)),_mm256_unpackhi_epi16(zero,h));
+	g=clampFixed16(lo,hi);
+	
+	/* B=76309*y+132202*u: */
+	h=_mm256_add_epi16(y,_mm256_add_epi16(u,u));
+	__m256i cb=coefficients(10773,1130);
+	lo=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo,cb),round),_mm256_unpacklo_epi16(zero,h));
+	hi=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi,cb),round),_mm256_unpackhi_epi16(zero,h));
+	b=clampFixed16(lo,hi);
+	
+	/* Pack the components to bytes: */
+	r=_mm256_packus_epi16(r,r);
+	g=_mm256_packus_epi16(g,g);
+	b=_mm256_packus_epi16(b,b);
+	}
+
+inline void rgbToYpcbcr16(__m256i r,__m256i g,__m256i b,__m256i& yp,__m256i& cb,__m256i& cr) // Converts sixteen 16-bit RGB pixels to 16-bit Y'CbCr
+	{
+	__m256i zero=_mm256_setzero_si256();
+	__m256i rgLo=_mm256_unpacklo_epi16(r,g);
+	__m256i rgHi=_mm256_unpackhi_epi16(r,g);
+	__m256i bgLo=_mm256_unpacklo_epi16(b,g);
+	__m256i bgHi=_mm256_unpackhi_epi16(b,g);
+	__m256i bzLo=_mm256_unpacklo_epi16(b,zero);
+	__m256i bzHi=_mm256_unpackhi_epi16(b,zero);
+	
+	/* Y'=1048576+16829*r+33039*g+6416*b: */
+	__m256i c1=coefficients(16829,16384);
+	__m256i c2=coefficients(6416,16655);
+	__m256i offset=_mm256_set1_epi32(1048576+32768);
+	__m256i lo=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgLo,c1),_mm256_madd_epi16(bgLo,c2)),offset);
+	__m256i hi=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgHi,c1),_mm256_madd_epi16(bgHi,c2)),offset);
+	yp=clampFixed16(lo,hi);
+	
+	/* Cb=8388608-9714*r-19071*g+28784*b: */
+	c1=coefficients(-9714,-19071);
+	c2=coefficients(28784,0);
+	offset=_mm256_set1_epi32(8388608+32768);
+	lo=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgLo,c1),_mm256_madd_epi16(bzLo,c2)),offset);
+	hi=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgHi,c1),_mm256_madd_epi16(bzHi,c2)),offset);
+	cb=clampFixed16(lo,hi);
+	
+	/* Cr=8388608+28784*r-24103*g-4681*b: */
+	c1=coefficients(28784,-24103);
+	c2=coefficients(-4681,0);
+	lo=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgLo,c1),_mm256_madd_epi16(bzLo,c2)),offset);
+	hi=_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgHi,c1),_mm256_madd_epi16(bzHi,c2)),offset);
+	cr=clampFixed16(lo,hi);
+	}
+
+inline __m256i avg4(__m256i v1,__m256i v2,__m256i v3,__m256i v4) // Returns the rounded averages of four vectors of bytes
+	{
+	__m256i zero=_mm256_setzero_si256();
+	__m256i two=_mm256_set1_epi16(2);
+	__m256i lo=_mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(v1,zero),_mm256_unpacklo_epi8(v2,zero)),_mm256_add_epi16(_mm256_unpacklo_epi8(v3,zero),_mm256_unpacklo_epi8(v4,zero)));
+	__m256i hi=_mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(v1,zero),_mm256_unpackhi_epi8(v2,zero)),_mm256_add_epi16(_mm256_unpackhi_epi8(v3,zero),_mm256_unpackhi_epi8(v4,zero)));
+	return _mm256_packus_epi16(_mm256_srli_epi16(_mm256_add_epi16(lo,two),2),_mm256_srli_epi16(_mm256_add_epi16(hi,two),2));
+	}
+
+inline __m256i load(const unsigned char* ptr)
+	{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+	}
+
+inline void bayerToRgb32(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,__m256i primaryMask,__m256i& r,__m256i& g,__m256i& b) // Interpolates thirty-two raw pixels
+	{
+	/* Load the pixels and their neighbors: */
+	__m256i c=load(raw);
+	__m256i left=load(raw-1);
+	__m256i right=load(raw+1);
+	__m256i u=load(raw-stride);
+	__m256i d=load(raw+stride);
+	
+	/* Interpolate all colors at all pixels: */
+	__m256i horizontal=_mm256_avg_epu8(left,right);
+	__m256i vertical=_mm256_avg_epu8(u,d);
+	__m256i cross=avg4(u,left,right,d);
+	__m256i diagonal=avg4(load(raw-stride-1),load(raw-stride+1),load(raw+stride-1),load(raw+stride+1));
+	
+	/* Select the primary, green, and secondary colors based on each pixel's color: */
+	__m256i p=_mm256_blendv_epi8(horizontal,c,primaryMask);
+	g=_mm256_blendv_epi8(c,cross,primaryMask);
+	__m256i s=_mm256_blendv_epi8(vertical,diagonal,primaryMask);
+	r=primaryRed?p:s;
+	b=primaryRed?s:p;
+	}
+
+/************
+AVX2 kernels:
+************/
+
+void ypToYAVX2(const unsigned char* yp,unsigned char* y,unsigned int width)
+	{
+	__m256i zero=_mm256_setzero_si256();
+	unsigned int x;
+	for(x=0;x+32<=width;x+=32)
+		{
+		__m256i v=load(yp+x);
+		__m256i lo=ypToY16(_mm256_unpacklo_epi8(v,zero));
+		__m256i hi=ypToY16(_mm256_unpackhi_epi8(v,zero));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(y+x),_mm256_packus_epi16(lo,hi));
+		}
+	if(x<width)
+		fallback.ypToY(yp+x,y+x,width-x);
+	}
+
+void ypcbcr422ToYAVX2(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,unsigned char* y,unsigned int width)
+	{
+	__m256i mask=_mm256_set1_epi16(0xff);
+	unsigned int x;
+	for(x=0;x+32<=width;x+=32)
+		{
+		__m256i v0=load(ypcbcr+x*2);
+		__m256i v1=load(ypcbcr+x*2+32);
+		if(pixelOrder==ColorspaceKernels::UYVY)
+			{
+			v0=_mm256_srli_epi16(v0,8);
+			v1=_mm256_srli_epi16(v1,8);
+			}
+		else
+			{
+			v0=_mm256_and_si256(v0,mask);
+			v1=_mm256_and_si256(v1,mask);
+			}
+		__m256i result=_mm256_packus_epi16(ypToY16(v0),ypToY16(v1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(y+x),_mm256_permute4x64_epi64(result,_MM_SHUFFLE(3,1,2,0)));
+		}
+	if(x<width)
+		fallback.ypcbcr422ToY(ypcbcr+x*2,pixelOrder,y+x,width-x);
+	}
+
+void ypcbcr422ToRgbAVX2(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,unsigned char* rgb,unsigned int width)
+	{
+	__m256i mask=_mm256_set1_epi16(0xff);
+	__m256i yOffset=_mm256_set1_epi16(16);
+	__m256i cOffset=_mm256_set1_epi16(128);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		/* Separate the Y' and chroma values: */
+		__m256i v=load(ypcbcr+x*2);
+		__m256i yp,c;
+		if(pixelOrder==ColorspaceKernels::UYVY)
+			{
+			yp=_mm256_srli_epi16(v,8);
+			c=_mm256_and_si256(v,mask);
+			}
+		else
+			{
+			yp=_mm256_and_si256(v,mask);
+			c=_mm256_srli_epi16(v,8);
+			}
+		
+		/* Replicate each pixel pair's chroma values and convert to YUV: */
+		__m256i y=_mm256_sub_epi16(yp,yOffset);
+		__m256i u=_mm256_sub_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c,_MM_SHUFFLE(2,2,0,0)),_MM_SHUFFLE(2,2,0,0)),cOffset);
+		__m256i w=_mm256_sub_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c,_MM_SHUFFLE(3,3,1,1)),_MM_SHUFFLE(3,3,1,1)),cOffset);
+		
+		/* Convert to RGB: */
+		__m256i r,g,b;
+		yuvToRgb16(y,u,w,r,g,b);
+		storeRgb16(rgb+x*3,r,g,b);
+		}
+	if(x<width)
+		fallback.ypcbcr422ToRgb(ypcbcr+x*2,pixelOrder,rgb+x*3,width-x);
+	}
+
+void ypcbcr422ToYpCAVX2(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,int chroma,unsigned char* yp,unsigned char* c,unsigned int width)
+	{
+	__m256i mask=_mm256_set1_epi16(0xff);
+	__m256i cMask=_mm256_set1_epi32(0xffff);
+	__m256i cOrder=_mm256_setr_epi32(0,4,1,5,2,6,3,7);
+	unsigned int x;
+	for(x=0;x+32<=width;x+=32)
+		{
+		/* Separate the Y' and chroma values: */
+		__m256i v0=load(ypcbcr+x*2);
+		__m256i v1=load(ypcbcr+x*2+32);
+		__m256i yp0,yp1,c0,c1;
+		if(pixelOrder==ColorspaceKernels::UYVY)
+			{
+			yp0=_mm256_srli_epi16(v0,8);
+			yp1=_mm256_srli_epi16(v1,8);
+			c0=_mm256_and_si256(v0,mask);
+			c1=_mm256_and_si256(v1,mask);
+			}
+		else
+			{
+			yp0=_mm256_and_si256(v0,mask);
+			yp1=_mm256_and_si256(v1,mask);
+			c0=_mm256_srli_epi16(v0,8);
+			c1=_mm256_srli_epi16(v1,8);
+			}
+		__m256i result=_mm256_packus_epi16(yp0,yp1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(yp+x),_mm256_permute4x64_epi64(result,_MM_SHUFFLE(3,1,2,0)));
+		
+		/* Keep the requested chroma values: */
+		if(chroma!=0)
+			{
+			c0=_mm256_srli_epi32(c0,16);
+			c1=_mm256_srli_epi32(c1,16);
+			}
+		else
+			{
+			c0=_mm256_and_si256(c0,cMask);
+			c1=_mm256_and_si256(c1,cMask);
+			}
+		c0=_mm256_packs_epi32(c0,c1);
+		c0=_mm256_permutevar8x32_epi32(_mm256_packus_epi16(c0,c0),cOrder);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(c+x/2),_mm256_castsi256_si128(c0));
+		}
+	if(x<width)
+		fallback.ypcbcr422ToYpC(ypcbcr+x*2,pixelOrder,chroma,yp+x,c+x/2,width-x);
+	}
+
+void ypcbcr420ToRgbAVX2(const unsigned char* yp,const unsigned char* cb,const unsigned char* cr,unsigned char* rgb,unsigned int width)
+	{
+	__m256i yOffset=_mm256_set1_epi16(16);
+	__m256i cOffset=_mm256_set1_epi16(128);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		/* Load sixteen Y' values and replicate eight Cb and Cr values each: */
+		__m256i y=_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(yp+x))),yOffset);
+		__m128i c=_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cb+x/2)),_mm_setzero_si128());
+		__m256i u=_mm256_sub_epi16(combine(_mm_unpacklo_epi16(c,c),_mm_unpackhi_epi16(c,c)),cOffset);
+		c=_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cr+x/2)),_mm_setzero_si128());
+		__m256i v=_mm256_sub_epi16(combine(_mm_unpacklo_epi16(c,c),_mm_unpackhi_epi16(c,c)),cOffset);
+		
+		/* Convert to RGB: */
+		__m256i r,g,b;
+		yuvToRgb16(y,u,v,r,g,b);
+		storeRgb16(rgb+x*3,r,g,b);
+		}
+	if(x<width)
+		fallback.ypcbcr420ToRgb(yp+x,cb+x/2,cr+x/2,rgb+x*3,width-x);
+	}
+
+void rgbToGreyAVX2(const unsigned char* rgb,unsigned char* grey,unsigned int width)
+	{
+	__m256i zero=_mm256_setzero_si256();
+	__m256i c1=coefficients(306,601);
+	__m256i c2=coefficients(117,0);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		__m256i r,g,b;
+		loadRgb16(rgb+x*3,r,g,b);
+		__m256i lo=_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r,g),c1),_mm256_madd_epi16(_mm256_unpacklo_epi16(b,zero),c2));
+		__m256i hi=_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r,g),c1),_mm256_madd_epi16(_mm256_unpackhi_epi16(b,zero),c2));
+		__m256i result=_mm256_packs_epi32(_mm256_srli_epi32(lo,10),_mm256_srli_epi32(hi,10));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(grey+x),packLanes(_mm256_packus_epi16(result,result)));
+		}
+	if(x<width)
+		fallback.rgbToGrey(rgb+x*3,grey+x,width-x);
+	}
+
+void rgbToYpcbcr420AVX2(const unsigned char* rgb0,const unsigned char* rgb1,unsigned char* yp0,unsigned char* yp1,unsigned char* cb,unsigned char* cr,unsigned int width)
+	{
+	__m256i one=_mm256_set1_epi16(1);
+	__m256i two=_mm256_set1_epi32(2);
+	__m256i cOrder=_mm256_setr_epi32(0,4,1,5,2,6,3,7);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		/* Convert sixteen pixels from each row: */
+		__m256i r,g,b,y0,cb0,cr0,y1,cb1,cr1;
+		loadRgb16(rgb0+x*3,r,g,b);
+		rgbToYpcbcr16(r,g,b,y0,cb0,cr0);
+		loadRgb16(rgb1+x*3,r,g,b);
+		rgbToYpcbcr16(r,g,b,y1,cb1,cr1);
+		
+		/* Store the Y' values: */
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(yp0+x),packLanes(_mm256_packus_epi16(y0,y0)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(yp1+x),packLanes(_mm256_packus_epi16(y1,y1)));
+		
+		/* Average the chroma values of each 2x2 pixel block: */
+		__m256i c=_mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_add_epi16(cb0,cb1),one),two),2);
+		c=_mm256_packs_epi32(c,c);
+		c=_mm256_permutevar8x32_epi32(_mm256_packus_epi16(c,c),cOrder);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(cb+x/2),_mm256_castsi256_si128(c));
+		c=_mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_add_epi16(cr0,cr1),one),two),2);
+		c=_mm256_packs_epi32(c,c);
+		c=_mm256_permutevar8x32_epi32(_mm256_packus_epi16(c,c),cOrder);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(cr+x/2),_mm256_castsi256_si128(c));
+		}
+	if(x<width)
+		fallback.rgbToYpcbcr420(rgb0+x*3,rgb1+x*3,yp0+x,yp1+x,cb+x/2,cr+x/2,width-x);
+	}
+
+void bayerToRgbAVX2(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* rgb,unsigned int width)
+	{
+	__m256i primaryMask=_mm256_set1_epi16(firstPrimary?0x00ff:short(0xff00));
+	unsigned int x;
+	for(x=0;x+32<=width;x+=32)
+		{
+		__m256i r,g,b;
+		bayerToRgb32(raw+x,stride,primaryRed,primaryMask,r,g,b);
+		storeRgb32(rgb+x*3,r,g,b);
+		}
+	if(x<width)
+		fallback.bayerToRgb(raw+x,stride,primaryRed,firstPrimary,rgb+x*3,width-x);
+	}
+
+void bayerToGreyAVX2(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* grey,unsigned int width)
+	{
+	__m256i primaryMask=_mm256_set1_epi16(firstPrimary?0x00ff:short(0xff00));
+	__m256i zero=_mm256_setzero_si256();
+	__m256i c1=coefficients(306,601);
+	__m256i c2=coefficients(117,512);
+	__m256i one=_mm256_set1_epi16(1);
+	unsigned int x;
+	for(x=0;x+32<=width;x+=32)
+		{
+		__m256i r,g,b;
+		bayerToRgb32(raw+x,stride,primaryRed,primaryMask,r,g,b);
+		
+		/* Convert the interpolated pixels to grey: */
+		__m256i rLo=_mm256_unpacklo_epi8(r,zero);
+		__m256i gLo=_mm256_unpacklo_epi8(g,zero);
+		__m256i bLo=_mm256_unpacklo_epi8(b,zero);
+		__m256i rHi=_mm256_unpackhi_epi8(r,zero);
+		__m256i gHi=_mm256_unpackhi_epi8(g,zero);
+		__m256i bHi=_mm256_unpackhi_epi8(b,zero);
+		__m256i s0=_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(rLo,gLo),c1),_mm256_madd_epi16(_mm256_unpacklo_epi16(bLo,one),c2));
+		__m256i s1=_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(rLo,gLo),c1),_mm256_madd_epi16(_mm256_unpackhi_epi16(bLo,one),c2));
+		__m256i s2=_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(rHi,gHi),c1),_mm256_madd_epi16(_mm256_unpacklo_epi16(bHi,one),c2));
+		__m256i s3=_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(rHi,gHi),c1),_mm256_madd_epi16(_mm256_unpackhi_epi16(bHi,one),c2));
+		__m256i lo=_mm256_packs_epi32(_mm256_srli_epi32(s0,10),_mm256_srli_epi32(s1,10));
+		__m256i hi=_mm256_packs_epi32(_mm256_srli_epi32(s2,10),_mm256_srli_epi32(s3,10));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(grey+x),_mm256_packus_epi16(lo,hi));
+		}
+	if(x<width)
+		fallback.bayerToGrey(raw+x,stride,primaryRed,firstPrimary,grey+x,width-x);
+	}
+
+}
+
+/*********************************
+Initialization of the AVX2 kernels:
+*********************************/
+
+void initColorspaceKernelsAVX2(ColorspaceKernels& kernels)
+	{
+	/* Remember the given kernels to process left-over pixels: */
+	fallback=kernels;
+	
+	kernels.instructionSet=ColorspaceKernels::AVX2;
+	kernels.ypToY=ypToYAVX2;
+	kernels.ypcbcr422ToY=ypcbcr422ToYAVX2;
+	kernels.ypcbcr422ToRgb=ypcbcr422ToRgbAVX2;
+	kernels.ypcbcr422ToYpC=ypcbcr422ToYpCAVX2;
+	kernels.ypcbcr420ToRgb=ypcbcr420ToRgbAVX2;
+	kernels.rgbToGrey=rgbToGreyAVX2;
+	kernels.rgbToYpcbcr420=rgbToYpcbcr420AVX2;
+	kernels.bayerToRgb=bayerToRgbAVX2;
+	kernels.bayerToGrey=bayerToGreyAVX2;
+	}
+
+}
@@ -0,0 +1,511 @@
+/***********************************************************************
+ColorspaceKernelsSSE2 - Row conversion kernels using SSE2 instructions.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+/***********************************************************************
+All kernels produce bit-identical results to the scalar kernels by
+evaluating the fixed-point formulas from Colorspaces.h exactly: 17-bit
+coefficients c are split into c=h*65536+l with |l|<32768, such that the
+products with l can be summed by pmaddwd, and the products with h can be
+calculated in 16-bit arithmetic and shifted into place. This file is
+compiled with SSE2 code generation enabled, and must therefore not
+include any headers defining inline functions used by other files.
+***********************************************************************/
+
+#include <Video/Internal/ColorspaceKernels.h>
+
+#include <string.h>
+#include <emmintrin.h>
+
+namespace Video {
+
+namespace {
+
+/**************
+Global kernels:
+**************/
+
+ColorspaceKernels fallback; // Kernels processing the pixels left over by the vectorized loops
+
+/****************
+Helper functions:
+****************/
+
+inline __m128i expandRgb4(__m128i v) // Expands four RGB pixels from the low 12 bytes of the given vector to 32-bit RGBX pixels
+	{
+	__m128i h=_mm_unpacklo_epi64(v,_mm_srli_si128(v,6));
+	__m128i lo=_mm_and_si128(h,_mm_set_epi32(0,0x00ffffff,0,0x00ffffff));
+	__m128i hi=_mm_and_si128(_mm_slli_epi64(h,8),_mm_set_epi32(0x00ffffff,0,0x00ffffff,0));
+	return _mm_or_si128(lo,hi);
+	}
+
+inline void loadRgb8(const unsigned char* rgb,__m128i& r,__m128i& g,__m128i& b) // Loads eight RGB pixels as 16-bit component values without reading past the last pixel
+	{
+	/* Expand the pixels to 32-bit RGBX: */
+	__m128i x0=expandRgb4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb)));
+	__m128i x1=expandRgb4(_mm_srli_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb+8)),4));
+	
+	/* Separate the components: */
+	__m128i mask=_mm_set1_epi32(0xff);
+	r=_mm_packs_epi32(_mm_and_si128(x0,mask),_mm_and_si128(x1,mask));
+	g=_mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0,8),mask),_mm_and_si128(_mm_srli_epi32(x1,8),mask));
+	b=_mm_packs_epi32(_mm_srli_epi32(x0,16),_mm_srli_epi32(x1,16));
+	}
+
+inline void storeRgbx4(unsigned char* rgb,__m128i rgbx) // Stores four 32-bit RGBX pixels as 12 bytes of RGB
+	{
+	/* Compact each pair of pixels into six bytes: */
+	__m128i lo=_mm_and_si128(rgbx,_mm_set_epi32(0,0x00ffffff,0,0x00ffffff));
+	__m128i hi=_mm_and_si128(_mm_srli_epi64(rgbx,8),_mm_set_epi32(0x0000ffff,int(0xff000000U),0x0000ffff,int(0xff000000U)));
+	__m128i c=_mm_or_si128(lo,hi);
+	
+	/* Combine the two groups of six bytes: */
+	c=_mm_or_si128(_mm_move_epi64(c),_mm_slli_si128(_mm_srli_si128(c,8),6));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(rgb),c);
+	int last=_mm_cvtsi128_si32(_mm_srli_si128(c,8));
+	memcpy(rgb+8,&last,4);
+	}
+
+inline void storeRgb8(unsigned char* rgb,__m128i r,__m128i g,__m128i b) // Stores eight pixels from the low eight bytes of separate component vectors
+	{
+	__m128i rg=_mm_unpacklo_epi8(r,g);
+	__m128i bz=_mm_unpacklo_epi8(b,_mm_setzero_si128());
+	storeRgbx4(rgb,_mm_unpacklo_epi16(rg,bz));
+	storeRgbx4(rgb+12,_mm_unpackhi_epi16(rg,bz));
+	}
+
+inline void storeRgb16(unsigned char* rgb,__m128i r,__m128i g,__m128i b) // Stores sixteen pixels from separate component vectors
+	{
+	__m128i zero=_mm_setzero_si128();
+	__m128i rg=_mm_unpacklo_epi8(r,g);
+	__m128i bz=_mm_unpacklo_epi8(b,zero);
+	storeRgbx4(rgb,_mm_unpacklo_epi16(rg,bz));
+	storeRgbx4(rgb+12,_mm_unpackhi_epi16(rg,bz));
+	rg=_mm_unpackhi_epi8(r,g);
+	bz=_mm_unpackhi_epi8(b,zero);
+	storeRgbx4(rgb+24,_mm_unpacklo_epi16(rg,bz));
+	storeRgbx4(rgb+36,_mm_unpackhi_epi16(rg,bz));
+	}
+
+inline __m128i coefficients(int c0,int c1) // Returns a vector of pairs of 16-bit coefficients for multiply-add
+	{
+	return _mm_set1_epi32(int(((unsigned int)(c1)&0xffffU)<<16|((unsigned int)(c0)&0xffffU)));
+	}
+
+inline __m128i ypToY16(__m128i yp) // Converts 16-bit Y' values to Y
+	{
+	/* Calculate (Y'-16)*256/220, clamped to [0, 256], by multiplying with a reciprocal: */
+	__m128i d=_mm_min_epi16(_mm_subs_epu16(yp,_mm_set1_epi16(16)),_mm_set1_epi16(220));
+	return _mm_srli_epi16(_mm_mulhi_epu16(_mm_slli_epi16(d,8),_mm_set1_epi16(short(38131))),7);
+	}
+
+inline __m128i clampFixed16(__m128i lo,__m128i hi) // Converts two vectors of 16.16 fixed-point values to one vector of 16-bit values clamped to [0, 255]
+	{
+	__m128i result=_mm_packs_epi32(_mm_srai_epi32(lo,16),_mm_srai_epi32(hi,16));
+	return _mm_min_epi16(_mm_max_epi16(result,_mm_setzero_si128()),_mm_set1_epi16(255));
+	}
+
+inline void yuvToRgb8(__m128i y,__m128i u,__m128i v,__m128i& r,__m128i& g,__m128i& b) // Converts eight 16-bit YUV pixels to RGB in the low eight bytes of the result vectors
+	{
+	__m128i zero=_mm_setzero_si128();
+	__m128i round=_mm_set1_epi32(32768);
+	
+	/* Interleave the components for multiply-add: */
+	__m128i yuLo=_mm_unpacklo_epi16(y,u);
+	__m128i yuHi=_mm_unpackhi_epi16(y,u);
+	__m128i yvLo=_mm_unpacklo_epi16(y,v);
+	__m128i yvHi=_mm_unpackhi_epi16(y,v);
+	__m128i v2Lo=_mm_unpacklo_epi16(v,_mm_set1_epi16(2));
+	__m128i v2Hi=_mm_unpackhi_epi16(v,_mm_set1_epi16(2));
+	
+	/* R=76309*y+104597*v: */
+	__m128i h=_mm_add_epi16(y,_mm_add_epi16(v,v));
+	__m128i cr=coefficients(10773,-26475);
+	__m128i lo=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yvLo,cr),round),_mm_unpacklo_epi16(zero,h));
+	__m128i hi=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yvHi,cr),round),_mm_unpackhi_epi16(zero,h));
+	r=clampFixed16(lo,hi);
+	
+	/* G=76309*y-25675*u-53279*v: */
+	h=_mm_sub_epi16(y,v);
+	__m128i cg1=coefficients(10773,-25675);
+	__m128i cg2=coefficients(12257,16384);
+	lo=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo,cg1),_mm_madd_epi16(v2Lo,cg2)),_mm_unpacklo_epi16(zero,h));
+	hi=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi,cg1),_mm_madd_epi16(v2Hi,cg2)),_mm_unpackhi_epi16(zero,h));
+	g=clampFixed16(lo,hi);
+	
+	/* B=76309*y+132202*u: */
+	h=_mm_add_epi16(y,_mm_add_epi16(u,u));
+	__m128i cb=coefficients(10773,1130);
+	lo=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo,cb),round),_mm_unpacklo_epi16(zero,h));
+	hi=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi,cb),round),_mm_unpackhi_epi16(zero,h));
+	b=clampFixed16(lo,hi);
+	
+	/* Pack the components to bytes: */
+	r=_mm_packus_epi16(r,r);
+	g=_mm_packus_epi16(g,g);
+	b=_mm_packus_epi16(b,b);
+	}
+
+inline void rgbToYpcbcr8(__m128i r,__m128i g,__m128i b,__m128i& yp,__m128i& cb,__m128i& cr) // Converts eight 16-bit RGB pixels to 16-bit Y'CbCr
+	{
+	__m128i zero=_mm_setzero_si128();
+	__m128i rgLo=_mm_unpacklo_epi16(r,g);
+	__m128i rgHi=_mm_unpackhi_epi16(r,g);
+	__m128i bgLo=_mm_unpacklo_epi16(b,g);
+	__m128i bgHi=_mm_unpackhi_epi16(b,g);
+	__m128i bzLo=_mm_unpacklo_epi16(b,zero);
+	__m128i bzHi=_mm_unpackhi_epi16(b,zero);
+	
+	/* Y'=1048576+16829*r+33039*g+6416*b: */
+	__m128i c1=coefficients(16829,16384);
+	__m128i c2=coefficients(6416,16655);
+	__m128i offset=_mm_set1_epi32(1048576+32768);
+	__m128i lo=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgLo,c1),_mm_madd_epi16(bgLo,c2)),offset);
+	__m128i hi=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgHi,c1),_mm_madd_epi16(bgHi,c2)),offset);
+	yp=clampFixed16(lo,hi);
+	
+	/* Cb=8388608-9714*r-19071*g+28784*b: */
+	c1=coefficients(-9714,-19071);
+	c2=coefficients(28784,0);
+	offset=_mm_set1_epi32(8388608+32768);
+	lo=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgLo,c1),_mm_madd_epi16(bzLo,c2)),offset);
+	hi=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgHi,c1),_mm_madd_epi16(bzHi,c2)),offset);
+	cb=clampFixed16(lo,hi);
+	
+	/* Cr=8388608+28784*r-24103*g-4681*b: */
+	c1=coefficients(28784,-24103);
+	c2=coefficients(-4681,0);
+	lo=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgLo,c1),_mm_madd_epi16(bzLo,c2)),offset);
+	hi=_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgHi,c1),_mm_madd_epi16(bzHi,c2)),offset);
+	cr=clampFixed16(lo,hi);
+	}
+
+inline __m128i avg4(__m128i v1,__m128i v2,__m128i v3,__m128i v4) // Returns the rounded averages of four vectors of bytes
+	{
+	__m128i zero=_mm_setzero_si128();
+	__m128i two=_mm_set1_epi16(2);
+	__m128i lo=_mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(v1,zero),_mm_unpacklo_epi8(v2,zero)),_mm_add_epi16(_mm_unpacklo_epi8(v3,zero),_mm_unpacklo_epi8(v4,zero)));
+	__m128i hi=_mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(v1,zero),_mm_unpackhi_epi8(v2,zero)),_mm_add_epi16(_mm_unpackhi_epi8(v3,zero),_mm_unpackhi_epi8(v4,zero)));
+	return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo,two),2),_mm_srli_epi16(_mm_add_epi16(hi,two),2));
+	}
+
+inline __m128i select(__m128i mask,__m128i v1,__m128i v2) // Returns bytes from the first vector where the mask is set, and from the second vector otherwise
+	{
+	return _mm_or_si128(_mm_and_si128(mask,v1),_mm_andnot_si128(mask,v2));
+	}
+
+inline void bayerToRgb16(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,__m128i primaryMask,__m128i& r,__m128i& g,__m128i& b) // Interpolates sixteen raw pixels
+	{
+	/* Load the pixels and their neighbors: */
+	const __m128i* up=reinterpret_cast<const __m128i*>(raw-stride);
+	const __m128i* center=reinterpret_cast<const __m128i*>(raw);
+	const __m128i* down=reinterpret_cast<const __m128i*>(raw+stride);
+	__m128i c=_mm_loadu_si128(center);
+	__m128i left=_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw-1));
+	__m128i right=_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw+1));
+	__m128i u=_mm_loadu_si128(up);
+	__m128i d=_mm_loadu_si128(down);
+	
+	/* Interpolate all colors at all pixels: */
+	__m128i horizontal=_mm_avg_epu8(left,right);
+	__m128i vertical=_mm_avg_epu8(u,d);
+	__m128i cross=avg4(u,left,right,d);
+	__m128i diagonal=avg4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw-stride-1)),_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw-stride+1)),_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw+stride-1)),_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw+stride+1)));
+	
+	/* Select the primary, green, and secondary colors based on each pixel's color: */
+	__m128i p=select(primaryMask,c,horizontal);
+	g=select(primaryMask,cross,c);
+	__m128i s=select(primaryMask,diagonal,vertical);
+	r=primaryRed?p:s;
+	b=primaryRed?s:p;
+	}
+
+/************
+SSE2 kernels:
+************/
+
+void ypToYSSE2(const unsigned char* yp,unsigned char* y,unsigned int width)
+	{
+	__m128i zero=_mm_setzero_si128();
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		__m128i v=_mm_loadu_si128(reinterpret_cast<const __m128i*>(yp+x));
+		__m128i lo=ypToY16(_mm_unpacklo_epi8(v,zero));
+		__m128i hi=ypToY16(_mm_unpackhi_epi8(v,zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(y+x),_mm_packus_epi16(lo,hi));
+		}
+	if(x<width)
+		fallback.ypToY(yp+x,y+x,width-x);
+	}
+
+void ypcbcr422ToYSSE2(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,unsigned char* y,unsigned int width)
+	{
+	__m128i mask=_mm_set1_epi16(0xff);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		__m128i v0=_mm_loadu_si128(reinterpret_cast<const __m128i*>(ypcbcr+x*2));
+		__m128i v1=_mm_loadu_si128(reinterpret_cast<const __m128i*>(ypcbcr+x*2+16));
+		if(pixelOrder==ColorspaceKernels::UYVY)
+			{
+			v0=_mm_srli_epi16(v0,8);
+			v1=_mm_srli_epi16(v1,8);
+			}
+		else
+			{
+			v0=_mm_and_si128(v0,mask);
+			v1=_mm_and_si128(v1,mask);
+			}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(y+x),_mm_packus_epi16(ypToY16(v0),ypToY16(v1)));
+		}
+	if(x<width)
+		fallback.ypcbcr422ToY(ypcbcr+x*2,pixelOrder,y+x,width-x);
+	}
+
+void ypcbcr422ToRgbSSE2(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,unsigned char* rgb,unsigned int width)
+	{
+	__m128i mask=_mm_set1_epi16(0xff);
+	__m128i yOffset=_mm_set1_epi16(16);
+	__m128i cOffset=_mm_set1_epi16(128);
+	unsigned int x;
+	for(x=0;x+8<=width;x+=8)
+		{
+		/* Separate the Y' and chroma values: */
+		__m128i v=_mm_loadu_si128(reinterpret_cast<const __m128i*>(ypcbcr+x*2));
+		__m128i yp,c;
+		if(pixelOrder==ColorspaceKernels::UYVY)
+			{
+			yp=_mm_srli_epi16(v,8);
+			c=_mm_and_si128(v,mask);
+			}
+		else
+			{
+			yp=_mm_and_si128(v,mask);
+			c=_mm_srli_epi16(v,8);
+			}
+		
+		/* Replicate each pixel pair's chroma values and convert to YUV: */
+		__m128i y=_mm_sub_epi16(yp,yOffset);
+		__m128i u=_mm_sub_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(c,_MM_SHUFFLE(2,2,0,0)),_MM_SHUFFLE(2,2,0,0)),cOffset);
+		__m128i w=_mm_sub_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(c,_MM_SHUFFLE(3,3,1,1)),_MM_SHUFFLE(3,3,1,1)),cOffset);
+		
+		/* Convert to RGB: */
+		__m128i r,g,b;
+		yuvToRgb8(y,u,w,r,g,b);
+		storeRgb8(rgb+x*3,r,g,b);
+		}
+	if(x<width)
+		fallback.ypcbcr422ToRgb(ypcbcr+x*2,pixelOrder,rgb+x*3,width-x);
+	}
+
+void ypcbcr422ToYpCSSE2(const unsigned char* ypcbcr,ColorspaceKernels::PixelOrder422 pixelOrder,int chroma,unsigned char* yp,unsigned char* c,unsigned int width)
+	{
+	__m128i mask=_mm_set1_epi16(0xff);
+	__m128i cMask=_mm_set1_epi32(0xffff);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		/* Separate the Y' and chroma values: */
+		__m128i v0=_mm_loadu_si128(reinterpret_cast<const __m128i*>(ypcbcr+x*2));
+		__m128i v1=_mm_loadu_si128(reinterpret_cast<const __m128i*>(ypcbcr+x*2+16));
+		__m128i yp0,yp1,c0,c1;
+		if(pixelOrder==ColorspaceKernels::UYVY)
+			{
+			yp0=_mm_srli_epi16(v0,8);
+			yp1=_mm_srli_epi16(v1,8);
+			c0=_mm_and_si128(v0,mask);
+			c1=_mm_and_si128(v1,mask);
+			}
+		else
+			{
+			yp0=_mm_and_si128(v0,mask);
+			yp1=_mm_and_si128(v1,mask);
+			c0=_mm_srli_epi16(v0,8);
+			c1=_mm_srli_epi16(v1,8);
+			}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(yp+x),_mm_packus_epi16(yp0,yp1));
+		
+		/* Keep the requested chroma values: */
+		if(chroma!=0)
+			{
+			c0=_mm_srli_epi32(c0,16);
+			c1=_mm_srli_epi32(c1,16);
+			}
+		else
+			{
+			c0=_mm_and_si128(c0,cMask);
+			c1=_mm_and_si128(c1,cMask);
+			}
+		c0=_mm_packs_epi32(c0,c1);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(c+x/2),_mm_packus_epi16(c0,c0));
+		}
+	if(x<width)
+		fallback.ypcbcr422ToYpC(ypcbcr+x*2,pixelOrder,chroma,yp+x,c+x/2,width-x);
+	}
+
+void ypcbcr420ToRgbSSE2(const unsigned char* yp,const unsigned char* cb,const unsigned char* cr,unsigned char* rgb,unsigned int width)
+	{
+	__m128i zero=_mm_setzero_si128();
+	__m128i yOffset=_mm_set1_epi16(16);
+	__m128i cOffset=_mm_set1_epi16(128);
+	unsigned int x;
+	for(x=0;x+8<=width;x+=8)
+		{
+		/* Load eight Y' values and replicate four Cb and Cr values each: */
+		__m128i y=_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(yp+x)),zero),yOffset);
+		int cbs,crs;
+		memcpy(&cbs,cb+x/2,4);
+		memcpy(&crs,cr+x/2,4);
+		__m128i u=_mm_unpacklo_epi8(_mm_cvtsi32_si128(cbs),zero);
+		u=_mm_sub_epi16(_mm_unpacklo_epi16(u,u),cOffset);
+		__m128i v=_mm_unpacklo_epi8(_mm_cvtsi32_si128(crs),zero);
+		v=_mm_sub_epi16(_mm_unpacklo_epi16(v,v),cOffset);
+		
+		/* Convert to RGB: */
+		__m128i r,g,b;
+		yuvToRgb8(y,u,v,r,g,b);
+		storeRgb8(rgb+x*3,r,g,b);
+		}
+	if(x<width)
+		fallback.ypcbcr420ToRgb(yp+x,cb+x/2,cr+x/2,rgb+x*3,width-x);
+	}
+
+void rgbToGreySSE2(const unsigned char* rgb,unsigned char* grey,unsigned int width)
+	{
+	__m128i zero=_mm_setzero_si128();
+	__m128i c1=coefficients(306,601);
+	__m128i c2=coefficients(117,0);
+	unsigned int x;
+	for(x=0;x+8<=width;x+=8)
+		{
+		__m128i r,g,b;
+		loadRgb8(rgb+x*3,r,g,b);
+		__m128i lo=_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r,g),c1),_mm_madd_epi16(_mm_unpacklo_epi16(b,zero),c2));
+		__m128i hi=_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r,g),c1),_mm_madd_epi16(_mm_unpackhi_epi16(b,zero),c2));
+		__m128i result=_mm_packs_epi32(_mm_srli_epi32(lo,10),_mm_srli_epi32(hi,10));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(grey+x),_mm_packus_epi16(result,result));
+		}
+	if(x<width)
+		fallback.rgbToGrey(rgb+x*3,grey+x,width-x);
+	}
+
+void rgbToYpcbcr420SSE2(const unsigned char* rgb0,const unsigned char* rgb1,unsigned char* yp0,unsigned char* yp1,unsigned char* cb,unsigned char* cr,unsigned int width)
+	{
+	__m128i one=_mm_set1_epi16(1);
+	__m128i two=_mm_set1_epi32(2);
+	unsigned int x;
+	for(x=0;x+8<=width;x+=8)
+		{
+		/* Convert eight pixels from each row: */
+		__m128i r,g,b,y0,cb0,cr0,y1,cb1,cr1;
+		loadRgb8(rgb0+x*3,r,g,b);
+		rgbToYpcbcr8(r,g,b,y0,cb0,cr0);
+		loadRgb8(rgb1+x*3,r,g,b);
+		rgbToYpcbcr8(r,g,b,y1,cb1,cr1);
+		
+		/* Store the Y' values: */
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(yp0+x),_mm_packus_epi16(y0,y0));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(yp1+x),_mm_packus_epi16(y1,y1));
+		
+		/* Average the chroma values of each 2x2 pixel block: */
+		__m128i c=_mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_add_epi16(cb0,cb1),one),two),2);
+		c=_mm_packs_epi32(c,c);
+		int cs=_mm_cvtsi128_si32(_mm_packus_epi16(c,c));
+		memcpy(cb+x/2,&cs,4);
+		c=_mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_add_epi16(cr0,cr1),one),two),2);
+		c=_mm_packs_epi32(c,c);
+		cs=_mm_cvtsi128_si32(_mm_packus_epi16(c,c));
+		memcpy(cr+x/2,&cs,4);
+		}
+	if(x<width)
+		fallback.rgbToYpcbcr420(rgb0+x*3,rgb1+x*3,yp0+x,yp1+x,cb+x/2,cr+x/2,width-x);
+	}
+
+void bayerToRgbSSE2(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* rgb,unsigned int width)
+	{
+	__m128i primaryMask=_mm_set1_epi16(firstPrimary?0x00ff:0xff00);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		__m128i r,g,b;
+		bayerToRgb16(raw+x,stride,primaryRed,primaryMask,r,g,b);
+		storeRgb16(rgb+x*3,r,g,b);
+		}
+	if(x<width)
+		fallback.bayerToRgb(raw+x,stride,primaryRed,firstPrimary,rgb+x*3,width-x);
+	}
+
+void bayerToGreySSE2(const unsigned char* raw,ptrdiff_t stride,bool primaryRed,bool firstPrimary,unsigned char* grey,unsigned int width)
+	{
+	__m128i primaryMask=_mm_set1_epi16(firstPrimary?0x00ff:0xff00);
+	__m128i zero=_mm_setzero_si128();
+	__m128i c1=coefficients(306,601);
+	__m128i c2=coefficients(117,512);
+	__m128i one=_mm_set1_epi16(1);
+	unsigned int x;
+	for(x=0;x+16<=width;x+=16)
+		{
+		__m128i r,g,b;
+		bayerToRgb16(raw+x,stride,primaryRed,primaryMask,r,g,b);
+		
+		/* Convert the interpolated pixels to grey: */
+		__m128i rLo=_mm_unpacklo_epi8(r,zero);
+		__m128i gLo=_mm_unpacklo_epi8(g,zero);
+		__m128i bLo=_mm_unpacklo_epi8(b,zero);
+		__m128i rHi=_mm_unpackhi_epi8(r,zero);
+		__m128i gHi=_mm_unpackhi_epi8(g,zero);
+		__m128i bHi=_mm_unpackhi_epi8(b,zero);
+		__m128i s0=_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(rLo,gLo),c1),_mm_madd_epi16(_mm_unpacklo_epi16(bLo,one),c2));
+		__m128i s1=_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(rLo,gLo),c1),_mm_madd_epi16(_mm_unpackhi_epi16(bLo,one),c2));
+		__m128i s2=_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(rHi,gHi),c1),_mm_madd_epi16(_mm_unpacklo_epi16(bHi,one),c2));
+		__m128i s3=_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(rHi,gHi),c1),_mm_madd_epi16(_mm_unpackhi_epi16(bHi,one),c2));
+		__m128i lo=_mm_packs_epi32(_mm_srli_epi32(s0,10),_mm_srli_epi32(s1,10));
+		__m128i hi=_mm_packs_epi32(_mm_srli_epi32(s2,10),_mm_srli_epi32(s3,10));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(grey+x),_mm_packus_epi16(lo,hi));
+		}
+	if(x<width)
+		fallback.bayerToGrey(raw+x,stride,primaryRed,firstPrimary,grey+x,width-x);
+	}
+
+}
+
+/*********************************
+Initialization of the SSE2 kernels:
+*********************************/
+
+void initColorspaceKernelsSSE2(ColorspaceKernels& kernels)
+	{
+	/* Remember the given kernels to process left-over pixels: */
+	fallback=kernels;
+	
+	kernels.instructionSet=ColorspaceKernels::SSE2;
+	kernels.ypToY=ypToYSSE2;
+	kernels.ypcbcr422ToY=ypcbcr422ToYSSE2;
+	kernels.ypcbcr422ToRgb=ypcbcr422ToRgbSSE2;
+	kernels.ypcbcr422ToYpC=ypcbcr422ToYpCSSE2;
+	kernels.ypcbcr420ToRgb=ypcbcr420ToRgbSSE2;
+	kernels.rgbToGrey=rgbToGreySSE2;
+	kernels.rgbToYpcbcr420=rgbToYpcbcr420SSE2;
+	kernels.bayerToRgb=bayerToRgbSSE2;
+	kernels.bayerToGrey=bayerToGreySSE2;
+	}
+
+}
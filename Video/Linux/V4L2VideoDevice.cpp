@@ -55,6 +55,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Video/ImageExtractorY10B.h>
 #include <Video/ImageExtractorYUYV.h>
 #include <Video/ImageExtractorUYVY.h>
+#include <Video/ImageExtractorYV12.h>
 #include <Video/ImageExtractorBA81.h>
 #if IMAGES_CONFIG_HAVE_JPEG
 #include <Video/ImageExtractorMJPG.h>
@@ -498,6 +499,18 @@ ImageExtractor* V4L2VideoDevice::createImageExtractor(void) const
 		return new ImageExtractorYUYV(format.size);
 	else if(format.isPixelFormat("UYVY"))
 		return new ImageExtractorUYVY(format.size);
+	else if(format.isPixelFormat("YV12")||format.isPixelFormat("YU12"))
+		{
+		/* Calculate the layout of the Y', Cb, and Cr planes; YV12 stores the Cr plane before the Cb plane: */
+		ptrdiff_t ypStride=ptrdiff_t(format.lineSize);
+		ptrdiff_t cStride=ypStride/2;
+		ptrdiff_t c0Offset=ypStride*ptrdiff_t(format.size[1]);
+		ptrdiff_t c1Offset=c0Offset+cStride*ptrdiff_t(format.size[1]/2);
+		if(format.isPixelFormat("YV12"))
+			return new ImageExtractorYV12(format.size,0,ypStride,c1Offset,cStride,c0Offset,cStride);
+		else
+			return new ImageExtractorYV12(format.size,0,ypStride,c0Offset,cStride,c1Offset,cStride);
+		}
 	else if(format.isPixelFormat("GRBG"))
 		return new ImageExtractorBA81(format.size,BAYER_GRBG);
 	#if IMAGES_CONFIG_HAVE_JPEG
@@ -0,0 +1,296 @@
+/***********************************************************************
+ColorspaceKernelBenchmark - Program to check the SIMD colorspace
+conversion kernels against the scalar kernels on random rows, and to
+measure the throughput of all kernels supported by the host CPU.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Video/Internal/ColorspaceKernels.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+enum Kernel // Enumerated type for the benchmarked conversions
+	{
+	YP_TO_Y=0,YUYV_TO_Y,YUYV_TO_RGB,UYVY_TO_RGB,YUYV_TO_YPC,YPCBCR420_TO_RGB,
+	RGB_TO_GREY,RGB_TO_YPCBCR420,
+	BAYER_TO_RGB,BAYER_TO_GREY,BAYER_TO_RGB_EDGE,BAYER_TO_GREY_EDGE,
+	NUM_KERNELS
+	};
+
+static const char* kernelNames[NUM_KERNELS]=
+	{
+	"Y' to Y","YUYV to Y","YUYV to RGB","UYVY to RGB","YUYV to Y'/Cb","Y'CbCr 4:2:0 to RGB",
+	"RGB to grey","RGB to Y'CbCr 4:2:0",
+	"Bayer to RGB","Bayer to grey","Bayer to RGB (edge)","Bayer to grey (edge)"
+	};
+
+static const char* instructionSetNames[3]=
+	{
+	"Scalar","SSE2","AVX2"
+	};
+
+struct Buffers // Structure holding input and output rows for a maximum row width
+	{
+	/* Elements: */
+	public:
+	unsigned int maxWidth; // Maximum width of a row in pixels
+	ptrdiff_t stride; // Distance between adjacent input rows for Bayer kernels
+	size_t inputSize,outputSize; // Sizes of the input and output buffers in bytes
+	unsigned char* input; // Three rows of random input data
+	unsigned char* outputs[4]; // Output rows
+	
+	/* Constructors and destructors: */
+	Buffers(unsigned int sMaxWidth)
+		:maxWidth(sMaxWidth),
+		 stride(ptrdiff_t(sMaxWidth)*3+64),
+		 inputSize(size_t(stride)*3),outputSize(size_t(sMaxWidth)*3+64),
+		 input(new unsigned char[inputSize])
+		{
+		for(int i=0;i<4;++i)
+			outputs[i]=new unsigned char[outputSize];
+		}
+	~Buffers(void)
+		{
+		delete[] input;
+		for(int i=0;i<4;++i)
+			delete[] outputs[i];
+		}
+	
+	/* Methods: */
+	void randomize(unsigned int& seed) // Fills the input rows with random data
+		{
+		for(size_t i=0;i<inputSize;++i)
+			input[i]=(unsigned char)(rand_r(&seed)&0xff);
+		}
+	void clearOutputs(void) // Clears the output rows
+		{
+		for(int i=0;i<4;++i)
+			memset(outputs[i],0,outputSize);
+		}
+	};
+
+void runKernel(const Video::ColorspaceKernels& kernels,Kernel kernel,const Buffers& b,unsigned int width) // Runs the given kernel on a row of the given width
+	{
+	const unsigned char* in=b.input;
+	const unsigned char* in2=b.input+b.stride;
+	const unsigned char* in3=b.input+b.stride*2;
+	unsigned char** out=const_cast<unsigned char**>(b.outputs);
+	switch(kernel)
+		{
+		case YP_TO_Y:
+			kernels.ypToY(in,out[0],width);
+			break;
+		
+		case YUYV_TO_Y:
+			kernels.ypcbcr422ToY(in,Video::ColorspaceKernels::YUYV,out[0],width);
+			break;
+		
+		case YUYV_TO_RGB:
+			kernels.ypcbcr422ToRgb(in,Video::ColorspaceKernels::YUYV,out[0],width);
+			break;
+		
+		case UYVY_TO_RGB:
+			kernels.ypcbcr422ToRgb(in,Video::ColorspaceKernels::UYVY,out[0],width);
+			break;
+		
+		case YUYV_TO_YPC:
+			kernels.ypcbcr422ToYpC(in,Video::ColorspaceKernels::YUYV,0,out[0],out[1],width);
+			kernels.ypcbcr422ToYpC(in,Video::ColorspaceKernels::YUYV,1,out[2],out[3],width);
+			break;
+		
+		case YPCBCR420_TO_RGB:
+			kernels.ypcbcr420ToRgb(in,in2,in3,out[0],width);
+			break;
+		
+		case RGB_TO_GREY:
+			kernels.rgbToGrey(in,out[0],width);
+			break;
+		
+		case RGB_TO_YPCBCR420:
+			kernels.rgbToYpcbcr420(in,in2,out[0],out[1],out[2],out[3],width);
+			break;
+		
+		/* Bayer kernels interpolate interior pixels, and read one pixel to either side and one row above and below: */
+		case BAYER_TO_RGB:
+			kernels.bayerToRgb(in2+1,b.stride,true,true,out[0],width);
+			kernels.bayerToRgb(in2+1,b.stride,false,false,out[1],width);
+			break;
+		
+		case BAYER_TO_GREY:
+			kernels.bayerToGrey(in2+1,b.stride,true,true,out[0],width);
+			kernels.bayerToGrey(in2+1,b.stride,false,false,out[1],width);
+			break;
+		
+		case BAYER_TO_RGB_EDGE:
+			kernels.bayerToRgbEdgeAware(in2+1,b.stride,true,true,out[0],width);
+			kernels.bayerToRgbEdgeAware(in2+1,b.stride,false,false,out[1],width);
+			break;
+		
+		case BAYER_TO_GREY_EDGE:
+			kernels.bayerToGreyEdgeAware(in2+1,b.stride,true,true,out[0],width);
+			kernels.bayerToGreyEdgeAware(in2+1,b.stride,false,false,out[1],width);
+			break;
+		
+		default:
+			;
+		}
+	}
+
+int compareOutputs(const Buffers& b1,const Buffers& b2,size_t& numDifferences) // Returns the maximum absolute difference between the output rows of the two buffers
+	{
+	int maxDiff=0;
+	for(int i=0;i<4;++i)
+		for(size_t j=0;j<b1.outputSize;++j)
+			{
+			int diff=abs(int(b1.outputs[i][j])-int(b2.outputs[i][j]));
+			if(diff!=0)
+				++numDifferences;
+			if(maxDiff<diff)
+				maxDiff=diff;
+			}
+	return maxDiff;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	unsigned int width=1920;
+	unsigned int numTestRows=2000;
+	unsigned int numBenchmarkRows=20000;
+	int maxAllowedDiff=0;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"width")==0&&i+1<argc)
+				{
+				width=(unsigned int)(atoi(argv[i+1]))&~0x1U;
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"testRows")==0&&i+1<argc)
+				{
+				numTestRows=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"rows")==0&&i+1<argc)
+				{
+				numBenchmarkRows=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"tolerance")==0&&i+1<argc)
+				{
+				maxAllowedDiff=atoi(argv[i+1]);
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-width <row width in pixels>] [-testRows <number of random rows to compare>] [-rows <number of rows to time>] [-tolerance <maximum allowed difference in LSB>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	if(width<2)
+		width=2;
+	
+	/* Collect the kernel sets supported by the host CPU: */
+	const Video::ColorspaceKernels* kernelSets[3];
+	int numKernelSets=0;
+	for(int i=0;i<3;++i)
+		{
+		const Video::ColorspaceKernels& kernels=Video::ColorspaceKernels::get(Video::ColorspaceKernels::InstructionSet(i));
+		if(kernels.instructionSet==Video::ColorspaceKernels::InstructionSet(i))
+			kernelSets[numKernelSets++]=&kernels;
+		}
+	
+	/* Compare the SIMD kernels to the scalar kernels on random rows of random even widths: */
+	std::cout<<"Comparing "<<numTestRows<<" random rows of up to "<<width<<" pixels against scalar kernels"<<std::endl;
+	std::cout<<"Kernel                Set       MaxDiff   Differences  Result"<<std::endl;
+	Buffers reference(width);
+	Buffers result(width);
+	bool ok=true;
+	for(int kernel=0;kernel<NUM_KERNELS;++kernel)
+		for(int set=1;set<numKernelSets;++set)
+			{
+			unsigned int seed=1U;
+			int maxDiff=0;
+			size_t numDifferences=0;
+			for(unsigned int row=0;row<numTestRows;++row)
+				{
+				reference.randomize(seed);
+				memcpy(result.input,reference.input,reference.inputSize);
+				unsigned int rowWidth=((unsigned int)(rand_r(&seed))%(width/2)+1)*2;
+				reference.clearOutputs();
+				result.clearOutputs();
+				runKernel(*kernelSets[0],Kernel(kernel),reference,rowWidth);
+				runKernel(*kernelSets[set],Kernel(kernel),result,rowWidth);
+				int diff=compareOutputs(reference,result,numDifferences);
+				if(maxDiff<diff)
+					maxDiff=diff;
+				}
+			bool kernelOk=maxDiff<=maxAllowedDiff;
+			ok=ok&&kernelOk;
+			std::cout<<std::setw(22)<<std::left<<kernelNames[kernel]<<std::setw(8)<<instructionSetNames[kernelSets[set]->instructionSet]<<std::right;
+			std::cout<<std::setw(9)<<maxDiff<<std::setw(14)<<numDifferences<<std::setw(8)<<(kernelOk?"ok":"FAILED")<<std::endl;
+			}
+	
+	/* Measure the throughput of all kernel sets on rows of the full width: */
+	std::cout<<std::endl<<"Converting "<<numBenchmarkRows<<" rows of "<<width<<" pixels; throughput in Mpixels/s"<<std::endl;
+	std::cout<<"Kernel               ";
+	for(int set=0;set<numKernelSets;++set)
+		std::cout<<std::setw(10)<<instructionSetNames[kernelSets[set]->instructionSet];
+	std::cout<<std::setw(10)<<"Speedup"<<std::endl;
+	unsigned int seed=1U;
+	reference.randomize(seed);
+	for(int kernel=0;kernel<NUM_KERNELS;++kernel)
+		{
+		std::cout<<std::setw(21)<<std::left<<kernelNames[kernel]<<std::right;
+		double scalarRate=0.0,rate=0.0;
+		for(int set=0;set<numKernelSets;++set)
+			{
+			Misc::Time startTime=Misc::Time::now();
+			for(unsigned int row=0;row<numBenchmarkRows;++row)
+				runKernel(*kernelSets[set],Kernel(kernel),reference,width);
+			double elapsed=toSeconds(Misc::Time::now()-startTime);
+			
+			/* Kernels converting two rows per call count both rows' pixels: */
+			double numPixels=double(numBenchmarkRows)*double(width);
+			if(kernel==YUYV_TO_YPC||kernel==RGB_TO_YPCBCR420||kernel>=BAYER_TO_RGB)
+				numPixels*=2.0;
+			rate=numPixels/(elapsed*1.0e6);
+			if(set==0)
+				scalarRate=rate;
+			std::cout<<std::setw(10)<<std::fixed<<std::setprecision(1)<<rate;
+			}
+		std::cout<<std::setw(10)<<std::setprecision(2)<<rate/scalarRate<<std::endl;
+		}
+	
+	return ok?0:1;
+	}
@@ -0,0 +1,226 @@
+/***********************************************************************
+DemosaicingBenchmark - Program to check that the Bayer image extractor
+produces identical output for any number of worker threads, to compare
+the quality of bilinear and edge-aware demosaicing on a synthetic image,
+and to measure the throughput of both demosaicing methods.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Threads/TaskScheduler.h>
+#include <Video/FrameBuffer.h>
+#include <Video/BayerPattern.h>
+#include <Video/ImageExtractorBA81.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+static const char* modeNames[Video::ImageExtractorBA81::NUM_DEMOSAICINGMODES]=
+	{
+	"Bilinear","Edge-aware"
+	};
+
+void createTestImage(const unsigned int size[2],std::vector<unsigned char>& image) // Creates a top-down RGB image with smooth gradients and sharp edges
+	{
+	image.resize(size_t(size[0])*size_t(size[1])*3);
+	unsigned char* iPtr=&image[0];
+	for(unsigned int y=0;y<size[1];++y)
+		for(unsigned int x=0;x<size[0];++x,iPtr+=3)
+			{
+			/* Start with smooth color gradients: */
+			double c[3];
+			c[0]=128.0+60.0*sin(double(x)*0.011);
+			c[1]=128.0+60.0*sin(double(y)*0.017+1.0);
+			c[2]=128.0+60.0*sin(double(x+y)*0.007+2.0);
+			
+			/* Overlay diagonal stripes and a checkerboard with sharp edges: */
+			if(((x+y*2)/24)%2==0)
+				for(int i=0;i<3;++i)
+					c[i]=c[i]*0.5;
+			if(((x/64)+(y/64))%2==0)
+				c[1]+=50.0;
+			
+			for(int i=0;i<3;++i)
+				iPtr[i]=(unsigned char)(c[i]<0.0?0.0:c[i]>255.0?255.0:c[i]+0.5);
+			}
+	}
+
+void mosaic(const unsigned int size[2],Video::BayerPattern bayerPattern,const std::vector<unsigned char>& image,std::vector<unsigned char>& raw) // Samples a top-down RGB image through the given Bayer pattern
+	{
+	raw.resize(size_t(size[0])*size_t(size[1]));
+	for(unsigned int y=0;y<size[1];++y)
+		for(unsigned int x=0;x<size[0];++x)
+			{
+			/* Find the color component sampled at the pixel: */
+			int component=1;
+			if(x%2==0&&y%2==0)
+				component=bayerPattern==Video::BAYER_RGGB?0:2;
+			else if(x%2==1&&y%2==1)
+				component=bayerPattern==Video::BAYER_RGGB?2:0;
+			raw[size_t(y)*size[0]+x]=image[(size_t(y)*size[0]+x)*3+component];
+			}
+	}
+
+double calcPsnr(const unsigned int size[2],const std::vector<unsigned char>& image,const std::vector<unsigned char>& result) // Returns the PSNR in dB of a bottom-up RGB result against a top-down RGB image, ignoring two-pixel borders
+	{
+	double sumSqrDiff=0.0;
+	size_t numSamples=0;
+	for(unsigned int y=2;y<size[1]-2;++y)
+		{
+		const unsigned char* iPtr=&image[(size_t(y)*size[0]+2)*3];
+		const unsigned char* rPtr=&result[(size_t(size[1]-1-y)*size[0]+2)*3];
+		for(unsigned int x=2;x<size[0]-2;++x)
+			for(int i=0;i<3;++i,++iPtr,++rPtr)
+				{
+				double diff=double(*iPtr)-double(*rPtr);
+				sumSqrDiff+=diff*diff;
+				++numSamples;
+				}
+		}
+	if(sumSqrDiff==0.0)
+		return 99.0;
+	return 10.0*log10(255.0*255.0*double(numSamples)/sumSqrDiff);
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	unsigned int size[2]={1920,1080};
+	unsigned int maxNumThreads=Threads::TaskScheduler::getNumProcessors();
+	int numPasses=10;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"size")==0&&i+2<argc)
+				{
+				for(int j=0;j<2;++j)
+					size[j]=(unsigned int)(atoi(argv[i+1+j]))&~0x1U;
+				i+=2;
+				}
+			else if(strcasecmp(argv[i]+1,"threads")==0&&i+1<argc)
+				{
+				maxNumThreads=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"passes")==0&&i+1<argc)
+				{
+				numPasses=atoi(argv[i+1]);
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-size <frame width> <frame height>] [-threads <maximum number of worker threads>] [-passes <number of timed extractions>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	for(int i=0;i<2;++i)
+		if(size[i]<8)
+			size[i]=8;
+	if(maxNumThreads<1)
+		maxNumThreads=1;
+	if(numPasses<1)
+		numPasses=1;
+	
+	/* Create the synthetic test image: */
+	std::vector<unsigned char> image;
+	createTestImage(size,image);
+	size_t numPixels=size_t(size[0])*size_t(size[1]);
+	std::vector<unsigned char> reference(numPixels*3),referenceGrey(numPixels);
+	std::vector<unsigned char> result(numPixels*3),resultGrey(numPixels);
+	
+	std::cout<<"Demosaicing "<<size[0]<<"x"<<size[1]<<" frames; times are the shortest of "<<numPasses<<" extractions"<<std::endl;
+	std::cout<<"Pattern  Mode        PSNR  Threads  RGB ms  Mpixels/s  Result"<<std::endl;
+	bool ok=true;
+	static const Video::BayerPattern bayerPatterns[2]={Video::BAYER_RGGB,Video::BAYER_BGGR};
+	static const char* bayerPatternNames[2]={"RGGB","BGGR"};
+	for(int pattern=0;pattern<2;++pattern)
+		{
+		/* Create a raw frame: */
+		std::vector<unsigned char> raw;
+		mosaic(size,bayerPatterns[pattern],image,raw);
+		Video::FrameBuffer frame;
+		frame.start=&raw[0];
+		frame.size=frame.used=raw.size();
+		
+		Video::ImageExtractorBA81 extractor(size,bayerPatterns[pattern]);
+		for(int mode=0;mode<Video::ImageExtractorBA81::NUM_DEMOSAICINGMODES;++mode)
+			{
+			/* Extract reference images in the calling thread: */
+			extractor.setTaskScheduler(0);
+			extractor.setDemosaicingMode(Video::ImageExtractorBA81::DemosaicingMode(mode));
+			extractor.extractRGB(&frame,&reference[0]);
+			extractor.extractGrey(&frame,&referenceGrey[0]);
+			double psnr=calcPsnr(size,image,reference);
+			
+			/* Extract with increasing numbers of worker threads: */
+			for(unsigned int numThreads=1;numThreads<=maxNumThreads;numThreads*=2)
+				{
+				Threads::TaskScheduler taskScheduler(numThreads);
+				extractor.setTaskScheduler(&taskScheduler);
+				
+				/* Check that the extracted images are identical to the reference images: */
+				memset(&result[0],0,result.size());
+				memset(&resultGrey[0],0,resultGrey.size());
+				extractor.extractRGB(&frame,&result[0]);
+				extractor.extractGrey(&frame,&resultGrey[0]);
+				bool match=result==reference&&resultGrey==referenceGrey;
+				
+				/* Measure the time to extract RGB images: */
+				double minTime=0.0;
+				for(int pass=0;pass<numPasses;++pass)
+					{
+					Misc::Time startTime=Misc::Time::now();
+					extractor.extractRGB(&frame,&result[0]);
+					double elapsed=toSeconds(Misc::Time::now()-startTime);
+					if(pass==0||minTime>elapsed)
+						minTime=elapsed;
+					}
+				
+				/* Check that estimating demosaicing costs does not change the extractor's state: */
+				double lastExtractionTime=extractor.getLastExtractionTime();
+				for(int costMode=0;costMode<Video::ImageExtractorBA81::NUM_DEMOSAICINGMODES;++costMode)
+					extractor.getDemosaicingCost(Video::ImageExtractorBA81::DemosaicingMode(costMode));
+				if(extractor.getDemosaicingMode()!=Video::ImageExtractorBA81::DemosaicingMode(mode)||extractor.getLastExtractionTime()!=lastExtractionTime)
+					match=false;
+				
+				ok=ok&&match;
+				std::cout<<std::setw(9)<<std::left<<bayerPatternNames[pattern]<<std::setw(10)<<modeNames[mode]<<std::right;
+				std::cout<<std::fixed<<std::setprecision(2)<<std::setw(7)<<psnr<<std::setw(9)<<numThreads;
+				std::cout<<std::setw(8)<<minTime*1.0e3<<std::setw(11)<<std::setprecision(1)<<double(numPixels)/(minTime*1.0e6);
+				std::cout<<std::setw(8)<<(match?"ok":"FAILED")<<std::endl;
+				}
+			}
+		}
+	
+	return ok?0:1;
+	}
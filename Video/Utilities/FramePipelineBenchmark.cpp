@@ -0,0 +1,429 @@
+/***********************************************************************
+FramePipelineBenchmark - Program to measure the number of copies and the
+latency per frame of the path from a video device to a Y'CbCr 4:2:0
+consumer through a frame pipeline, using a synthetic video device and
+no graphics hardware.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <deque>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Misc/ThrowStdErr.h>
+#include <Threads/MutexCond.h>
+#include <Threads/Thread.h>
+#include <Video/VideoDataFormat.h>
+#include <Video/FrameBuffer.h>
+#include <Video/VideoDevice.h>
+#include <Video/ImageExtractor.h>
+#include <Video/ImageExtractorYUYV.h>
+#include <Video/ImageExtractorYV12.h>
+#include <Video/FramePipeline.h>
+#include <Video/YpCbCr420Stage.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+/*********************************************************************
+Video device generating frames in YUYV or YV12 format in memory at a
+fixed rate, or as fast as frame buffers are returned:
+*********************************************************************/
+
+class SyntheticVideoDevice:public Video::VideoDevice
+	{
+	/* Elements: */
+	private:
+	Video::VideoDataFormat format; // The device's video format
+	double frameInterval; // Time between frames in seconds, or zero to deliver frames as fast as possible
+	std::vector<Video::FrameBuffer*> frameBuffers; // List of allocated frame buffers
+	Threads::MutexCond queueCond; // Condition variable to signal returned frame buffers
+	std::deque<Video::FrameBuffer*> captureQueue; // Queue of frame buffers ready to receive frames
+	bool streaming; // Flag whether the device is streaming; threads waiting for frame buffers give up when streaming stops
+	Misc::Time nextFrameTime; // Time at which to deliver the next frame
+	unsigned int frameIndex; // Index of the next delivered frame
+	unsigned int numStalls; // Number of times the device had to wait for a frame buffer to be returned
+	
+	/* Constructors and destructors: */
+	public:
+	SyntheticVideoDevice(const unsigned int sSize[2],const char* pixelFormat,double frameRate)
+		:frameInterval(frameRate>0.0?1.0/frameRate:0.0),
+		 streaming(false),
+		 frameIndex(0),numStalls(0)
+		{
+		format.setPixelFormat(pixelFormat);
+		for(int i=0;i<2;++i)
+			format.size[i]=sSize[i];
+		if(format.isPixelFormat("YV12"))
+			{
+			format.lineSize=format.size[0];
+			format.frameSize=format.size[0]*format.size[1]+(format.size[0]/2)*(format.size[1]/2)*2;
+			}
+		else
+			{
+			format.lineSize=format.size[0]*2;
+			format.frameSize=format.lineSize*format.size[1];
+			}
+		format.frameIntervalCounter=1;
+		format.frameIntervalDenominator=frameRate>0.0?(unsigned int)(frameRate+0.5):0;
+		}
+	virtual ~SyntheticVideoDevice(void)
+		{
+		releaseFrameBuffers();
+		}
+	
+	/* Methods from VideoDevice: */
+	virtual std::vector<Video::VideoDataFormat> getVideoFormatList(void) const
+		{
+		return std::vector<Video::VideoDataFormat>(1,format);
+		}
+	virtual Video::VideoDataFormat getVideoFormat(void) const
+		{
+		return format;
+		}
+	virtual Video::VideoDataFormat& setVideoFormat(Video::VideoDataFormat& newFormat)
+		{
+		newFormat=format;
+		return newFormat;
+		}
+	virtual Video::ImageExtractor* createImageExtractor(void) const
+		{
+		if(format.isPixelFormat("YV12"))
+			{
+			ptrdiff_t ySize=format.size[0]*format.size[1];
+			ptrdiff_t cSize=(format.size[0]/2)*(format.size[1]/2);
+			return new Video::ImageExtractorYV12(format.size,0,format.size[0],ySize+cSize,format.size[0]/2,ySize,format.size[0]/2);
+			}
+		else
+			return new Video::ImageExtractorYUYV(format.size);
+		}
+	virtual GLMotif::Widget* createControlPanel(GLMotif::WidgetManager* widgetManager)
+		{
+		return 0;
+		}
+	virtual unsigned int allocateFrameBuffers(unsigned int requestedNumFrameBuffers)
+		{
+		/* Create frame buffers containing a smooth test pattern: */
+		for(unsigned int i=0;i<requestedNumFrameBuffers;++i)
+			{
+			Video::FrameBuffer* frame=new Video::FrameBuffer;
+			frame->size=format.frameSize;
+			frame->start=new unsigned char[frame->size];
+			for(size_t j=0;j<frame->size;++j)
+				frame->start[j]=(unsigned char)((j*7U+i*13U)&0xffU);
+			frameBuffers.push_back(frame);
+			captureQueue.push_back(frame);
+			}
+		
+		return requestedNumFrameBuffers;
+		}
+	virtual void startStreaming(void)
+		{
+		Video::VideoDevice::startStreaming();
+		nextFrameTime=Misc::Time::now();
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		streaming=true;
+		}
+		}
+	virtual Video::FrameBuffer* dequeueFrame(void)
+		{
+		/* Wait until the next frame is due: */
+		if(frameInterval>0.0)
+			{
+			nextFrameTime.increment(frameInterval);
+			Misc::Time wait=nextFrameTime-Misc::Time::now();
+			if(wait.tv_sec>=0)
+				nanosleep(&wait,0);
+			}
+		
+		/* Wait until a frame buffer is available: */
+		Video::FrameBuffer* result;
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		if(streaming&&captureQueue.empty())
+			{
+			++numStalls;
+			while(streaming&&captureQueue.empty())
+				queueCond.wait(queueLock);
+			}
+		if(!streaming)
+			Misc::throwStdErr("SyntheticVideoDevice::dequeueFrame: Streaming was stopped");
+		result=captureQueue.front();
+		captureQueue.pop_front();
+		}
+		
+		/* "Capture" the frame by stamping its index into the buffer: */
+		memcpy(result->start,&frameIndex,sizeof(unsigned int));
+		++frameIndex;
+		result->used=result->size;
+		
+		return result;
+		}
+	virtual void enqueueFrame(Video::FrameBuffer* frame)
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		captureQueue.push_back(frame);
+		queueCond.signal();
+		}
+	virtual void stopStreaming(void)
+		{
+		/* Wake up a thread waiting for a frame buffer, as stopping a V4L2 device does: */
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		streaming=false;
+		queueCond.broadcast();
+		}
+		Video::VideoDevice::stopStreaming();
+		}
+	virtual void releaseFrameBuffers(void)
+		{
+		for(std::vector<Video::FrameBuffer*>::iterator fbIt=frameBuffers.begin();fbIt!=frameBuffers.end();++fbIt)
+			{
+			delete[] (*fbIt)->start;
+			delete *fbIt;
+			}
+		frameBuffers.clear();
+		captureQueue.clear();
+		}
+	
+	/* New methods: */
+	unsigned int getNumStalls(void) const
+		{
+		return numStalls;
+		}
+	};
+
+/*********************************************************************
+Image extractor hiding the planes of an underlying extractor, to force
+a copy for comparison:
+*********************************************************************/
+
+class CopyingImageExtractor:public Video::ImageExtractor
+	{
+	/* Elements: */
+	private:
+	Video::ImageExtractor* extractor; // The underlying image extractor
+	
+	/* Constructors and destructors: */
+	public:
+	CopyingImageExtractor(Video::ImageExtractor* sExtractor)
+		:extractor(sExtractor)
+		{
+		}
+	virtual ~CopyingImageExtractor(void)
+		{
+		delete extractor;
+		}
+	
+	/* Methods from ImageExtractor: */
+	virtual void extractGrey(const Video::FrameBuffer* frame,void* image)
+		{
+		extractor->extractGrey(frame,image);
+		}
+	virtual void extractRGB(const Video::FrameBuffer* frame,void* image)
+		{
+		extractor->extractRGB(frame,image);
+		}
+	virtual void extractYpCbCr420(const Video::FrameBuffer* frame,void* yp,unsigned int ypStride,void* cb,unsigned int cbStride,void* cr,unsigned int crStride)
+		{
+		extractor->extractYpCbCr420(frame,yp,ypStride,cb,cbStride,cr,crStride);
+		}
+	};
+
+/*********************************************************************
+Consumer thread standing in for a rendering thread uploading textures:
+*********************************************************************/
+
+struct Consumer
+	{
+	/* Elements: */
+	public:
+	Video::YpCbCr420Stage& stage; // Stage delivering frames
+	unsigned int size[2]; // Frame size
+	volatile bool keepRunning; // Flag to shut down the consumer thread
+	unsigned int numConsumedFrames; // Number of frames received by the consumer
+	double latencySum,maxLatency; // Sum and maximum of capture-to-consumer latencies in seconds
+	unsigned int checksum; // Checksum over all consumed frames, to keep the compiler from skipping reads
+	
+	/* Constructors and destructors: */
+	Consumer(Video::YpCbCr420Stage& sStage,const unsigned int sSize[2])
+		:stage(sStage),keepRunning(true),
+		 numConsumedFrames(0),latencySum(0.0),maxLatency(0.0),checksum(0)
+		{
+		for(int i=0;i<2;++i)
+			size[i]=sSize[i];
+		}
+	
+	/* Methods: */
+	void* threadMethod(void)
+		{
+		while(keepRunning)
+			{
+			if(stage.lockNewFrame())
+				{
+				const Video::YpCbCr420Stage::Planes& p=stage.getLockedFrame();
+				
+				/* Measure the frame's latency: */
+				double latency=toSeconds(Misc::Time::now()-p.captureTime);
+				latencySum+=latency;
+				if(maxLatency<latency)
+					maxLatency=latency;
+				++numConsumedFrames;
+				
+				/* Read all planes like a texture upload would: */
+				for(int i=0;i<3;++i)
+					{
+					unsigned int w=i==0?size[0]:size[0]/2;
+					unsigned int h=i==0?size[1]:size[1]/2;
+					const unsigned char* rowPtr=p.planes[i];
+					for(unsigned int y=0;y<h;++y,rowPtr+=p.strides[i])
+						for(unsigned int x=0;x<w;++x)
+							checksum+=rowPtr[x];
+					}
+				}
+			else
+				{
+				/* Wait a bit for the next frame: */
+				struct timespec wait;
+				wait.tv_sec=0;
+				wait.tv_nsec=100000;
+				nanosleep(&wait,0);
+				}
+			}
+		
+		return 0;
+		}
+	};
+
+void runBenchmark(const char* name,const unsigned int size[2],const char* pixelFormat,bool forceCopy,double frameRate,unsigned int numFrameBuffers,unsigned int numFrames)
+	{
+	/* Create the synthetic video device and the frame pipeline: */
+	SyntheticVideoDevice device(size,pixelFormat,frameRate);
+	device.allocateFrameBuffers(numFrameBuffers);
+	Video::ImageExtractor* extractor=device.createImageExtractor();
+	if(forceCopy)
+		extractor=new CopyingImageExtractor(extractor);
+	
+	{
+	Video::FramePipeline pipeline(device);
+	Video::YpCbCr420Stage stage(extractor,size);
+	pipeline.addStage(&stage);
+	
+	/* Start the consumer thread and capture the requested number of frames: */
+	Consumer consumer(stage,size);
+	Threads::Thread consumerThread;
+	consumerThread.start(&consumer,&Consumer::threadMethod);
+	Misc::Time startTime=Misc::Time::now();
+	pipeline.start();
+	while(pipeline.getNumCapturedFrames()<numFrames)
+		{
+		struct timespec wait;
+		wait.tv_sec=0;
+		wait.tv_nsec=1000000;
+		nanosleep(&wait,0);
+		}
+	pipeline.stop();
+	double elapsed=toSeconds(Misc::Time::now()-startTime);
+	consumer.keepRunning=false;
+	consumerThread.join();
+	
+	/* Print the results: */
+	double frameBytes=double(size[0])*double(size[1])*1.5;
+	unsigned int numDelivered=stage.getNumFrames();
+	std::cout<<std::setw(16)<<std::left<<name<<std::right;
+	std::cout<<std::setw(8)<<pipeline.getNumCapturedFrames();
+	std::cout<<std::setw(8)<<numDelivered;
+	std::cout<<std::setw(8)<<consumer.numConsumedFrames;
+	std::cout<<std::setw(10)<<std::fixed<<std::setprecision(2)<<double(stage.getNumCopiedFrames())/double(numDelivered);
+	std::cout<<std::setw(12)<<std::setprecision(0)<<double(stage.getNumCopiedFrames())*frameBytes/double(numDelivered);
+	std::cout<<std::setw(10)<<std::setprecision(3)<<(consumer.numConsumedFrames>0?consumer.latencySum*1000.0/double(consumer.numConsumedFrames):0.0);
+	std::cout<<std::setw(10)<<std::setprecision(3)<<consumer.maxLatency*1000.0;
+	std::cout<<std::setw(10)<<std::setprecision(1)<<double(pipeline.getNumCapturedFrames())/elapsed;
+	std::cout<<std::setw(8)<<device.getNumStalls()<<std::endl;
+	}
+	
+	delete extractor;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	unsigned int size[2]={1280,720};
+	double frameRate=0.0;
+	unsigned int numFrameBuffers=5;
+	unsigned int numFrames=1000;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"size")==0&&i+2<argc)
+				{
+				size[0]=(unsigned int)(atoi(argv[i+1]))&~0x1U;
+				size[1]=(unsigned int)(atoi(argv[i+2]))&~0x1U;
+				i+=2;
+				}
+			else if(strcasecmp(argv[i]+1,"rate")==0&&i+1<argc)
+				{
+				frameRate=atof(argv[i+1]);
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"buffers")==0&&i+1<argc)
+				{
+				numFrameBuffers=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"frames")==0&&i+1<argc)
+				{
+				numFrames=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-size <width> <height>] [-rate <frame rate, 0 for unthrottled>] [-buffers <number of frame buffers>] [-frames <number of frames>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	std::cout<<"Frame size "<<size[0]<<"x"<<size[1]<<", "<<numFrameBuffers<<" frame buffers, ";
+	if(frameRate>0.0)
+		std::cout<<frameRate<<" Hz";
+	else
+		std::cout<<"unthrottled";
+	std::cout<<std::endl;
+	std::cout<<"Path            Capture Deliver Consume  Copies/f  Bytes/f   Lat (ms)  Max (ms)  Capt fps Stalls"<<std::endl;
+	
+	/* Run the benchmark for a packed format and a planar format with and without zero-copy: */
+	runBenchmark("YUYV extract",size,"YUYV",false,frameRate,numFrameBuffers,numFrames);
+	runBenchmark("YV12 copy",size,"YV12",true,frameRate,numFrameBuffers,numFrames);
+	runBenchmark("YV12 zero-copy",size,"YV12",false,frameRate,numFrameBuffers,numFrames);
+	
+	return 0;
+	}
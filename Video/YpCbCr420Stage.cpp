@@ -0,0 +1,98 @@
+/***********************************************************************
+YpCbCr420Stage - Frame pipeline stage to pass captured video frames in
+Y'CbCr 4:2:0 format to a consumer thread, typically for display via a
+YpCbCr420Texture. Frames already in a planar Y'CbCr 4:2:0 format are
+passed by reference without copying.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Video/YpCbCr420Stage.h>
+
+#include <Video/ImageExtractor.h>
+#include <Video/YpCbCr420Texture.h>
+
+namespace Video {
+
+/*******************************
+Methods of class YpCbCr420Stage:
+*******************************/
+
+YpCbCr420Stage::YpCbCr420Stage(ImageExtractor* sExtractor,const unsigned int sSize[2])
+	:extractor(sExtractor),
+	 numFrames(0),numCopiedFrames(0)
+	{
+	/* Copy the frame size: */
+	for(int i=0;i<2;++i)
+		size[i]=sSize[i];
+	}
+
+void YpCbCr420Stage::processFrame(const FramePipeline::FramePtr& frame)
+	{
+	/* Start a new frame; this releases the frame previously held in the same slot: */
+	Planes& p=frames.startNewValue();
+	p.frame=0;
+	
+	/* Check if the frame buffer can be passed to the consumer directly: */
+	if(extractor->getYpCbCr420Planes(frame->getBuffer(),p.planes,p.strides))
+		{
+		/* Hold on to the frame until the consumer is done with it: */
+		p.frame=frame;
+		}
+	else
+		{
+		/* Allocate private plane storage on first use: */
+		if(p.storage==0)
+			p.storage=new unsigned char[size[0]*size[1]+(size[0]/2)*(size[1]/2)*2];
+		
+		/* Extract the frame into the private storage: */
+		unsigned char* ypcbcr[3];
+		ypcbcr[0]=p.storage;
+		ypcbcr[1]=ypcbcr[0]+size[0]*size[1];
+		ypcbcr[2]=ypcbcr[1]+(size[0]/2)*(size[1]/2);
+		p.strides[0]=size[0];
+		p.strides[1]=p.strides[2]=size[0]/2;
+		extractor->extractYpCbCr420(frame->getBuffer(),ypcbcr[0],p.strides[0],ypcbcr[1],p.strides[1],ypcbcr[2],p.strides[2]);
+		for(int i=0;i<3;++i)
+			p.planes[i]=ypcbcr[i];
+		++numCopiedFrames;
+		}
+	p.index=frame->getIndex();
+	p.captureTime=frame->getCaptureTime();
+	
+	/* Pass the frame to the consumer: */
+	frames.postNewValue();
+	++numFrames;
+	}
+
+bool YpCbCr420Stage::updateTexture(YpCbCr420Texture& texture)
+	{
+	/* Lock the most recent frame: */
+	if(!frames.lockNewValue())
+		return false;
+	
+	/* Pass the locked frame's planes to the texture: */
+	const Planes& p=frames.getLockedValue();
+	if(texture.getFrameWidth()!=size[0]||texture.getFrameHeight()!=size[1])
+		texture.setFrameSize(size[0],size[1]);
+	texture.setFrame(p.planes[0],p.strides[0],p.planes[1],p.strides[1],p.planes[2],p.strides[2]);
+	
+	return true;
+	}
+
+}
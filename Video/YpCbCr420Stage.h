@@ -0,0 +1,116 @@
+/***********************************************************************
+YpCbCr420Stage - Frame pipeline stage to pass captured video frames in
+Y'CbCr 4:2:0 format to a consumer thread, typically for display via a
+YpCbCr420Texture. Frames already in a planar Y'CbCr 4:2:0 format are
+passed by reference without copying.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Basic Video Library (Video).
+
+The Basic Video Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The Basic Video Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Basic Video Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef VIDEO_YPCBCR420STAGE_INCLUDED
+#define VIDEO_YPCBCR420STAGE_INCLUDED
+
+#include <Misc/Time.h>
+#include <Threads/TripleBuffer.h>
+#include <Video/FramePipeline.h>
+
+/* Forward declarations: */
+namespace Video {
+class ImageExtractor;
+class YpCbCr420Texture;
+}
+
+namespace Video {
+
+class YpCbCr420Stage:public FramePipeline::Stage
+	{
+	/* Embedded classes: */
+	public:
+	struct Planes // Structure describing a video frame in Y'CbCr 4:2:0 format
+		{
+		friend class YpCbCr420Stage;
+		
+		/* Elements: */
+		public:
+		FramePipeline::FramePtr frame; // Captured frame whose buffer contains the planes, or null if the planes were extracted into private storage
+		const unsigned char* planes[3]; // Pointers to the top-left pixels of the Y', Cb, and Cr planes, respectively
+		unsigned int strides[3]; // Offsets in bytes between adjacent pixel rows in the Y', Cb, and Cr planes, respectively
+		unsigned int index; // Running index of the frame in the pipeline
+		Misc::Time captureTime; // Time at which the frame was captured
+		private:
+		unsigned char* storage; // Private storage for extracted planes, or null
+		
+		/* Constructors and destructors: */
+		public:
+		Planes(void)
+			:index(0),storage(0)
+			{
+			for(int i=0;i<3;++i)
+				{
+				planes[i]=0;
+				strides[i]=0;
+				}
+			}
+		private:
+		Planes(const Planes& source); // Prohibit copy constructor
+		Planes& operator=(const Planes& source); // Prohibit assignment operator
+		public:
+		~Planes(void)
+			{
+			delete[] storage;
+			}
+		};
+	
+	/* Elements: */
+	private:
+	ImageExtractor* extractor; // Image extractor for the video device's current video format
+	unsigned int size[2]; // Frame width and height
+	Threads::TripleBuffer<Planes> frames; // Triple buffer passing frames from the capture thread to the consumer thread
+	unsigned int numFrames; // Number of frames passed to the consumer thread
+	unsigned int numCopiedFrames; // Number of frames that had to be extracted into private storage
+	
+	/* Constructors and destructors: */
+	public:
+	YpCbCr420Stage(ImageExtractor* sExtractor,const unsigned int sSize[2]); // Creates a stage for frames of the given size, using the given image extractor; extractor is not owned by the stage; stage holds on to up to three frames, so video device needs at least four frame buffers
+	
+	/* Methods from FramePipeline::Stage: */
+	virtual void processFrame(const FramePipeline::FramePtr& frame);
+	
+	/* New methods: */
+	unsigned int getNumFrames(void) const // Returns the number of frames passed to the consumer thread
+		{
+		return numFrames;
+		}
+	unsigned int getNumCopiedFrames(void) const // Returns the number of frames that had to be copied
+		{
+		return numCopiedFrames;
+		}
+	bool lockNewFrame(void) // Locks the most recent frame in the consumer thread; returns true if the frame is new
+		{
+		return frames.lockNewValue();
+		}
+	const Planes& getLockedFrame(void) const // Returns the locked frame; frame is valid until the next call to lockNewFrame
+		{
+		return frames.getLockedValue();
+		}
+	bool updateTexture(YpCbCr420Texture& texture); // Locks the most recent frame and passes it to the given texture; returns true if the frame is new
+	};
+
+}
+
+#endif
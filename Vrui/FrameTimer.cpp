@@ -0,0 +1,299 @@
+/***********************************************************************
+FrameTimer - Class to collect the durations of the phases of Vrui frames
+from the main thread and rendering threads, and to report rolling
+percentiles of phase durations.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/FrameTimer.h>
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <Misc/Endianness.h>
+#include <IO/OpenFile.h>
+
+namespace Vrui {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+void radixSort(std::vector<Misc::UInt64>& keys) // Sorts the given array of keys in ascending order
+	{
+	/* Sort by 8-bit digits, starting from the least significant: */
+	std::vector<Misc::UInt64> temp(keys.size());
+	size_t counts[256];
+	for(int shift=0;shift<64;shift+=8)
+		{
+		/* Count the number of keys with each digit value: */
+		memset(counts,0,sizeof(counts));
+		for(std::vector<Misc::UInt64>::const_iterator kIt=keys.begin();kIt!=keys.end();++kIt)
+			++counts[(*kIt>>shift)&0xffU];
+		
+		/* Skip the pass if all keys share the same digit value: */
+		if(counts[(keys.front()>>shift)&0xffU]==keys.size())
+			continue;
+		
+		/* Convert the counts into starting positions: */
+		size_t position=0;
+		for(int i=0;i<256;++i)
+			{
+			size_t count=counts[i];
+			counts[i]=position;
+			position+=count;
+			}
+		
+		/* Distribute the keys in stable order: */
+		for(std::vector<Misc::UInt64>::const_iterator kIt=keys.begin();kIt!=keys.end();++kIt)
+			temp[counts[(*kIt>>shift)&0xffU]++]=*kIt;
+		keys.swap(temp);
+		}
+	}
+
+inline double getSortedPercentile(const std::vector<Misc::UInt64>& sortedKeys,double percentile) // Returns the duration at the given percentile from an array of sorted duration keys
+	{
+	/* Clamp the percentile to the valid range; also catches NaNs: */
+	size_t index=0;
+	if(percentile>=100.0)
+		index=sortedKeys.size()-1;
+	else if(percentile>0.0)
+		index=size_t(percentile*double(sortedKeys.size()-1)/100.0+0.5);
+	
+	Misc::Float64 result;
+	memcpy(&result,&sortedKeys[index],sizeof(Misc::Float64));
+	return result;
+	}
+
+}
+
+/***************************
+Methods of class FrameTimer:
+***************************/
+
+bool FrameTimer::readSample(unsigned int sampleIndex,FrameTimer::Sample& sample) const
+	{
+	const Slot& slot=slots[sampleIndex&slotMask];
+	unsigned int completeSequence=sampleIndex*2U+2U;
+	
+	/* Copy the sample between two checks that the slot holds the completed sample: */
+	if(slot.sequence.get()!=completeSequence)
+		return false;
+	sample=slot.sample;
+	return slot.sequence.get()==completeSequence;
+	}
+
+void FrameTimer::writeTrace(void)
+	{
+	/* Skip samples that have already been overwritten: */
+	unsigned int endIndex=nextSampleIndex.get();
+	if(endIndex-nextTraceSampleIndex>slotMask+1U)
+		nextTraceSampleIndex=endIndex-(slotMask+1U);
+	
+	/* Write completed samples in order until the first sample that is still being recorded: */
+	Sample sample;
+	while(nextTraceSampleIndex!=endIndex&&readSample(nextTraceSampleIndex,sample))
+		{
+		traceFile->write<Misc::UInt32>(sample.frameIndex);
+		traceFile->write<Misc::UInt16>(sample.phase);
+		traceFile->write<Misc::SInt16>(sample.windowIndex);
+		traceFile->write<Misc::Float64>(sample.startTime);
+		traceFile->write<Misc::Float64>(sample.duration);
+		++nextTraceSampleIndex;
+		}
+	}
+
+void* FrameTimer::traceWriterThreadMethod(void)
+	{
+	unsigned int writtenFrameIndex=frameIndex.get();
+	bool done=false;
+	while(!done)
+		{
+		/* Wait until the main thread starts a new frame or closes the trace file: */
+		{
+		Threads::MutexCond::Lock traceLock(traceCond);
+		while(!traceWriterDone&&frameIndex.get()==writtenFrameIndex)
+			traceCond.wait(traceLock);
+		done=traceWriterDone;
+		}
+		
+		/* Write all samples completed so far; the file is only flushed when it is closed: */
+		writtenFrameIndex=frameIndex.get();
+		writeTrace();
+		}
+	
+	return 0;
+	}
+
+void FrameTimer::getSortedDurations(FrameTimer::Phase phase,int windowIndex,std::vector<Misc::UInt64>& sortedDurations) const
+	{
+	/* Collect the durations of all matching samples still in the ring buffer: */
+	sortedDurations.clear();
+	unsigned int endIndex=nextSampleIndex.get();
+	unsigned int numSamples=endIndex<=slotMask+1U?endIndex:slotMask+1U;
+	sortedDurations.reserve(numSamples);
+	Sample sample;
+	for(unsigned int sampleIndex=endIndex-numSamples;sampleIndex!=endIndex;++sampleIndex)
+		if(readSample(sampleIndex,sample)&&sample.phase==Misc::UInt16(phase)&&(windowIndex<0||sample.windowIndex==windowIndex))
+			{
+			/* Non-negative IEEE doubles sort in the same order as their bit patterns: */
+			Misc::Float64 duration=sample.duration>0.0?sample.duration:0.0;
+			Misc::UInt64 key;
+			memcpy(&key,&duration,sizeof(Misc::UInt64));
+			sortedDurations.push_back(key);
+			}
+	
+	/* Sort the durations; radix sorting only pays off for large numbers of samples: */
+	if(sortedDurations.size()>=2048)
+		radixSort(sortedDurations);
+	else
+		std::sort(sortedDurations.begin(),sortedDurations.end());
+	}
+
+FrameTimer::FrameTimer(unsigned int sMaxNumSamples)
+	:timeBase(getTime()),
+	 slotMask(0),slots(0),
+	 nextSampleIndex(0U),frameIndex(0U),
+	 nextTraceSampleIndex(0),traceWriterDone(false)
+	{
+	/* Round the ring buffer size up to the next power of two: */
+	unsigned int numSlots=2;
+	while(numSlots<sMaxNumSamples)
+		numSlots<<=1;
+	slotMask=numSlots-1;
+	slots=new Slot[numSlots];
+	}
+
+FrameTimer::~FrameTimer(void)
+	{
+	closeTraceFile();
+	delete[] slots;
+	}
+
+const char* FrameTimer::getPhaseName(FrameTimer::Phase phase)
+	{
+	static const char* phaseNames[NUM_PHASES]=
+		{
+		"Input update","Tool update","Application frame","Display","Swap","Cluster barrier"
+		};
+	return phaseNames[phase];
+	}
+
+void FrameTimer::openTraceFile(const char* traceFileName)
+	{
+	/* Close a previous trace file: */
+	closeTraceFile();
+	
+	/* Open the new trace file and write its header: */
+	traceFile=IO::openFile(traceFileName,IO::File::WriteOnly);
+	traceFile->setEndianness(Misc::LittleEndian);
+	static const char header[]="Vrui frame timing trace v1.0\n";
+	traceFile->write<char>(header,sizeof(header)-1);
+	
+	/* Start writing with the next recorded sample: */
+	nextTraceSampleIndex=nextSampleIndex.get();
+	
+	/* Start the trace writing thread: */
+	traceWriterDone=false;
+	traceWriterThread.start(this,&FrameTimer::traceWriterThreadMethod);
+	}
+
+void FrameTimer::closeTraceFile(void)
+	{
+	if(traceFile!=0)
+		{
+		/* Shut down the trace writing thread, which writes all remaining completed samples before exiting: */
+		{
+		Threads::MutexCond::Lock traceLock(traceCond);
+		traceWriterDone=true;
+		traceCond.signal();
+		}
+		traceWriterThread.join();
+		
+		traceFile->flush();
+		traceFile=0;
+		}
+	}
+
+void FrameTimer::startFrame(void)
+	{
+	/* Advance to the next frame: */
+	frameIndex.preAdd(1U);
+	
+	/* Wake up the trace writing thread to write the previous frame's samples: */
+	if(traceFile!=0)
+		{
+		Threads::MutexCond::Lock traceLock(traceCond);
+		traceCond.signal();
+		}
+	}
+
+void FrameTimer::record(FrameTimer::Phase phase,int windowIndex,double startTime,double endTime)
+	{
+	/* Claim the next slot in the ring buffer: */
+	unsigned int sampleIndex=nextSampleIndex.postAdd(1U);
+	Slot& slot=slots[sampleIndex&slotMask];
+	
+	/* Mark the slot as being written, write the sample, and mark the slot as complete: */
+	slot.sequence.set(sampleIndex*2U+1U);
+	slot.sample.frameIndex=frameIndex.get();
+	slot.sample.phase=Misc::UInt16(phase);
+	slot.sample.windowIndex=Misc::SInt16(windowIndex);
+	slot.sample.startTime=startTime-timeBase;
+	slot.sample.duration=endTime-startTime;
+	slot.sequence.set(sampleIndex*2U+2U);
+	}
+
+FrameTimer::Statistics FrameTimer::getStatistics(FrameTimer::Phase phase,int windowIndex) const
+	{
+	std::vector<Misc::UInt64> sortedDurations;
+	getSortedDurations(phase,windowIndex,sortedDurations);
+	
+	/* Pick the percentiles: */
+	Statistics result;
+	result.numSamples=sortedDurations.size();
+	if(!sortedDurations.empty())
+		{
+		result.p50=getSortedPercentile(sortedDurations,50.0);
+		result.p95=getSortedPercentile(sortedDurations,95.0);
+		result.p99=getSortedPercentile(sortedDurations,99.0);
+		result.max=getSortedPercentile(sortedDurations,100.0);
+		}
+	else
+		result.p50=result.p95=result.p99=result.max=0.0;
+	
+	return result;
+	}
+
+double FrameTimer::getPercentile(FrameTimer::Phase phase,double percentile,int windowIndex) const
+	{
+	std::vector<Misc::UInt64> sortedDurations;
+	getSortedDurations(phase,windowIndex,sortedDurations);
+	
+	/* Pick the percentile: */
+	if(!sortedDurations.empty())
+		return getSortedPercentile(sortedDurations,percentile);
+	else
+		return 0.0;
+	}
+
+}
@@ -0,0 +1,162 @@
+/***********************************************************************
+FrameTimer - Class to collect the durations of the phases of Vrui frames
+from the main thread and rendering threads, and to report rolling
+percentiles of phase durations.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_FRAMETIMER_INCLUDED
+#define VRUI_FRAMETIMER_INCLUDED
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/time.h>
+#include <vector>
+#include <Misc/SizedTypes.h>
+#include <Threads/Atomic.h>
+#include <Threads/MutexCond.h>
+#include <Threads/Thread.h>
+#include <IO/File.h>
+
+namespace Vrui {
+
+class FrameTimer
+	{
+	/* Embedded classes: */
+	public:
+	enum Phase // Enumerated type for timed phases of a Vrui frame
+		{
+		INPUT_UPDATE=0, // Updating input device states and distributing them to cluster nodes
+		TOOL_UPDATE, // Updating the input graph and all tools
+		APPLICATION_FRAME, // Calling the application's frame function
+		DISPLAY, // Drawing a single window
+		SWAP, // Swapping a single window's buffers
+		CLUSTER_BARRIER, // Waiting for all cluster nodes to finish rendering
+		NUM_PHASES
+		};
+	
+	struct Sample // Structure for a single timed phase, as written to trace files
+		{
+		/* Elements: */
+		public:
+		Misc::UInt32 frameIndex; // Index of the frame during which the phase occurred
+		Misc::UInt16 phase; // The timed phase
+		Misc::SInt16 windowIndex; // Index of the window for per-window phases, -1 otherwise
+		Misc::Float64 startTime; // Time at which the phase started, in seconds since the creation of the frame timer
+		Misc::Float64 duration; // Duration of the phase in seconds
+		};
+	
+	struct Statistics // Structure reporting the distribution of a phase's recent durations
+		{
+		/* Elements: */
+		public:
+		size_t numSamples; // Number of recent samples of the phase
+		double p50,p95,p99; // 50th, 95th, and 99th percentiles of the phase's recent durations, in seconds
+		double max; // Maximum recent duration of the phase in seconds
+		};
+	
+	class Scope // Class to time a phase during the lifetime of a scope object
+		{
+		/* Elements: */
+		private:
+		FrameTimer* timer; // Timer receiving the sample, or null to disable timing
+		Phase phase; // The timed phase
+		int windowIndex; // Index of the window for per-window phases
+		double startTime; // Time at which the phase started
+		
+		/* Constructors and destructors: */
+		public:
+		Scope(FrameTimer* sTimer,Phase sPhase,int sWindowIndex =-1) // Starts timing the given phase with the given frame timer
+			:timer(sTimer),phase(sPhase),windowIndex(sWindowIndex),
+			 startTime(timer!=0?getTime():0.0)
+			{
+			}
+		~Scope(void) // Records the timed phase
+			{
+			if(timer!=0)
+				timer->record(phase,windowIndex,startTime,getTime());
+			}
+		};
+	
+	private:
+	struct Slot // Structure for a slot in the sample ring buffer
+		{
+		/* Elements: */
+		public:
+		Threads::Atomic<unsigned int> sequence; // Twice the free-running index of the slot's sample plus one while the sample is being written, plus two once it is complete
+		Sample sample; // The sample stored in the slot
+		};
+	
+	/* Elements: */
+	double timeBase; // Time at which the frame timer was created
+	unsigned int slotMask; // Bit mask to convert free-running sample indices to slot indices
+	Slot* slots; // Ring buffer of recent samples
+	Threads::Atomic<unsigned int> nextSampleIndex; // Free-running index of the next sample to be recorded
+	Threads::Atomic<unsigned int> frameIndex; // Index of the current frame
+	IO::FilePtr traceFile; // File receiving all recorded samples, or null
+	unsigned int nextTraceSampleIndex; // Free-running index of the next sample to be written to the trace file
+	Threads::MutexCond traceCond; // Condition variable signalled when a new frame starts or the trace file is closed
+	bool traceWriterDone; // Flag to shut down the trace writing thread
+	Threads::Thread traceWriterThread; // Thread writing samples to the trace file in the background
+	
+	/* Private methods: */
+	bool readSample(unsigned int sampleIndex,Sample& sample) const; // Copies the sample of the given free-running index; returns false if the sample is incomplete or was overwritten
+	void writeTrace(void); // Writes all completed samples to the trace file
+	void* traceWriterThreadMethod(void); // Writes the samples of each frame to the trace file after the main thread starts the next frame
+	void getSortedDurations(Phase phase,int windowIndex,std::vector<Misc::UInt64>& sortedDurations) const; // Returns the sorted bit patterns of the durations of all recent samples of the given phase and window
+	
+	/* Constructors and destructors: */
+	public:
+	FrameTimer(unsigned int sMaxNumSamples); // Creates a frame timer retaining at least the given number of recent samples
+	private:
+	FrameTimer(const FrameTimer& source); // Prohibit copy constructor
+	FrameTimer& operator=(const FrameTimer& source); // Prohibit assignment operator
+	public:
+	~FrameTimer(void);
+	
+	/* Methods: */
+	static double getTime(void) // Returns the current time of a monotonic clock in seconds
+		{
+		#ifdef CLOCK_MONOTONIC
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		return double(now.tv_sec)+double(now.tv_nsec)/1.0e9;
+		#else
+		struct timeval now;
+		gettimeofday(&now,0);
+		return double(now.tv_sec)+double(now.tv_usec)/1.0e6;
+		#endif
+		}
+	static const char* getPhaseName(Phase phase); // Returns a human-readable name for the given phase
+	void openTraceFile(const char* traceFileName); // Writes all samples recorded from now on to a binary trace file of the given name
+	void closeTraceFile(void); // Stops writing samples to the current trace file
+	void startFrame(void); // Advances to the next frame and wakes up the trace writing thread; must be called from the main thread
+	unsigned int getFrameIndex(void) const // Returns the index of the current frame
+		{
+		return frameIndex.get();
+		}
+	void record(Phase phase,int windowIndex,double startTime,double endTime); // Records a sample for the given phase, started and ended at the given times as returned by getTime; can be called from any thread
+	Statistics getStatistics(Phase phase,int windowIndex =-1) const; // Returns the distribution of recent durations of the given phase for the given window, or all windows if the index is -1
+	double getPercentile(Phase phase,double percentile,int windowIndex =-1) const; // Returns the given percentile (clamped to [0, 100]) of recent durations of the given phase
+	};
+
+}
+
+#endif
@@ -25,18 +25,18 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <ctype.h>
 #include <stdio.h>
-#include <unistd.h>
 #include <iostream>
 #include <Misc/ThrowStdErr.h>
 #include <Misc/StandardValueCoders.h>
 #include <Misc/ConfigurationFile.h>
-#include <Images/WriteImageFile.h>
+#include <Threads/TaskScheduler.h>
+#include <Threads/Profiler.h>
 
 namespace Vrui {
 
-/*********************************
-Methods of class TheoraMovieSaver:
-*********************************/
+/****************************************
+Methods of class ImageSequenceMovieSaver:
+****************************************/
 
 void ImageSequenceMovieSaver::frameWritingThreadMethod(void)
 	{
@@ -44,13 +44,24 @@ void ImageSequenceMovieSaver::frameWritingThreadMethod(void)
 	unsigned int frameIndex=0;
 	while(!done)
 		{
-		/* Add the most recent frame to the captured frame queue: */
-		{
-		Threads::MutexCond::Lock captureLock(captureCond);
+		/* Lock the most recent frame: */
 		frames.lockNewValue();
-		capturedFrames.push_back(frames.getLockedValue());
-		captureCond.signal();
-		}
+		const FrameBuffer& frame=frames.getLockedValue();
+		
+		/* Drop the frame if the image writer is falling behind, to bound memory use: */
+		if(imageWriter.getNumPendingImages()<queueSize)
+			{
+			/* Queue a copy of the frame for writing into the next frame image file: */
+			char frameName[1024];
+			snprintf(frameName,sizeof(frameName),frameNameTemplate.c_str(),numQueuedFrames);
+			
+			THREADS_PROFILE_ZONE("Vrui::ImageSequenceMovieSaver::queueFrame");
+			imageWriter.writeImageFile(frame.getFrameSize()[0],frame.getFrameSize()[1],frame.getBuffer(),frameName);
+			++numQueuedFrames;
+			}
+		else
+			++numDroppedFrames;
+		++frameIndex;
 		
 		/* Wait for the next frame: */
 		int numSkippedFrames=waitForNextFrame();
@@ -62,38 +73,13 @@ void ImageSequenceMovieSaver::frameWritingThreadMethod(void)
 		}
 	}
 
-void* ImageSequenceMovieSaver::frameSavingThreadMethod(void)
-	{
-	unsigned int frameIndex=0;
-	while(true)
-		{
-		/* Wait for the next frame: */
-		FrameBuffer frame;
-		{
-		Threads::MutexCond::Lock captureLock(captureCond);
-		while(!done&&capturedFrames.empty())
-			captureCond.wait(captureLock);
-		if(capturedFrames.empty()) // Bail out if there will be no more frames
-			break;
-		frame=capturedFrames.front();
-		capturedFrames.pop_front();
-		}
-		
-		/* Write the next frame image file: */
-		char frameName[1024];
-		snprintf(frameName,sizeof(frameName),frameNameTemplate.c_str(),frameIndex);
-		++frameIndex;
-		
-		Images::writeImageFile(frame.getFrameSize()[0],frame.getFrameSize()[1],frame.getBuffer(),frameName);
-		}
-	
-	return 0;
-	}
-
 ImageSequenceMovieSaver::ImageSequenceMovieSaver(const Misc::ConfigurationFileSection& configFileSection)
 	:MovieSaver(configFileSection),
 	 frameNameTemplate(configFileSection.retrieveString("./movieFrameNameTemplate")),
-	 done(false)
+	 queueSize(configFileSection.retrieveValue<unsigned int>("./movieQueueSize",8)),
+	 imageWriter(configFileSection.retrieveValue<unsigned int>("./movieNumEncodingThreads",Threads::TaskScheduler::getNumProcessors())),
+	 done(false),
+	 numQueuedFrames(0),numDroppedFrames(0)
 	{
 	/* Check if the frame name template has the correct format: */
 	int numConversions=0;
@@ -121,19 +107,23 @@ ImageSequenceMovieSaver::ImageSequenceMovieSaver(const Misc::ConfigurationFileSe
 		}
 	if(numConversions!=1||!hasIntConversion)
 		Misc::throwStdErr("MovieSaver::MovieSaver: movie frame name template \"%s\" does not have exactly one %%u conversion",frameNameTemplate.c_str());
-	
-	/* Start the image writing thread: */
-	frameSavingThread.start(this,&ImageSequenceMovieSaver::frameSavingThreadMethod);
 	}
 
 ImageSequenceMovieSaver::~ImageSequenceMovieSaver(void)
 	{
-	/* Signal the frame capturing and saving threads to shut down: */
+	/* Stop the frame writing thread: */
 	done=true;
-	captureCond.signal();
+	if(!frameWritingThread.isJoined())
+		frameWritingThread.join();
+	
+	/* Wait until all queued frames have been written: */
+	imageWriter.waitForCompletion();
 	
-	/* Wait until the frame saving thread has saved all frames and terminates: */
-	frameSavingThread.join();
+	/* Print frame statistics: */
+	std::cout<<"MovieSaver: Wrote "<<numQueuedFrames-imageWriter.getNumFailedImages()<<" frames, dropped "<<numDroppedFrames<<" frames due to a full writing queue";
+	if(imageWriter.getNumFailedImages()>0)
+		std::cout<<", failed to write "<<imageWriter.getNumFailedImages()<<" frames";
+	std::cout<<std::endl;
 	}
 
 }
@@ -25,9 +25,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #define VRUI_INTERNAL_IMAGESEQUENCEMOVIESAVER_INCLUDED
 
 #include <string>
-#include <deque>
-#include <Threads/MutexCond.h>
-#include <Threads/Thread.h>
+#include <Images/AsyncImageWriter.h>
 #include <Vrui/Internal/MovieSaver.h>
 
 namespace Vrui {
@@ -37,19 +35,16 @@ class ImageSequenceMovieSaver:public MovieSaver
 	/* Elements: */
 	private:
 	std::string frameNameTemplate; // Template for creating image file names; must contain exactly one %d placeholder
-	Threads::MutexCond captureCond; // Condition variable to signal that a new frame has been captured and added to the queue
-	std::deque<FrameBuffer> capturedFrames; // Queue of frame buffers selected for writing
-	Threads::Thread frameSavingThread; // Thread to write captured frames to disk; in separate thread to avoid latency issues
+	unsigned int queueSize; // Maximum number of frames waiting to be written before new frames are dropped
+	Images::AsyncImageWriter imageWriter; // Pool of background threads writing frame image files in parallel
 	volatile bool done; // Flag whether all frames have been captured
+	unsigned int numQueuedFrames; // Number of frames handed to the image writer
+	unsigned int numDroppedFrames; // Number of frames dropped because too many frames were waiting to be written
 	
 	/* Protected methods from MovieSaver: */
 	protected:
 	virtual void frameWritingThreadMethod(void);
 	
-	/* Private methods: */
-	private:
-	void* frameSavingThreadMethod(void); // Thread method to write captured frames to disk
-	
 	/* Constructors and destructors: */
 	public:
 	ImageSequenceMovieSaver(const Misc::ConfigurationFileSection& configFileSection);
@@ -26,6 +26,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <stdio.h>
 #include <Misc/ThrowStdErr.h>
+#include <Math/Math.h>
 #include <Misc/FunctionCalls.h>
 #include <Misc/StandardValueCoders.h>
 #include <Misc/CompoundValueCoders.h>
@@ -37,9 +38,20 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/InputDeviceManager.h>
 #include <Vrui/InputGraphManager.h>
 #include <Vrui/Internal/VRDeviceDescriptor.h>
+#include <Vrui/Internal/VRDeviceSubscription.h>
 
 namespace Vrui {
 
+namespace {
+
+/**************
+Helper objects:
+**************/
+
+const double maxSampleAge=0.1; // Maximum age of a tracker state in seconds that is compensated by motion prediction
+
+}
+
 /***********************************************
 Methods of class InputDeviceAdapterDeviceDaemon:
 ***********************************************/
@@ -60,6 +72,18 @@ void InputDeviceAdapterDeviceDaemon::errorCallback(const VRDeviceClient::Protoco
 	requestUpdate();
 	}
 
+void InputDeviceAdapterDeviceDaemon::initMotionPrediction(int deviceIndex,const Misc::ConfigurationFileSection& configFileSection)
+	{
+	if(motionPredictionDeltas.size()<=size_t(deviceIndex))
+		motionPredictionDeltas.resize(deviceIndex+1,-1.0);
+	
+	/* Check whether to extrapolate the device's tracker state to the expected display time: */
+	if(configFileSection.retrieveValue<bool>("./predictMotion",false))
+		motionPredictionDeltas[deviceIndex]=Math::max(configFileSection.retrieveValue<double>("./motionPredictionDelta",0.0),0.0);
+	else
+		motionPredictionDeltas[deviceIndex]=-1.0;
+	}
+
 void InputDeviceAdapterDeviceDaemon::createInputDevice(int deviceIndex,const Misc::ConfigurationFileSection& configFileSection)
 	{
 	/* Check if the device client has a virtual device of the same name as this configuration file section: */
@@ -123,6 +147,9 @@ void InputDeviceAdapterDeviceDaemon::createInputDevice(int deviceIndex,const Mis
 			for(int i=0;i<vd.numValuators;++i)
 				valuatorNames.push_back(vd.valuatorNames[i]);
 			
+			/* Initialize the new device's motion prediction: */
+			initMotionPrediction(deviceIndex,configFileSection);
+			
 			/* Skip the usual device creation procedure: */
 			return;
 			}
@@ -162,6 +189,9 @@ void InputDeviceAdapterDeviceDaemon::createInputDevice(int deviceIndex,const Mis
 		snprintf(valuatorName,sizeof(valuatorName),"Valuator%d",valuatorIndex);
 		valuatorNames.push_back(valuatorName);
 		}
+	
+	/* Initialize the new device's motion prediction: */
+	initMotionPrediction(deviceIndex,configFileSection);
 	}
 
 InputDeviceAdapterDeviceDaemon::InputDeviceAdapterDeviceDaemon(InputDeviceManager* sInputDeviceManager,const Misc::ConfigurationFileSection& configFileSection)
@@ -171,6 +201,27 @@ InputDeviceAdapterDeviceDaemon::InputDeviceAdapterDeviceDaemon(InputDeviceManage
 	/* Initialize input device adapter: */
 	InputDeviceAdapterIndexMap::initializeAdapter(deviceClient.getState().getNumTrackers(),deviceClient.getState().getNumButtons(),deviceClient.getState().getNumValuators(),configFileSection);
 	
+	if(configFileSection.retrieveValue<bool>("./subscribeToUsedFeatures",true))
+		{
+		/* Subscribe only to those trackers, buttons, and valuators that are mapped to input devices: */
+		VRDeviceSubscription subscription;
+		for(int deviceIndex=0;deviceIndex<numInputDevices;++deviceIndex)
+			{
+			if(trackerIndexMapping[deviceIndex]>=0)
+				subscription.trackerIndices.push_back(trackerIndexMapping[deviceIndex]);
+			for(int i=0;i<inputDevices[deviceIndex]->getNumButtons();++i)
+				subscription.buttonIndices.push_back(buttonIndexMapping[deviceIndex][i]);
+			for(int i=0;i<inputDevices[deviceIndex]->getNumValuators();++i)
+				subscription.valuatorIndices.push_back(valuatorIndexMapping[deviceIndex][i]);
+			}
+		subscription.keyframeInterval=configFileSection.retrieveValue<unsigned int>("./keyframeInterval",subscription.keyframeInterval);
+		subscription.clip(deviceClient.getState());
+		
+		/* Old servers ignore subscriptions and keep sending full state packets: */
+		if(!subscription.empty())
+			deviceClient.subscribe(subscription);
+		}
+	
 	/* Start VR devices: */
 	deviceClient.activate();
 	deviceClient.startStream(Misc::createFunctionCall(packetNotificationCallback),Misc::createFunctionCall(this,&InputDeviceAdapterDeviceDaemon::errorCallback));
@@ -266,6 +317,7 @@ void InputDeviceAdapterDeviceDaemon::updateInputDevices(void)
 	}
 	
 	/* Update all managed input devices: */
+	VRDeviceState::TimeStamp now=VRDeviceState::getTimeStamp();
 	deviceClient.lockState();
 	const VRDeviceState& state=deviceClient.getState();
 	for(int deviceIndex=0;deviceIndex<numInputDevices;++deviceIndex)
@@ -278,13 +330,31 @@ void InputDeviceAdapterDeviceDaemon::updateInputDevices(void)
 			{
 			/* Get device's tracker state from VR device client: */
 			const VRDeviceState::TrackerState& ts=state.getTrackerState(trackerIndexMapping[deviceIndex]);
+			TrackerState transformation(ts.positionOrientation);
+			Vector linearVelocity(ts.linearVelocity);
+			Vector angularVelocity(ts.angularVelocity);
+			
+			if(motionPredictionDeltas[deviceIndex]>=0.0)
+				{
+				/* Calculate the age of the tracker state, ignoring bogus ages from stalled or restarted servers: */
+				double sampleAge=double(VRDeviceState::getAge(state.getTrackerTimeStamp(trackerIndexMapping[deviceIndex]),now))*1.0e-6;
+				if(sampleAge<0.0||sampleAge>maxSampleAge)
+					sampleAge=0.0;
+				
+				/* Extrapolate the tracker state from its sample time to the expected display time: */
+				Scalar dt=Scalar(sampleAge+motionPredictionDeltas[deviceIndex]);
+				Vector translation=transformation.getTranslation()+linearVelocity*dt;
+				Rotation rotation=Rotation::rotateScaledAxis(angularVelocity*dt)*transformation.getRotation();
+				rotation.renormalize();
+				transformation=TrackerState(translation,rotation);
+				}
 			
 			/* Set device's transformation: */
-			device->setTransformation(TrackerState(ts.positionOrientation));
+			device->setTransformation(transformation);
 			
 			/* Set device's linear and angular velocities: */
-			device->setLinearVelocity(Vector(ts.linearVelocity));
-			device->setAngularVelocity(Vector(ts.angularVelocity));
+			device->setLinearVelocity(linearVelocity);
+			device->setAngularVelocity(angularVelocity);
 			}
 		
 		/* Update button states: */
@@ -45,12 +45,14 @@ class InputDeviceAdapterDeviceDaemon:public InputDeviceAdapterIndexMap
 	VRDeviceClient deviceClient; // Device client delivering "raw" device state
 	std::vector<std::string> buttonNames; // Array of button names for all defined input devices
 	std::vector<std::string> valuatorNames; // Array of valuator names for all defined input devices
+	std::vector<double> motionPredictionDeltas; // Array of intervals from the beginning of a frame to the expected display time for all defined input devices in seconds, negative if motion prediction is disabled
 	Threads::Spinlock errorMessageMutex; // Mutex protecting the error message log
 	std::vector<std::string> errorMessages; // Log of error messages received from the device client
 	
 	/* Private methods: */
 	static void packetNotificationCallback(VRDeviceClient* client);
 	void errorCallback(const VRDeviceClient::ProtocolError& error);
+	void initMotionPrediction(int deviceIndex,const Misc::ConfigurationFileSection& configFileSection); // Reads motion prediction settings for the given input device
 	
 	/* Protected methods from InputDeviceAdapter: */
 	protected:
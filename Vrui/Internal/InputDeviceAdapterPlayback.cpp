@@ -26,8 +26,6 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <ctype.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
 #include <iostream>
 #include <Misc/Time.h>
 #include <Misc/ThrowStdErr.h>
@@ -472,40 +470,8 @@ void InputDeviceAdapterPlayback::updateInputDevices(void)
 	
 	if(saveMovie&&movieWindow!=0)
 		{
-		/* Copy the last saved screenshot if multiple movie frames needed to be taken during the last Vrui frame: */
-		while(nextMovieFrameTime<timeStamp)
-			{
-			/* Copy the last saved screenshot: */
-			pid_t childPid=fork();
-			if(childPid==0)
-				{
-				/* Create the old and new file names: */
-				char oldImageFileName[1024];
-				snprintf(oldImageFileName,sizeof(oldImageFileName),movieFileNameTemplate.c_str(),nextMovieFrameCounter-1);
-				char imageFileName[1024];
-				snprintf(imageFileName,sizeof(imageFileName),movieFileNameTemplate.c_str(),nextMovieFrameCounter);
-				
-				/* Execute the cp system command: */
-				char* cpArgv[10];
-				int cpArgc=0;
-				cpArgv[cpArgc++]=const_cast<char*>("/bin/cp");
-				cpArgv[cpArgc++]=oldImageFileName;
-				cpArgv[cpArgc++]=imageFileName;
-				cpArgv[cpArgc++]=0;
-				execvp(cpArgv[0],cpArgv);
-				}
-			else
-				{
-				/* Wait for the copy process to finish: */
-				waitpid(childPid,0,0);
-				}
-			
-			/* Advance the frame counters: */
-			nextMovieFrameTime+=movieFrameTimeInterval;
-			++nextMovieFrameCounter;
-			}
-		
-		if(nextTimeStamp>nextMovieFrameTime)
+		/* Request a screenshot from the movie window for every movie frame before the next Vrui frame; the window saves the same contents under each frame's name: */
+		while(nextTimeStamp>nextMovieFrameTime)
 			{
 			/* Request a screenshot from the movie window: */
 			char imageFileName[1024];
@@ -515,6 +481,10 @@ void InputDeviceAdapterPlayback::updateInputDevices(void)
 			/* Advance the movie frame counters: */
 			nextMovieFrameTime+=movieFrameTimeInterval;
 			++nextMovieFrameCounter;
+			
+			/* Only save a single frame after the last data frame: */
+			if(done)
+				break;
 			}
 		}
 	}
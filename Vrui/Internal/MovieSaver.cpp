@@ -29,6 +29,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Misc/StandardValueCoders.h>
 #include <Misc/ConfigurationFile.h>
 #include <Misc/CreateNumberedFileName.h>
+#include <Threads/Profiler.h>
 #include <Sound/SoundDataFormat.h>
 #include <Sound/SoundRecorder.h>
 #include <Vrui/Internal/ImageSequenceMovieSaver.h>
@@ -91,7 +92,7 @@ void MovieSaver::FrameBuffer::setFrameSize(int newWidth,int newHeight)
 		/* Update the frame size and allocate new image data: */
 		frameSize[0]=newWidth;
 		frameSize[1]=newHeight;
-		unsigned int* allocBuffer=new unsigned int[(frameSize[1]*frameSize[0]*3+sizeof(unsigned int)-1)/sizeof(unsigned int)];
+		unsigned int* allocBuffer=new unsigned int[(frameSize[1]*frameSize[0]*3+sizeof(unsigned int)-1)/sizeof(unsigned int)+1];
 		allocBuffer[0]=1;
 		buffer=reinterpret_cast<unsigned char*>(allocBuffer+1);
 		}
@@ -108,7 +109,7 @@ void MovieSaver::FrameBuffer::prepareWrite(void)
 			unref();
 			
 			/* Allocate new image data: */
-			unsigned int* allocBuffer=new unsigned int[(frameSize[1]*frameSize[0]*3+sizeof(unsigned int)-1)/sizeof(unsigned int)];
+			unsigned int* allocBuffer=new unsigned int[(frameSize[1]*frameSize[0]*3+sizeof(unsigned int)-1)/sizeof(unsigned int)+1];
 			allocBuffer[0]=1;
 			buffer=reinterpret_cast<unsigned char*>(allocBuffer+1);
 			}
@@ -121,6 +122,8 @@ Methods of class MovieSaver:
 
 void* MovieSaver::frameWritingThreadWrapper(void)
 	{
+	Threads::Profiler::setThreadName("Vrui movie saver thread");
+	
 	/* Start the virtual thread method: */
 	frameWritingThreadMethod();
 	return 0;
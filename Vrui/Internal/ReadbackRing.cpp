@@ -0,0 +1,200 @@
+/***********************************************************************
+ReadbackRing - Helper class to read back the contents of a window's
+frame buffer asynchronously through a ring of OpenGL pixel buffer
+objects, mapping each buffer only several frames after the read request
+was issued to overlap the transfer with rendering.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/Internal/ReadbackRing.h>
+
+#include <stdexcept>
+#include <iostream>
+#include <Threads/Profiler.h>
+#include <GL/Extensions/GLARBVertexBufferObject.h>
+#include <GL/Extensions/GLARBPixelBufferObject.h>
+
+namespace Vrui {
+
+/*****************************
+Methods of class ReadbackRing:
+*****************************/
+
+void ReadbackRing::setPackState(void)
+	{
+	glPixelStorei(GL_PACK_ALIGNMENT,1);
+	glPixelStorei(GL_PACK_SKIP_PIXELS,0);
+	glPixelStorei(GL_PACK_ROW_LENGTH,0);
+	glPixelStorei(GL_PACK_SKIP_ROWS,0);
+	}
+
+void ReadbackRing::retireOldest(void)
+	{
+	THREADS_PROFILE_ZONE("Vrui::ReadbackRing::retireOldest");
+	
+	/* Remove the oldest pending slot from the queue: */
+	Slot& slot=slots[firstPending];
+	firstPending=(firstPending+1)%numSlots;
+	--numPending;
+	
+	/* Map the slot's pixel buffer object; this only blocks if the transfer has not completed yet: */
+	glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB,slot.bufferId);
+	const unsigned char* pixels=static_cast<const unsigned char*>(glMapBufferARB(GL_PIXEL_PACK_BUFFER_ARB,GL_READ_ONLY_ARB));
+	if(pixels!=0)
+		{
+		/* Hand the pixels to the receiver: */
+		try
+			{
+			slot.receiver->receivePixels(slot.size[0],slot.size[1],pixels);
+			}
+		catch(std::runtime_error err)
+			{
+			std::cerr<<"Vrui::ReadbackRing: Caught exception "<<err.what()<<" while delivering read-back frame"<<std::endl;
+			}
+		glUnmapBufferARB(GL_PIXEL_PACK_BUFFER_ARB);
+		}
+	else
+		std::cerr<<"Vrui::ReadbackRing: Unable to map pixel buffer object; dropping read-back frame"<<std::endl;
+	glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB,0);
+	
+	/* Release the receiver: */
+	delete slot.receiver;
+	slot.receiver=0;
+	}
+
+ReadbackRing::ReadbackRing(unsigned int sNumSlots)
+	:numSlots(0),slots(0),
+	 latency(0),firstPending(0),numPending(0),
+	 frameIndex(0),
+	 fallbackBuffer(0),fallbackBufferSize(0)
+	{
+	if(sNumSlots>0&&isSupported())
+		{
+		/* Initialize the required OpenGL extensions: */
+		GLARBVertexBufferObject::initExtension();
+		GLARBPixelBufferObject::initExtension();
+		
+		/* Create the ring of pixel buffer objects; storage is allocated on first use: */
+		numSlots=sNumSlots;
+		slots=new Slot[numSlots];
+		for(unsigned int i=0;i<numSlots;++i)
+			{
+			glGenBuffersARB(1,&slots[i].bufferId);
+			slots[i].bufferSize=0;
+			slots[i].size[0]=slots[i].size[1]=0;
+			slots[i].receiver=0;
+			slots[i].frameIndex=0;
+			}
+		
+		/* Map each buffer as late as possible without stalling the next read-back into the same buffer: */
+		latency=numSlots>1?numSlots-1:1;
+		}
+	}
+
+ReadbackRing::~ReadbackRing(void)
+	{
+	/* Deliver all pending read-backs: */
+	flush();
+	
+	/* Release the pixel buffer objects: */
+	for(unsigned int i=0;i<numSlots;++i)
+		glDeleteBuffersARB(1,&slots[i].bufferId);
+	delete[] slots;
+	delete[] fallbackBuffer;
+	}
+
+bool ReadbackRing::isSupported(void)
+	{
+	/* Pixel buffer objects use the buffer object entry points of the vertex buffer object extension: */
+	return GLARBVertexBufferObject::isSupported()&&GLARBPixelBufferObject::isSupported();
+	}
+
+void ReadbackRing::startFrame(void)
+	{
+	++frameIndex;
+	
+	/* Deliver all read-backs that were requested at least the ring's latency ago: */
+	while(numPending>0&&frameIndex-slots[firstPending].frameIndex>=latency)
+		retireOldest();
+	}
+
+void ReadbackRing::readPixels(int width,int height,ReadbackRing::Receiver* receiver)
+	{
+	THREADS_PROFILE_ZONE("Vrui::ReadbackRing::readPixels");
+	
+	size_t frameSize=size_t(width)*size_t(height)*3;
+	setPackState();
+	
+	if(numSlots>0)
+		{
+		/* Free up the next slot if all slots are in use; this might stall until the oldest transfer completes: */
+		if(numPending==numSlots)
+			retireOldest();
+		
+		/* Queue the request in the next free slot: */
+		Slot& slot=slots[(firstPending+numPending)%numSlots];
+		++numPending;
+		slot.size[0]=width;
+		slot.size[1]=height;
+		slot.receiver=receiver;
+		slot.frameIndex=frameIndex;
+		
+		/* Start an asynchronous transfer into the slot's pixel buffer object: */
+		glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB,slot.bufferId);
+		if(slot.bufferSize!=frameSize)
+			{
+			glBufferDataARB(GL_PIXEL_PACK_BUFFER_ARB,frameSize,0,GL_STREAM_READ_ARB);
+			slot.bufferSize=frameSize;
+			}
+		glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,0);
+		glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB,0);
+		}
+	else
+		{
+		/* Read the frame buffer synchronously into the fallback buffer: */
+		if(fallbackBufferSize<frameSize)
+			{
+			delete[] fallbackBuffer;
+			fallbackBuffer=new unsigned char[frameSize];
+			fallbackBufferSize=frameSize;
+			}
+		glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,fallbackBuffer);
+		
+		/* Deliver the pixels immediately: */
+		try
+			{
+			receiver->receivePixels(width,height,fallbackBuffer);
+			}
+		catch(std::runtime_error err)
+			{
+			std::cerr<<"Vrui::ReadbackRing: Caught exception "<<err.what()<<" while delivering read-back frame"<<std::endl;
+			}
+		delete receiver;
+		}
+	}
+
+void ReadbackRing::flush(void)
+	{
+	/* Deliver all pending read-backs in order: */
+	while(numPending>0)
+		retireOldest();
+	}
+
+}
@@ -0,0 +1,102 @@
+/***********************************************************************
+ReadbackRing - Helper class to read back the contents of a window's
+frame buffer asynchronously through a ring of OpenGL pixel buffer
+objects, mapping each buffer only several frames after the read request
+was issued to overlap the transfer with rendering.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_INTERNAL_READBACKRING_INCLUDED
+#define VRUI_INTERNAL_READBACKRING_INCLUDED
+
+#include <stddef.h>
+#include <GL/gl.h>
+
+namespace Vrui {
+
+class ReadbackRing
+	{
+	/* Embedded classes: */
+	public:
+	class Receiver // Abstract base class for objects receiving read-back frame buffer contents
+		{
+		/* Constructors and destructors: */
+		public:
+		virtual ~Receiver(void)
+			{
+			}
+		
+		/* Methods: */
+		virtual void receivePixels(int width,int height,const unsigned char* pixels) =0; // Called from the rendering thread with tightly packed RGB pixels in bottom-up row order; pixels are only valid during the call
+		};
+	
+	private:
+	struct Slot // Structure for a pending read-back request
+		{
+		/* Elements: */
+		public:
+		GLuint bufferId; // ID of the slot's pixel buffer object
+		size_t bufferSize; // Currently allocated size of the pixel buffer object in bytes
+		int size[2]; // Width and height of the read-back frame buffer region
+		Receiver* receiver; // Receiver for the read-back pixels
+		unsigned int frameIndex; // Index of the frame in which the read-back was requested
+		};
+	
+	/* Elements: */
+	unsigned int numSlots; // Number of pixel buffer objects in the ring; zero if pixel buffer objects are not used
+	Slot* slots; // Array of read-back slots
+	unsigned int latency; // Number of frames between issuing a read-back request and mapping its pixel buffer object
+	unsigned int firstPending; // Index of the oldest pending slot
+	unsigned int numPending; // Number of pending slots
+	unsigned int frameIndex; // Index of the current frame
+	unsigned char* fallbackBuffer; // Buffer for synchronous read-backs if pixel buffer objects are not used
+	size_t fallbackBufferSize; // Allocated size of the synchronous read-back buffer in bytes
+	
+	/* Private methods: */
+	static void setPackState(void); // Sets up OpenGL pixel pack state for tightly packed RGB pixels
+	void retireOldest(void); // Maps the oldest pending slot, hands its pixels to its receiver, and deletes the receiver
+	
+	/* Constructors and destructors: */
+	public:
+	ReadbackRing(unsigned int sNumSlots); // Creates a ring of the given number of pixel buffer objects in the current OpenGL context; reads back synchronously if zero or if pixel buffer objects are not supported
+	private:
+	ReadbackRing(const ReadbackRing& source); // Prohibit copy constructor
+	ReadbackRing& operator=(const ReadbackRing& source); // Prohibit assignment operator
+	public:
+	~ReadbackRing(void); // Delivers all pending read-backs and releases the pixel buffer objects; must be called in the OpenGL context that created the ring
+	
+	/* Methods: */
+	static bool isSupported(void); // Returns true if the current OpenGL context supports asynchronous read-backs
+	bool isAsynchronous(void) const // Returns true if read-backs are delivered after a delay
+		{
+		return numSlots>0;
+		}
+	unsigned int getNumPending(void) const // Returns the number of read-backs that have not been delivered yet
+		{
+		return numPending;
+		}
+	void startFrame(void); // Starts a new frame and delivers all read-backs that were requested sufficiently many frames ago
+	void readPixels(int width,int height,Receiver* receiver); // Requests a read-back of the given-size lower-left region of the current read buffer; ring takes ownership of the receiver and deletes it after delivery
+	void flush(void); // Delivers all pending read-backs immediately
+	};
+
+}
+
+#endif
@@ -29,88 +29,266 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Misc/ConfigurationFile.h>
 #include <IO/File.h>
 #include <IO/OpenFile.h>
+#include <Threads/Profiler.h>
+#include <Threads/TaskScheduler.h>
 #include <Video/FrameBuffer.h>
 #include <Video/ImageExtractorRGB8.h>
 #include <Video/OggPage.h>
-#include <Video/TheoraInfo.h>
 #include <Video/TheoraComment.h>
+#include <Video/TheoraPacket.h>
+#include <Video/TheoraEncoder.h>
+#include <Vrui/Vrui.h>
 
 namespace Vrui {
 
+/**********************************************
+Declaration of struct TheoraMovieSaver::Chunk:
+**********************************************/
+
+struct TheoraMovieSaver::Chunk
+	{
+	/* Elements: */
+	public:
+	unsigned int firstFrameIndex; // Index of the chunk's first frame in the movie
+	unsigned int numFrames; // Number of frames submitted to the chunk so far
+	std::deque<Video::TheoraFrame*> frames; // Queue of converted frames waiting to be encoded
+	bool complete; // Flag whether all of the chunk's frames have been submitted
+	bool assigned; // Flag whether an encoding thread picked up the chunk
+	bool encoded; // Flag whether all of the chunk's frames have been encoded
+	std::vector<Video::TheoraPacket*> packets; // Encoded packets, with granule positions relative to the start of the movie
+	
+	/* Constructors and destructors: */
+	Chunk(unsigned int sFirstFrameIndex)
+		:firstFrameIndex(sFirstFrameIndex),numFrames(0),
+		 complete(false),assigned(false),encoded(false)
+		{
+		}
+	~Chunk(void)
+		{
+		/* Delete all unencoded frames and unwritten packets: */
+		for(std::deque<Video::TheoraFrame*>::iterator fIt=frames.begin();fIt!=frames.end();++fIt)
+			delete *fIt;
+		for(std::vector<Video::TheoraPacket*>::iterator pIt=packets.begin();pIt!=packets.end();++pIt)
+			delete *pIt;
+		}
+	};
+
 /*********************************
 Methods of class TheoraMovieSaver:
 *********************************/
 
+void TheoraMovieSaver::writePacket(ogg_packet& packet,bool flush)
+	{
+	/* Add the packet to the Ogg stream: */
+	oggStream.packetIn(packet);
+	
+	/* Write any generated pages to the movie file: */
+	Video::OggPage page;
+	if(flush)
+		{
+		while(oggStream.flush(page))
+			page.write(*movieFile);
+		}
+	else
+		{
+		while(oggStream.pageOut(page))
+			page.write(*movieFile);
+		}
+	}
+
+void TheoraMovieSaver::writeEncodedChunks(void)
+	{
+	Threads::Mutex::Lock writeLock(writeMutex);
+	
+	/* Write chunks in stream order until the front chunk is still being encoded: */
+	while(true)
+		{
+		/* Remove the front chunk from the queue if it has been encoded: */
+		Chunk* chunk;
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		if(chunks.empty()||!chunks.front()->encoded)
+			break;
+		chunk=chunks.front();
+		chunks.pop_front();
+		}
+		
+		/* Write the chunk's packets to the movie file: */
+		for(std::vector<Video::TheoraPacket*>::iterator pIt=chunk->packets.begin();pIt!=chunk->packets.end();++pIt)
+			writePacket(**pIt,false);
+		delete chunk;
+		}
+	}
+
+void* TheoraMovieSaver::encodingThreadMethod(void)
+	{
+	Threads::Profiler::setThreadName("Vrui Theora encoding thread");
+	
+	Video::TheoraEncoder theoraEncoder;
+	Video::TheoraComment comments;
+	comments.setVendorString("Virtual Reality User Interface (Vrui) MovieSaver");
+	Video::TheoraPacket packet;
+	while(true)
+		{
+		/* Wait for a chunk that is not yet being encoded: */
+		Chunk* chunk=0;
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		while(true)
+			{
+			for(std::deque<Chunk*>::iterator cIt=chunks.begin();cIt!=chunks.end()&&chunk==0;++cIt)
+				if(!(*cIt)->assigned)
+					chunk=*cIt;
+			if(chunk!=0||encodingDone)
+				break;
+			queueCond.wait(queueLock);
+			}
+		if(chunk==0)
+			break;
+		chunk->assigned=true;
+		}
+		
+		/* Start a fresh encoder so that the chunk does not depend on any previous chunks: */
+		theoraEncoder.init(theoraInfo);
+		if(chunk->firstFrameIndex==0)
+			{
+			Threads::Mutex::Lock writeLock(writeMutex);
+			
+			/* Write the stream header packets to the movie file; the first packet goes onto its own page: */
+			bool firstHeader=true;
+			while(theoraEncoder.emitHeader(comments,packet))
+				{
+				writePacket(packet,firstHeader);
+				firstHeader=false;
+				}
+			
+			/* Flush the Ogg stream: */
+			Video::OggPage page;
+			while(oggStream.flush(page))
+				page.write(*movieFile);
+			}
+		else
+			{
+			/* Discard the stream header packets; they are identical to the first chunk's: */
+			while(theoraEncoder.emitHeader(comments,packet))
+				;
+			}
+		
+		/* Encode the chunk's frames as they arrive: */
+		while(true)
+			{
+			/* Wait for the next frame: */
+			Video::TheoraFrame* theoraFrame;
+			{
+			Threads::MutexCond::Lock queueLock(queueCond);
+			while(chunk->frames.empty()&&!chunk->complete)
+				queueCond.wait(queueLock);
+			if(chunk->frames.empty())
+				break;
+			theoraFrame=chunk->frames.front();
+			chunk->frames.pop_front();
+			}
+			
+			/* Feed the converted Y'CbCr 4:2:0 frame to the Theora encoder: */
+			{
+			THREADS_PROFILE_ZONE("Vrui::TheoraMovieSaver::encodeFrame");
+			theoraEncoder.encodeFrame(*theoraFrame);
+			}
+			
+			/* Return the frame to the pool: */
+			{
+			Threads::MutexCond::Lock queueLock(queueCond);
+			freeFrames.push_back(theoraFrame);
+			}
+			
+			if(chunkSize==0)
+				{
+				/* Write all encoded Theora packets to the movie file: */
+				Threads::Mutex::Lock writeLock(writeMutex);
+				while(theoraEncoder.emitPacket(packet))
+					writePacket(packet,false);
+				}
+			else
+				{
+				/* Store copies of all encoded Theora packets until the chunk can be written: */
+				int shift=theoraInfo.keyframe_granule_shift;
+				while(theoraEncoder.emitPacket(packet))
+					{
+					Video::TheoraPacket* chunkPacket=new Video::TheoraPacket;
+					*chunkPacket=packet;
+					
+					/* Offset the packet's keyframe number from the start of the chunk to the start of the movie: */
+					if(chunkPacket->granulepos>=0)
+						{
+						ogg_int64_t keyframe=chunkPacket->granulepos>>shift;
+						ogg_int64_t delta=chunkPacket->granulepos-(keyframe<<shift);
+						chunkPacket->granulepos=((keyframe+ogg_int64_t(chunk->firstFrameIndex))<<shift)+delta;
+						}
+					chunk->packets.push_back(chunkPacket);
+					}
+				}
+			}
+		
+		if(chunkSize!=0)
+			{
+			/* Mark the chunk as encoded and write it if all preceding chunks have been written: */
+			{
+			Threads::MutexCond::Lock queueLock(queueCond);
+			chunk->encoded=true;
+			}
+			writeEncodedChunks();
+			}
+		}
+	
+	return 0;
+	}
+
 void TheoraMovieSaver::frameWritingThreadMethod(void)
 	{
 	/* Get the first frame: */
 	frames.lockNewValue();
 	const FrameBuffer& frame=frames.getLockedValue();
 	
-	/* Create the Theora info structure: */
-	Video::TheoraInfo theoraInfo;
+	/* Complete the Theora info structure: */
 	unsigned int imageSize[2];
 	for(int i=0;i<2;++i)
 		imageSize[i]=(unsigned int)frame.getFrameSize()[i];
 	theoraInfo.setImageSize(imageSize);
 	theoraInfo.colorspace=TH_CS_UNSPECIFIED;
 	theoraInfo.pixel_fmt=TH_PF_420;
-	theoraInfo.target_bitrate=theoraBitrate;
-	theoraInfo.quality=theoraQuality;
-	theoraInfo.setGopSize(theoraGopSize);
-	theoraInfo.fps_numerator=theoraFrameRate;
-	theoraInfo.fps_denominator=1;
-	theoraInfo.aspect_numerator=1;
-	theoraInfo.aspect_denominator=1;
-	theoraEncoder.init(theoraInfo);
-	if(!theoraEncoder.isValid())
+	
+	/* Check that the Theora encoder accepts the stream format: */
+	try
+		{
+		Video::TheoraEncoder testEncoder;
+		testEncoder.init(theoraInfo);
+		}
+	catch(std::runtime_error err)
 		{
 		std::cerr<<"MovieSaver: Could not initialize Theora encoder"<<std::endl;
 		return;
 		}
 	
-	/* Create the image extractor: */
+	/* Create the image extractor and let it convert frames in parallel: */
 	imageExtractor=new Video::ImageExtractorRGB8(imageSize);
+	imageExtractor->setTaskScheduler(getTaskScheduler());
 	
-	/* Create the Theora frame buffer: */
-	theoraFrame.init420(theoraInfo);
-	
-	/*************************************************
-	Write the Theora stream headers to the Ogg stream:
-	*************************************************/
-	
-	/* Set up a comment structure: */
-	Video::TheoraComment comments;
-	comments.setVendorString("Virtual Reality User Interface (Vrui) MovieSaver");
-	
-	/* Write the first stream header packet to the movie file: */
-	Video::TheoraPacket packet;
-	if(theoraEncoder.emitHeader(comments,packet))
+	/* Create the pool of Theora frame buffers: */
+	for(unsigned int i=0;i<queueSize;++i)
 		{
-		/* Write the packet to the movie file: */
-		oggStream.packetIn(packet);
-		Video::OggPage page;
-		while(oggStream.flush(page))
-			page.write(*movieFile);
-		}
-	
-	/* Write all remaining stream header packets to the movie file: */
-	while(theoraEncoder.emitHeader(comments,packet))
-		{
-		oggStream.packetIn(packet);
-		Video::OggPage page;
-		while(oggStream.pageOut(page))
-			page.write(*movieFile);
+		Video::TheoraFrame* theoraFrame=new Video::TheoraFrame;
+		theoraFrame->init420(theoraInfo);
+		freeFrames.push_back(theoraFrame);
 		}
 	
-	/* Flush the Ogg stream: */
-	Video::OggPage page;
-	while(oggStream.flush(page))
-		page.write(*movieFile);
+	/* Start the encoding threads: */
+	encodingThreads=new Threads::Thread[numEncodingThreads];
+	for(unsigned int i=0;i<numEncodingThreads;++i)
+		encodingThreads[i].start(this,&TheoraMovieSaver::encodingThreadMethod);
 	
-	/* Encode and save frames until shut down: */
+	/* Convert and queue frames until shut down: */
 	unsigned int frameIndex=0;
-	while(true)
+	while(keepWriting)
 		{
 		/* Get the most recent frame and check whether it's new: */
 		bool newFrame=frames.lockNewValue();
@@ -124,36 +302,55 @@ void TheoraMovieSaver::frameWritingThreadMethod(void)
 				std::cerr<<"MovieSaver: Terminating due to changed frame size"<<std::endl;
 				return;
 				}
-			
-			/* Convert the new raw RGB frame to Y'CbCr 4:2:0: */
-			Video::FrameBuffer tempFrame;
-			tempFrame.start=frame.getBuffer();
-			imageExtractor->extractYpCbCr420(&tempFrame,theoraFrame.planes[0].data,theoraFrame.planes[0].stride,theoraFrame.planes[1].data,theoraFrame.planes[1].stride,theoraFrame.planes[2].data,theoraFrame.planes[2].stride);
 			}
 		
-		/* Feed the last converted Y'CbCr 4:2:0 frame to the Theora encoder: */
-		theoraEncoder.encodeFrame(theoraFrame);
+		/* Grab an unused Theora frame buffer from the pool: */
+		Video::TheoraFrame* theoraFrame=0;
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		if(!freeFrames.empty())
+			{
+			theoraFrame=freeFrames.back();
+			freeFrames.pop_back();
+			}
+		}
 		
-		/* Write all encoded Theora packets to the movie file: */
-		Video::TheoraPacket packet;
-		while(theoraEncoder.emitPacket(packet))
+		if(theoraFrame!=0)
+			{
+			/* Convert the most recent raw RGB frame to Y'CbCr 4:2:0; this repeats the previous frame if no new frame arrived: */
 			{
-			/* Add the packet to the Ogg stream: */
-			oggStream.packetIn(packet);
+			THREADS_PROFILE_ZONE("Vrui::TheoraMovieSaver::convertFrame");
+			Video::FrameBuffer tempFrame;
+			tempFrame.start=frame.getBuffer();
+			imageExtractor->extractYpCbCr420(&tempFrame,theoraFrame->planes[0].data,theoraFrame->planes[0].stride,theoraFrame->planes[1].data,theoraFrame->planes[1].stride,theoraFrame->planes[2].data,theoraFrame->planes[2].stride);
+			}
 			
-			/* Write any generated pages to the movie file: */
-			Video::OggPage page;
-			while(oggStream.pageOut(page))
-				page.write(*movieFile);
+			/* Append the converted frame to the most recent chunk, or start a new chunk if that one is full: */
+			Threads::MutexCond::Lock queueLock(queueCond);
+			if(chunks.empty()||chunks.back()->complete)
+				chunks.push_back(new Chunk(numQueuedFrames));
+			Chunk* chunk=chunks.back();
+			chunk->frames.push_back(theoraFrame);
+			++chunk->numFrames;
+			++numQueuedFrames;
+			if(chunkSize!=0&&chunk->numFrames==chunkSize)
+				chunk->complete=true;
+			queueCond.broadcast();
+			}
+		else
+			{
+			/* The encoding threads fell behind; drop the frame: */
+			++numDroppedFrames;
 			}
 		++frameIndex;
 		
 		/* Wait for the next frame: */
-		int numSkippedFrames=waitForNextFrame();
-		if(numSkippedFrames>0)
+		int numSkipped=waitForNextFrame();
+		if(numSkipped>0)
 			{
-			std::cerr<<"MovieSaver: Skipped frames "<<frameIndex<<" to "<<frameIndex+numSkippedFrames-1<<std::endl;
-			frameIndex+=numSkippedFrames;
+			std::cerr<<"MovieSaver: Skipped frames "<<frameIndex<<" to "<<frameIndex+numSkipped-1<<std::endl;
+			frameIndex+=numSkipped;
+			numSkippedFrames+=numSkipped;
 			}
 		}
 	}
@@ -163,7 +360,11 @@ TheoraMovieSaver::TheoraMovieSaver(const Misc::ConfigurationFileSection& configF
 	 movieFile(IO::openFile(configFileSection.retrieveString("./movieFileName").c_str(),IO::File::WriteOnly)),
 	 oggStream(1),
 	 theoraBitrate(0),theoraQuality(32),theoraGopSize(32),
-	 imageExtractor(0)
+	 queueSize(8),chunkSize(0),numEncodingThreads(1),
+	 imageExtractor(0),
+	 keepWriting(true),
+	 numQueuedFrames(0),encodingDone(false),encodingThreads(0),
+	 numDroppedFrames(0),numSkippedFrames(0)
 	{
 	movieFile->setEndianness(Misc::LittleEndian);
 	
@@ -184,19 +385,88 @@ TheoraMovieSaver::TheoraMovieSaver(const Misc::ConfigurationFileSection& configF
 	theoraFrameRate=int(frameRate+0.5);
 	frameRate=theoraFrameRate;
 	frameInterval=Misc::Time(1.0/frameRate);
+	
+	/* Initialize the Theora info structure; the frame size is set when the first frame arrives: */
+	theoraInfo.target_bitrate=theoraBitrate;
+	theoraInfo.quality=theoraQuality;
+	theoraInfo.setGopSize(theoraGopSize);
+	theoraInfo.fps_numerator=theoraFrameRate;
+	theoraInfo.fps_denominator=1;
+	theoraInfo.aspect_numerator=1;
+	theoraInfo.aspect_denominator=1;
+	
+	/* Read the encoding queue and chunk parameters: */
+	queueSize=configFileSection.retrieveValue<unsigned int>("./movieQueueSize",queueSize);
+	if(queueSize<1)
+		queueSize=1;
+	chunkSize=configFileSection.retrieveValue<unsigned int>("./movieChunkSize",chunkSize);
+	if(chunkSize>0)
+		{
+		/* Round the chunk size up to a multiple of the keyframe distance: */
+		unsigned int gopSize=(unsigned int)theoraInfo.getGopSize();
+		chunkSize=((chunkSize+gopSize-1)/gopSize)*gopSize;
+		
+		/* Encode chunks on all CPUs by default: */
+		numEncodingThreads=configFileSection.retrieveValue<unsigned int>("./movieNumEncodingThreads",Threads::TaskScheduler::getNumProcessors());
+		if(numEncodingThreads<1)
+			numEncodingThreads=1;
+		
+		/* Frames are handed to one chunk at a time, so chunks are only encoded in parallel if the queue holds all their frames; shrink the chunks to fit the configured queue instead of growing the queue, as each queued frame holds an entire image: */
+		unsigned int maxChunkSize=((queueSize/numEncodingThreads)/gopSize)*gopSize;
+		if(maxChunkSize<gopSize)
+			{
+			/* Not even one keyframe distance per thread fits into the queue; use fewer threads: */
+			unsigned int maxNumEncodingThreads=queueSize/gopSize;
+			if(maxNumEncodingThreads<1)
+				maxNumEncodingThreads=1;
+			std::cerr<<"MovieSaver: Reducing the number of encoding threads from "<<numEncodingThreads<<" to "<<maxNumEncodingThreads<<" to fit the queue size of "<<queueSize<<" frames"<<std::endl;
+			numEncodingThreads=maxNumEncodingThreads;
+			maxChunkSize=gopSize;
+			}
+		if(chunkSize>maxChunkSize)
+			{
+			std::cerr<<"MovieSaver: Reducing the chunk size from "<<chunkSize<<" to "<<maxChunkSize<<" frames to fit the queue size of "<<queueSize<<" frames"<<std::endl;
+			chunkSize=maxChunkSize;
+			}
+		}
 	}
 
 TheoraMovieSaver::~TheoraMovieSaver(void)
 	{
 	/* Stop the frame writing thread: */
-	frameWritingThread.cancel();
-	frameWritingThread.join();
+	keepWriting=false;
+	if(!frameWritingThread.isJoined())
+		frameWritingThread.join();
+	
+	if(encodingThreads!=0)
+		{
+		/* Let the encoding threads finish all queued frames and shut down: */
+		{
+		Threads::MutexCond::Lock queueLock(queueCond);
+		if(!chunks.empty())
+			chunks.back()->complete=true;
+		encodingDone=true;
+		queueCond.broadcast();
+		}
+		for(unsigned int i=0;i<numEncodingThreads;++i)
+			encodingThreads[i].join();
+		delete[] encodingThreads;
+		
+		/* Print frame statistics: */
+		std::cout<<"MovieSaver: Encoded "<<numQueuedFrames<<" frames, dropped "<<numDroppedFrames<<" frames due to a full encoding queue, skipped "<<numSkippedFrames<<" frames due to late conversion"<<std::endl;
+		}
 	
 	/* Flush the Ogg stream: */
 	Video::OggPage page;
 	while(oggStream.flush(page))
 		page.write(*movieFile);
 	
+	/* Delete all remaining chunks and the frame pool: */
+	for(std::deque<Chunk*>::iterator cIt=chunks.begin();cIt!=chunks.end();++cIt)
+		delete *cIt;
+	for(std::vector<Video::TheoraFrame*>::iterator fIt=freeFrames.begin();fIt!=freeFrames.end();++fIt)
+		delete *fIt;
+	
 	/* Delete the image extractor: */
 	delete imageExtractor;
 	}
@@ -24,32 +24,57 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #ifndef VRUI_INTERNAL_THEORAMOVIESAVER_INCLUDED
 #define VRUI_INTERNAL_THEORAMOVIESAVER_INCLUDED
 
+#include <deque>
+#include <vector>
 #include <IO/File.h>
+#include <Threads/Mutex.h>
+#include <Threads/MutexCond.h>
+#include <Threads/Thread.h>
 #include <Video/OggStream.h>
+#include <Video/TheoraInfo.h>
 #include <Video/TheoraFrame.h>
-#include <Video/TheoraEncoder.h>
 #include <Vrui/Internal/MovieSaver.h>
 
 /* Forward declarations: */
 namespace Video {
-class ImageExtractor;
+class ImageExtractorRGB8;
 }
 
 namespace Vrui {
 
 class TheoraMovieSaver:public MovieSaver
 	{
-	/* Elements: */
+	/* Embedded classes: */
 	private:
+	struct Chunk; // Structure for runs of consecutive frames that are encoded independently of each other
+	
+	/* Elements: */
 	IO::FilePtr movieFile; // The created movie file
 	Video::OggStream oggStream; // The Ogg stream for the created movie file
 	int theoraBitrate; // Target bitrate for Theora encoder in CBR mode
 	int theoraQuality; // Target quality for Theora encoder in VBR mode
 	int theoraGopSize; // Distance between keyframes in the Theora video stream
 	int theoraFrameRate; // Integer frame rate
-	Video::ImageExtractor* imageExtractor; // Extractor to convert RGB images to Y'CbCr 4:2:0 images
-	Video::TheoraEncoder theoraEncoder; // Theora encoder object
-	Video::TheoraFrame theoraFrame; // Frame buffer for frames in Y'CbCr 4:2:0 pixel format
+	unsigned int queueSize; // Maximum number of converted frames waiting to be encoded
+	unsigned int chunkSize; // Number of frames in each independently encoded chunk, or zero to encode the movie as a single chunk
+	unsigned int numEncodingThreads; // Number of threads encoding chunks in parallel
+	Video::TheoraInfo theoraInfo; // Format of the Theora video stream
+	Video::ImageExtractorRGB8* imageExtractor; // Extractor to convert RGB images to Y'CbCr 4:2:0 images
+	volatile bool keepWriting; // Flag to shut down the frame writing thread
+	Threads::MutexCond queueCond; // Condition variable protecting the frame pool and chunk queue, signalled when frames or chunks are added
+	std::vector<Video::TheoraFrame*> freeFrames; // Pool of Y'CbCr 4:2:0 frames not currently waiting to be encoded
+	std::deque<Chunk*> chunks; // Queue of chunks in stream order that have not been written to the movie file yet
+	unsigned int numQueuedFrames; // Total number of frames submitted to chunks
+	bool encodingDone; // Flag to shut down the encoding threads once all queued frames are encoded
+	Threads::Thread* encodingThreads; // Array of threads encoding chunks
+	Threads::Mutex writeMutex; // Mutex serializing writes to the Ogg stream
+	unsigned int numDroppedFrames; // Number of frames dropped because the encoding queue was full
+	unsigned int numSkippedFrames; // Number of frames skipped because the frame writing thread fell behind
+	
+	/* Private methods: */
+	void writePacket(ogg_packet& packet,bool flush); // Writes a packet to the Ogg stream, and writes completed pages or flushes the stream
+	void writeEncodedChunks(void); // Writes all encoded chunks at the front of the chunk queue to the movie file
+	void* encodingThreadMethod(void); // Encodes queued chunks
 	
 	/* Protected methods from MovieSaver: */
 	protected:
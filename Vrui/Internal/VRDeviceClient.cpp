@@ -24,9 +24,13 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/Internal/VRDeviceClient.h>
 
 #include <Misc/Time.h>
+#include <Misc/StandardMarshallers.h>
 #include <Misc/StandardValueCoders.h>
 #include <Misc/ConfigurationFile.h>
+#include <Threads/Profiler.h>
 #include <Vrui/Internal/VRDeviceDescriptor.h>
+#include <Vrui/Internal/VRDeviceSubscription.h>
+#include <Vrui/Internal/VRDeviceSharedState.h>
 
 namespace Vrui {
 
@@ -34,9 +38,75 @@ namespace Vrui {
 Methods of class VRDeviceClient:
 *******************************/
 
+void VRDeviceClient::readState(VRDevicePipe::MessageIdType message)
+	{
+	Threads::Mutex::Lock stateLock(stateMutex);
+	if(message==VRDevicePipe::PACKET_DELTA_REPLY)
+		{
+		/* Apply the server's changed state components: */
+		VRDeviceSubscription::readDelta(state,serverProtocolVersionNumber>=5U,pipe);
+		}
+	else
+		{
+		/* Read server's full state: */
+		state.read(pipe);
+		
+		/* Read the tracker states' sample ages, or assume that all tracker states are fresh: */
+		if(serverProtocolVersionNumber>=5U)
+			state.readTrackerTimeStamps(pipe);
+		else
+			state.touchTrackerTimeStamps();
+		}
+	}
+
+void VRDeviceClient::receiveSharedStream(void)
+	{
+	Misc::UInt32 lastSequence=sharedState->getSequence();
+	while(!stopSharedStream)
+		{
+		/* Wait for the server to publish a new state, or for a timeout to check the stop flag: */
+		if(sharedState->waitForUpdate(lastSequence,Misc::Time(0,100000000)))
+			{
+			/* Check if the server is shutting down: */
+			if(!sharedState->isAlive())
+				{
+				if(errorCallback!=0)
+					(*errorCallback)(ProtocolError("VRDeviceClient: Server stopped publishing states",this));
+				connectionDead=true;
+				packetSignalCond.broadcast();
+				break;
+				}
+			
+			/* Copy the server's state: */
+			{
+			THREADS_PROFILE_ZONE("Vrui::VRDeviceClient::receiveSharedState");
+			Threads::Mutex::Lock stateLock(stateMutex);
+			lastSequence=sharedState->read(state);
+			}
+			
+			/* Signal packet reception: */
+			packetSignalCond.broadcast();
+			
+			/* Invoke packet notification callback: */
+			if(packetNotificationCallback!=0)
+				(*packetNotificationCallback)(this);
+			}
+		else if(pipe.waitForData(Misc::Time(0,0)))
+			{
+			/* The server does not send anything while streaming through shared memory; the connection must have been interrupted: */
+			if(errorCallback!=0)
+				(*errorCallback)(ProtocolError("VRDeviceClient: Server disconnected",this));
+			connectionDead=true;
+			packetSignalCond.broadcast();
+			break;
+			}
+		}
+	}
+
 void* VRDeviceClient::streamReceiveThreadMethod(void)
 	{
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
+	Threads::Profiler::setThreadName("VRDeviceClient stream receive thread");
 	
 	while(true)
 		{
@@ -44,12 +114,12 @@ void* VRDeviceClient::streamReceiveThreadMethod(void)
 		try
 			{
 			VRDevicePipe::MessageIdType message=pipe.readMessage();
-			if(message==VRDevicePipe::PACKET_REPLY)
+			if(message==VRDevicePipe::PACKET_REPLY||message==VRDevicePipe::PACKET_DELTA_REPLY)
 				{
 				/* Read server's state: */
 				{
-				Threads::Mutex::Lock stateLock(stateMutex);
-				state.read(pipe);
+				THREADS_PROFILE_ZONE("Vrui::VRDeviceClient::readState");
+				readState(message);
 				}
 				
 				/* Signal packet reception: */
@@ -58,6 +128,13 @@ void* VRDeviceClient::streamReceiveThreadMethod(void)
 				/* Invoke packet notification callback: */
 				if(packetNotificationCallback!=0)
 					(*packetNotificationCallback)(this);
+				
+				/* After the initial state packet, receive all further states through shared memory: */
+				if(sharedState!=0)
+					{
+					receiveSharedStream();
+					break;
+					}
 				}
 			else if(message==VRDevicePipe::STOPSTREAM_REPLY)
 				break;
@@ -89,7 +166,7 @@ void* VRDeviceClient::streamReceiveThreadMethod(void)
 	return 0;
 	}
 
-void VRDeviceClient::initClient(void)
+void VRDeviceClient::initClient(bool useSharedMemory)
 	{
 	/* Initiate connection: */
 	pipe.writeMessage(VRDevicePipe::CONNECT_REQUEST);
@@ -124,24 +201,60 @@ void VRDeviceClient::initClient(void)
 			virtualDevices.push_back(newDevice);
 			}
 		}
+	
+	if(useSharedMemory&&serverProtocolVersionNumber>=4U&&VRDeviceSharedState::isSupported())
+		{
+		/* Request the server's shared memory segment: */
+		pipe.writeMessage(VRDevicePipe::SHAREDMEMORY_REQUEST);
+		pipe.flush();
+		if(!pipe.waitForData(Misc::Time(30,0)))
+			throw ProtocolError("VRDeviceClient: Timeout while waiting for SHAREDMEMORY_REPLY",this);
+		if(pipe.readMessage()!=VRDevicePipe::SHAREDMEMORY_REPLY)
+			throw ProtocolError("VRDeviceClient: Mismatching message while waiting for SHAREDMEMORY_REPLY",this);
+		std::string sharedMemoryName=Misc::Marshaller<std::string>::read(pipe);
+		VRDeviceSharedState::Key sharedMemoryKey=pipe.read<VRDeviceSharedState::Key>();
+		
+		if(!sharedMemoryName.empty())
+			{
+			/* Try attaching to the segment; this fails if the server runs on a different host: */
+			try
+				{
+				sharedState=new VRDeviceSharedState(sharedMemoryName.c_str(),sharedMemoryKey,state);
+				}
+			catch(std::runtime_error)
+				{
+				/* Fall back to receiving states through the pipe: */
+				}
+			
+			/* Tell the server whether to send streamed states through the pipe: */
+			if(sharedState!=0)
+				{
+				pipe.writeMessage(VRDevicePipe::ATTACHSHAREDMEMORY_REQUEST);
+				pipe.write<unsigned char>(1);
+				pipe.flush();
+				}
+			}
+		}
 	}
 
-VRDeviceClient::VRDeviceClient(const char* deviceServerName,int deviceServerPort)
+VRDeviceClient::VRDeviceClient(const char* deviceServerName,int deviceServerPort,bool useSharedMemory)
 	:pipe(deviceServerName,deviceServerPort),
 	 serverProtocolVersionNumber(0),
+	 sharedState(0),stopSharedStream(false),
 	 active(false),streaming(false),connectionDead(false),
 	 packetNotificationCallback(0),errorCallback(0)
 	{
-	initClient();
+	initClient(useSharedMemory);
 	}
 
 VRDeviceClient::VRDeviceClient(const Misc::ConfigurationFileSection& configFileSection)
 	:pipe(configFileSection.retrieveString("./serverName").c_str(),configFileSection.retrieveValue<int>("./serverPort")),
 	 serverProtocolVersionNumber(0),
+	 sharedState(0),stopSharedStream(false),
 	 active(false),streaming(false),connectionDead(false),
 	 packetNotificationCallback(0),errorCallback(0)
 	{
-	initClient();
+	initClient(configFileSection.retrieveValue<bool>("./useSharedMemory",true));
 	}
 
 VRDeviceClient::~VRDeviceClient(void)
@@ -161,6 +274,23 @@ VRDeviceClient::~VRDeviceClient(void)
 	/* Delete all virtual input devices: */
 	for(std::vector<VRDeviceDescriptor*>::iterator vdIt=virtualDevices.begin();vdIt!=virtualDevices.end();++vdIt)
 		delete *vdIt;
+	
+	/* Detach from the server's shared memory segment: */
+	delete sharedState;
+	}
+
+bool VRDeviceClient::subscribe(const VRDeviceSubscription& subscription)
+	{
+	/* Bail out if the server does not understand subscriptions, or if the client is in an invalid state: */
+	if(serverProtocolVersionNumber<3U||streaming||connectionDead)
+		return false;
+	
+	/* Send subscription request message: */
+	pipe.writeMessage(VRDevicePipe::SUBSCRIBE_REQUEST);
+	subscription.write(pipe);
+	pipe.flush();
+	
+	return true;
 	}
 
 void VRDeviceClient::activate(void)
@@ -212,7 +342,8 @@ void VRDeviceClient::getPacket(void)
 				connectionDead=true;
 				throw ProtocolError("VRDeviceClient: Timout while waiting for PACKET_REPLY",this);
 				}
-			if(pipe.readMessage()!=VRDevicePipe::PACKET_REPLY)
+			VRDevicePipe::MessageIdType message=pipe.readMessage();
+			if(message!=VRDevicePipe::PACKET_REPLY&&message!=VRDevicePipe::PACKET_DELTA_REPLY)
 				{
 				connectionDead=true;
 				throw ProtocolError("VRDeviceClient: Mismatching message while waiting for PACKET_REPLY",this);
@@ -221,8 +352,7 @@ void VRDeviceClient::getPacket(void)
 			/* Read server's state: */
 			try
 				{
-				Threads::Mutex::Lock stateLock(stateMutex);
-				state.read(pipe);
+				readState(message);
 				}
 			catch(std::runtime_error err)
 				{
@@ -267,7 +397,23 @@ void VRDeviceClient::stopStream(void)
 	if(streaming)
 		{
 		streaming=false;
-		if(!connectionDead)
+		if(sharedState!=0)
+			{
+			/* Stop the packet receiving thread: */
+			stopSharedStream=true;
+			streamReceiveThread.join();
+			stopSharedStream=false;
+			
+			if(!connectionDead)
+				{
+				/* Send stop streaming message and wait for the server's reply: */
+				pipe.writeMessage(VRDevicePipe::STOPSTREAM_REQUEST);
+				pipe.flush();
+				if(!pipe.waitForData(Misc::Time(10,0))||pipe.readMessage()!=VRDevicePipe::STOPSTREAM_REPLY)
+					connectionDead=true;
+				}
+			}
+		else if(!connectionDead)
 			{
 			/* Send stop streaming message: */
 			pipe.writeMessage(VRDevicePipe::STOPSTREAM_REQUEST);
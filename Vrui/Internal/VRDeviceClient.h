@@ -40,6 +40,8 @@ class ConfigurationFileSection;
 }
 namespace Vrui {
 class VRDeviceDescriptor;
+class VRDeviceSubscription;
+class VRDeviceSharedState;
 }
 
 namespace Vrui {
@@ -72,6 +74,8 @@ class VRDeviceClient
 	std::vector<VRDeviceDescriptor*> virtualDevices; // List of virtual input devices managed by the server
 	Threads::Mutex stateMutex; // Mutex to serialize access to current state
 	VRDeviceState state; // Shadow of server's current state
+	VRDeviceSharedState* sharedState; // Server's shared memory state segment if the server runs on the same host, or null
+	volatile bool stopSharedStream; // Flag to stop the packet receiving thread when streaming through shared memory
 	bool active; // Flag if client is active
 	bool streaming; // Flag if client is in streaming mode
 	volatile bool connectionDead; // Flag whether the connection to the server was interrupted while in streaming mode
@@ -81,12 +85,14 @@ class VRDeviceClient
 	ErrorCallback* errorCallback; // Function called when a protocol error occurs in streaming mode (called from background thread)
 	
 	/* Private methods: */
+	void readState(VRDevicePipe::MessageIdType message); // Reads a full or delta-encoded state packet of the given message type from the server
 	void* streamReceiveThreadMethod(void); // Stream packet receiving thread method
-	void initClient(void); // Initializes communication between device server and client
+	void receiveSharedStream(void); // Receives streamed states from the server's shared memory segment
+	void initClient(bool useSharedMemory); // Initializes communication between device server and client; tries to attach to the server's shared memory segment if flag is true
 	
 	/* Constructors and destructors: */
 	public:
-	VRDeviceClient(const char* deviceServerName,int deviceServerPort); // Connects client to given server
+	VRDeviceClient(const char* deviceServerName,int deviceServerPort,bool useSharedMemory =false); // Connects client to given server; receives streamed states through shared memory if flag is true and the server runs on the same host
 	VRDeviceClient(const Misc::ConfigurationFileSection& configFileSection); // Connects client to server listed in current configuration file section
 	~VRDeviceClient(void); // Disconnects client from server
 	
@@ -111,6 +117,11 @@ class VRDeviceClient
 		{
 		return state;
 		}
+	bool isSharedMemory(void) const // Returns true if the client receives streamed states through shared memory
+		{
+		return sharedState!=0;
+		}
+	bool subscribe(const VRDeviceSubscription& subscription); // Asks the server to only send the given subset of its state as delta-encoded packets; must not be called in streaming mode; returns false if the server does not support subscriptions
 	void activate(void); // Prepares the server for sending state packets
 	void deactivate(void); // Deactivates server
 	void getPacket(void); // Requests state packet from server; blocks until arrival
@@ -29,6 +29,6 @@ namespace Vrui {
 Static elements of class VRDevicePipe:
 *************************************/
 
-const unsigned int VRDevicePipe::protocolVersionNumber=2U;
+const unsigned int VRDevicePipe::protocolVersionNumber=5U;
 
 }
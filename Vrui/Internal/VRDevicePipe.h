@@ -46,7 +46,12 @@ class VRDevicePipe:public Comm::TCPPipe
 		PACKET_REPLY, // Sends a device state packet
 		STARTSTREAM_REQUEST, // Requests entering stream mode (server sends packets automatically)
 		STOPSTREAM_REQUEST, // Requests leaving stream mode
-		STOPSTREAM_REPLY // Server's reply after last stream packet has been sent
+		STOPSTREAM_REPLY, // Server's reply after last stream packet has been sent
+		SUBSCRIBE_REQUEST, // Requests to only receive a subset of the server's state as delta-encoded packets (protocol version 3)
+		PACKET_DELTA_REPLY, // Sends a delta-encoded device state packet to a subscribed client (protocol version 3)
+		SHAREDMEMORY_REQUEST, // Requests the name of the server's shared memory state segment (protocol version 4)
+		SHAREDMEMORY_REPLY, // Sends the name and key of the server's shared memory state segment, or an empty name if there is none
+		ATTACHSHAREDMEMORY_REQUEST // Tells the server whether the client reads streamed states from shared memory instead of the pipe
 		};
 	
 	/* Constructors and destructors: */
@@ -0,0 +1,276 @@
+/***********************************************************************
+VRDeviceSharedState - Class to publish the current state of a VR device
+server in a POSIX shared memory segment, from which device clients on
+the same host can read it without going through the network stack.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/Internal/VRDeviceSharedState.h>
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include <Misc/Time.h>
+#include <Misc/ThrowStdErr.h>
+
+namespace Vrui {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+const Misc::UInt32 sharedStateMagic=0x56524453U; // Magic number "VRDS"
+
+size_t alignSize(size_t size) // Rounds the given size up to a multiple of 16 bytes
+	{
+	return (size+15)&~size_t(15);
+	}
+
+}
+
+/************************************
+Methods of class VRDeviceSharedState:
+************************************/
+
+size_t VRDeviceSharedState::calcSize(int numTrackers,int numButtons,int numValuators)
+	{
+	size_t result=alignSize(sizeof(Header));
+	result+=alignSize(numTrackers*sizeof(VRDeviceState::TrackerState));
+	result+=alignSize(numTrackers*sizeof(VRDeviceState::TimeStamp));
+	result+=alignSize(numButtons*sizeof(VRDeviceState::ButtonState));
+	result+=alignSize(numValuators*sizeof(VRDeviceState::ValuatorState));
+	return result;
+	}
+
+void VRDeviceSharedState::setPointers(void)
+	{
+	char* ptr=static_cast<char*>(memory);
+	header=reinterpret_cast<Header*>(ptr);
+	ptr+=alignSize(sizeof(Header));
+	trackerStates=reinterpret_cast<VRDeviceState::TrackerState*>(ptr);
+	ptr+=alignSize(header->numTrackers*sizeof(VRDeviceState::TrackerState));
+	trackerTimeStamps=reinterpret_cast<VRDeviceState::TimeStamp*>(ptr);
+	ptr+=alignSize(header->numTrackers*sizeof(VRDeviceState::TimeStamp));
+	buttonStates=reinterpret_cast<VRDeviceState::ButtonState*>(ptr);
+	ptr+=alignSize(header->numButtons*sizeof(VRDeviceState::ButtonState));
+	valuatorStates=reinterpret_cast<VRDeviceState::ValuatorState*>(ptr);
+	}
+
+bool VRDeviceSharedState::isSupported(void)
+	{
+	#ifdef __linux__
+	return true;
+	#else
+	return false;
+	#endif
+	}
+
+VRDeviceSharedState::VRDeviceSharedState(const char* sName,const VRDeviceState& state)
+	:name(sName),owner(true),
+	 size(calcSize(state.getNumTrackers(),state.getNumButtons(),state.getNumValuators())),
+	 memory(0),header(0),trackerStates(0),trackerTimeStamps(0),buttonStates(0),valuatorStates(0)
+	{
+	/* Create the shared memory segment, replacing any stale segment left behind by a crashed server: */
+	shm_unlink(name.c_str());
+	int fd=shm_open(name.c_str(),O_RDWR|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	if(fd<0)
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to create shared memory segment %s due to error %s",name.c_str(),strerror(errno));
+	if(ftruncate(fd,size)<0)
+		{
+		int error=errno;
+		close(fd);
+		shm_unlink(name.c_str());
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to size shared memory segment %s due to error %s",name.c_str(),strerror(error));
+		}
+	
+	/* Map the segment: */
+	memory=mmap(0,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+	int error=errno;
+	close(fd);
+	if(memory==MAP_FAILED)
+		{
+		shm_unlink(name.c_str());
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to map shared memory segment %s due to error %s",name.c_str(),strerror(error));
+		}
+	
+	/* Initialize the segment header: */
+	header=static_cast<Header*>(memory);
+	header->numTrackers=Misc::UInt32(state.getNumTrackers());
+	header->numButtons=Misc::UInt32(state.getNumButtons());
+	header->numValuators=Misc::UInt32(state.getNumValuators());
+	
+	/* Create a key unique to this server instance: */
+	timespec now;
+	clock_gettime(CLOCK_REALTIME,&now);
+	header->key=(Key(now.tv_sec)<<32)^(Key(now.tv_nsec)<<8)^Key(getpid());
+	header->sequence=0U;
+	header->alive=1U;
+	setPointers();
+	
+	/* Publish the initial state and mark the segment as valid: */
+	publish(state);
+	__sync_synchronize();
+	header->magic=sharedStateMagic;
+	}
+
+VRDeviceSharedState::VRDeviceSharedState(const char* sName,VRDeviceSharedState::Key key,const VRDeviceState& state)
+	:name(sName),owner(false),
+	 size(calcSize(state.getNumTrackers(),state.getNumButtons(),state.getNumValuators())),
+	 memory(0),header(0),trackerStates(0),trackerTimeStamps(0),buttonStates(0),valuatorStates(0)
+	{
+	/* Open the shared memory segment: */
+	int fd=shm_open(name.c_str(),O_RDONLY,0);
+	if(fd<0)
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to open shared memory segment %s due to error %s",name.c_str(),strerror(errno));
+	
+	/* Check the segment's size: */
+	struct stat segmentStat;
+	if(fstat(fd,&segmentStat)<0||size_t(segmentStat.st_size)!=size)
+		{
+		close(fd);
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Shared memory segment %s has mismatching size",name.c_str());
+		}
+	
+	/* Map the segment read-only: */
+	memory=mmap(0,size,PROT_READ,MAP_SHARED,fd,0);
+	int error=errno;
+	close(fd);
+	if(memory==MAP_FAILED)
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to map shared memory segment %s due to error %s",name.c_str(),strerror(error));
+	header=static_cast<Header*>(memory);
+	
+	/* Check that the segment was created by the expected server instance and has the expected layout: */
+	if(header->magic!=sharedStateMagic||header->key!=key||header->numTrackers!=Misc::UInt32(state.getNumTrackers())||header->numButtons!=Misc::UInt32(state.getNumButtons())||header->numValuators!=Misc::UInt32(state.getNumValuators()))
+		{
+		munmap(memory,size);
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Shared memory segment %s does not belong to the connected server",name.c_str());
+		}
+	setPointers();
+	}
+
+VRDeviceSharedState::~VRDeviceSharedState(void)
+	{
+	if(owner)
+		{
+		/* Wake up all clients and remove the segment's name; clients keep their mappings until they detach: */
+		shutdown();
+		shm_unlink(name.c_str());
+		}
+	munmap(memory,size);
+	}
+
+void VRDeviceSharedState::publish(const VRDeviceState& state)
+	{
+	/* Enter the write section of the sequence lock: */
+	header->sequence=header->sequence+1U;
+	__sync_synchronize();
+	
+	/* Copy the state arrays: */
+	memcpy(trackerStates,state.getTrackerStates(),header->numTrackers*sizeof(VRDeviceState::TrackerState));
+	memcpy(trackerTimeStamps,state.getTrackerTimeStamps(),header->numTrackers*sizeof(VRDeviceState::TimeStamp));
+	memcpy(buttonStates,state.getButtonStates(),header->numButtons*sizeof(VRDeviceState::ButtonState));
+	memcpy(valuatorStates,state.getValuatorStates(),header->numValuators*sizeof(VRDeviceState::ValuatorState));
+	
+	/* Leave the write section of the sequence lock: */
+	__sync_synchronize();
+	header->sequence=header->sequence+1U;
+	
+	#ifdef __linux__
+	/* Wake up all clients waiting for a new state: */
+	syscall(SYS_futex,&header->sequence,FUTEX_WAKE,0x7fffffff,0,0,0);
+	#endif
+	}
+
+void VRDeviceSharedState::shutdown(void)
+	{
+	header->alive=0U;
+	__sync_synchronize();
+	
+	/* Bump the sequence number by a full write cycle to wake up waiting clients: */
+	header->sequence=header->sequence+2U;
+	#ifdef __linux__
+	syscall(SYS_futex,&header->sequence,FUTEX_WAKE,0x7fffffff,0,0,0);
+	#endif
+	}
+
+bool VRDeviceSharedState::waitForUpdate(Misc::UInt32 lastSequence,const Misc::Time& timeout) const
+	{
+	/* Check if there already is a new state: */
+	Misc::UInt32 sequence=header->sequence;
+	if(sequence!=lastSequence&&(sequence&0x1U)==0U)
+		return true;
+	
+	#ifdef __linux__
+	/* Sleep until the sequence number changes or the timeout expires: */
+	timespec futexTimeout;
+	futexTimeout.tv_sec=timeout.tv_sec;
+	futexTimeout.tv_nsec=timeout.tv_nsec;
+	syscall(SYS_futex,&header->sequence,FUTEX_WAIT,sequence,&futexTimeout,0,0);
+	#else
+	/* Fall back to sleeping for the timeout: */
+	timespec sleepTime;
+	sleepTime.tv_sec=timeout.tv_sec;
+	sleepTime.tv_nsec=timeout.tv_nsec;
+	nanosleep(&sleepTime,0);
+	#endif
+	
+	/* A write section might still be in progress; read() will retry until it is done: */
+	return header->sequence!=lastSequence;
+	}
+
+Misc::UInt32 VRDeviceSharedState::read(VRDeviceState& state) const
+	{
+	while(true)
+		{
+		/* Wait until no write section is in progress: */
+		Misc::UInt32 sequence=header->sequence;
+		if(sequence&0x1U)
+			{
+			sched_yield();
+			continue;
+			}
+		__sync_synchronize();
+		
+		/* Copy the state arrays: */
+		memcpy(state.getTrackerStates(),trackerStates,header->numTrackers*sizeof(VRDeviceState::TrackerState));
+		memcpy(state.getTrackerTimeStamps(),trackerTimeStamps,header->numTrackers*sizeof(VRDeviceState::TimeStamp));
+		memcpy(state.getButtonStates(),buttonStates,header->numButtons*sizeof(VRDeviceState::ButtonState));
+		memcpy(state.getValuatorStates(),valuatorStates,header->numValuators*sizeof(VRDeviceState::ValuatorState));
+		
+		/* Check that the state was not modified while it was being copied: */
+		__sync_synchronize();
+		if(header->sequence==sequence)
+			return sequence;
+		}
+	}
+
+}
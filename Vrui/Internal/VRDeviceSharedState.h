@@ -0,0 +1,113 @@
+/***********************************************************************
+VRDeviceSharedState - Class to publish the current state of a VR device
+server in a POSIX shared memory segment, from which device clients on
+the same host can read it without going through the network stack.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_INTERNAL_VRDEVICESHAREDSTATE_INCLUDED
+#define VRUI_INTERNAL_VRDEVICESHAREDSTATE_INCLUDED
+
+#include <stddef.h>
+#include <string>
+#include <Misc/SizedTypes.h>
+#include <Vrui/Internal/VRDeviceState.h>
+
+/* Forward declarations: */
+namespace Misc {
+class Time;
+}
+
+namespace Vrui {
+
+class VRDeviceSharedState
+	{
+	/* Embedded classes: */
+	public:
+	typedef Misc::UInt64 Key; // Type for keys identifying a shared memory segment created by a particular server instance
+	
+	private:
+	struct Header // Header structure at the beginning of the shared memory segment
+		{
+		/* Elements: */
+		public:
+		Misc::UInt32 magic; // Magic number identifying a VR device shared memory segment
+		Misc::UInt32 numTrackers,numButtons,numValuators; // Layout of the published device state
+		Key key; // Key of the server instance that created the segment
+		volatile Misc::UInt32 sequence; // Sequence number protecting the state arrays; odd while the server is writing a new state
+		volatile Misc::UInt32 alive; // Flag whether the server is still publishing states
+		};
+	
+	/* Elements: */
+	std::string name; // Name of the shared memory segment
+	bool owner; // Flag whether this object created the shared memory segment and publishes states into it
+	size_t size; // Size of the shared memory segment in bytes
+	void* memory; // Pointer to the mapped shared memory segment
+	Header* header; // Pointer to the segment's header
+	VRDeviceState::TrackerState* trackerStates; // Pointer to the segment's tracker state array
+	VRDeviceState::TimeStamp* trackerTimeStamps; // Pointer to the segment's tracker time stamp array
+	VRDeviceState::ButtonState* buttonStates; // Pointer to the segment's button state array
+	VRDeviceState::ValuatorState* valuatorStates; // Pointer to the segment's valuator state array
+	
+	/* Private methods: */
+	static size_t calcSize(int numTrackers,int numButtons,int numValuators); // Returns the size of a shared memory segment for the given device state layout
+	void setPointers(void); // Sets the state array pointers after the segment has been mapped
+	
+	/* Constructors and destructors: */
+	public:
+	static bool isSupported(void); // Returns true if shared memory transport is supported on the host platform
+	VRDeviceSharedState(const char* sName,const VRDeviceState& state); // Creates a shared memory segment of the given name to publish states of the given state's layout
+	VRDeviceSharedState(const char* sName,Key key,const VRDeviceState& state); // Maps an existing shared memory segment of the given name read-only; throws exception if the segment's key or layout do not match
+	private:
+	VRDeviceSharedState(const VRDeviceSharedState& source); // Prohibit copy constructor
+	VRDeviceSharedState& operator=(const VRDeviceSharedState& source); // Prohibit assignment operator
+	public:
+	~VRDeviceSharedState(void); // Unmaps the shared memory segment, and removes it if it was created by this object
+	
+	/* Methods: */
+	const std::string& getName(void) const // Returns the name of the shared memory segment
+		{
+		return name;
+		}
+	Key getKey(void) const // Returns the key of the shared memory segment
+		{
+		return header->key;
+		}
+	Misc::UInt32 getSequence(void) const // Returns the current sequence number of the shared state
+		{
+		return header->sequence;
+		}
+	bool isAlive(void) const // Returns true if the server is still publishing states
+		{
+		return header->alive!=0;
+		}
+	
+	/* Server-side methods: */
+	void publish(const VRDeviceState& state); // Publishes the given device state and wakes up all waiting clients
+	void shutdown(void); // Marks the segment as no longer updated and wakes up all waiting clients
+	
+	/* Client-side methods: */
+	bool waitForUpdate(Misc::UInt32 lastSequence,const Misc::Time& timeout) const; // Blocks until a state newer than the given sequence number is published or the timeout expires; returns true if a new state is available
+	Misc::UInt32 read(VRDeviceState& state) const; // Copies the most recently published state into the given device state; returns the sequence number of the copied state
+	};
+
+}
+
+#endif
@@ -1,7 +1,7 @@
 /***********************************************************************
 VRDeviceState - Class to represent the current state of a single or
 multiple VR devices.
-Copyright (c) 2002-2011 Oliver Kreylos
+Copyright (c) 2002-2013 Oliver Kreylos
 
 This file is part of the Virtual Reality User Interface Library (Vrui).
 
@@ -24,6 +24,9 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #ifndef VRUI_INTERNAL_VRDEVICESTATE_INCLUDED
 #define VRUI_INTERNAL_VRDEVICESTATE_INCLUDED
 
+#include <time.h>
+#include <sys/time.h>
+#include <Misc/SizedTypes.h>
 #include <Misc/ArrayMarshallers.h>
 #include <IO/File.h>
 #include <Geometry/OrthonormalTransformation.h>
@@ -51,11 +54,13 @@ class VRDeviceState
 	
 	typedef bool ButtonState; // Type for button states
 	typedef float ValuatorState; // Type for valuator states
+	typedef Misc::SInt32 TimeStamp; // Type for tracker sample time stamps in microseconds on a monotonic clock; wraps around, so only differences between time stamps are meaningful
 	
 	/* Elements: */
 	private:
 	int numTrackers; // Number of represented trackers
 	TrackerState* trackerStates; // Array of current tracker states
+	TimeStamp* trackerTimeStamps; // Array of sample time stamps of current tracker states
 	int numButtons; // Number of represented buttons
 	ButtonState* buttonStates; // Array of current button states
 	int numValuators; // Number of represented valuators
@@ -64,11 +69,13 @@ class VRDeviceState
 	/* Private methods: */
 	void initState(void)
 		{
+		TimeStamp now=getTimeStamp();
 		for(int i=0;i<numTrackers;++i)
 			{
 			trackerStates[i].positionOrientation=TrackerState::PositionOrientation::identity;
 			trackerStates[i].linearVelocity=TrackerState::LinearVelocity::zero;
 			trackerStates[i].angularVelocity=TrackerState::AngularVelocity::zero;
+			trackerTimeStamps[i]=now;
 			}
 		for(int i=0;i<numButtons;++i)
 			buttonStates[i]=false;
@@ -79,13 +86,13 @@ class VRDeviceState
 	/* Constructors and destructors: */
 	public:
 	VRDeviceState(void) // Creates empty device state
-		:numTrackers(0),trackerStates(0),
+		:numTrackers(0),trackerStates(0),trackerTimeStamps(0),
 		 numButtons(0),buttonStates(0),
 		 numValuators(0),valuatorStates(0)
 		{
 		}
 	VRDeviceState(int sNumTrackers,int sNumButtons,int sNumValuators) // Creates device state of given layout
-		:numTrackers(sNumTrackers),trackerStates(new TrackerState[numTrackers]),
+		:numTrackers(sNumTrackers),trackerStates(new TrackerState[numTrackers]),trackerTimeStamps(new TimeStamp[numTrackers]),
 		 numButtons(sNumButtons),buttonStates(new ButtonState[numButtons]),
 		 numValuators(sNumValuators),valuatorStates(new ValuatorState[numValuators])
 		{
@@ -95,19 +102,38 @@ class VRDeviceState
 	~VRDeviceState(void)
 		{
 		delete[] trackerStates;
+		delete[] trackerTimeStamps;
 		delete[] buttonStates;
 		delete[] valuatorStates;
 		}
 	
 	/* Methods: */
+	static TimeStamp getTimeStamp(void) // Returns a time stamp for the current time
+		{
+		#ifdef CLOCK_MONOTONIC
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		return TimeStamp(Misc::UInt32(now.tv_sec)*1000000U+Misc::UInt32(now.tv_nsec/1000));
+		#else
+		struct timeval now;
+		gettimeofday(&now,0);
+		return TimeStamp(Misc::UInt32(now.tv_sec)*1000000U+Misc::UInt32(now.tv_usec));
+		#endif
+		}
+	static TimeStamp getAge(TimeStamp timeStamp,TimeStamp now) // Returns the number of microseconds between the given time stamp and the given current time
+		{
+		return TimeStamp(Misc::UInt32(now)-Misc::UInt32(timeStamp));
+		}
 	void setLayout(int newNumTrackers,int newNumButtons,int newNumValuators) // Sets the number of represented trackers, buttons and valuators
 		{
 		/* Re-allocate state arrays: */
 		if(numTrackers!=newNumTrackers)
 			{
 			delete[] trackerStates;
+			delete[] trackerTimeStamps;
 			numTrackers=newNumTrackers;
 			trackerStates=new TrackerState[numTrackers];
+			trackerTimeStamps=new TimeStamp[numTrackers];
 			}
 		if(numButtons!=newNumButtons)
 			{
@@ -145,6 +171,14 @@ class VRDeviceState
 		{
 		trackerStates[trackerIndex]=newTrackerState;
 		}
+	TimeStamp getTrackerTimeStamp(int trackerIndex) const // Returns sample time stamp of single tracker
+		{
+		return trackerTimeStamps[trackerIndex];
+		}
+	void setTrackerTimeStamp(int trackerIndex,TimeStamp newTimeStamp) // Updates sample time stamp of single tracker
+		{
+		trackerTimeStamps[trackerIndex]=newTimeStamp;
+		}
 	ButtonState getButtonState(int buttonIndex) const // Returns state of single button
 		{
 		return buttonStates[buttonIndex];
@@ -169,6 +203,14 @@ class VRDeviceState
 		{
 		return trackerStates;
 		}
+	const TimeStamp* getTrackerTimeStamps(void) const // Returns array of tracker sample time stamps
+		{
+		return trackerTimeStamps;
+		}
+	TimeStamp* getTrackerTimeStamps(void) // Ditto
+		{
+		return trackerTimeStamps;
+		}
 	const ButtonState* getButtonStates(void) const // Returns array of button states
 		{
 		return buttonStates;
@@ -210,6 +252,24 @@ class VRDeviceState
 		Misc::FixedArrayMarshaller<ButtonState>::read(buttonStates,numButtons,source);
 		Misc::FixedArrayMarshaller<ValuatorState>::read(valuatorStates,numValuators,source);
 		}
+	void writeTrackerTimeStamps(IO::File& sink) const // Writes tracker sample time stamps to given data sink as ages relative to the current time
+		{
+		TimeStamp now=getTimeStamp();
+		for(int i=0;i<numTrackers;++i)
+			sink.write<TimeStamp>(getAge(trackerTimeStamps[i],now));
+		}
+	void readTrackerTimeStamps(IO::File& source) // Reads tracker sample ages from given data source and converts them to time stamps relative to the current time
+		{
+		TimeStamp now=getTimeStamp();
+		for(int i=0;i<numTrackers;++i)
+			trackerTimeStamps[i]=TimeStamp(Misc::UInt32(now)-Misc::UInt32(source.read<TimeStamp>()));
+		}
+	void touchTrackerTimeStamps(void) // Sets the sample time stamps of all trackers to the current time
+		{
+		TimeStamp now=getTimeStamp();
+		for(int i=0;i<numTrackers;++i)
+			trackerTimeStamps[i]=now;
+		}
 	};
 
 }
@@ -0,0 +1,220 @@
+/***********************************************************************
+VRDeviceSubscription - Class describing the subset of a VR device
+server's trackers, buttons, and valuators a client wants to receive,
+and implementing the delta-encoded state packets sent to subscribed
+clients in streaming mode.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/Internal/VRDeviceSubscription.h>
+
+#include <algorithm>
+#include <limits>
+#include <Misc/ThrowStdErr.h>
+#include <IO/File.h>
+#include <Vrui/Internal/VRDeviceState.h>
+
+namespace Vrui {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+void clipIndexList(VRDeviceSubscription::IndexList& indices,int numFeatures)
+	{
+	/* Sort the index list and remove duplicates: */
+	std::sort(indices.begin(),indices.end());
+	indices.erase(std::unique(indices.begin(),indices.end()),indices.end());
+	
+	/* Remove out-of-range indices: */
+	VRDeviceSubscription::IndexList::iterator validBegin=std::lower_bound(indices.begin(),indices.end(),0);
+	VRDeviceSubscription::IndexList::iterator validEnd=std::lower_bound(validBegin,indices.end(),numFeatures);
+	indices.erase(validEnd,indices.end());
+	indices.erase(indices.begin(),validBegin);
+	}
+
+void writeIndexList(const VRDeviceSubscription::IndexList& indices,IO::File& sink)
+	{
+	sink.write<VRDeviceSubscription::IndexType>(VRDeviceSubscription::IndexType(indices.size()));
+	for(VRDeviceSubscription::IndexList::const_iterator iIt=indices.begin();iIt!=indices.end();++iIt)
+		sink.write<VRDeviceSubscription::IndexType>(VRDeviceSubscription::IndexType(*iIt));
+	}
+
+void readIndexList(VRDeviceSubscription::IndexList& indices,IO::File& source)
+	{
+	unsigned int numIndices=source.read<VRDeviceSubscription::IndexType>();
+	indices.clear();
+	indices.reserve(numIndices);
+	for(unsigned int i=0;i<numIndices;++i)
+		indices.push_back(source.read<VRDeviceSubscription::IndexType>());
+	}
+
+inline bool operator!=(const VRDeviceState::TrackerState& ts1,const VRDeviceState::TrackerState& ts2)
+	{
+	return ts1.positionOrientation!=ts2.positionOrientation||ts1.linearVelocity!=ts2.linearVelocity||ts1.angularVelocity!=ts2.angularVelocity;
+	}
+
+inline bool isMoving(const VRDeviceState::TrackerState& ts)
+	{
+	return ts.linearVelocity!=VRDeviceState::TrackerState::LinearVelocity::zero||ts.angularVelocity!=VRDeviceState::TrackerState::AngularVelocity::zero;
+	}
+
+}
+
+/*************************************
+Methods of class VRDeviceSubscription:
+*************************************/
+
+void VRDeviceSubscription::clip(const VRDeviceState& state)
+	{
+	/* Limit the number of features such that feature counts can be represented in the protocol: */
+	const int maxNumFeatures=int(std::numeric_limits<IndexType>::max());
+	int maxTrackers=std::min(state.getNumTrackers(),maxNumFeatures);
+	int maxButtons=std::min(state.getNumButtons(),maxNumFeatures);
+	int maxValuators=std::min(state.getNumValuators(),maxNumFeatures);
+	
+	clipIndexList(trackerIndices,maxTrackers);
+	clipIndexList(buttonIndices,maxButtons);
+	clipIndexList(valuatorIndices,maxValuators);
+	
+	if(keyframeInterval<1U)
+		keyframeInterval=1U;
+	}
+
+void VRDeviceSubscription::write(IO::File& sink) const
+	{
+	writeIndexList(trackerIndices,sink);
+	writeIndexList(buttonIndices,sink);
+	writeIndexList(valuatorIndices,sink);
+	sink.write<unsigned int>(keyframeInterval);
+	}
+
+void VRDeviceSubscription::read(IO::File& source)
+	{
+	readIndexList(trackerIndices,source);
+	readIndexList(buttonIndices,source);
+	readIndexList(valuatorIndices,source);
+	keyframeInterval=source.read<unsigned int>();
+	}
+
+void VRDeviceSubscription::writeDelta(const VRDeviceState& state,VRDeviceState& sentState,bool keyframe,bool timeStamps,IO::File& sink) const
+	{
+	VRDeviceState::TimeStamp now=VRDeviceState::getTimeStamp();
+	
+	/* Collect the indices of all changed trackers: */
+	IndexList changedTrackers;
+	for(IndexList::const_iterator tiIt=trackerIndices.begin();tiIt!=trackerIndices.end();++tiIt)
+		{
+		const VRDeviceState::TrackerState& ts=state.getTrackerState(*tiIt);
+		if(keyframe||ts!=sentState.getTrackerState(*tiIt))
+			changedTrackers.push_back(*tiIt);
+		else if(timeStamps&&state.getTrackerTimeStamp(*tiIt)!=sentState.getTrackerTimeStamp(*tiIt)&&isMoving(ts))
+			{
+			/* Resend a moving tracker that received a new but identical sample, so that clients do not extrapolate it from an ever-growing sample age: */
+			changedTrackers.push_back(*tiIt);
+			}
+		}
+	
+	/* Send the changed tracker states: */
+	sink.write<IndexType>(IndexType(changedTrackers.size()));
+	for(IndexList::iterator ctIt=changedTrackers.begin();ctIt!=changedTrackers.end();++ctIt)
+		{
+		sink.write<IndexType>(IndexType(*ctIt));
+		Misc::Marshaller<VRDeviceState::TrackerState>::write(state.getTrackerState(*ctIt),sink);
+		if(timeStamps)
+			sink.write<VRDeviceState::TimeStamp>(VRDeviceState::getAge(state.getTrackerTimeStamp(*ctIt),now));
+		sentState.setTrackerState(*ctIt,state.getTrackerState(*ctIt));
+		sentState.setTrackerTimeStamp(*ctIt,state.getTrackerTimeStamp(*ctIt));
+		}
+	
+	/* Collect and send the changed button states: */
+	IndexList changedButtons;
+	for(IndexList::const_iterator biIt=buttonIndices.begin();biIt!=buttonIndices.end();++biIt)
+		if(keyframe||state.getButtonState(*biIt)!=sentState.getButtonState(*biIt))
+			changedButtons.push_back(*biIt);
+	sink.write<IndexType>(IndexType(changedButtons.size()));
+	for(IndexList::iterator cbIt=changedButtons.begin();cbIt!=changedButtons.end();++cbIt)
+		{
+		sink.write<IndexType>(IndexType(*cbIt));
+		sink.write<unsigned char>(state.getButtonState(*cbIt)?1:0);
+		sentState.setButtonState(*cbIt,state.getButtonState(*cbIt));
+		}
+	
+	/* Collect and send the changed valuator states: */
+	IndexList changedValuators;
+	for(IndexList::const_iterator viIt=valuatorIndices.begin();viIt!=valuatorIndices.end();++viIt)
+		if(keyframe||state.getValuatorState(*viIt)!=sentState.getValuatorState(*viIt))
+			changedValuators.push_back(*viIt);
+	sink.write<IndexType>(IndexType(changedValuators.size()));
+	for(IndexList::iterator cvIt=changedValuators.begin();cvIt!=changedValuators.end();++cvIt)
+		{
+		sink.write<IndexType>(IndexType(*cvIt));
+		sink.write<VRDeviceState::ValuatorState>(state.getValuatorState(*cvIt));
+		sentState.setValuatorState(*cvIt,state.getValuatorState(*cvIt));
+		}
+	}
+
+void VRDeviceSubscription::readDelta(VRDeviceState& state,bool timeStamps,IO::File& source)
+	{
+	VRDeviceState::TimeStamp now=VRDeviceState::getTimeStamp();
+	
+	/* Read changed tracker states: */
+	unsigned int numTrackers=source.read<IndexType>();
+	for(unsigned int i=0;i<numTrackers;++i)
+		{
+		int trackerIndex=source.read<IndexType>();
+		VRDeviceState::TrackerState ts=Misc::Marshaller<VRDeviceState::TrackerState>::read(source);
+		
+		/* Convert the tracker's sample age to a local time stamp; assume the sample is fresh if the server does not send ages: */
+		VRDeviceState::TimeStamp timeStamp=now;
+		if(timeStamps)
+			timeStamp=VRDeviceState::TimeStamp(Misc::UInt32(now)-Misc::UInt32(source.read<VRDeviceState::TimeStamp>()));
+		if(trackerIndex>=state.getNumTrackers())
+			Misc::throwStdErr("VRDeviceSubscription::readDelta: Invalid tracker index %d",trackerIndex);
+		state.setTrackerState(trackerIndex,ts);
+		state.setTrackerTimeStamp(trackerIndex,timeStamp);
+		}
+	
+	/* Read changed button states: */
+	unsigned int numButtons=source.read<IndexType>();
+	for(unsigned int i=0;i<numButtons;++i)
+		{
+		int buttonIndex=source.read<IndexType>();
+		bool buttonState=source.read<unsigned char>()!=0;
+		if(buttonIndex>=state.getNumButtons())
+			Misc::throwStdErr("VRDeviceSubscription::readDelta: Invalid button index %d",buttonIndex);
+		state.setButtonState(buttonIndex,buttonState);
+		}
+	
+	/* Read changed valuator states: */
+	unsigned int numValuators=source.read<IndexType>();
+	for(unsigned int i=0;i<numValuators;++i)
+		{
+		int valuatorIndex=source.read<IndexType>();
+		VRDeviceState::ValuatorState valuatorState=source.read<VRDeviceState::ValuatorState>();
+		if(valuatorIndex>=state.getNumValuators())
+			Misc::throwStdErr("VRDeviceSubscription::readDelta: Invalid valuator index %d",valuatorIndex);
+		state.setValuatorState(valuatorIndex,valuatorState);
+		}
+	}
+
+}
@@ -0,0 +1,74 @@
+/***********************************************************************
+VRDeviceSubscription - Class describing the subset of a VR device
+server's trackers, buttons, and valuators a client wants to receive,
+and implementing the delta-encoded state packets sent to subscribed
+clients in streaming mode.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_INTERNAL_VRDEVICESUBSCRIPTION_INCLUDED
+#define VRUI_INTERNAL_VRDEVICESUBSCRIPTION_INCLUDED
+
+#include <vector>
+
+/* Forward declarations: */
+namespace IO {
+class File;
+}
+namespace Vrui {
+class VRDeviceState;
+}
+
+namespace Vrui {
+
+class VRDeviceSubscription
+	{
+	/* Embedded classes: */
+	public:
+	typedef unsigned short int IndexType; // Network type for tracker, button, and valuator indices and counts
+	typedef std::vector<int> IndexList; // Type for lists of subscribed feature indices
+	
+	/* Elements: */
+	IndexList trackerIndices; // Indices of subscribed trackers
+	IndexList buttonIndices; // Indices of subscribed buttons
+	IndexList valuatorIndices; // Indices of subscribed valuators
+	unsigned int keyframeInterval; // Number of delta packets after which the server sends a full keyframe packet for resynchronization
+	
+	/* Constructors and destructors: */
+	VRDeviceSubscription(void) // Creates an empty subscription
+		:keyframeInterval(60)
+		{
+		}
+	
+	/* Methods: */
+	bool empty(void) const // Returns true if the subscription does not contain any features
+		{
+		return trackerIndices.empty()&&buttonIndices.empty()&&valuatorIndices.empty();
+		}
+	void clip(const VRDeviceState& state); // Removes duplicate indices, indices that are invalid for the given device state layout, and indices beyond the largest feature count representable by IndexType
+	void write(IO::File& sink) const; // Writes the subscription to the given data sink
+	void read(IO::File& source); // Reads a subscription from the given data source
+	void writeDelta(const VRDeviceState& state,VRDeviceState& sentState,bool keyframe,bool timeStamps,IO::File& sink) const; // Writes all subscribed features of the given state that differ from the given previously sent state, or all subscribed features if keyframe is true, and updates the previously sent state; writes tracker sample ages if timeStamps is true
+	static void readDelta(VRDeviceState& state,bool timeStamps,IO::File& source); // Reads a delta packet from the given data source and applies it to the given state; reads tracker sample ages if timeStamps is true
+	};
+
+}
+
+#endif
@@ -49,6 +49,8 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Misc/ConfigurationFile.h>
 #include <Misc/Time.h>
 #include <Misc/TimerEventScheduler.h>
+#include <Threads/TaskScheduler.h>
+#include <Threads/Profiler.h>
 #include <IO/File.h>
 #include <IO/OpenFile.h>
 #include <Cluster/Multiplexer.h>
@@ -101,6 +103,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/VisletManager.h>
 #include <Vrui/Internal/InputDeviceDataSaver.h>
 #include <Vrui/Internal/ScaleBar.h>
+#include <Vrui/FrameTimer.h>
 #include <Vrui/OpenFile.h>
 
 #if EVILHACK_LOCK_INPUTDEVICE_POS
@@ -308,6 +311,13 @@ void VruiState::buildSystemMenu(GLMotif::Container* parent)
 	GLMotif::ToggleButton* showScaleBarToggle=new GLMotif::ToggleButton("ShowScaleBarToggle",parent,"Show Scale Bar");
 	showScaleBarToggle->getValueChangedCallbacks().add(this,&VruiState::showScaleBarToggleCallback);
 	
+	#if THREADS_CONFIG_PROFILER
+	/* Create a button to record a profile of Vrui's threads: */
+	GLMotif::ToggleButton* recordProfileToggle=new GLMotif::ToggleButton("RecordProfileToggle",parent,"Record Profile");
+	recordProfileToggle->setToggle(Threads::Profiler::isActive());
+	recordProfileToggle->getValueChangedCallbacks().add(this,&VruiState::recordProfileToggleCallback);
+	#endif
+	
 	if(visletManager->getNumVislets()>0)
 		{
 		/* Create the vislet submenu: */
@@ -421,6 +431,7 @@ VruiState::VruiState(Cluster::Multiplexer* sMultiplexer,Cluster::MulticastPipe*
 	 backgroundColor(Color(0.0f,0.0f,0.0f,1.0f)),
 	 ambientLightColor(Color(0.2f,0.2f,0.2f)),
 	 useSound(false),
+	 taskScheduler(0),
 	 widgetMaterial(GLMaterial::Color(1.0f,1.0f,1.0f),GLMaterial::Color(0.5f,0.5f,0.5f),25.0f),
 	 timerEventScheduler(0),
 	 widgetManager(0),
@@ -441,7 +452,9 @@ VruiState::VruiState(Cluster::Multiplexer* sMultiplexer,Cluster::MulticastPipe*
 	 soundFunction(0),soundFunctionData(0),
 	 minimumFrameTime(0.0),nextFrameTime(0.0),
 	 synchFrameTime(0.0),synchWait(false),
-	 numRecentFrameTimes(0),recentFrameTimes(0),nextFrameTimeIndex(0),sortedFrameTimes(0),
+	 numRecentFrameTimes(0),recentFrameTimes(0),nextFrameTimeIndex(0),
+	 frameTimer(0),
+	 profilerNumEventsPerThread(0),
 	 activeNavigationTool(0),
 	 mostRecentGUIInteractor(0),mostRecentHotSpot(displayCenter),
 	 updateContinuously(false)
@@ -460,7 +473,7 @@ VruiState::~VruiState(void)
 	
 	/* Delete time management: */
 	delete[] recentFrameTimes;
-	delete[] sortedFrameTimes;
+	delete frameTimer;
 	
 	/* Deregister the popup callback: */
 	widgetManager->getWidgetPopCallbacks().remove(this,&VruiState::widgetPopCallback);
@@ -487,6 +500,9 @@ VruiState::~VruiState(void)
 	delete widgetManager;
 	delete timerEventScheduler;
 	
+	/* Shut down the task scheduler: */
+	delete taskScheduler;
+	
 	/* Delete listeners: */
 	delete[] listeners;
 	
@@ -712,6 +728,10 @@ void VruiState::initialize(const Misc::ConfigurationFileSection& configFileSecti
 		}
 	mainListener=&listeners[0];
 	
+	/* Create the pool of worker threads for parallel application and library tasks, leaving one processor to the main thread by default: */
+	unsigned int numTaskThreads=configFileSection.retrieveValue<unsigned int>("./numTaskThreads",Threads::TaskScheduler::getNumProcessors()-1);
+	taskScheduler=new Threads::TaskScheduler(numTaskThreads);
+	
 	/* Initialize widget management: */
 	timerEventScheduler=new Misc::TimerEventScheduler;
 	widgetManager=new GLMotif::WidgetManager;
@@ -791,9 +811,25 @@ void VruiState::initialize(const Misc::ConfigurationFileSection& configFileSecti
 	for(int i=0;i<numRecentFrameTimes;++i)
 		recentFrameTimes[i]=1.0;
 	nextFrameTimeIndex=0;
-	sortedFrameTimes=new double[numRecentFrameTimes];
 	currentFrameTime=1.0;
 	
+	/* Create the frame phase timer: */
+	frameTimer=new FrameTimer(configFileSection.retrieveValue<unsigned int>("./frameTimerNumSamples",4096));
+	if(master)
+		{
+		/* Write frame phase timings to a trace file if requested: */
+		std::string frameTimerTraceFileName=configFileSection.retrieveString("./frameTimerTraceFileName","");
+		if(!frameTimerTraceFileName.empty())
+			frameTimer->openTraceFile(frameTimerTraceFileName.c_str());
+		}
+	
+	/* Initialize the hot-path profiler: */
+	Threads::Profiler::setThreadName("Vrui main thread");
+	profilerTraceFileName=configFileSection.retrieveString("./profilerTraceFileName","VruiProfile.json");
+	profilerNumEventsPerThread=configFileSection.retrieveValue<unsigned int>("./profilerNumEventsPerThread",65536);
+	if(configFileSection.retrieveValue<bool>("./startProfiler",false))
+		Threads::Profiler::start(profilerNumEventsPerThread);
+	
 	/* Initialize the hot spot position for dialog windows: */
 	mostRecentHotSpot=displayCenter;
 	}
@@ -871,6 +907,14 @@ void VruiState::prepareMainLoop(void)
 
 void VruiState::update(void)
 	{
+	THREADS_PROFILE_ZONE("Vrui::VruiState::update");
+	
+	/* Release all transient memory allocated during the previous frame: */
+	frameArena.reset();
+	
+	/* Start timing the new frame's phases: */
+	frameTimer->startFrame();
+	
 	/*********************************************************************
 	Update the application time and all related state:
 	*********************************************************************/
@@ -915,15 +959,15 @@ void VruiState::update(void)
 		if(nextFrameTimeIndex==numRecentFrameTimes)
 			nextFrameTimeIndex=0;
 		
-		/* Calculate current median frame time: */
+		/* Calculate current median frame time by selecting the frame time of median rank without branching: */
+		int medianRank=numRecentFrameTimes/2;
 		for(int i=0;i<numRecentFrameTimes;++i)
 			{
-			int j;
-			for(j=i-1;j>=0&&sortedFrameTimes[j]>recentFrameTimes[i];--j)
-				sortedFrameTimes[j+1]=sortedFrameTimes[j];
-			sortedFrameTimes[j+1]=recentFrameTimes[i];
+			int rank=0;
+			for(int j=0;j<numRecentFrameTimes;++j)
+				rank+=int(recentFrameTimes[j]<recentFrameTimes[i])+(int(recentFrameTimes[j]==recentFrameTimes[i])&int(j<i));
+			currentFrameTime=rank==medianRank?recentFrameTimes[i]:currentFrameTime;
 			}
-		currentFrameTime=sortedFrameTimes[numRecentFrameTimes/2];
 		if(multiplexer!=0)
 			pipe->write<double>(currentFrameTime);
 		}
@@ -952,6 +996,9 @@ void VruiState::update(void)
 	Update input device state and distribute all shared state:
 	*********************************************************************/
 	
+	{
+	FrameTimer::Scope inputUpdateTimer(frameTimer,FrameTimer::INPUT_UPDATE);
+	THREADS_PROFILE_ZONE("Vrui::inputUpdate");
 	int navBroadcastMask=navigationTransformationChangedMask;
 	if(master)
 		{
@@ -1036,6 +1083,7 @@ void VruiState::update(void)
 		
 		pipe->flush();
 		}
+	}
 	
 	#if SAVESHAREDVRUISTATE
 	/* Save shared state to a local file for post-mortem analysis purposes: */
@@ -1061,11 +1109,16 @@ void VruiState::update(void)
 	/* Trigger all due timer events: */
 	timerEventScheduler->triggerEvents(lastFrame);
 	
+	{
+	FrameTimer::Scope toolUpdateTimer(frameTimer,FrameTimer::TOOL_UPDATE);
+	THREADS_PROFILE_ZONE("Vrui::toolUpdate");
+	
 	/* Update the input graph: */
 	inputGraphManager->update();
 	
 	/* Update the tool manager: */
 	toolManager->update();
+	}
 	
 	/* Check if a new input graph needs to be loaded: */
 	if(loadInputGraph)
@@ -1102,7 +1155,11 @@ void VruiState::update(void)
 		visletManager->frame();
 	
 	/* Call frame function: */
+	{
+	FrameTimer::Scope applicationFrameTimer(frameTimer,FrameTimer::APPLICATION_FRAME);
+	THREADS_PROFILE_ZONE("Vrui::applicationFrame");
 	frameFunction(frameFunctionData);
+	}
 	
 	/* Finish any pending messages on the main pipe, in case an application didn't clean up: */
 	if(multiplexer!=0)
@@ -1224,8 +1281,41 @@ void VruiState::sound(ALContextData& contextData) const
 	#endif
 	}
 
+void VruiState::writeProfile(void)
+	{
+	/* Append the node index to the trace file name on cluster nodes: */
+	std::string traceFileName=profilerTraceFileName;
+	if(multiplexer!=0)
+		{
+		char nodeSuffix[32];
+		snprintf(nodeSuffix,sizeof(nodeSuffix),"-Node%u",multiplexer->getNodeIndex());
+		std::string::size_type extPos=traceFileName.size()-strlen(Misc::getExtension(traceFileName.c_str()));
+		traceFileName.insert(extPos,nodeSuffix);
+		}
+	
+	try
+		{
+		/* Write the recorded events to a new numbered trace file: */
+		std::string numberedTraceFileName=Misc::createNumberedFileName(traceFileName,4);
+		Threads::Profiler::writeTrace(numberedTraceFileName.c_str());
+		if(master&&Threads::Profiler::getNumDroppedEvents()>0)
+			std::cerr<<"Vrui: Profiler dropped "<<Threads::Profiler::getNumDroppedEvents()<<" events; increase profilerNumEventsPerThread"<<std::endl;
+		}
+	catch(std::runtime_error err)
+		{
+		std::cerr<<"Vrui: Unable to write profile due to exception "<<err.what()<<std::endl;
+		}
+	}
+
 void VruiState::finishMainLoop(void)
 	{
+	if(Threads::Profiler::isActive())
+		{
+		/* Stop the hot-path profiler and save the recorded events: */
+		Threads::Profiler::stop();
+		writeProfile();
+		}
+	
 	/* Disable all vislets: */
 	visletManager->disable();
 	
@@ -1397,6 +1487,21 @@ void VruiState::showScaleBarToggleCallback(GLMotif::ToggleButton::ValueChangedCa
 		}
 	}
 
+void VruiState::recordProfileToggleCallback(GLMotif::ToggleButton::ValueChangedCallbackData* cbData)
+	{
+	if(cbData->set)
+		{
+		/* Start recording a new profile: */
+		Threads::Profiler::start(profilerNumEventsPerThread);
+		}
+	else
+		{
+		/* Stop recording and save the profile: */
+		Threads::Profiler::stop();
+		writeProfile();
+		}
+	}
+
 void VruiState::quitCallback(Misc::CallbackData* cbData)
 	{
 	/* Request Vrui to shut down cleanly: */
@@ -1500,14 +1605,24 @@ Cluster::MulticastPipe* getMainPipe(void)
 	return vruiState->pipe;
 	}
 
-Cluster::MulticastPipe* openPipe(void)
+Cluster::MulticastPipe* openPipe(bool compressed)
 	{
 	if(vruiState->multiplexer!=0)
-		return new Cluster::MulticastPipe(vruiState->multiplexer);
+		return new Cluster::MulticastPipe(vruiState->multiplexer,compressed);
 	else
 		return 0;
 	}
 
+Threads::TaskScheduler* getTaskScheduler(void)
+	{
+	return vruiState->taskScheduler;
+	}
+
+Misc::ArenaAllocator& getFrameArena(void)
+	{
+	return vruiState->frameArena;
+	}
+
 GlyphRenderer* getGlyphRenderer(void)
 	{
 	return vruiState->glyphRenderer;
@@ -2413,6 +2528,11 @@ double getCurrentFrameTime(void)
 	return vruiState->currentFrameTime;
 	}
 
+FrameTimer& getFrameTimer(void)
+	{
+	return *vruiState->frameTimer;
+	}
+
 void updateContinuously(void)
 	{
 	vruiState->updateContinuously=true;
@@ -46,6 +46,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Threads/Thread.h>
 #include <Threads/Mutex.h>
 #include <Threads/Barrier.h>
+#include <Threads/Profiler.h>
 #include <Cluster/Multiplexer.h>
 #include <Cluster/MulticastPipe.h>
 #include <Cluster/ThreadSynchronizer.h>
@@ -69,6 +70,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/Internal/InputDeviceAdapterMouse.h>
 #include <Vrui/CoordinateManager.h>
 #include <Vrui/VRWindow.h>
+#include <Vrui/FrameTimer.h>
 #include <Vrui/SoundContext.h>
 #include <Vrui/ToolManager.h>
 #include <Vrui/VisletManager.h>
@@ -410,6 +412,8 @@ void* vruiRenderingThreadFunction(VruiWindowGroupCreator group)
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
 	// Threads::Thread::setCancelType(Threads::Thread::CANCEL_ASYNCHRONOUS);
 	
+	Threads::Profiler::setThreadName("Vrui rendering thread");
+	
 	/* Create all windows in this thread's group: */
 	bool allWindowsOk=vruiCreateWindowGroup(group);
 	
@@ -432,7 +436,10 @@ void* vruiRenderingThreadFunction(VruiWindowGroupCreator group)
 		
 		/* Draw all windows' contents: */
 		for(std::vector<VruiWindowGroupCreator::VruiWindow>::iterator wIt=group.windows.begin();wIt!=group.windows.end();++wIt)
+			{
+			FrameTimer::Scope displayTimer(vruiState->frameTimer,FrameTimer::DISPLAY,wIt->windowIndex);
 			vruiWindows[wIt->windowIndex]->draw();
+			}
 		
 		/* Wait until all threads are done rendering: */
 		glFinish();
@@ -447,6 +454,8 @@ void* vruiRenderingThreadFunction(VruiWindowGroupCreator group)
 		/* Swap all windows' buffers: */
 		for(std::vector<VruiWindowGroupCreator::VruiWindow>::iterator wIt=group.windows.begin();wIt!=group.windows.end();++wIt)
 			{
+			FrameTimer::Scope swapTimer(vruiState->frameTimer,FrameTimer::SWAP,wIt->windowIndex);
+			THREADS_PROFILE_ZONE("Vrui::swapBuffers");
 			vruiWindows[wIt->windowIndex]->makeCurrent();
 			vruiWindows[wIt->windowIndex]->swapBuffers();
 			}
@@ -738,10 +747,15 @@ void init(int& argc,char**& argv,char**&)
 				std::string multicastGroup=vruiConfigFile->retrieveString("./multipipeMulticastGroup");
 				int multicastPort=vruiConfigFile->retrieveValue<int>("./multipipeMulticastPort");
 				unsigned int multicastSendBufferSize=vruiConfigFile->retrieveValue<unsigned int>("./multipipeSendBufferSize",16);
+				double multicastResendSuppressionInterval=vruiConfigFile->retrieveValue<double>("./multipipeResendSuppressionInterval",0.005);
+				double multicastMinSendRate=vruiConfigFile->retrieveValue<double>("./multipipeMinSendRate",0.0);
+				double multicastMaxSendRate=vruiConfigFile->retrieveValue<double>("./multipipeMaxSendRate",0.0);
 				
 				/* Create the multicast multiplexer: */
 				vruiMultiplexer=new Cluster::Multiplexer(vruiNumSlaves,0,master.c_str(),masterPort,multicastGroup.c_str(),multicastPort);
 				vruiMultiplexer->setSendBufferSize(multicastSendBufferSize);
+				vruiMultiplexer->setResendSuppressionInterval(multicastResendSuppressionInterval);
+				vruiMultiplexer->setSendRateLimits(multicastMinSendRate,multicastMaxSendRate);
 				
 				/* Start the multipipe slaves on all slave nodes: */
 				std::string multipipeRemoteCommand=vruiConfigFile->retrieveString("./multipipeRemoteCommand","ssh");
@@ -1579,7 +1593,10 @@ void vruiInnerLoopMultiWindow(void)
 			if(vruiState->multiplexer!=0)
 				{
 				/* Synchronize with other nodes: */
+				{
+				FrameTimer::Scope barrierTimer(vruiState->frameTimer,FrameTimer::CLUSTER_BARRIER);
 				vruiState->pipe->barrier();
+				}
 				
 				/* Notify the render threads to swap buffers: */
 				vruiRenderingBarrier.synchronize();
@@ -1594,12 +1611,16 @@ void vruiInnerLoopMultiWindow(void)
 			for(int i=0;i<vruiNumWindowGroups;++i)
 				{
 				for(std::vector<VruiWindowGroup::Window>::iterator wgIt=vruiWindowGroups[i].windows.begin();wgIt!=vruiWindowGroups[i].windows.end();++wgIt)
+					{
+					FrameTimer::Scope displayTimer(vruiState->frameTimer,FrameTimer::DISPLAY);
 					wgIt->window->draw();
+					}
 				}
 			
 			if(vruiState->multiplexer!=0)
 				{
 				/* Synchronize with other nodes: */
+				FrameTimer::Scope barrierTimer(vruiState->frameTimer,FrameTimer::CLUSTER_BARRIER);
 				glFinish();
 				vruiState->pipe->barrier();
 				}
@@ -1609,6 +1630,8 @@ void vruiInnerLoopMultiWindow(void)
 				{
 				for(std::vector<VruiWindowGroup::Window>::iterator wgIt=vruiWindowGroups[i].windows.begin();wgIt!=vruiWindowGroups[i].windows.end();++wgIt)
 					{
+					FrameTimer::Scope swapTimer(vruiState->frameTimer,FrameTimer::SWAP);
+					THREADS_PROFILE_ZONE("Vrui::swapBuffers");
 					wgIt->window->makeCurrent();
 					wgIt->window->swapBuffers();
 					}
@@ -1620,11 +1643,15 @@ void vruiInnerLoopMultiWindow(void)
 			{
 			/* Update rendering: */
 			for(int i=0;i<vruiNumWindows;++i)
+				{
+				FrameTimer::Scope displayTimer(vruiState->frameTimer,FrameTimer::DISPLAY,i);
 				vruiWindows[i]->draw();
+				}
 			
 			if(vruiState->multiplexer!=0)
 				{
 				/* Synchronize with other nodes: */
+				FrameTimer::Scope barrierTimer(vruiState->frameTimer,FrameTimer::CLUSTER_BARRIER);
 				glFinish();
 				vruiState->pipe->barrier();
 				}
@@ -1632,6 +1659,8 @@ void vruiInnerLoopMultiWindow(void)
 			/* Swap all buffers at once: */
 			for(int i=0;i<vruiNumWindows;++i)
 				{
+				FrameTimer::Scope swapTimer(vruiState->frameTimer,FrameTimer::SWAP,i);
+				THREADS_PROFILE_ZONE("Vrui::swapBuffers");
 				vruiWindows[i]->makeCurrent();
 				vruiWindows[i]->swapBuffers();
 				}
@@ -1639,6 +1668,7 @@ void vruiInnerLoopMultiWindow(void)
 		else if(vruiState->multiplexer!=0)
 			{
 			/* Synchronize with other nodes: */
+			FrameTimer::Scope barrierTimer(vruiState->frameTimer,FrameTimer::CLUSTER_BARRIER);
 			vruiState->pipe->barrier();
 			}
 		
@@ -1708,17 +1738,25 @@ void vruiInnerLoopSingleWindow(void)
 		GLContextData::resetThingManager();
 		
 		/* Update rendering: */
+		{
+		FrameTimer::Scope displayTimer(vruiState->frameTimer,FrameTimer::DISPLAY,0);
 		vruiWindows[0]->draw();
+		}
 		
 		if(vruiState->multiplexer!=0)
 			{
 			/* Synchronize with other nodes: */
+			FrameTimer::Scope barrierTimer(vruiState->frameTimer,FrameTimer::CLUSTER_BARRIER);
 			glFinish();
 			vruiState->pipe->barrier();
 			}
 		
 		/* Swap buffer: */
+		{
+		FrameTimer::Scope swapTimer(vruiState->frameTimer,FrameTimer::SWAP,0);
+		THREADS_PROFILE_ZONE("Vrui::swapBuffers");
 		vruiWindows[0]->swapBuffers();
+		}
 		
 		firstFrame=false;
 		}
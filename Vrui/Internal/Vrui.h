@@ -28,6 +28,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <deque>
 #include <Misc/Timer.h>
 #include <Misc/CallbackList.h>
+#include <Misc/ArenaAllocator.h>
 #include <Threads/Mutex.h>
 #include <IO/Directory.h>
 #include <Geometry/Point.h>
@@ -54,6 +55,9 @@ class ConfigurationFileSection;
 class CallbackData;
 class TimerEventScheduler;
 }
+namespace Threads {
+class TaskScheduler;
+}
 namespace Cluster {
 class Multiplexer;
 class MulticastPipe;
@@ -65,6 +69,7 @@ class PopupMenu;
 class PopupWindow;
 }
 namespace Vrui {
+class FrameTimer;
 class InputDeviceDataSaver;
 class MultipipeDispatcher;
 class ScaleBar;
@@ -182,6 +187,10 @@ struct VruiState
 	/* Sound rendering parameters: */
 	bool useSound;
 	
+	/* Parallel task management: */
+	Threads::TaskScheduler* taskScheduler; // Pool of worker threads executing parallel application and library tasks
+	Misc::ArenaAllocator frameArena; // Arena for transient allocations in the main thread, reset at the beginning of each frame
+	
 	/* Widget management: */
 	GLMaterial widgetMaterial;
 	GLMotif::StyleSheet uiStyleSheet;
@@ -236,8 +245,10 @@ struct VruiState
 	int numRecentFrameTimes; // Number of recent frame times to average from
 	double* recentFrameTimes; // Array of recent times to complete a frame
 	int nextFrameTimeIndex; // Index at which the next frame time is stored in the array
-	double* sortedFrameTimes; // Helper array to calculate median of frame times
 	double currentFrameTime; // Current frame time average
+	FrameTimer* frameTimer; // Collector for the durations of the phases of recent frames
+	std::string profilerTraceFileName; // Base name of trace files written by the hot-path profiler
+	unsigned int profilerNumEventsPerThread; // Number of events the hot-path profiler records per thread
 	
 	/* Transient dragging/moving/scaling state: */
 	const Tool* activeNavigationTool;
@@ -260,6 +271,7 @@ struct VruiState
 	void updateNavigationTransformation(const NavTransform& newTransform); // Updates the working version of the navigation transformation
 	void loadViewpointFile(IO::Directory& directory,const char* viewpointFileName); // Overrides the navigation transformation with viewpoint data stored in the given viewpoint file
 	void toolDestructionCallback(ToolManager::ToolDestructionCallbackData* cbData); // Callback method called when a tool is destroyed
+	void writeProfile(void); // Writes all events recorded by the hot-path profiler to a new numbered trace file
 	
 	/* Constructors and destructors: */
 	VruiState(Cluster::Multiplexer* sMultiplexer,Cluster::MulticastPipe* sPipe); // Initializes basic Vrui state
@@ -293,6 +305,7 @@ struct VruiState
 	void loadInputGraphCallback(GLMotif::FileSelectionDialog::OKCallbackData* cbData);
 	void saveInputGraphCallback(GLMotif::FileSelectionDialog::OKCallbackData* cbData);
 	void showScaleBarToggleCallback(GLMotif::ToggleButton::ValueChangedCallbackData* cbData);
+	void recordProfileToggleCallback(GLMotif::ToggleButton::ValueChangedCallbackData* cbData);
 	void quitCallback(Misc::CallbackData* cbData);
 	};
 
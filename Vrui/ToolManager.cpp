@@ -29,6 +29,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Misc/StandardValueCoders.h>
 #include <Misc/CompoundValueCoders.h>
 #include <Misc/ConfigurationFile.h>
+#include <Threads/Profiler.h>
 #include <GLMotif/WidgetManager.h>
 #include <GLMotif/Label.h>
 #include <GLMotif/Button.h>
@@ -1147,6 +1148,8 @@ void ToolManager::destroyTool(Tool* tool,bool destroyImmediately)
 
 void ToolManager::update(void)
 	{
+	THREADS_PROFILE_ZONE("Vrui::ToolManager::update");
+	
 	/* Process the tool management queue: */
 	for(ToolManagementQueue::iterator tmqIt=toolManagementQueue.begin();tmqIt!=toolManagementQueue.end();++tmqIt)
 		{
@@ -0,0 +1,198 @@
+/***********************************************************************
+FrameTimerBenchmark - Program to measure the cost of recording frame
+phase samples from concurrent threads, and of computing rolling
+percentiles of recent phase durations.
+Copyright (c) 2013 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <Misc/Time.h>
+#include <Threads/Thread.h>
+#include <Vrui/FrameTimer.h>
+
+/****************
+Helper functions:
+****************/
+
+double toSeconds(const Misc::Time& time)
+	{
+	return double(time.tv_sec)+double(time.tv_nsec)*1.0e-9;
+	}
+
+/*********************************************************************
+Recorder threads; each thread times a number of empty phases, like a
+rendering thread timing its display and swap phases:
+*********************************************************************/
+
+struct Recorder
+	{
+	/* Elements: */
+	public:
+	Vrui::FrameTimer* timer; // The frame timer receiving the samples
+	int windowIndex; // Window index to record
+	unsigned int numSamples; // Number of samples to record
+	
+	/* Methods: */
+	void* threadMethod(void)
+		{
+		for(unsigned int i=0;i<numSamples;++i)
+			{
+			Vrui::FrameTimer::Scope scope(timer,Vrui::FrameTimer::DISPLAY,windowIndex);
+			}
+		return 0;
+		}
+	};
+
+void runRecordBenchmark(unsigned int numThreads,unsigned int numSamples,unsigned int numSlots)
+	{
+	Vrui::FrameTimer timer(numSlots);
+	Recorder* recorders=new Recorder[numThreads];
+	Threads::Thread* threads=new Threads::Thread[numThreads];
+	
+	/* Start all threads and wait for them to finish: */
+	Misc::Time startTime=Misc::Time::now();
+	for(unsigned int i=0;i<numThreads;++i)
+		{
+		recorders[i].timer=&timer;
+		recorders[i].windowIndex=int(i);
+		recorders[i].numSamples=numSamples/numThreads;
+		threads[i].start(&recorders[i],&Recorder::threadMethod);
+		}
+	for(unsigned int i=0;i<numThreads;++i)
+		threads[i].join();
+	double elapsed=toSeconds(Misc::Time::now()-startTime);
+	
+	/* Print the results: */
+	unsigned int totalSamples=(numSamples/numThreads)*numThreads;
+	std::cout<<std::setw(8)<<numThreads;
+	std::cout<<std::setw(12)<<totalSamples;
+	std::cout<<std::setw(10)<<std::fixed<<std::setprecision(3)<<elapsed;
+	std::cout<<std::setw(12)<<std::setprecision(1)<<elapsed*1.0e9/double(totalSamples);
+	std::cout<<std::setw(12)<<timer.getStatistics(Vrui::FrameTimer::DISPLAY).numSamples<<std::endl;
+	
+	delete[] threads;
+	delete[] recorders;
+	}
+
+void runStatisticsBenchmark(unsigned int numSlots,unsigned int numRounds)
+	{
+	/* Fill the timer's ring buffer with random durations: */
+	Vrui::FrameTimer timer(numSlots);
+	std::vector<double> durations;
+	unsigned int seed=1U;
+	for(unsigned int i=0;i<numSlots;++i)
+		{
+		double endTime=1.0+double(rand_r(&seed))/double(RAND_MAX)*0.02;
+		timer.record(Vrui::FrameTimer::SWAP,-1,1.0,endTime);
+		durations.push_back(endTime-1.0);
+		}
+	
+	/* Time the frame timer's percentile computation: */
+	Misc::Time startTime=Misc::Time::now();
+	Vrui::FrameTimer::Statistics stats;
+	for(unsigned int round=0;round<numRounds;++round)
+		stats=timer.getStatistics(Vrui::FrameTimer::SWAP);
+	double timerTime=toSeconds(Misc::Time::now()-startTime)/double(numRounds);
+	
+	/* Time the same computation using a comparison sort: */
+	startTime=Misc::Time::now();
+	std::vector<double> sorted;
+	for(unsigned int round=0;round<numRounds;++round)
+		{
+		sorted=durations;
+		std::sort(sorted.begin(),sorted.end());
+		}
+	double sortTime=toSeconds(Misc::Time::now()-startTime)/double(numRounds);
+	
+	/* Check the percentiles against the comparison sort, and check that out-of-range percentiles are clamped: */
+	size_t last=sorted.size()-1;
+	bool ok=stats.numSamples==sorted.size();
+	ok=ok&&(timer.getStatistics(Vrui::FrameTimer::SWAP).p50==stats.p50);
+	ok=ok&&(stats.p50==sorted[size_t(50.0*double(last)/100.0+0.5)]);
+	ok=ok&&(stats.p99==sorted[size_t(99.0*double(last)/100.0+0.5)]);
+	ok=ok&&(stats.max==sorted[last]);
+	ok=ok&&(timer.getPercentile(Vrui::FrameTimer::SWAP,-10.0)==sorted[0]);
+	ok=ok&&(timer.getPercentile(Vrui::FrameTimer::SWAP,250.0)==sorted[last]);
+	
+	/* Print the results: */
+	std::cout<<std::setw(8)<<numSlots;
+	std::cout<<std::setw(14)<<std::fixed<<std::setprecision(1)<<timerTime*1.0e6;
+	std::cout<<std::setw(14)<<sortTime*1.0e6;
+	std::cout<<std::setw(8)<<(ok?"ok":"FAILED")<<std::endl;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	unsigned int numSamples=4000000;
+	unsigned int maxNumThreads=8;
+	unsigned int numSlots=4096;
+	unsigned int numRounds=1000;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"samples")==0&&i+1<argc)
+				{
+				numSamples=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"maxThreads")==0&&i+1<argc)
+				{
+				maxNumThreads=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"slots")==0&&i+1<argc)
+				{
+				numSlots=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else if(strcasecmp(argv[i]+1,"rounds")==0&&i+1<argc)
+				{
+				numRounds=(unsigned int)(atoi(argv[i+1]));
+				++i;
+				}
+			else
+				{
+				std::cerr<<"Usage: "<<argv[0]<<" [-samples <number of recorded samples>] [-maxThreads <maximum number of recording threads>] [-slots <ring buffer size>] [-rounds <number of statistics rounds>]"<<std::endl;
+				return 1;
+				}
+			}
+		}
+	
+	/* Measure the cost of recording samples from increasing numbers of threads: */
+	std::cout<<"Recording samples into a ring buffer of "<<numSlots<<" slots"<<std::endl;
+	std::cout<<" Threads     Samples  Time (s)  ns/sample    Retained"<<std::endl;
+	for(unsigned int numThreads=1;numThreads<=maxNumThreads;numThreads*=2)
+		runRecordBenchmark(numThreads,numSamples,numSlots);
+	
+	/* Measure the cost of computing percentiles for increasing ring buffer sizes: */
+	std::cout<<std::endl<<"Computing percentiles of a full ring buffer"<<std::endl;
+	std::cout<<"   Slots  FrameTimer us   std::sort us  Result"<<std::endl;
+	for(unsigned int slots=256;slots<=numSlots*4;slots*=4)
+		runStatisticsBenchmark(slots,numRounds);
+	
+	return 0;
+	}
@@ -28,6 +28,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <Vrui/VRWindow.h>
 
+#include <string.h>
 #include <unistd.h>
 #include <iostream>
 #include <X11/keysym.h>
@@ -38,6 +39,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Misc/ArrayValueCoders.h>
 #include <Misc/CompoundValueCoders.h>
 #include <Misc/ConfigurationFile.h>
+#include <Threads/Profiler.h>
 #if SAVE_SCREENSHOT_PROJECTION
 #include <IO/File.h>
 #endif
@@ -67,7 +69,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Images/Config.h>
 #include <Images/RGBImage.h>
 #include <Images/ReadImageFile.h>
-#include <Images/WriteImageFile.h>
+#include <Images/AsyncImageWriter.h>
 #include <GLMotif/WidgetManager.h>
 #include <Vrui/Vrui.h>
 #if SAVE_SCREENSHOT_PROJECTION
@@ -83,6 +85,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/ToolManager.h>
 #include <Vrui/Internal/ToolKillZone.h>
 #include <Vrui/Internal/MovieSaver.h>
+#include <Vrui/Internal/ReadbackRing.h>
 #include <Vrui/Internal/Vrui.h>
 
 #if SAVE_SCREENSHOT_PROJECTION
@@ -242,6 +245,64 @@ extern double frameTimes[];
 extern int frameTimeIndex;
 #endif
 
+namespace {
+
+/**************
+Helper classes:
+**************/
+
+class ScreenshotReceiver:public ReadbackRing::Receiver // Class to hand read-back screen shots to a background image writer
+	{
+	/* Elements: */
+	private:
+	Images::AsyncImageWriter& writer; // Image writer for screen shot image files
+	std::vector<std::string> imageFileNames; // Names of the screen shot image files
+	
+	/* Constructors and destructors: */
+	public:
+	ScreenshotReceiver(Images::AsyncImageWriter& sWriter,const std::vector<std::string>& sImageFileNames)
+		:writer(sWriter),imageFileNames(sImageFileNames)
+		{
+		}
+	
+	/* Methods from ReadbackRing::Receiver: */
+	virtual void receivePixels(int width,int height,const unsigned char* pixels)
+		{
+		/* Queue a copy of the pixels for writing into each image file: */
+		for(std::vector<std::string>::iterator ifnIt=imageFileNames.begin();ifnIt!=imageFileNames.end();++ifnIt)
+			writer.writeImageFile(width,height,pixels,ifnIt->c_str());
+		}
+	};
+
+class MovieFrameReceiver:public ReadbackRing::Receiver // Class to hand read-back movie frames to a movie saver
+	{
+	/* Elements: */
+	private:
+	MovieSaver& movieSaver; // Movie saver receiving the frames
+	
+	/* Constructors and destructors: */
+	public:
+	MovieFrameReceiver(MovieSaver& sMovieSaver)
+		:movieSaver(sMovieSaver)
+		{
+		}
+	
+	/* Methods from ReadbackRing::Receiver: */
+	virtual void receivePixels(int width,int height,const unsigned char* pixels)
+		{
+		/* Get a fresh frame buffer and prepare it for writing: */
+		MovieSaver::FrameBuffer& frameBuffer=movieSaver.startNewFrame();
+		frameBuffer.setFrameSize(width,height);
+		frameBuffer.prepareWrite();
+		
+		/* Copy the pixels and post the new frame: */
+		memcpy(frameBuffer.getBuffer(),pixels,size_t(width)*size_t(height)*3);
+		movieSaver.postNewFrame();
+		}
+	};
+
+}
+
 /*************************
 Methods of class VRWindow:
 *************************/
@@ -724,7 +785,10 @@ VRWindow::VRWindow(GLContext* sContext,int sScreen,const char* windowName,const
 	 dirty(true),
 	 resizeViewport(true),
 	 saveScreenshot(false),
-	 movieSaver(0)
+	 movieSaver(0),
+	 numReadbackBuffers(configFileSection.retrieveValue<unsigned int>("./numReadbackBuffers",3)),
+	 readbackRing(0),
+	 screenshotWriter(0)
 	{
 	/* Update the X window's event mask: */
 	{
@@ -1356,6 +1420,9 @@ VRWindow::VRWindow(GLContext* sContext,int sScreen,const char* windowName,const
 VRWindow::~VRWindow(void)
 	{
 	delete movieSaver;
+	
+	/* Wait until all screen shots have been written: */
+	delete screenshotWriter;
 	}
 
 void VRWindow::setWindowGroup(VruiWindowGroup* newWindowGroup)
@@ -1422,6 +1489,11 @@ void VRWindow::setViewer(Viewer* newViewer)
 void VRWindow::deinit(void)
 	{
 	makeCurrent();
+	
+	/* Deliver all pending screen shots and movie frames and release the read-back buffers: */
+	delete readbackRing;
+	readbackRing=0;
+	
 	if(windowType==INTERLEAVEDVIEWPORT_STEREO)
 		{
 		if(hasFramebufferObjectExtension)
@@ -1886,14 +1958,14 @@ bool VRWindow::processEvent(const XEvent& event)
 							char numberedFileName[256];
 							#if IMAGES_CONFIG_HAVE_PNG
 							/* Save the screenshot as a PNG file: */
-							screenshotImageFileName=Misc::createNumberedFileName("VruiScreenshot.png",4,numberedFileName);
+							screenshotImageFileNames.push_back(Misc::createNumberedFileName("VruiScreenshot.png",4,numberedFileName));
 							#else
 							/* Save the screenshot as a PPM file: */
-							screenshotImageFileName=Misc::createNumberedFileName("VruiScreenshot.ppm",4,numberedFileName);
+							screenshotImageFileNames.push_back(Misc::createNumberedFileName("VruiScreenshot.ppm",4,numberedFileName));
 							#endif
 							
 							/* Write a confirmation message: */
-							std::cout<<"Saving window contents as "<<screenshotImageFileName<<std::endl;
+							std::cout<<"Saving window contents as "<<screenshotImageFileNames.back()<<std::endl;
 							}
 						break;
 					
@@ -2013,11 +2085,13 @@ void VRWindow::requestScreenshot(const char* sScreenshotImageFileName)
 	{
 	/* Set the screenshot flag and remember the given image file name: */
 	saveScreenshot=true;
-	screenshotImageFileName=sScreenshotImageFileName;
+	screenshotImageFileNames.push_back(sScreenshotImageFileName);
 	}
 
 void VRWindow::draw(void)
 	{
+	THREADS_PROFILE_ZONE("Vrui::VRWindow::draw");
+	
 	/* Update the window's display state: */
 	getMaxWindowSizes(windowGroup,displayState->maxViewportSize,displayState->maxFrameSize);
 	
@@ -2307,20 +2381,27 @@ void VRWindow::draw(void)
 	/* Check for OpenGL errors: */
 	glPrintError(std::cerr);
 	
+	/* Check if the window contents need to be read back: */
+	if(readbackRing==0&&(saveScreenshot||movieSaver!=0))
+		{
+		/* Create the read-back ring: */
+		readbackRing=new ReadbackRing(numReadbackBuffers);
+		}
+	if(readbackRing!=0)
+		{
+		/* Deliver screen shots and movie frames read back in previous frames: */
+		readbackRing->startFrame();
+		}
+	
 	/* Take a screen shot if requested: */
 	if(saveScreenshot)
 		{
-		/* Wait for the OpenGL pipeline to finish: */
-		glFinish();
-		
-		/* Create an RGB image of the same size as the window: */
-		Images::RGBImage image(getWindowWidth(),getWindowHeight());
+		/* Create the screen shot writer on first use: */
+		if(screenshotWriter==0)
+			screenshotWriter=new Images::AsyncImageWriter(1);
 		
-		/* Read the window contents into an RGB image: */
-		image.glReadPixels(0,0);
-		
-		/* Save the image buffer to the given image file: */
-		Images::writeImageFile(image,screenshotImageFileName.c_str());
+		/* Read the window contents and hand them to the screen shot writer when they arrive: */
+		readbackRing->readPixels(getWindowWidth(),getWindowHeight(),new ScreenshotReceiver(*screenshotWriter,screenshotImageFileNames));
 		
 		#if SAVE_SCREENSHOT_PROJECTION
 		
@@ -2337,43 +2418,32 @@ void VRWindow::draw(void)
 		
 		glPopMatrix();
 		
-		/* Write the matrices to a projection file: */
-		{
-		IO::AutoFile projFile(Vrui::openFile((screenshotImageFileName+".proj").c_str(),Misc::BufferedFile::WriteOnly));
-		projFile->setEndianness(IO::File::LittleEndian);
-		projFile->write(proj,16);
-		projFile->write(mv,16);
-		}
+		/* Write the matrices to a projection file for each image file: */
+		for(std::vector<std::string>::iterator ifnIt=screenshotImageFileNames.begin();ifnIt!=screenshotImageFileNames.end();++ifnIt)
+			{
+			IO::AutoFile projFile(Vrui::openFile((*ifnIt+".proj").c_str(),Misc::BufferedFile::WriteOnly));
+			projFile->setEndianness(IO::File::LittleEndian);
+			projFile->write(proj,16);
+			projFile->write(mv,16);
+			}
 		
 		#endif
 		
 		saveScreenshot=false;
+		screenshotImageFileNames.clear();
 		}
 	
 	/* Check if the window is supposed to save a movie: */
 	if(movieSaver!=0)
 		{
-		/* Get a fresh frame buffer: */
-		MovieSaver::FrameBuffer& frameBuffer=movieSaver->startNewFrame();
-		
-		/* Update the frame buffer's size and prepare it for writing: */
-		frameBuffer.setFrameSize(getWindowWidth(),getWindowHeight());
-		frameBuffer.prepareWrite();
-		
-		/* Wait for the OpenGL pipeline to finish: */
-		glFinish();
-		
-		/* Read the window contents into the movie saver's frame buffer: */
-		glPixelStorei(GL_PACK_ALIGNMENT,1);
-		glPixelStorei(GL_PACK_SKIP_PIXELS,0);
-		glPixelStorei(GL_PACK_ROW_LENGTH,0);
-		glPixelStorei(GL_PACK_SKIP_ROWS,0);
-		glReadPixels(0,0,getWindowWidth(),getWindowHeight(),GL_RGB,GL_UNSIGNED_BYTE,frameBuffer.getBuffer());
-		
-		/* Post the new frame: */
-		movieSaver->postNewFrame();
+		/* Read the window contents and hand them to the movie saver when they arrive: */
+		readbackRing->readPixels(getWindowWidth(),getWindowHeight(),new MovieFrameReceiver(*movieSaver));
 		}
 	
+	/* Keep rendering until all read-backs have been delivered: */
+	if(readbackRing!=0&&readbackRing->getNumPending()>0)
+		requestUpdate();
+	
 	/* Window is now up-to-date: */
 	resizeViewport=false;
 	dirty=false;
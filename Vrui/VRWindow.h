@@ -26,6 +26,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #define VRUI_VRWINDOW_INCLUDED
 
 #include <string>
+#include <vector>
 #include <Geometry/ComponentArray.h>
 #include <Geometry/Point.h>
 #include <Geometry/Ray.h>
@@ -41,6 +42,9 @@ class GLExtensionManager;
 class GLShader;
 class GLContextData;
 class GLFont;
+namespace Images {
+class AsyncImageWriter;
+}
 namespace Vrui {
 class InputDevice;
 class Viewer;
@@ -50,6 +54,7 @@ class ViewSpecification;
 class DisplayState;
 class InputDeviceAdapterMouse;
 class MovieSaver;
+class ReadbackRing;
 class VruiState;
 }
 namespace Vrui {
@@ -136,8 +141,11 @@ class VRWindow:public GLWindow
 	bool dirty; // Flag if the window needs to be redrawn
 	bool resizeViewport; // Flag if the window's OpenGL viewport needs to be resized on the next draw() call
 	bool saveScreenshot; // Flag if the window is to save its contents after the next draw() call
-	std::string screenshotImageFileName; // Name of the image file into which to save the next screen shot
+	std::vector<std::string> screenshotImageFileNames; // Names of the image files into which to save the next screen shot
 	MovieSaver* movieSaver; // Pointer to a movie saver object if the window is supposed to write contents to a movie
+	unsigned int numReadbackBuffers; // Number of pixel buffer objects used to read back screen shots and movie frames asynchronously; zero reads back synchronously
+	ReadbackRing* readbackRing; // Ring of pixel buffer objects to read back screen shots and movie frames; created on first use
+	Images::AsyncImageWriter* screenshotWriter; // Background writer for screen shot image files; created on first use
 	
 	/* Private methods: */
 	void render(const GLWindow::WindowPos& viewportPos,int screenIndex,const Point& eye);
@@ -211,7 +219,7 @@ class VRWindow:public GLWindow
 		{
 		return dirty;
 		}
-	void requestScreenshot(const char* sScreenshotImageFileName); // Asks the window to save its contents to the given image file on the next render pass
+	void requestScreenshot(const char* sScreenshotImageFileName); // Asks the window to save its contents to the given image file on the next render pass; saves the same contents to each file if called repeatedly before the next render pass
 	void draw(void); // Redraws the window's contents
 	};
 
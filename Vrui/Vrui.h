@@ -35,6 +35,10 @@ namespace Misc {
 class Time;
 class CallbackList;
 class TimerEventScheduler;
+class ArenaAllocator;
+}
+namespace Threads {
+class TaskScheduler;
 }
 namespace Cluster {
 class Multiplexer;
@@ -51,6 +55,7 @@ class PopupMenu;
 }
 class ALContextData;
 namespace Vrui {
+class FrameTimer;
 class Glyph;
 class GlyphRenderer;
 class InputDevice;
@@ -139,7 +144,11 @@ bool isMaster(void); // Returns true if the multipipe node the caller is running
 int getNodeIndex(void); // Returns index of the multipipe node the caller is running on (0: master node)
 int getNumNodes(void); // Returns number of multipipe nodes, including master
 Cluster::MulticastPipe* getMainPipe(void); // Returns Vrui's main frame pipe; safe to use inside frame function, user must call finishMessage() when done (returns 0 if called in a non-cluster environment)
-Cluster::MulticastPipe* openPipe(void); // Opens a pipe for 1-to-n communication from master to all slaves (returns 0 if called in a non-cluster environment)
+Cluster::MulticastPipe* openPipe(bool compressed =false); // Opens a pipe for 1-to-n communication from master to all slaves, optionally compressing the sent data (returns 0 if called in a non-cluster environment)
+
+/* Manage parallel tasks: */
+Threads::TaskScheduler* getTaskScheduler(void); // Returns pointer to the shared pool of worker threads for parallel tasks
+Misc::ArenaAllocator& getFrameArena(void); // Returns an arena for transient memory allocated by the main thread; all memory allocated from the arena is released at the beginning of the next frame
 
 /* Manage glyph rendering: */
 GlyphRenderer* getGlyphRenderer(void); // Returns pointer to the glyph renderer
@@ -267,6 +276,7 @@ Misc::Time getTimeOfDay(void); // Returns the system's wall clock time; requires
 double getApplicationTime(void); // Returns the time since the application was started in seconds; is identical throughout a Vrui frame and across a cluster
 double getFrameTime(void); // Returns the duration of the last frame in seconds
 double getCurrentFrameTime(void); // Returns the current average time between frames (1/framerate) in seconds
+FrameTimer& getFrameTimer(void); // Returns the collector of the durations of the phases of recent frames
 
 /* Rendering management: */
 void updateContinuously(void); // Tells Vrui to continuously update its state (must be called before mainLoop)